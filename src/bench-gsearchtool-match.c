@@ -0,0 +1,242 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  bench-gsearchtool-match.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Micro-benchmarks for the matching layer, run by "make bench".  Each
+ * predicate is timed over a corpus of paths and reported in nanoseconds
+ * per path, one JSON object per line.  The corpus is either generated
+ * from a seed, with the shape of a home folder, or read from a file with
+ * one path per line, for example the output of "find ~".
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+
+#include "gsearchtool-match.h"
+
+/* Each predicate runs over the corpus until at least this much time has
+   passed, so short corpora still give stable figures. */
+#define BENCH_MINIMUM_DURATION (G_USEC_PER_SEC / 4)
+
+static gint seed = 1;
+static gint corpus_size = 200000;
+static gchar * corpus_filename = NULL;
+
+static GOptionEntry BenchEntries[] = {
+	{ "seed", 0, 0, G_OPTION_ARG_INT, &seed, "Seed of the generated corpus", "N" },
+	{ "paths", 0, 0, G_OPTION_ARG_INT, &corpus_size, "Size of the generated corpus", "N" },
+	{ "corpus", 0, 0, G_OPTION_ARG_FILENAME, &corpus_filename, "Read the paths from FILE", "FILE" },
+	{ NULL }
+};
+
+static const gchar * BenchFolders[] = {
+	"Documents", "Pictures", "Music", "Videos", "Downloads", "Desktop", "src", "projects",
+	"work", "2009", "2010", "2011", "holiday", "backup", "old", "misc",
+	".cache", ".config", ".local", ".mozilla", ".thumbnails", ".git", "share", "lib"
+};
+
+static const gchar * BenchNames[] = {
+	"report", "notes", "IMG_", "track", "invoice", "draft", "main", "index",
+	"README", "Makefile", "config", "summary", "letter", "budget", "photo", "thesis"
+};
+
+static const gchar * BenchExtensions[] = {
+	".txt", ".odt", ".jpg", ".JPG", ".png", ".ogg", ".mp3", ".c", ".h", ".pdf", ".html", "", "~"
+};
+
+static GPtrArray *
+create_corpus (void)
+{
+	GPtrArray * corpus;
+	GRand * rand;
+	gint idx;
+
+	corpus = g_ptr_array_new_with_free_func (g_free);
+	rand = g_rand_new_with_seed (seed);
+
+	for (idx = 0; idx < corpus_size; idx++) {
+		GString * path = g_string_new ("/home/user");
+		gint depth = g_rand_int_range (rand, 0, 7);
+		gint level;
+
+		for (level = 0; level < depth; level++) {
+			g_string_append_c (path, G_DIR_SEPARATOR);
+			g_string_append (path, BenchFolders[g_rand_int_range (rand, 0, G_N_ELEMENTS (BenchFolders))]);
+		}
+		g_string_append_printf (path, "/%s%d%s",
+		                        BenchNames[g_rand_int_range (rand, 0, G_N_ELEMENTS (BenchNames))],
+		                        g_rand_int_range (rand, 0, 10000),
+		                        BenchExtensions[g_rand_int_range (rand, 0, G_N_ELEMENTS (BenchExtensions))]);
+		g_ptr_array_add (corpus, g_string_free (path, FALSE));
+	}
+	g_rand_free (rand);
+
+	return corpus;
+}
+
+static GPtrArray *
+read_corpus (const gchar * filename)
+{
+	GPtrArray * corpus;
+	GError * error = NULL;
+	gchar * contents;
+	gchar ** lines;
+	gint idx;
+
+	if (!g_file_get_contents (filename, &contents, NULL, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return NULL;
+	}
+
+	corpus = g_ptr_array_new_with_free_func (g_free);
+	lines = g_strsplit (contents, "\n", -1);
+	for (idx = 0; lines[idx] != NULL; idx++) {
+		if (lines[idx][0] != '\0') {
+			g_ptr_array_add (corpus, lines[idx]);
+		}
+		else {
+			g_free (lines[idx]);
+		}
+	}
+	g_free (lines);
+	g_free (contents);
+
+	return corpus;
+}
+
+typedef enum {
+	BENCH_NAME_SUBSTRING,
+	BENCH_NAME_EXTENSION,
+	BENCH_PATH_HIDDEN,
+	BENCH_REGEX,
+	BENCH_EXCLUDED_PATH,
+	BENCH_NUM_PREDICATES
+} BenchPredicate;
+
+static const gchar * BenchPredicateNames[BENCH_NUM_PREDICATES] = {
+	"compare_name_pattern:*report*",
+	"compare_name_pattern:*.jpg",
+	"is_path_hidden",
+	"compare_regex:^[a-z]+[0-9]+\\\\.txt$",
+	"is_path_excluded:quick_search_excluded_paths"
+};
+
+static gboolean
+run_predicate (BenchPredicate predicate,
+               const gchar * path,
+               const gchar * name,
+               GSList * exclude_path_list)
+{
+	switch (predicate) {
+	case BENCH_NAME_SUBSTRING:
+		return compare_name_pattern ("*report*", name);
+	case BENCH_NAME_EXTENSION:
+		return compare_name_pattern ("*.jpg", name);
+	case BENCH_PATH_HIDDEN:
+		return is_path_hidden (path);
+	case BENCH_REGEX:
+		return compare_regex ("^[a-z]+[0-9]+\\.txt$", name);
+	case BENCH_EXCLUDED_PATH:
+		return is_path_excluded (path, exclude_path_list);
+	default:
+		return FALSE;
+	}
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	GOptionContext * context;
+	GError * error = NULL;
+	GPtrArray * corpus;
+	GPtrArray * names;
+	GSList * exclude_path_list = NULL;
+	gint predicate;
+	guint idx;
+
+	context = g_option_context_new ("- measure the matching layer in ns/path");
+	g_option_context_add_main_entries (context, BenchEntries, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	corpus = (corpus_filename != NULL) ? read_corpus (corpus_filename) : create_corpus ();
+	if ((corpus == NULL) || (corpus->len == 0)) {
+		return 1;
+	}
+
+	/* The results filter matches names, compute them outside of the loop. */
+	names = g_ptr_array_new_with_free_func (g_free);
+	for (idx = 0; idx < corpus->len; idx++) {
+		g_ptr_array_add (names, g_path_get_basename (g_ptr_array_index (corpus, idx)));
+	}
+
+	/* The default quick_search_excluded_paths. */
+	exclude_path_list = g_slist_append (exclude_path_list, "/mnt/*");
+	exclude_path_list = g_slist_append (exclude_path_list, "/media/*");
+	exclude_path_list = g_slist_append (exclude_path_list, "/dev/*");
+	exclude_path_list = g_slist_append (exclude_path_list, "/tmp/*");
+	exclude_path_list = g_slist_append (exclude_path_list, "/proc/*");
+	exclude_path_list = g_slist_append (exclude_path_list, "/var/*");
+
+	for (predicate = 0; predicate < BENCH_NUM_PREDICATES; predicate++) {
+		gint64 start;
+		gint64 elapsed;
+		gint64 evaluated = 0;
+		gint64 matches = 0;
+
+		start = g_get_monotonic_time ();
+		do {
+			for (idx = 0; idx < corpus->len; idx++) {
+				if (run_predicate (predicate, g_ptr_array_index (corpus, idx),
+				                   g_ptr_array_index (names, idx), exclude_path_list)) {
+					matches++;
+				}
+			}
+			evaluated += corpus->len;
+			elapsed = g_get_monotonic_time () - start;
+		} while (elapsed < BENCH_MINIMUM_DURATION);
+
+		g_print ("{\"benchmark\":\"match\",\"predicate\":\"%s\",\"paths\":%u,"
+		         "\"evaluations\":%" G_GINT64_FORMAT ",\"matches\":%" G_GINT64_FORMAT ",\"ns_per_path\":%.1f}\n",
+		         BenchPredicateNames[predicate], corpus->len,
+		         evaluated, matches * (gint64) corpus->len / evaluated,
+		         (gdouble) elapsed * 1000 / evaluated);
+	}
+
+	g_slist_free (exclude_path_list);
+	g_ptr_array_free (names, TRUE);
+	g_ptr_array_free (corpus, TRUE);
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+#!/bin/sh
+#
+# GNOME Search Tool benchmark suite, run by "make bench".
+#
+# Generates a deterministic file tree with gsearchtool-mktree, runs the
+# search tool in --batch mode for a name, a constraint and a content
+# search and appends one JSON object per run to the output file.
+#
+# The tree parameters and the number of runs can be overridden from the
+# environment:
+#
+#   BENCH_SEED BENCH_DEPTH BENCH_FANOUT BENCH_FILES BENCH_MAX_SIZE
+#   BENCH_RUNS BENCH_TREE
+#
+# The default tree lives below /tmp, which the search tool excludes from
+# quick searches, so the runs measure the find engine rather than the
+# state of the locate database.
+
+MKTREE=./gsearchtool-mktree
+SEARCH_TOOL=./gnome-search-tool
+OUTPUT=bench-results.jsonl
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+	--mktree) MKTREE="$2"; shift 2 ;;
+	--search-tool) SEARCH_TOOL="$2"; shift 2 ;;
+	--output) OUTPUT="$2"; shift 2 ;;
+	*) echo "Usage: $0 [--mktree PATH] [--search-tool PATH] [--output FILE]" >&2; exit 1 ;;
+	esac
+done
+
+BENCH_SEED=${BENCH_SEED:-1}
+BENCH_DEPTH=${BENCH_DEPTH:-4}
+BENCH_FANOUT=${BENCH_FANOUT:-5}
+BENCH_FILES=${BENCH_FILES:-24}
+BENCH_MAX_SIZE=${BENCH_MAX_SIZE:-65536}
+BENCH_RUNS=${BENCH_RUNS:-3}
+BENCH_TREE=${BENCH_TREE:-${TMPDIR:-/tmp}/gnome-search-tool-bench-$BENCH_SEED-$BENCH_DEPTH-$BENCH_FANOUT-$BENCH_FILES-$BENCH_MAX_SIZE}
+
+# The window is never shown in batch mode, but GTK still needs a display.
+RUN=""
+if [ -z "$DISPLAY" ]; then
+	if command -v xvfb-run >/dev/null 2>&1; then
+		RUN="xvfb-run -a"
+	else
+		echo "$0: no DISPLAY and xvfb-run is not installed" >&2
+		exit 1
+	fi
+fi
+
+# gsearchtool-mktree refuses to write into a folder that is not empty.
+if [ ! -f "$BENCH_TREE/.bench-tree" ]; then
+	"$MKTREE" --seed "$BENCH_SEED" --depth "$BENCH_DEPTH" --fanout "$BENCH_FANOUT" \
+		--files "$BENCH_FILES" --max-size "$BENCH_MAX_SIZE" "$BENCH_TREE" > "$BENCH_TREE.json" || exit 1
+	mv "$BENCH_TREE.json" "$BENCH_TREE/.bench-tree"
+fi
+TREE_JSON=$(cat "$BENCH_TREE/.bench-tree")
+COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+
+# run_case NAME ARGS...
+run_case ()
+{
+	name="$1"
+	shift
+
+	# The first run warms the page cache and is not recorded.
+	$RUN "$SEARCH_TOOL" --batch --path "$BENCH_TREE" "$@" > /dev/null 2>&1
+
+	run=1
+	while [ "$run" -le "$BENCH_RUNS" ]; do
+		start=$(date +%s.%N)
+		output=$($RUN "$SEARCH_TOOL" --batch --path "$BENCH_TREE" "$@" 2>/dev/null)
+		end=$(date +%s.%N)
+
+		results=$(printf '%s\n' "$output" | grep -c '^/')
+		stats=$(printf '%s\n' "$output" | grep '^{' | tail -n 1)
+		[ -n "$stats" ] || stats=null
+
+		printf '%s\n' "$stats" | awk -v name="$name" -v run="$run" -v results="$results" \
+			-v start="$start" -v end="$end" -v tree="$TREE_JSON" -v commit="$COMMIT" '
+		{
+			entries = 0; wall = 0
+			if (match ($0, /"entries_examined":[0-9]+/))
+				entries = substr ($0, RSTART + 19, RLENGTH - 19)
+			if (match ($0, /"wall_time":[0-9.]+/))
+				wall = substr ($0, RSTART + 12, RLENGTH - 12)
+			printf "{\"benchmark\":\"%s\",\"commit\":\"%s\",\"run\":%d,\"tree\":%s,", name, commit, run, tree
+			printf "\"results\":%d,\"process_time\":%.6f,", results, end - start
+			printf "\"entries_per_second\":%.1f,\"stats\":%s}\n", (wall > 0) ? entries / wall : 0, $0
+		}' >> "$OUTPUT"
+
+		run=$((run + 1))
+	done
+	echo "  $name: $results results"
+}
+
+echo "Benchmarking $SEARCH_TOOL on $BENCH_TREE"
+
+run_case name-search --named report
+run_case constraint-search --named "*" --sizemore 32 --notnamed .jpg
+run_case content-search --named "*" --contains gsearchneedle
+
+echo "Results appended to $OUTPUT"
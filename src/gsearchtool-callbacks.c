@@ -46,10 +46,6 @@
 
 #define SILENT_WINDOW_OPEN_LIMIT 5
 
-#ifdef HAVE_GETPGID
-extern pid_t getpgid (pid_t);
-#endif
-
 gboolean row_selected_by_button_press_event;
 
 static void
@@ -69,27 +65,7 @@ store_window_state_and_geometry (GSearchWindow *gsearch)
 static void
 quit_application (GSearchWindow * gsearch)
 {
-	GSearchCommandDetails * command_details = gsearch->command_details;
-
-	if (command_details->command_status == RUNNING) {
-#ifdef HAVE_GETPGID
-		pid_t pgid;
-#endif
-		command_details->command_status = MAKE_IT_QUIT;
-#ifdef HAVE_GETPGID
-		pgid = getpgid (command_details->command_pid);
-
-		if ((pgid > 1) && (pgid != getpid ())) {
-			kill (-(getpgid (command_details->command_pid)), SIGKILL);
-		}
-		else {
-			kill (command_details->command_pid, SIGKILL);
-		}
-#else
-		kill (command_details->command_pid, SIGKILL);
-#endif
-		wait (NULL);
-	}
+	stop_search_command (gsearch, MAKE_IT_QUIT);
 	store_window_state_and_geometry (gsearch);
 	gtk_main_quit ();
 }
@@ -131,7 +107,6 @@ click_find_cb (GtkWidget * widget,
                gpointer data)
 {
 	GSearchWindow * gsearch = data;
-	gchar * command;
 
 	if (gsearch->command_details->is_command_timeout_enabled == TRUE) {
 		return;
@@ -139,11 +114,7 @@ click_find_cb (GtkWidget * widget,
 
 	if ((gsearch->command_details->command_status == STOPPED) ||
 	    (gsearch->command_details->command_status == ABORTED)) {
-	    	command = build_search_command (gsearch, TRUE);
-		if (command != NULL) {
-			spawn_search_command (gsearch, command);
-			g_free (command);
-		}
+		start_search_command (gsearch);
 	}
 }
 
@@ -154,24 +125,8 @@ click_stop_cb (GtkWidget * widget,
 	GSearchWindow * gsearch = data;
 
 	if (gsearch->command_details->command_status == RUNNING) {
-#ifdef HAVE_GETPGID
-		pid_t pgid;
-#endif
 		gtk_widget_set_sensitive (gsearch->stop_button, FALSE);
-		gsearch->command_details->command_status = MAKE_IT_STOP;
-#ifdef HAVE_GETPGID
-		pgid = getpgid (gsearch->command_details->command_pid);
-
-		if ((pgid > 1) && (pgid != getpid ())) {
-			kill (-(getpgid (gsearch->command_details->command_pid)), SIGKILL);
-		}
-		else {
-			kill (gsearch->command_details->command_pid, SIGKILL);
-		}
-#else
-		kill (gsearch->command_details->command_pid, SIGKILL);
-#endif
-		wait (NULL);
+		stop_search_command (gsearch, MAKE_IT_STOP);
 	}
 }
 
@@ -312,6 +267,15 @@ name_contains_activate_cb (GtkWidget * widget,
 	}
 }
 
+void
+name_contains_changed_cb (GtkWidget * widget,
+                          gpointer data)
+{
+	GSearchWindow * gsearch = data;
+
+	update_live_search (gsearch);
+}
+
 void
 look_in_folder_changed_cb (GtkWidget * widget,
                            gpointer data)
@@ -465,10 +429,10 @@ open_file_cb (GtkMenuItem * action,
 		gchar * locale_file;
 		GtkTreeIter iter;
 
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                         g_list_nth (list, idx)->data);
 
-		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
     		                    COLUMN_NAME, &utf8_name,
 				    COLUMN_LOCALE_FILE, &locale_file,
 		                    COLUMN_NO_FILES_FOUND, &no_files_found,
@@ -594,10 +558,10 @@ open_folder_cb (GtkAction * action,
 		gchar * locale_file;
 		GtkTreeIter iter;
 
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 					 g_list_nth (list, idx)->data);
 
-		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 				    COLUMN_RELATIVE_PATH, &utf8_folder,
 				    COLUMN_LOCALE_FILE, &locale_file,
 				    -1);
@@ -639,25 +603,38 @@ open_folder_cb (GtkAction * action,
 
 void
 file_changed_cb (GFileMonitor * handle,
-                 const gchar * monitor_uri,
-                 const gchar * info_uri,
+                 GFile * file,
+                 GFile * other_file,
                  GFileMonitorEvent event_type,
                  gpointer data)
 {
-	GSearchMonitor * monitor = data;
-	GSearchWindow * gsearch = monitor->gsearch;
-	GtkTreeModel * model;
-	GtkTreePath * path;
-	GtkTreeIter iter;
+	GSearchWindow * gsearch = data;
+	gchar * locale_file;
 
 	switch (event_type) {
 	case G_FILE_MONITOR_EVENT_DELETED:
-		path = gtk_tree_row_reference_get_path (monitor->reference);
-		model = gtk_tree_row_reference_get_model (monitor->reference);
-		gtk_tree_model_get_iter (model, &iter, path);
-		tree_model_iter_free_monitor (model, NULL, &iter, NULL);
-		gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
-		update_search_counts (gsearch);
+		/* The monitors watch the folders of the results, most of
+		   the files they report were not found by the search. */
+		locale_file = g_file_get_path (file);
+		if (locale_file != NULL &&
+		    gsearch_results_model_remove_file (gsearch->search_results_model, locale_file) == TRUE) {
+			update_search_counts (gsearch);
+		}
+		g_free (locale_file);
+		break;
+	case G_FILE_MONITOR_EVENT_CREATED:
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+	case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+		/* In the watch mode the files are tested again, see
+		   queue_watched_file(). */
+		if (gsearch->is_search_results_watched == FALSE) {
+			break;
+		}
+		locale_file = g_file_get_path (file);
+		if (locale_file != NULL) {
+			queue_watched_file (gsearch, locale_file);
+		}
+		g_free (locale_file);
 		break;
 	default:
 		break;
@@ -784,10 +761,10 @@ move_to_trash_cb (GtkAction * action,
 		list = gtk_tree_selection_get_selected_rows (GTK_TREE_SELECTION (gsearch->search_results_selection),
  		                                             &model);
 
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 					 g_list_nth (list, 0)->data);
 
-		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
     				    COLUMN_NAME, &utf8_basename,
 				    COLUMN_LOCALE_FILE, &locale_filename,
 			   	    COLUMN_NO_FILES_FOUND, &no_files_found,
@@ -801,7 +778,7 @@ move_to_trash_cb (GtkAction * action,
 		}
 		
 		if (idx + 1 == total) {
-			last_selected_path = gtk_tree_model_get_path (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter);
+			last_selected_path = gtk_tree_model_get_path (GTK_TREE_MODEL (gsearch->search_results_model), &iter);
 		}
 
 		if ((!g_file_test (locale_filename, G_FILE_TEST_EXISTS)) &&
@@ -818,9 +795,7 @@ move_to_trash_cb (GtkAction * action,
 		g_object_unref (g_file);
 
 		if (result == TRUE) {
-			tree_model_iter_free_monitor (GTK_TREE_MODEL (gsearch->search_results_list_store),
-						      NULL, &iter, NULL);
-			gtk_list_store_remove (GTK_LIST_STORE (gsearch->search_results_list_store), &iter);
+			gsearch_results_model_remove (gsearch->search_results_model, &iter);
 		}
 		else {
 			gint response;
@@ -837,9 +812,7 @@ move_to_trash_cb (GtkAction * action,
 				g_object_unref (g_file_tmp);
 
 				if (result == TRUE) {
-					tree_model_iter_free_monitor (GTK_TREE_MODEL (gsearch->search_results_list_store),
-								      NULL, &iter, NULL);
-					gtk_list_store_remove (GTK_LIST_STORE (gsearch->search_results_list_store), &iter);
+					gsearch_results_model_remove (gsearch->search_results_model, &iter);
 				}
 				else {
 					gchar * message;
@@ -1259,10 +1232,10 @@ file_button_release_event_cb (GtkWidget * widget,
 		list = gtk_tree_selection_get_selected_rows (GTK_TREE_SELECTION (gsearch->search_results_selection),
 		                                             &model);
 
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                         g_list_first (list)->data);
 
-		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                    COLUMN_NAME, &utf8_name_first,
 				    COLUMN_LOCALE_FILE, &locale_file_first,
 			    	    COLUMN_NO_FILES_FOUND, &no_files_found,
@@ -1289,10 +1262,10 @@ file_button_release_event_cb (GtkWidget * widget,
 					GFile * g_file;
 					GAppInfo * app_info;
 
-					gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+					gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 					                         tmp->data);
 
-					gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+					gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 							    COLUMN_LOCALE_FILE, &locale_file_tmp,
 					                    -1);
 
@@ -1418,16 +1391,16 @@ file_motion_notify_cb (GtkWidget *widget,
 	    (!(last_hover_path != NULL && gsearch->search_results_hover_path != NULL) ||
 	     gtk_tree_path_compare (last_hover_path, gsearch->search_results_hover_path))) {
 		if (last_hover_path) {
-			gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store),
+			gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model),
 			                         &iter, last_hover_path);
-			gtk_tree_model_row_changed (GTK_TREE_MODEL (gsearch->search_results_list_store),
+			gtk_tree_model_row_changed (GTK_TREE_MODEL (gsearch->search_results_model),
 			                            last_hover_path, &iter);
 		}
 
 		if (gsearch->search_results_hover_path) {
-			gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store),
+			gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model),
 			                         &iter, gsearch->search_results_hover_path);
-			gtk_tree_model_row_changed (GTK_TREE_MODEL (gsearch->search_results_list_store),
+			gtk_tree_model_row_changed (GTK_TREE_MODEL (gsearch->search_results_model),
 			                            gsearch->search_results_hover_path, &iter);
 		}
 	}
@@ -1446,10 +1419,10 @@ file_leave_notify_cb (GtkWidget *widget,
 	GtkTreeIter iter;
 
 	if (gsearch->is_search_results_single_click_to_activate && (gsearch->search_results_hover_path != NULL)) {
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store),
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model),
 		                         &iter,
 		                         gsearch->search_results_hover_path);
-		gtk_tree_model_row_changed (GTK_TREE_MODEL (gsearch->search_results_list_store),
+		gtk_tree_model_row_changed (GTK_TREE_MODEL (gsearch->search_results_model),
 		                            gsearch->search_results_hover_path,
 		                            &iter);
 
@@ -1462,6 +1435,48 @@ file_leave_notify_cb (GtkWidget *widget,
 	return FALSE;
 }
 
+gboolean
+file_query_tooltip_cb (GtkWidget * widget,
+                       gint x,
+                       gint y,
+                       gboolean keyboard_mode,
+                       GtkTooltip * tooltip,
+                       gpointer data)
+{
+	GSearchWindow * gsearch = data;
+	GtkTreeModel * model;
+	GtkTreePath * path;
+	GtkTreeIter iter;
+	gchar * locale_file;
+	const gchar * hits;
+	gboolean has_tooltip = FALSE;
+
+	if (gsearch->search_results_content_hits == NULL) {
+		return FALSE;
+	}
+
+	if (!gtk_tree_view_get_tooltip_context (GTK_TREE_VIEW (widget), &x, &y, keyboard_mode,
+	                                        &model, &path, &iter)) {
+		return FALSE;
+	}
+
+	gtk_tree_model_get (model, &iter, COLUMN_LOCALE_FILE, &locale_file, -1);
+	hits = g_hash_table_lookup (gsearch->search_results_content_hits, locale_file);
+	if (hits != NULL) {
+		gchar * text;
+
+		text = g_strdup_printf (_("Contains: %s"), hits);
+		gtk_tooltip_set_text (tooltip, text);
+		gtk_tree_view_set_tooltip_row (GTK_TREE_VIEW (widget), tooltip, path);
+		has_tooltip = TRUE;
+		g_free (text);
+	}
+	g_free (locale_file);
+	gtk_tree_path_free (path);
+
+	return has_tooltip;
+}
+
 void
 drag_begin_file_cb (GtkWidget * widget,
                     GdkDragContext * context,
@@ -1484,10 +1499,10 @@ drag_begin_file_cb (GtkWidget * widget,
 		list = gtk_tree_selection_get_selected_rows (GTK_TREE_SELECTION (gsearch->search_results_selection),
 		                                             &model);
 
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                         g_list_first (list)->data);
 
-		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                    COLUMN_ICON, &pixbuf,
 		                    -1);
 		g_list_foreach (list, (GFunc) gtk_tree_path_free, NULL);
@@ -1530,10 +1545,10 @@ drag_file_cb  (GtkWidget * widget,
 		gchar * utf8_name;
 		gchar * locale_file;
 
-		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                         g_list_nth (list, idx)->data);
 
-		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 		                    COLUMN_NAME, &utf8_name,
 		                    COLUMN_LOCALE_FILE, &locale_file,
 		                    COLUMN_NO_FILES_FOUND, &no_files_found,
@@ -1700,7 +1715,7 @@ save_results_cb (GtkWidget * chooser,
                  gpointer data)
 {
 	GSearchWindow * gsearch = data;
-	GtkListStore * store;
+	GtkTreeModel * store;
 	GtkTreeIter iter;
 	FILE * fp;
 	gchar * utf8 = NULL;
@@ -1710,7 +1725,7 @@ save_results_cb (GtkWidget * chooser,
 		return;
 	}
 
-	store = gsearch->search_results_list_store;
+	store = GTK_TREE_MODEL (gsearch->search_results_model);
 	g_free (gsearch->save_results_as_default_filename);
 
 	gsearch->save_results_as_default_filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (chooser));
@@ -1814,10 +1829,10 @@ key_press_cb (GtkWidget * widget,
 			list = gtk_tree_selection_get_selected_rows (GTK_TREE_SELECTION (gsearch->search_results_selection),
 			                                             &model);
 
-			gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+			gtk_tree_model_get_iter (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 						 g_list_first (list)->data);
 
-			gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_list_store), &iter,
+			gtk_tree_model_get (GTK_TREE_MODEL (gsearch->search_results_model), &iter,
 					    COLUMN_NO_FILES_FOUND, &no_files_found, -1);
 
 			g_list_foreach (list, (GFunc) gtk_tree_path_free, NULL);
@@ -1871,6 +1886,22 @@ single_click_to_activate_key_changed_cb (GConfClient * client,
 		(strncmp (gconf_value_get_string (value), "single", 6) == 0) ? TRUE : FALSE;
 }
 
+void
+show_search_statistics_key_changed_cb (GConfClient * client,
+                                       guint cnxn_id,
+                                       GConfEntry * entry,
+                                       gpointer user_data)
+{
+	GSearchWindow * gsearch = user_data;
+	GConfValue * value;
+
+	value = gconf_entry_get_value (entry);
+
+	g_return_if_fail (value->type == GCONF_VALUE_BOOL);
+
+	set_search_statistics_visible (gsearch, gconf_value_get_bool (value));
+}
+
 void
 columns_changed_cb (GtkTreeView * treeview,
                     gpointer user_data)
@@ -1885,6 +1916,18 @@ columns_changed_cb (GtkTreeView * treeview,
 	g_slist_free (order);
 }
 
+gboolean
+disk_usage_test_expand_row_cb (GtkTreeView * treeview,
+                               GtkTreeIter * iter,
+                               GtkTreePath * path,
+                               gpointer data)
+{
+	GSearchWindow * gsearch = data;
+
+	add_disk_usage_folders (gsearch, iter);
+	return FALSE;
+}
+
 gboolean
 window_state_event_cb (GtkWidget * widget,
                        GdkEventWindowState * event,
@@ -83,6 +83,9 @@ void
 name_contains_activate_cb (GtkWidget * widget,
                            gpointer data);
 void
+name_contains_changed_cb (GtkWidget * widget,
+                          gpointer data);
+void
 look_in_folder_changed_cb (GtkWidget * widget,
                            gpointer data);
 void
@@ -97,8 +100,8 @@ open_folder_cb (GtkAction * action,
                 gpointer data);
 void
 file_changed_cb (GFileMonitor * handle,
-                 const gchar * monitor_uri,
-                 const gchar * info_uri,
+                 GFile * file,
+                 GFile * other_file,
                  GFileMonitorEvent event_type,
                  gpointer data);
 void
@@ -155,6 +158,13 @@ file_leave_notify_cb (GtkWidget *widget,
                       GdkEventCrossing *event,
                       gpointer user_data);
 gboolean
+file_query_tooltip_cb (GtkWidget * widget,
+                       gint x,
+                       gint y,
+                       gboolean keyboard_mode,
+                       GtkTooltip * tooltip,
+                       gpointer data);
+gboolean
 not_running_timeout_cb (gpointer data);
 
 void
@@ -167,9 +177,19 @@ single_click_to_activate_key_changed_cb (GConfClient * client,
                                          GConfEntry * entry,
                                          gpointer user_data);
 void
+show_search_statistics_key_changed_cb (GConfClient * client,
+                                       guint cnxn_id,
+                                       GConfEntry * entry,
+                                       gpointer user_data);
+void
 columns_changed_cb (GtkTreeView * treeview,
                     gpointer user_data);
 gboolean
+disk_usage_test_expand_row_cb (GtkTreeView * treeview,
+                               GtkTreeIter * iter,
+                               GtkTreePath * path,
+                               gpointer data);
+gboolean
 window_state_event_cb (GtkWidget * widget,
                        GdkEventWindowState * event,
                        gpointer data);
@@ -0,0 +1,749 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-content.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Looks for several patterns at once in the contents of files.
+ *
+ * The patterns are compiled into an Aho-Corasick automaton, kept as a
+ * full transition table so each byte of a file costs one lookup however
+ * many patterns there are.  Like grep -i, the matching ignores the case
+ * of ASCII letters, and like grep -I, a file with a NUL byte in its first
+ * block is taken to be binary and never matches.
+ *
+ * Some patterns are required and the others are alternatives: a file
+ * matches when it has all the required ones and, if there are any
+ * alternatives, at least one of them.  A file is read to the end, or
+ * until all of the patterns are found, so the hits say every pattern the
+ * file has.
+ *
+ * With GSEARCH_CONTENT_DECOMPRESS, compressed files and archives are
+ * read through gsearchtool-decompress.c.  The hits of an archive are
+ * those of all its members, a binary member is left out on its own, and
+ * with GSEARCH_CONTENT_MEMBER_NAMES the names of the members are matched
+ * too.
+ *
+ * The scanner queues the files by the device they are on, and reads as
+ * many of them at once on each device as gsearchtool-device.c says it
+ * takes: several on a solid state disk, one on a spinning one, in the
+ * order of their inode numbers when they are known.  Each thread takes
+ * the files of its device a batch at a time, opened and read into
+ * through gsearchtool-io.c.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include "gsearchtool-content.h"
+#include "gsearchtool-decompress.h"
+#include "gsearchtool-device.h"
+#include "gsearchtool-io.h"
+
+#define GSEARCH_CONTENT_READ_SIZE 65536
+#define GSEARCH_CONTENT_BATCH_SIZE 16
+#define GSEARCH_CONTENT_NO_STATE G_MAXUINT32
+
+struct _GSearchContentPatterns {
+	GPtrArray             * patterns;
+	guint64                 required_mask;
+	guint64                 alternative_mask;
+	GSearchContentFlags     flags;
+
+	/* The automaton, built on the first scan. */
+	guint32               * delta;
+	guint64               * output;
+	guint                   n_states;
+};
+
+typedef struct {
+	gchar                 * path;
+	gint64                  size;
+	gint64                  mtime;
+	guint64                 inode;
+} GSearchContentJob;
+
+/* A file being scanned, member by member if it is an archive. */
+typedef struct {
+	GSearchContentPatterns * patterns;
+	guint64                 hits;
+	guint64                 all_mask;
+	guint32                 state;
+	gboolean                has_members;
+	gboolean                is_first_block;
+	gboolean                is_binary;
+} GSearchContentScan;
+
+typedef struct _GSearchContentDevice GSearchContentDevice;
+
+struct _GSearchContentScanner {
+	GSearchContentPatterns * patterns;
+	GThreadPool           * pool;
+	guint                   threads;
+
+	/* Only used by the thread pushing the files. */
+	GHashTable            * devices;
+	GHashTable            * folder_devices;
+
+	/* The lock guards everything below, and the fields of the devices. */
+	GMutex                  lock;
+	GQueue                  matches;
+	guint                   pending;
+	guint64                 bytes_read;
+	gboolean                is_cancelled;
+};
+
+/* The files waiting on a device, read by up to limit threads at once. */
+struct _GSearchContentDevice {
+	GSearchDeviceQueue    * jobs;
+	guint                   active;
+	guint                   limit;
+};
+
+GSearchContentPatterns *
+gsearchtool_content_patterns_new (void)
+{
+	GSearchContentPatterns * patterns;
+
+	patterns = g_slice_new0 (GSearchContentPatterns);
+	patterns->patterns = g_ptr_array_new_with_free_func (g_free);
+
+	return patterns;
+}
+
+void
+gsearchtool_content_patterns_free (GSearchContentPatterns * patterns)
+{
+	if (patterns == NULL) {
+		return;
+	}
+	g_ptr_array_free (patterns->patterns, TRUE);
+	g_free (patterns->delta);
+	g_free (patterns->output);
+	g_slice_free (GSearchContentPatterns, patterns);
+}
+
+/* Returns FALSE if the pattern is empty or there are too many already.
+   Patterns can only be added before the first scan. */
+gboolean
+gsearchtool_content_patterns_add (GSearchContentPatterns * patterns,
+                                  const gchar * pattern,
+                                  gboolean is_required)
+{
+	guint64 bit;
+
+	g_return_val_if_fail (patterns->delta == NULL, FALSE);
+
+	if (pattern == NULL || *pattern == '\0' ||
+	    patterns->patterns->len == GSEARCH_CONTENT_MAX_PATTERNS) {
+		return FALSE;
+	}
+
+	bit = G_GUINT64_CONSTANT (1) << patterns->patterns->len;
+	if (is_required == TRUE) {
+		patterns->required_mask |= bit;
+	}
+	else {
+		patterns->alternative_mask |= bit;
+	}
+	g_ptr_array_add (patterns->patterns, g_ascii_strdown (pattern, -1));
+
+	return TRUE;
+}
+
+/* The flags can only be set before the first scan. */
+void
+gsearchtool_content_patterns_set_flags (GSearchContentPatterns * patterns,
+                                        GSearchContentFlags flags)
+{
+	g_return_if_fail (patterns->delta == NULL);
+
+	patterns->flags = flags;
+}
+
+guint
+gsearchtool_content_patterns_get_length (GSearchContentPatterns * patterns)
+{
+	return patterns->patterns->len;
+}
+
+gboolean
+gsearchtool_content_patterns_is_match (GSearchContentPatterns * patterns,
+                                       guint64 hits)
+{
+	if ((hits & patterns->required_mask) != patterns->required_mask) {
+		return FALSE;
+	}
+	return (patterns->alternative_mask == 0) || ((hits & patterns->alternative_mask) != 0);
+}
+
+/* Returns the patterns in @hits, as they were added but in lower case,
+   separated by commas. */
+gchar *
+gsearchtool_content_patterns_get_hits_string (GSearchContentPatterns * patterns,
+                                              guint64 hits)
+{
+	GString * string;
+	guint idx;
+
+	string = g_string_new (NULL);
+	for (idx = 0; idx < patterns->patterns->len; idx++) {
+		if (hits & (G_GUINT64_CONSTANT (1) << idx)) {
+			if (string->len > 0) {
+				g_string_append (string, ", ");
+			}
+			g_string_append (string, g_ptr_array_index (patterns->patterns, idx));
+		}
+	}
+	return g_string_free (string, FALSE);
+}
+
+static void
+build_automaton (GSearchContentPatterns * patterns)
+{
+	guint32 * fail;
+	guint32 * queue;
+	guint max_states = 1;
+	guint head = 0;
+	guint tail = 0;
+	guint idx;
+	guint c;
+
+	for (idx = 0; idx < patterns->patterns->len; idx++) {
+		max_states += strlen (g_ptr_array_index (patterns->patterns, idx));
+	}
+	patterns->delta = g_new (guint32, max_states * 256);
+	patterns->output = g_new0 (guint64, max_states);
+	memset (patterns->delta, 0xff, max_states * 256 * sizeof (guint32));
+	patterns->n_states = 1;
+
+	/* The trie of the patterns. */
+	for (idx = 0; idx < patterns->patterns->len; idx++) {
+		const guchar * pattern = g_ptr_array_index (patterns->patterns, idx);
+		guint32 state = 0;
+
+		for (; *pattern != '\0'; pattern++) {
+			guint32 * next = &patterns->delta[state * 256 + *pattern];
+
+			if (*next == GSEARCH_CONTENT_NO_STATE) {
+				*next = patterns->n_states++;
+			}
+			state = *next;
+		}
+		patterns->output[state] |= G_GUINT64_CONSTANT (1) << idx;
+	}
+
+	/* The failure links, breadth first, turn the trie into a full
+	   transition table. */
+	fail = g_new0 (guint32, patterns->n_states);
+	queue = g_new (guint32, patterns->n_states);
+	for (c = 0; c < 256; c++) {
+		guint32 * next = &patterns->delta[c];
+
+		if (*next == GSEARCH_CONTENT_NO_STATE) {
+			*next = 0;
+		}
+		else {
+			fail[*next] = 0;
+			queue[tail++] = *next;
+		}
+	}
+	while (head < tail) {
+		guint32 state = queue[head++];
+
+		patterns->output[state] |= patterns->output[fail[state]];
+		for (c = 0; c < 256; c++) {
+			guint32 * next = &patterns->delta[state * 256 + c];
+			guint32 fallback = patterns->delta[fail[state] * 256 + c];
+
+			if (*next == GSEARCH_CONTENT_NO_STATE) {
+				*next = fallback;
+			}
+			else {
+				fail[*next] = fallback;
+				queue[tail++] = *next;
+			}
+		}
+	}
+	g_free (fail);
+	g_free (queue);
+
+	/* The patterns are in lower case, an upper case letter moves the
+	   automaton the same way. */
+	for (idx = 0; idx < patterns->n_states; idx++) {
+		for (c = 'A'; c <= 'Z'; c++) {
+			patterns->delta[idx * 256 + c] = patterns->delta[idx * 256 + g_ascii_tolower (c)];
+		}
+	}
+}
+
+static guint32
+scan_buffer (GSearchContentPatterns * patterns,
+             guint32 state,
+             const guchar * buffer,
+             gsize length,
+             guint64 * hits)
+{
+	const guint32 * delta = patterns->delta;
+	const guint64 * output = patterns->output;
+	guint64 found = *hits;
+	gsize idx;
+
+	for (idx = 0; idx < length; idx++) {
+		state = delta[state * 256 + buffer[idx]];
+		found |= output[state];
+	}
+	*hits = found;
+
+	return state;
+}
+
+static guint64
+get_all_mask (GSearchContentPatterns * patterns)
+{
+	return patterns->required_mask | patterns->alternative_mask;
+}
+
+guint64
+gsearchtool_content_patterns_scan (GSearchContentPatterns * patterns,
+                                   const gchar * buffer,
+                                   gsize length)
+{
+	guint64 hits = 0;
+
+	if (patterns->delta == NULL) {
+		build_automaton (patterns);
+	}
+	scan_buffer (patterns, 0, (const guchar *) buffer, length, &hits);
+
+	return hits;
+}
+
+/* Takes the contents of a file, or of the members of an archive, see
+   GSearchDecompressFunc. */
+static gboolean
+scan_member (const gchar * member,
+             const guchar * buffer,
+             gsize length,
+             gpointer data)
+{
+	GSearchContentScan * scan = data;
+
+	if (member != NULL) {
+		scan->has_members = TRUE;
+		scan->state = 0;
+		scan->is_first_block = TRUE;
+		scan->is_binary = FALSE;
+		if (scan->patterns->flags & GSEARCH_CONTENT_MEMBER_NAMES) {
+			scan_buffer (scan->patterns, 0, (const guchar *) member, strlen (member), &scan->hits);
+		}
+		return scan->hits != scan->all_mask;
+	}
+
+	if (scan->is_first_block == TRUE) {
+		scan->is_first_block = FALSE;
+		scan->is_binary = (memchr (buffer, '\0', length) != NULL);
+	}
+	if (scan->is_binary == TRUE) {
+		/* The other members of an archive can still match. */
+		return scan->has_members;
+	}
+	scan->state = scan_buffer (scan->patterns, scan->state, buffer, length, &scan->hits);
+
+	return scan->hits != scan->all_mask;
+}
+
+/* Scans a file opened on @fd, of which the first @count bytes are read
+   into @buffer, a GSEARCH_CONTENT_READ_SIZE one the rest is read into. */
+static guint64
+scan_fd (GSearchContentPatterns * patterns,
+         gint fd,
+         guchar * buffer,
+         gssize count,
+         guint64 * bytes_read)
+{
+	GSearchContentScan scan;
+	GSearchDecompressFormat format = GSEARCH_DECOMPRESS_NONE;
+
+	memset (&scan, 0, sizeof (scan));
+	scan.patterns = patterns;
+	scan.all_mask = get_all_mask (patterns);
+	scan.is_first_block = TRUE;
+
+	if (count > 0 && bytes_read != NULL) {
+		*bytes_read += count;
+	}
+	if (count > 0 && (patterns->flags & GSEARCH_CONTENT_DECOMPRESS)) {
+		format = gsearchtool_decompress_get_format (buffer, count);
+	}
+
+	if (format != GSEARCH_DECOMPRESS_NONE) {
+		gsearchtool_decompress_fd (fd, format, buffer, count, scan_member, &scan, bytes_read);
+	}
+	else {
+		while (count > 0 && scan_member (NULL, buffer, count, &scan) == TRUE) {
+			count = read (fd, buffer, GSEARCH_CONTENT_READ_SIZE);
+			if (count > 0 && bytes_read != NULL) {
+				*bytes_read += count;
+			}
+		}
+	}
+
+	return scan.hits;
+}
+
+/* Returns the patterns found in the file at @path, none if it cannot be
+   read or is binary. */
+guint64
+gsearchtool_content_patterns_scan_file (GSearchContentPatterns * patterns,
+                                        const gchar * path,
+                                        guint64 * bytes_read)
+{
+	guchar * buffer;
+	guint64 hits;
+	gssize count;
+	gint fd;
+
+	if (patterns->delta == NULL) {
+		build_automaton (patterns);
+	}
+
+	fd = g_open (path, O_RDONLY, 0);
+	if (fd < 0) {
+		return 0;
+	}
+
+	buffer = g_malloc (GSEARCH_CONTENT_READ_SIZE);
+	count = read (fd, buffer, GSEARCH_CONTENT_READ_SIZE);
+	hits = scan_fd (patterns, fd, buffer, count, bytes_read);
+	g_free (buffer);
+	close (fd);
+
+	return hits;
+}
+
+static void
+free_job (GSearchContentJob * job)
+{
+	g_free (job->path);
+	g_slice_free (GSearchContentJob, job);
+}
+
+static void
+finish_job (GSearchContentScanner * scanner,
+            GSearchContentJob * job,
+            guint64 hits,
+            guint64 bytes_read)
+{
+	GSearchContentMatch * match = NULL;
+
+	if (gsearchtool_content_patterns_is_match (scanner->patterns, hits) == TRUE) {
+		match = g_slice_new (GSearchContentMatch);
+		match->path = job->path;
+		match->size = job->size;
+		match->mtime = job->mtime;
+		match->inode = job->inode;
+		match->hits = hits;
+		job->path = NULL;
+	}
+
+	g_mutex_lock (&scanner->lock);
+	if (match != NULL) {
+		g_queue_push_tail (&scanner->matches, match);
+	}
+	scanner->bytes_read += bytes_read;
+	scanner->pending--;
+	g_mutex_unlock (&scanner->lock);
+
+	free_job (job);
+}
+
+/* Opens and reads the start of the files of @jobs all at once, which
+   io_uring does as a few batches instead of three calls a file. */
+static void
+scan_file_jobs (GSearchContentJob ** jobs,
+                guint n_jobs,
+                guchar * buffers,
+                GSearchContentScanner * scanner)
+{
+	const gchar * paths[GSEARCH_CONTENT_BATCH_SIZE];
+	GSearchIoHead heads[GSEARCH_CONTENT_BATCH_SIZE];
+	gboolean is_cancelled;
+	guint i;
+
+	g_mutex_lock (&scanner->lock);
+	is_cancelled = scanner->is_cancelled;
+	g_mutex_unlock (&scanner->lock);
+
+	if (is_cancelled == TRUE) {
+		for (i = 0; i < n_jobs; i++) {
+			finish_job (scanner, jobs[i], 0, 0);
+		}
+		return;
+	}
+
+	if (n_jobs == 1 || buffers == NULL) {
+		for (i = 0; i < n_jobs; i++) {
+			guint64 bytes_read = 0;
+			guint64 hits;
+
+			hits = gsearchtool_content_patterns_scan_file (scanner->patterns, jobs[i]->path, &bytes_read);
+			finish_job (scanner, jobs[i], hits, bytes_read);
+		}
+		return;
+	}
+
+	for (i = 0; i < n_jobs; i++) {
+		paths[i] = jobs[i]->path;
+		heads[i].head = buffers + i * GSEARCH_CONTENT_READ_SIZE;
+	}
+	gsearchtool_io_open_files (paths, n_jobs, heads, GSEARCH_CONTENT_READ_SIZE);
+
+	for (i = 0; i < n_jobs; i++) {
+		guint64 bytes_read = 0;
+		guint64 hits = 0;
+
+		if (heads[i].fd >= 0) {
+			hits = scan_fd (scanner->patterns, heads[i].fd, heads[i].head, heads[i].length, &bytes_read);
+		}
+		finish_job (scanner, jobs[i], hits, bytes_read);
+	}
+	gsearchtool_io_close_files (heads, n_jobs);
+}
+
+/* Run on the threads of the pool, one call per thread a device has. */
+static void
+scan_device_jobs (GSearchContentDevice * device,
+                  GSearchContentScanner * scanner)
+{
+	guchar * buffers = NULL;
+
+	if (gsearchtool_io_has_uring () == TRUE) {
+		buffers = g_malloc (GSEARCH_CONTENT_BATCH_SIZE * GSEARCH_CONTENT_READ_SIZE);
+	}
+
+	while (TRUE) {
+		GSearchContentJob * jobs[GSEARCH_CONTENT_BATCH_SIZE];
+		guint n_jobs = 0;
+
+		g_mutex_lock (&scanner->lock);
+		while (n_jobs < GSEARCH_CONTENT_BATCH_SIZE &&
+		       (jobs[n_jobs] = gsearchtool_device_queue_pop (device->jobs)) != NULL) {
+			n_jobs++;
+		}
+		if (n_jobs == 0) {
+			device->active--;
+		}
+		g_mutex_unlock (&scanner->lock);
+
+		if (n_jobs == 0) {
+			break;
+		}
+		scan_file_jobs (jobs, n_jobs, buffers, scanner);
+	}
+	g_free (buffers);
+}
+
+static void
+free_device (GSearchContentDevice * device)
+{
+	gsearchtool_device_queue_free (device->jobs, (GDestroyNotify) free_job);
+	g_slice_free (GSearchContentDevice, device);
+}
+
+/* The files of a folder are taken to be on the device of the folder. */
+static GSearchContentDevice *
+get_device (GSearchContentScanner * scanner,
+            const gchar * path)
+{
+	GSearchContentDevice * device;
+	gint64 * number;
+	gchar * folder;
+
+	folder = g_path_get_dirname (path);
+	number = g_hash_table_lookup (scanner->folder_devices, folder);
+	if (number == NULL) {
+		GStatBuf file_stat;
+
+		number = g_new0 (gint64, 1);
+		if (g_stat (folder, &file_stat) == 0) {
+			*number = file_stat.st_dev;
+		}
+		g_hash_table_insert (scanner->folder_devices, folder, number);
+	}
+	else {
+		g_free (folder);
+	}
+
+	device = g_hash_table_lookup (scanner->devices, number);
+	if (device == NULL) {
+		GSearchDeviceKind kind = gsearchtool_device_get_kind (*number);
+
+		device = g_slice_new0 (GSearchContentDevice);
+		device->jobs = gsearchtool_device_queue_new (gsearchtool_device_is_inode_ordered (kind));
+		device->limit = gsearchtool_device_get_concurrency (kind);
+		if (scanner->threads > 0) {
+			device->limit = MIN (device->limit, scanner->threads);
+		}
+		g_hash_table_insert (scanner->devices, number, device);
+	}
+	return device;
+}
+
+/* Takes @patterns over.  @threads caps the number of files read at once
+   on each device, 0 to leave it to the kind of the device. */
+GSearchContentScanner *
+gsearchtool_content_scanner_new (GSearchContentPatterns * patterns,
+                                 guint threads)
+{
+	GSearchContentScanner * scanner;
+
+	/* Built once here, before the threads share it. */
+	if (patterns->delta == NULL) {
+		build_automaton (patterns);
+	}
+
+	scanner = g_slice_new0 (GSearchContentScanner);
+	scanner->patterns = patterns;
+	scanner->threads = threads;
+	scanner->pool = g_thread_pool_new ((GFunc) scan_device_jobs, scanner, -1, FALSE, NULL);
+	scanner->devices = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, (GDestroyNotify) free_device);
+	scanner->folder_devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	g_mutex_init (&scanner->lock);
+	g_queue_init (&scanner->matches);
+
+	return scanner;
+}
+
+/* Stops the scan, waiting for the files being read. */
+void
+gsearchtool_content_scanner_free (GSearchContentScanner * scanner)
+{
+	if (scanner == NULL) {
+		return;
+	}
+
+	g_mutex_lock (&scanner->lock);
+	scanner->is_cancelled = TRUE;
+	g_mutex_unlock (&scanner->lock);
+
+	g_thread_pool_free (scanner->pool, FALSE, TRUE);
+	g_hash_table_destroy (scanner->devices);
+	g_hash_table_destroy (scanner->folder_devices);
+
+	g_queue_foreach (&scanner->matches, (GFunc) gsearchtool_content_match_free, NULL);
+	g_queue_clear (&scanner->matches);
+	g_mutex_clear (&scanner->lock);
+	gsearchtool_content_patterns_free (scanner->patterns);
+	g_slice_free (GSearchContentScanner, scanner);
+}
+
+void
+gsearchtool_content_scanner_push (GSearchContentScanner * scanner,
+                                  const gchar * path,
+                                  gint64 size,
+                                  gint64 mtime,
+                                  guint64 inode)
+{
+	GSearchContentDevice * device;
+	GSearchContentJob * job;
+	gboolean is_starting = FALSE;
+
+	job = g_slice_new (GSearchContentJob);
+	job->path = g_strdup (path);
+	job->size = size;
+	job->mtime = mtime;
+	job->inode = inode;
+	device = get_device (scanner, path);
+
+	g_mutex_lock (&scanner->lock);
+	scanner->pending++;
+	gsearchtool_device_queue_push (device->jobs, job, inode);
+	if (device->active < device->limit) {
+		device->active++;
+		is_starting = TRUE;
+	}
+	g_mutex_unlock (&scanner->lock);
+
+	if (is_starting == TRUE) {
+		g_thread_pool_push (scanner->pool, device, NULL);
+	}
+}
+
+/* Returns the next file found to match, or NULL if there is none yet. */
+GSearchContentMatch *
+gsearchtool_content_scanner_pop (GSearchContentScanner * scanner)
+{
+	GSearchContentMatch * match;
+
+	g_mutex_lock (&scanner->lock);
+	match = g_queue_pop_head (&scanner->matches);
+	g_mutex_unlock (&scanner->lock);
+
+	return match;
+}
+
+/* Once this returns TRUE, the matches still queued are all there is for
+   the files pushed so far. */
+gboolean
+gsearchtool_content_scanner_is_idle (GSearchContentScanner * scanner)
+{
+	gboolean is_idle;
+
+	g_mutex_lock (&scanner->lock);
+	is_idle = (scanner->pending == 0);
+	g_mutex_unlock (&scanner->lock);
+
+	return is_idle;
+}
+
+GSearchContentPatterns *
+gsearchtool_content_scanner_get_patterns (GSearchContentScanner * scanner)
+{
+	return scanner->patterns;
+}
+
+guint64
+gsearchtool_content_scanner_get_bytes_read (GSearchContentScanner * scanner)
+{
+	guint64 bytes_read;
+
+	g_mutex_lock (&scanner->lock);
+	bytes_read = scanner->bytes_read;
+	g_mutex_unlock (&scanner->lock);
+
+	return bytes_read;
+}
+
+void
+gsearchtool_content_match_free (GSearchContentMatch * match)
+{
+	g_free (match->path);
+	g_slice_free (GSearchContentMatch, match);
+}
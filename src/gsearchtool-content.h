@@ -0,0 +1,118 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-content.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_CONTENT_H_
+#define _GSEARCHTOOL_CONTENT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+/* The hits of a file are a bit mask, one bit per pattern. */
+#define GSEARCH_CONTENT_MAX_PATTERNS 64
+
+typedef enum {
+	GSEARCH_CONTENT_DECOMPRESS = 1 << 0,
+	GSEARCH_CONTENT_MEMBER_NAMES = 1 << 1
+} GSearchContentFlags;
+
+typedef struct _GSearchContentPatterns GSearchContentPatterns;
+typedef struct _GSearchContentScanner GSearchContentScanner;
+typedef struct _GSearchContentMatch GSearchContentMatch;
+
+/* A file that matched, with the size, date and inode it was pushed with. */
+struct _GSearchContentMatch {
+	gchar                 * path;
+	gint64                  size;
+	gint64                  mtime;
+	guint64                 inode;
+	guint64                 hits;
+};
+
+GSearchContentPatterns *
+gsearchtool_content_patterns_new (void);
+
+void
+gsearchtool_content_patterns_free (GSearchContentPatterns * patterns);
+
+gboolean
+gsearchtool_content_patterns_add (GSearchContentPatterns * patterns,
+                                  const gchar * pattern,
+                                  gboolean is_required);
+void
+gsearchtool_content_patterns_set_flags (GSearchContentPatterns * patterns,
+                                        GSearchContentFlags flags);
+guint
+gsearchtool_content_patterns_get_length (GSearchContentPatterns * patterns);
+
+gboolean
+gsearchtool_content_patterns_is_match (GSearchContentPatterns * patterns,
+                                       guint64 hits);
+gchar *
+gsearchtool_content_patterns_get_hits_string (GSearchContentPatterns * patterns,
+                                              guint64 hits);
+guint64
+gsearchtool_content_patterns_scan (GSearchContentPatterns * patterns,
+                                   const gchar * buffer,
+                                   gsize length);
+guint64
+gsearchtool_content_patterns_scan_file (GSearchContentPatterns * patterns,
+                                        const gchar * path,
+                                        guint64 * bytes_read);
+
+GSearchContentScanner *
+gsearchtool_content_scanner_new (GSearchContentPatterns * patterns,
+                                 guint threads);
+void
+gsearchtool_content_scanner_free (GSearchContentScanner * scanner);
+
+void
+gsearchtool_content_scanner_push (GSearchContentScanner * scanner,
+                                  const gchar * path,
+                                  gint64 size,
+                                  gint64 mtime,
+                                  guint64 inode);
+GSearchContentMatch *
+gsearchtool_content_scanner_pop (GSearchContentScanner * scanner);
+
+gboolean
+gsearchtool_content_scanner_is_idle (GSearchContentScanner * scanner);
+
+GSearchContentPatterns *
+gsearchtool_content_scanner_get_patterns (GSearchContentScanner * scanner);
+
+guint64
+gsearchtool_content_scanner_get_bytes_read (GSearchContentScanner * scanner);
+
+void
+gsearchtool_content_match_free (GSearchContentMatch * match);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_CONTENT_H_ */
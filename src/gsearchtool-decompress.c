@@ -0,0 +1,743 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-decompress.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Streams the contents of compressed files and archives, without
+ * temporary files.
+ *
+ * gzip, xz and zstd files are decompressed as they are read, with zlib,
+ * liblzma and libzstd when they were found at build time.  A tar archive,
+ * compressed or not, is walked member by member.  The members of a zip
+ * archive are found from its central directory, and the stored and
+ * deflated ones are read.  Archives inside archives are not opened.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#  include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif
+
+#include "gsearchtool-decompress.h"
+
+#define GSEARCH_DECOMPRESS_READ_SIZE 65536
+#define GSEARCH_DECOMPRESS_XZ_MEMORY_LIMIT (G_GUINT64_CONSTANT (256) << 20)
+
+#define TAR_BLOCK_SIZE 512
+
+#define ZIP_LOCAL_SIGNATURE 0x04034b50
+#define ZIP_CENTRAL_SIGNATURE 0x02014b50
+#define ZIP_END_SIGNATURE 0x06054b50
+#define ZIP_LOCAL_SIZE 30
+#define ZIP_CENTRAL_SIZE 46
+#define ZIP_END_SIZE 22
+#define ZIP_MAX_COMMENT_SIZE 65535
+
+typedef enum {
+	TAR_UNKNOWN,
+	TAR_NONE,
+	TAR_HEADER,
+	TAR_MEMBER,
+	TAR_END
+} GSearchDecompressTarState;
+
+/* The compressed bytes of a file, or of a member of a zip archive. */
+typedef struct {
+	gint                    fd;
+	const guchar          * head;
+	gsize                   head_length;
+	guchar                * buffer;
+	guint64                 left;
+	guint64               * bytes_read;
+} GSearchDecompressReader;
+
+/* Where the decompressed bytes go, through the tar walker unless the
+   file is a zip archive. */
+typedef struct {
+	GSearchDecompressFunc   func;
+	gpointer                data;
+	gboolean                is_stopped;
+
+	GSearchDecompressTarState tar_state;
+	guchar                  header[TAR_BLOCK_SIZE];
+	gsize                   header_length;
+	guint64                 member_left;
+	guint64                 padding_left;
+	gboolean                is_member_data;
+	GString               * long_name;
+	gboolean                is_long_name_data;
+} GSearchDecompressSink;
+
+/* Returns the next bytes of the file in @data, 0 at its end or -1 if it
+   cannot be read. */
+static gssize
+reader_read (GSearchDecompressReader * reader,
+             const guchar ** data)
+{
+	gssize count;
+
+	if (reader->head_length > 0) {
+		*data = reader->head;
+		count = reader->head_length;
+		reader->head_length = 0;
+		return count;
+	}
+	if (reader->left == 0) {
+		return 0;
+	}
+
+	count = read (reader->fd, reader->buffer, MIN (reader->left, GSEARCH_DECOMPRESS_READ_SIZE));
+	if (count > 0) {
+		reader->left -= count;
+		if (reader->bytes_read != NULL) {
+			*reader->bytes_read += count;
+		}
+	}
+	*data = reader->buffer;
+
+	return count;
+}
+
+static void
+sink_call (GSearchDecompressSink * sink,
+           const gchar * member,
+           const guchar * buffer,
+           gsize length)
+{
+	if (sink->is_stopped == FALSE && sink->func (member, buffer, length, sink->data) == FALSE) {
+		sink->is_stopped = TRUE;
+	}
+}
+
+static guint64
+get_tar_number (const guchar * field,
+                gsize length)
+{
+	guint64 number = 0;
+	gsize idx = 0;
+
+	/* GNU tar writes the large sizes in base 256. */
+	if (field[0] & 0x80) {
+		number = field[0] & 0x7f;
+		for (idx = 1; idx < length; idx++) {
+			number = (number << 8) | field[idx];
+		}
+		return number;
+	}
+
+	while (idx < length && field[idx] == ' ') {
+		idx++;
+	}
+	for (; idx < length && field[idx] >= '0' && field[idx] <= '7'; idx++) {
+		number = (number << 3) | (field[idx] - '0');
+	}
+	return number;
+}
+
+static gboolean
+is_tar_header (const guchar * header)
+{
+	guint64 checksum = 0;
+	gint idx;
+
+	if (memcmp (header + 257, "ustar", 5) != 0) {
+		return FALSE;
+	}
+	for (idx = 0; idx < TAR_BLOCK_SIZE; idx++) {
+		checksum += (idx >= 148 && idx < 156) ? ' ' : header[idx];
+	}
+	return checksum == get_tar_number (header + 148, 8);
+}
+
+static void
+read_tar_header (GSearchDecompressSink * sink)
+{
+	const guchar * header = sink->header;
+	guint64 size;
+	gchar type;
+	gint idx;
+
+	for (idx = 0; idx < TAR_BLOCK_SIZE && header[idx] == '\0'; idx++);
+	if (idx == TAR_BLOCK_SIZE || is_tar_header (header) == FALSE) {
+		sink->tar_state = TAR_END;
+		return;
+	}
+
+	size = get_tar_number (header + 124, 12);
+	type = header[156];
+	sink->member_left = size;
+	sink->padding_left = (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+	sink->is_member_data = FALSE;
+	sink->is_long_name_data = FALSE;
+
+	if (type == 'L') {
+		/* A GNU long name, for the member that follows. */
+		if (sink->long_name == NULL) {
+			sink->long_name = g_string_new (NULL);
+		}
+		g_string_truncate (sink->long_name, 0);
+		sink->is_long_name_data = TRUE;
+	}
+	else if (type == '0' || type == '\0' || type == '7') {
+		gchar * name;
+
+		if (sink->long_name != NULL && sink->long_name->len > 0) {
+			name = g_strdup (sink->long_name->str);
+			g_string_truncate (sink->long_name, 0);
+		}
+		else if (header[345] != '\0') {
+			gchar * prefix = g_strndup ((const gchar *) header + 345, 155);
+			gchar * base = g_strndup ((const gchar *) header, 100);
+
+			name = g_strconcat (prefix, "/", base, NULL);
+			g_free (prefix);
+			g_free (base);
+		}
+		else {
+			name = g_strndup ((const gchar *) header, 100);
+		}
+		sink_call (sink, name, NULL, 0);
+		sink->is_member_data = TRUE;
+		g_free (name);
+	}
+
+	sink->tar_state = (size > 0) ? TAR_MEMBER : TAR_HEADER;
+}
+
+/* Returns FALSE once the sink wants no more. */
+static gboolean
+sink_write (GSearchDecompressSink * sink,
+            const guchar * buffer,
+            gsize length)
+{
+	while (length > 0 && sink->is_stopped == FALSE) {
+		gsize count;
+
+		switch (sink->tar_state) {
+		case TAR_UNKNOWN:
+		case TAR_HEADER:
+			count = MIN (TAR_BLOCK_SIZE - sink->header_length, length);
+			memcpy (sink->header + sink->header_length, buffer, count);
+			sink->header_length += count;
+			if (sink->header_length < TAR_BLOCK_SIZE) {
+				break;
+			}
+			sink->header_length = 0;
+			if (sink->tar_state == TAR_UNKNOWN && is_tar_header (sink->header) == FALSE) {
+				sink->tar_state = TAR_NONE;
+				sink_call (sink, NULL, sink->header, TAR_BLOCK_SIZE);
+				break;
+			}
+			read_tar_header (sink);
+			break;
+		case TAR_MEMBER:
+			if (sink->member_left > 0) {
+				count = MIN (sink->member_left, length);
+				if (sink->is_long_name_data == TRUE) {
+					g_string_append_len (sink->long_name, (const gchar *) buffer, count);
+				}
+				else if (sink->is_member_data == TRUE) {
+					sink_call (sink, NULL, buffer, count);
+				}
+				sink->member_left -= count;
+			}
+			else {
+				count = MIN (sink->padding_left, length);
+				sink->padding_left -= count;
+			}
+			if (sink->member_left == 0 && sink->padding_left == 0) {
+				sink->tar_state = TAR_HEADER;
+			}
+			break;
+		case TAR_END:
+			count = length;
+			break;
+		case TAR_NONE:
+		default:
+			count = length;
+			sink_call (sink, NULL, buffer, count);
+			break;
+		}
+		buffer += count;
+		length -= count;
+	}
+	return sink->is_stopped == FALSE;
+}
+
+static void
+sink_finish (GSearchDecompressSink * sink)
+{
+	/* Too short to tell, it was not a tar archive. */
+	if (sink->tar_state == TAR_UNKNOWN && sink->header_length > 0) {
+		sink_call (sink, NULL, sink->header, sink->header_length);
+	}
+	if (sink->long_name != NULL) {
+		g_string_free (sink->long_name, TRUE);
+	}
+}
+
+static gboolean
+copy_stream (GSearchDecompressReader * reader,
+             GSearchDecompressSink * sink)
+{
+	while (sink->is_stopped == FALSE) {
+		const guchar * data;
+		gssize count;
+
+		count = reader_read (reader, &data);
+		if (count <= 0) {
+			return count == 0;
+		}
+		sink_write (sink, data, count);
+	}
+	return TRUE;
+}
+
+#ifdef HAVE_ZLIB
+/* @window_bits is 15 + 16 for gzip, -15 for the raw deflate of zip. */
+static gboolean
+inflate_stream (GSearchDecompressReader * reader,
+                GSearchDecompressSink * sink,
+                gint window_bits)
+{
+	z_stream stream;
+	guchar * output;
+	gboolean is_flushed = TRUE;
+	gboolean is_ok = TRUE;
+
+	memset (&stream, 0, sizeof (stream));
+	if (inflateInit2 (&stream, window_bits) != Z_OK) {
+		return FALSE;
+	}
+
+	output = g_malloc (GSEARCH_DECOMPRESS_READ_SIZE);
+	while (sink->is_stopped == FALSE) {
+		gint status;
+
+		if (stream.avail_in == 0 && is_flushed == TRUE) {
+			const guchar * data;
+			gssize count;
+
+			count = reader_read (reader, &data);
+			if (count <= 0) {
+				is_ok = (count == 0);
+				break;
+			}
+			stream.next_in = (Bytef *) data;
+			stream.avail_in = count;
+		}
+
+		stream.next_out = output;
+		stream.avail_out = GSEARCH_DECOMPRESS_READ_SIZE;
+		status = inflate (&stream, Z_NO_FLUSH);
+		is_flushed = (stream.avail_out > 0);
+		sink_write (sink, output, GSEARCH_DECOMPRESS_READ_SIZE - stream.avail_out);
+
+		if (status == Z_STREAM_END) {
+			/* A gzip file can be several members one after the other. */
+			if (window_bits < 0) {
+				break;
+			}
+			inflateReset (&stream);
+		}
+		else if (status == Z_BUF_ERROR && stream.avail_in == 0) {
+			is_flushed = TRUE;
+		}
+		else if (status != Z_OK) {
+			is_ok = FALSE;
+			break;
+		}
+	}
+	inflateEnd (&stream);
+	g_free (output);
+
+	return is_ok;
+}
+#endif
+
+#ifdef HAVE_LZMA
+static gboolean
+unxz_stream (GSearchDecompressReader * reader,
+             GSearchDecompressSink * sink)
+{
+	lzma_stream stream = LZMA_STREAM_INIT;
+	lzma_action action = LZMA_RUN;
+	guchar * output;
+	gboolean is_ok = TRUE;
+
+	if (lzma_stream_decoder (&stream, GSEARCH_DECOMPRESS_XZ_MEMORY_LIMIT, LZMA_CONCATENATED) != LZMA_OK) {
+		return FALSE;
+	}
+
+	output = g_malloc (GSEARCH_DECOMPRESS_READ_SIZE);
+	while (sink->is_stopped == FALSE) {
+		lzma_ret status;
+
+		if (stream.avail_in == 0 && action == LZMA_RUN) {
+			const guchar * data;
+			gssize count;
+
+			count = reader_read (reader, &data);
+			if (count < 0) {
+				is_ok = FALSE;
+				break;
+			}
+			if (count == 0) {
+				action = LZMA_FINISH;
+			}
+			else {
+				stream.next_in = data;
+				stream.avail_in = count;
+			}
+		}
+
+		stream.next_out = output;
+		stream.avail_out = GSEARCH_DECOMPRESS_READ_SIZE;
+		status = lzma_code (&stream, action);
+		sink_write (sink, output, GSEARCH_DECOMPRESS_READ_SIZE - stream.avail_out);
+
+		if (status == LZMA_STREAM_END) {
+			break;
+		}
+		if (status != LZMA_OK) {
+			is_ok = FALSE;
+			break;
+		}
+	}
+	lzma_end (&stream);
+	g_free (output);
+
+	return is_ok;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static gboolean
+unzstd_stream (GSearchDecompressReader * reader,
+               GSearchDecompressSink * sink)
+{
+	ZSTD_DStream * stream;
+	ZSTD_inBuffer input = { NULL, 0, 0 };
+	guchar * output;
+	gboolean is_flushed = TRUE;
+	gboolean is_ok = TRUE;
+
+	stream = ZSTD_createDStream ();
+	if (stream == NULL) {
+		return FALSE;
+	}
+	ZSTD_initDStream (stream);
+
+	output = g_malloc (GSEARCH_DECOMPRESS_READ_SIZE);
+	while (sink->is_stopped == FALSE) {
+		ZSTD_outBuffer buffer = { output, GSEARCH_DECOMPRESS_READ_SIZE, 0 };
+		size_t status;
+
+		if (input.pos == input.size && is_flushed == TRUE) {
+			const guchar * data;
+			gssize count;
+
+			count = reader_read (reader, &data);
+			if (count <= 0) {
+				is_ok = (count == 0);
+				break;
+			}
+			input.src = data;
+			input.size = count;
+			input.pos = 0;
+		}
+
+		status = ZSTD_decompressStream (stream, &buffer, &input);
+		if (ZSTD_isError (status)) {
+			is_ok = FALSE;
+			break;
+		}
+		is_flushed = (buffer.pos < buffer.size);
+		sink_write (sink, output, buffer.pos);
+	}
+	ZSTD_freeDStream (stream);
+	g_free (output);
+
+	return is_ok;
+}
+#endif
+
+#ifdef HAVE_ZLIB
+static guint16
+get_le16 (const guchar * bytes)
+{
+	return bytes[0] | (bytes[1] << 8);
+}
+
+static guint32
+get_le32 (const guchar * bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((guint32) bytes[3] << 24);
+}
+
+static gboolean
+read_at (GSearchDecompressReader * reader,
+         guchar * buffer,
+         gsize length,
+         goffset offset)
+{
+	gssize count;
+
+	count = pread (reader->fd, buffer, length, offset);
+	if (count > 0 && reader->bytes_read != NULL) {
+		*reader->bytes_read += count;
+	}
+	return count == (gssize) length;
+}
+
+/* The archives larger than 4 GiB, with zip64 records, are not read. */
+static gboolean
+unzip_archive (GSearchDecompressReader * reader,
+               GSearchDecompressSink * sink)
+{
+	const guchar * end = NULL;
+	guchar * tail;
+	guchar * central = NULL;
+	goffset size;
+	gsize tail_length;
+	guint32 central_size;
+	guint32 central_offset;
+	guint16 entries;
+	guint16 entry;
+	gsize position = 0;
+	gssize idx;
+	gboolean is_ok = TRUE;
+
+	size = lseek (reader->fd, 0, SEEK_END);
+	if (size < ZIP_END_SIZE) {
+		return FALSE;
+	}
+
+	/* The end of central directory record, before a comment. */
+	tail_length = MIN (size, ZIP_END_SIZE + ZIP_MAX_COMMENT_SIZE);
+	tail = g_malloc (tail_length);
+	if (read_at (reader, tail, tail_length, size - tail_length) == TRUE) {
+		for (idx = tail_length - ZIP_END_SIZE; idx >= 0; idx--) {
+			if (get_le32 (tail + idx) == ZIP_END_SIGNATURE) {
+				end = tail + idx;
+				break;
+			}
+		}
+	}
+	if (end == NULL) {
+		g_free (tail);
+		return FALSE;
+	}
+	entries = get_le16 (end + 10);
+	central_size = get_le32 (end + 12);
+	central_offset = get_le32 (end + 16);
+	g_free (tail);
+
+	if ((goffset) central_offset + central_size > size) {
+		return FALSE;
+	}
+	central = g_malloc (central_size);
+	if (read_at (reader, central, central_size, central_offset) == FALSE) {
+		g_free (central);
+		return FALSE;
+	}
+
+	for (entry = 0; entry < entries && sink->is_stopped == FALSE; entry++) {
+		const guchar * record = central + position;
+		guint16 flags;
+		guint16 method;
+		guint32 compressed_size;
+		guint16 name_length;
+		guint32 local_offset;
+		gchar * name;
+
+		if (position + ZIP_CENTRAL_SIZE > central_size ||
+		    get_le32 (record) != ZIP_CENTRAL_SIGNATURE) {
+			is_ok = FALSE;
+			break;
+		}
+		flags = get_le16 (record + 8);
+		method = get_le16 (record + 10);
+		compressed_size = get_le32 (record + 20);
+		name_length = get_le16 (record + 28);
+		local_offset = get_le32 (record + 42);
+		position += ZIP_CENTRAL_SIZE + name_length + get_le16 (record + 30) + get_le16 (record + 32);
+		if (position > central_size) {
+			is_ok = FALSE;
+			break;
+		}
+
+		/* The folders have no contents. */
+		if (name_length == 0 || record[ZIP_CENTRAL_SIZE + name_length - 1] == '/') {
+			continue;
+		}
+		name = g_strndup ((const gchar *) record + ZIP_CENTRAL_SIZE, name_length);
+		sink_call (sink, name, NULL, 0);
+		g_free (name);
+
+		/* The encrypted members only have their names read. */
+		if ((flags & 1) == 0 && (method == 0 || method == Z_DEFLATED)) {
+			guchar local[ZIP_LOCAL_SIZE];
+			goffset data_offset;
+
+			if (read_at (reader, local, ZIP_LOCAL_SIZE, local_offset) == FALSE ||
+			    get_le32 (local) != ZIP_LOCAL_SIGNATURE) {
+				is_ok = FALSE;
+				break;
+			}
+			data_offset = (goffset) local_offset + ZIP_LOCAL_SIZE + get_le16 (local + 26) + get_le16 (local + 28);
+			if (lseek (reader->fd, data_offset, SEEK_SET) != data_offset) {
+				is_ok = FALSE;
+				break;
+			}
+			reader->head_length = 0;
+			reader->left = compressed_size;
+			if (method == 0) {
+				copy_stream (reader, sink);
+			}
+			else {
+				inflate_stream (reader, sink, -15);
+			}
+		}
+	}
+	g_free (central);
+
+	return is_ok;
+}
+#endif
+
+/* Returns the format of a file from its first bytes, or
+   GSEARCH_DECOMPRESS_NONE if it is not one that can be read. */
+GSearchDecompressFormat
+gsearchtool_decompress_get_format (const guchar * header,
+                                   gsize length)
+{
+#ifdef HAVE_ZLIB
+	static const guchar gzip_magic[] = { 0x1f, 0x8b };
+	static const guchar zip_magic[] = { 'P', 'K', 0x03, 0x04 };
+#endif
+#ifdef HAVE_LZMA
+	static const guchar xz_magic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+#endif
+#ifdef HAVE_ZSTD
+	static const guchar zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+#endif
+
+#ifdef HAVE_ZLIB
+	if (length >= sizeof (gzip_magic) && memcmp (header, gzip_magic, sizeof (gzip_magic)) == 0) {
+		return GSEARCH_DECOMPRESS_GZIP;
+	}
+	if (length >= sizeof (zip_magic) && memcmp (header, zip_magic, sizeof (zip_magic)) == 0) {
+		return GSEARCH_DECOMPRESS_ZIP;
+	}
+#endif
+#ifdef HAVE_LZMA
+	if (length >= sizeof (xz_magic) && memcmp (header, xz_magic, sizeof (xz_magic)) == 0) {
+		return GSEARCH_DECOMPRESS_XZ;
+	}
+#endif
+#ifdef HAVE_ZSTD
+	if (length >= sizeof (zstd_magic) && memcmp (header, zstd_magic, sizeof (zstd_magic)) == 0) {
+		return GSEARCH_DECOMPRESS_ZSTD;
+	}
+#endif
+	if (length >= TAR_BLOCK_SIZE && is_tar_header (header)) {
+		return GSEARCH_DECOMPRESS_TAR;
+	}
+	return GSEARCH_DECOMPRESS_NONE;
+}
+
+/* Passes the decompressed contents of the file open on @fd to @func.
+   @head is what the caller read from the start of the file already, the
+   rest is read from the current position of @fd.  Returns FALSE if the
+   file cannot be read to the end, what was read before is passed on. */
+gboolean
+gsearchtool_decompress_fd (gint fd,
+                           GSearchDecompressFormat format,
+                           const guchar * head,
+                           gsize head_length,
+                           GSearchDecompressFunc func,
+                           gpointer data,
+                           guint64 * bytes_read)
+{
+	GSearchDecompressReader reader;
+	GSearchDecompressSink sink;
+	gboolean is_ok;
+
+	memset (&reader, 0, sizeof (reader));
+	reader.fd = fd;
+	reader.head = head;
+	reader.head_length = head_length;
+	reader.buffer = g_malloc (GSEARCH_DECOMPRESS_READ_SIZE);
+	reader.left = G_MAXUINT64;
+	reader.bytes_read = bytes_read;
+
+	memset (&sink, 0, sizeof (sink));
+	sink.func = func;
+	sink.data = data;
+	sink.tar_state = (format == GSEARCH_DECOMPRESS_ZIP) ? TAR_NONE : TAR_UNKNOWN;
+
+	switch (format) {
+#ifdef HAVE_ZLIB
+	case GSEARCH_DECOMPRESS_GZIP:
+		is_ok = inflate_stream (&reader, &sink, 15 + 16);
+		break;
+	case GSEARCH_DECOMPRESS_ZIP:
+		is_ok = unzip_archive (&reader, &sink);
+		break;
+#endif
+#ifdef HAVE_LZMA
+	case GSEARCH_DECOMPRESS_XZ:
+		is_ok = unxz_stream (&reader, &sink);
+		break;
+#endif
+#ifdef HAVE_ZSTD
+	case GSEARCH_DECOMPRESS_ZSTD:
+		is_ok = unzstd_stream (&reader, &sink);
+		break;
+#endif
+	case GSEARCH_DECOMPRESS_TAR:
+		is_ok = copy_stream (&reader, &sink);
+		break;
+	default:
+		sink.tar_state = TAR_NONE;
+		is_ok = copy_stream (&reader, &sink);
+		break;
+	}
+	sink_finish (&sink);
+	g_free (reader.buffer);
+
+	return is_ok;
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-decompress.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_DECOMPRESS_H_
+#define _GSEARCHTOOL_DECOMPRESS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+/* The bytes gsearchtool_decompress_get_format() needs to see. */
+#define GSEARCH_DECOMPRESS_HEADER_SIZE 512
+
+typedef enum {
+	GSEARCH_DECOMPRESS_NONE,
+	GSEARCH_DECOMPRESS_GZIP,
+	GSEARCH_DECOMPRESS_XZ,
+	GSEARCH_DECOMPRESS_ZSTD,
+	GSEARCH_DECOMPRESS_ZIP,
+	GSEARCH_DECOMPRESS_TAR
+} GSearchDecompressFormat;
+
+/* Called with @member set and no data when a member of an archive
+   starts, then with the data of the member, or of the whole file when it
+   is not an archive.  Returns FALSE to stop. */
+typedef gboolean (* GSearchDecompressFunc) (const gchar * member,
+                                            const guchar * buffer,
+                                            gsize length,
+                                            gpointer data);
+
+GSearchDecompressFormat
+gsearchtool_decompress_get_format (const guchar * header,
+                                   gsize length);
+gboolean
+gsearchtool_decompress_fd (gint fd,
+                           GSearchDecompressFormat format,
+                           const guchar * head,
+                           gsize head_length,
+                           GSearchDecompressFunc func,
+                           gpointer data,
+                           guint64 * bytes_read);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_DECOMPRESS_H_ */
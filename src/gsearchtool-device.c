@@ -0,0 +1,583 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-device.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Tells what kind of storage a device number is on, so the work of a
+ * search can be spread over each device as well as it takes it.  A
+ * solid state disk reads many files at once faster than one at a time,
+ * a spinning disk only seeks back and forth between them.
+ *
+ * The files waiting on a spinning disk are also taken in the order of
+ * their inode numbers, which on most filesystems follows where the
+ * inodes are on the disk, rather than in the order a folder lists them.
+ * The queue sweeps up through the numbers and starts over from the
+ * lowest once past the highest, like an elevator, so files pushed while
+ * it runs are not left waiting behind a steady stream of lower ones.
+ *
+ * The mount table also says which folders inside a search are on a
+ * kernel, memory backed or network filesystem, for a search to leave
+ * them out.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_SYSMACROS_H
+#  include <sys/sysmacros.h>
+#endif
+#include <glib/gstdio.h>
+
+#include "gsearchtool-device.h"
+
+static const gchar * network_filesystems[] = {
+	"9p",
+	"afs",
+	"ceph",
+	"cifs",
+	"davfs",
+	"fuse.sshfs",
+	"glusterfs",
+	"lustre",
+	"ncpfs",
+	"nfs",
+	"nfs4",
+	"smb3",
+	"smbfs",
+	NULL
+};
+
+struct _GSearchDeviceQueue {
+	GQueue                  items;
+	GSequence             * sorted;
+	guint64                 position;
+	guint64                 serial;
+};
+
+typedef struct {
+	gpointer                data;
+	guint64                 inode;
+	guint64                 serial;
+} GSearchDeviceItem;
+
+/* Kernel and desktop filesystems with nothing worth finding, and memory
+   backed ones that only hold what is there while the system runs. */
+static const gchar * pseudo_filesystems[] = {
+	"autofs",
+	"binfmt_misc",
+	"bpf",
+	"cgroup",
+	"cgroup2",
+	"configfs",
+	"debugfs",
+	"devpts",
+	"devtmpfs",
+	"efivarfs",
+	"fuse.gvfsd-fuse",
+	"fuse.lxcfs",
+	"fuse.portal",
+	"fusectl",
+	"hugetlbfs",
+	"mqueue",
+	"nsfs",
+	"proc",
+	"pstore",
+	"ramfs",
+	"rpc_pipefs",
+	"securityfs",
+	"selinuxfs",
+	"sysfs",
+	"tmpfs",
+	"tracefs",
+	NULL
+};
+
+static guint concurrency[GSEARCH_DEVICE_N_KINDS];
+
+G_LOCK_DEFINE_STATIC (kinds);
+static GHashTable * kinds = NULL;
+
+static gboolean
+is_network_filesystem (const gchar * fstype)
+{
+	gint i;
+
+	for (i = 0; network_filesystems[i] != NULL; i++) {
+		if (strcmp (fstype, network_filesystems[i]) == 0) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+is_pseudo_filesystem (const gchar * fstype)
+{
+	gint i;
+
+	for (i = 0; pseudo_filesystems[i] != NULL; i++) {
+		if (strcmp (fstype, pseudo_filesystems[i]) == 0) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Finds the mount of @device in @mountinfo, a /proc/self/mountinfo file.
+   Its lines read "id parent major:minor root mount-point options
+   [optional fields] - type source super-options". */
+static gboolean
+find_mount (const gchar * mountinfo,
+            guint dev_major,
+            guint dev_minor,
+            gchar ** fstype,
+            gchar ** source)
+{
+	gchar * contents;
+	gchar ** lines;
+	gboolean is_found = FALSE;
+	gint i;
+
+	if (g_file_get_contents (mountinfo, &contents, NULL, NULL) == FALSE) {
+		return FALSE;
+	}
+	lines = g_strsplit (contents, "\n", -1);
+	g_free (contents);
+
+	for (i = 0; (lines[i] != NULL) && (is_found == FALSE); i++) {
+		gchar ** fields;
+		const gchar * separator;
+		guint line_major;
+		guint line_minor;
+
+		if (sscanf (lines[i], "%*u %*u %u:%u", &line_major, &line_minor) != 2 ||
+		    line_major != dev_major || line_minor != dev_minor) {
+			continue;
+		}
+		separator = strstr (lines[i], " - ");
+		if (separator == NULL) {
+			continue;
+		}
+		fields = g_strsplit (separator + 3, " ", 3);
+		if ((fields[0] != NULL) && (fields[1] != NULL)) {
+			*fstype = g_strdup (fields[0]);
+			*source = g_strdup (fields[1]);
+			is_found = TRUE;
+		}
+		g_strfreev (fields);
+	}
+	g_strfreev (lines);
+
+	return is_found;
+}
+
+/* The queue of a partition is the one of its disk, the folder above it. */
+static GSearchDeviceKind
+get_block_device_kind (const gchar * sys_folder,
+                       guint dev_major,
+                       guint dev_minor)
+{
+	GSearchDeviceKind kind = GSEARCH_DEVICE_OTHER;
+	gchar * contents = NULL;
+	gchar * path;
+
+	path = g_strdup_printf ("%s/dev/block/%u:%u/queue/rotational", sys_folder, dev_major, dev_minor);
+	if (g_file_get_contents (path, &contents, NULL, NULL) == FALSE) {
+		g_free (path);
+		path = g_strdup_printf ("%s/dev/block/%u:%u/../queue/rotational", sys_folder, dev_major, dev_minor);
+		g_file_get_contents (path, &contents, NULL, NULL);
+	}
+	if (contents != NULL) {
+		kind = (contents[0] == '1') ? GSEARCH_DEVICE_ROTATIONAL : GSEARCH_DEVICE_SOLID;
+	}
+	g_free (contents);
+	g_free (path);
+
+	return kind;
+}
+
+/* Looks @device up in the @sys_folder sysfs tree and the @mountinfo
+   mount table, without the cache. */
+GSearchDeviceKind
+gsearchtool_device_lookup_kind (const gchar * sys_folder,
+                                const gchar * mountinfo,
+                                guint64 device)
+{
+	GSearchDeviceKind kind;
+	gchar * fstype = NULL;
+	gchar * source = NULL;
+	guint dev_major = major ((dev_t) device);
+	guint dev_minor = minor ((dev_t) device);
+
+	find_mount (mountinfo, dev_major, dev_minor, &fstype, &source);
+
+	if ((fstype != NULL) && is_network_filesystem (fstype)) {
+		kind = GSEARCH_DEVICE_NETWORK;
+	}
+	else {
+		kind = get_block_device_kind (sys_folder, dev_major, dev_minor);
+
+		/* Btrfs and the like give their files a device number of their
+		   own, the disk is the source of the mount. */
+		if ((kind == GSEARCH_DEVICE_OTHER) && (source != NULL) && g_str_has_prefix (source, "/dev/")) {
+			GStatBuf file_stat;
+
+			if ((g_stat (source, &file_stat) == 0) && S_ISBLK (file_stat.st_mode)) {
+				kind = get_block_device_kind (sys_folder, major (file_stat.st_rdev), minor (file_stat.st_rdev));
+			}
+		}
+	}
+	g_free (fstype);
+	g_free (source);
+
+	return kind;
+}
+
+GSearchDeviceKind
+gsearchtool_device_get_kind (guint64 device)
+{
+	gpointer kind;
+
+	G_LOCK (kinds);
+	if (kinds == NULL) {
+		kinds = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
+	}
+	if (g_hash_table_lookup_extended (kinds, &device, NULL, &kind) == FALSE) {
+		gint64 * key;
+
+		kind = GINT_TO_POINTER (gsearchtool_device_lookup_kind ("/sys", "/proc/self/mountinfo", device));
+		key = g_new (gint64, 1);
+		*key = device;
+		g_hash_table_insert (kinds, key, kind);
+	}
+	G_UNLOCK (kinds);
+
+	return GPOINTER_TO_INT (kind);
+}
+
+/* The number of files read or folders walked at once on a device. */
+guint
+gsearchtool_device_get_concurrency (GSearchDeviceKind kind)
+{
+	g_return_val_if_fail (kind < GSEARCH_DEVICE_N_KINDS, 1);
+
+	if (concurrency[kind] > 0) {
+		return concurrency[kind];
+	}
+	switch (kind) {
+	case GSEARCH_DEVICE_SOLID:
+		return MAX (g_get_num_processors (), 2);
+	case GSEARCH_DEVICE_ROTATIONAL:
+		return 1;
+	case GSEARCH_DEVICE_NETWORK:
+		return 4;
+	default:
+		return 2;
+	}
+}
+
+/* Sets the concurrency of the devices of @kind, 0 for the default. */
+void
+gsearchtool_device_set_concurrency (GSearchDeviceKind kind,
+                                    guint value)
+{
+	g_return_if_fail (kind < GSEARCH_DEVICE_N_KINDS);
+
+	concurrency[kind] = value;
+}
+
+/* Whether the files on the devices of @kind are best read by inode. */
+gboolean
+gsearchtool_device_is_inode_ordered (GSearchDeviceKind kind)
+{
+	return kind == GSEARCH_DEVICE_ROTATIONAL;
+}
+
+/* Items with the same inode number keep the order they came in. */
+static gint
+compare_items (GSearchDeviceItem * a,
+               GSearchDeviceItem * b,
+               gpointer data)
+{
+	if (a->inode != b->inode) {
+		return (a->inode < b->inode) ? -1 : 1;
+	}
+	if (a->serial != b->serial) {
+		return (a->serial < b->serial) ? -1 : 1;
+	}
+	return 0;
+}
+
+/* A queue of the files waiting on a device, first in first out unless
+   @is_inode_ordered. */
+GSearchDeviceQueue *
+gsearchtool_device_queue_new (gboolean is_inode_ordered)
+{
+	GSearchDeviceQueue * queue;
+
+	queue = g_slice_new0 (GSearchDeviceQueue);
+	g_queue_init (&queue->items);
+	if (is_inode_ordered == TRUE) {
+		queue->sorted = g_sequence_new (NULL);
+	}
+	return queue;
+}
+
+void
+gsearchtool_device_queue_free (GSearchDeviceQueue * queue,
+                               GDestroyNotify free_func)
+{
+	gpointer data;
+
+	if (queue == NULL) {
+		return;
+	}
+	while ((data = gsearchtool_device_queue_pop (queue)) != NULL) {
+		if (free_func != NULL) {
+			free_func (data);
+		}
+	}
+	if (queue->sorted != NULL) {
+		g_sequence_free (queue->sorted);
+	}
+	g_slice_free (GSearchDeviceQueue, queue);
+}
+
+/* Queues @data, which must not be NULL, for the file of number @inode,
+   0 if it is not known. */
+void
+gsearchtool_device_queue_push (GSearchDeviceQueue * queue,
+                               gpointer data,
+                               guint64 inode)
+{
+	GSearchDeviceItem * item;
+
+	g_return_if_fail (data != NULL);
+
+	if (queue->sorted == NULL) {
+		g_queue_push_tail (&queue->items, data);
+		return;
+	}
+	item = g_slice_new (GSearchDeviceItem);
+	item->data = data;
+	item->inode = inode;
+	item->serial = ++queue->serial;
+	g_sequence_insert_sorted (queue->sorted, item, (GCompareDataFunc) compare_items, NULL);
+}
+
+/* Returns the next item, or NULL when the queue is empty. */
+gpointer
+gsearchtool_device_queue_pop (GSearchDeviceQueue * queue)
+{
+	GSearchDeviceItem * item;
+	GSearchDeviceItem key;
+	GSequenceIter * iter;
+	gpointer data;
+
+	if (queue->sorted == NULL) {
+		return g_queue_pop_head (&queue->items);
+	}
+	if (g_sequence_get_length (queue->sorted) == 0) {
+		return NULL;
+	}
+
+	/* The first item at or past the last inode taken, if there is one. */
+	key.inode = queue->position;
+	key.serial = 0;
+	iter = g_sequence_search (queue->sorted, &key, (GCompareDataFunc) compare_items, NULL);
+	if (g_sequence_iter_is_end (iter) == TRUE) {
+		iter = g_sequence_get_begin_iter (queue->sorted);
+	}
+
+	item = g_sequence_get (iter);
+	g_sequence_remove (iter);
+	queue->position = item->inode;
+	data = item->data;
+	g_slice_free (GSearchDeviceItem, item);
+
+	return data;
+}
+
+guint
+gsearchtool_device_queue_get_length (GSearchDeviceQueue * queue)
+{
+	if (queue->sorted == NULL) {
+		return g_queue_get_length (&queue->items);
+	}
+	return g_sequence_get_length (queue->sorted);
+}
+
+GSearchFilesystemClass
+gsearchtool_device_get_filesystem_class (const gchar * fstype)
+{
+	if (is_network_filesystem (fstype)) {
+		return GSEARCH_FILESYSTEM_NETWORK;
+	}
+	if (is_pseudo_filesystem (fstype)) {
+		return GSEARCH_FILESYSTEM_PSEUDO;
+	}
+	return GSEARCH_FILESYSTEM_LOCAL;
+}
+
+static void
+free_mount (GSearchMount * mount)
+{
+	g_free (mount->mount_point);
+	g_free (mount->fstype);
+	g_slice_free (GSearchMount, mount);
+}
+
+/* Reads the mount points and filesystem types of @mountinfo, an empty
+   array if it cannot be read. */
+GPtrArray *
+gsearchtool_device_read_mounts (const gchar * mountinfo)
+{
+	GPtrArray * mounts;
+	gchar * contents;
+	gchar ** lines;
+	gint i;
+
+	mounts = g_ptr_array_new_with_free_func ((GDestroyNotify) free_mount);
+	if (g_file_get_contents (mountinfo, &contents, NULL, NULL) == FALSE) {
+		return mounts;
+	}
+	lines = g_strsplit (contents, "\n", -1);
+	g_free (contents);
+
+	for (i = 0; lines[i] != NULL; i++) {
+		GSearchMount * mount;
+		gchar ** fields;
+		const gchar * separator;
+		gchar * fstype;
+
+		separator = strstr (lines[i], " - ");
+		if (separator == NULL) {
+			continue;
+		}
+		fields = g_strsplit (lines[i], " ", 6);
+		if (g_strv_length (fields) < 6) {
+			g_strfreev (fields);
+			continue;
+		}
+		fstype = g_strndup (separator + 3, strcspn (separator + 3, " "));
+
+		/* Spaces and the like in the mount point are octal escapes. */
+		mount = g_slice_new (GSearchMount);
+		mount->mount_point = g_strcompress (fields[4]);
+		mount->fstype = fstype;
+		g_ptr_array_add (mounts, mount);
+		g_strfreev (fields);
+	}
+	g_strfreev (lines);
+
+	return mounts;
+}
+
+/* Whether @policy, a list of filesystem classes ("pseudo", "network" or
+   "local") and types separated by commas or spaces, names @mount. */
+static gboolean
+is_mount_skipped (GSearchMount * mount,
+                  gchar ** policy)
+{
+	static const gchar * class_names[] = { "local", "pseudo", "network" };
+	GSearchFilesystemClass filesystem_class;
+	gint i;
+
+	filesystem_class = gsearchtool_device_get_filesystem_class (mount->fstype);
+	for (i = 0; policy[i] != NULL; i++) {
+		if ((strcmp (policy[i], class_names[filesystem_class]) == 0) ||
+		    (strcmp (policy[i], mount->fstype) == 0)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gint
+compare_strings (gconstpointer a,
+                 gconstpointer b)
+{
+	return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* Returns the mount points inside @folder, a path with no symbolic links
+   in it, that @policy says to leave out, sorted and without the ones
+   inside another one left out. */
+gchar **
+gsearchtool_device_get_skipped_mounts (GPtrArray * mounts,
+                                       const gchar * folder,
+                                       const gchar * policy)
+{
+	GPtrArray * skipped;
+	gchar ** policy_names;
+	gchar * prefix;
+	guint i;
+	guint kept = 0;
+
+	skipped = g_ptr_array_new ();
+	policy_names = g_strsplit_set ((policy != NULL) ? policy : "", ", ", -1);
+	prefix = g_str_has_suffix (folder, G_DIR_SEPARATOR_S) ? g_strdup (folder) : g_strconcat (folder, G_DIR_SEPARATOR_S, NULL);
+
+	for (i = 0; i < mounts->len; i++) {
+		GSearchMount * mount = g_ptr_array_index (mounts, i);
+
+		if ((g_str_has_prefix (mount->mount_point, prefix) == TRUE) &&
+		    (mount->mount_point[strlen (prefix)] != '\0') &&
+		    (is_mount_skipped (mount, policy_names) == TRUE)) {
+			g_ptr_array_add (skipped, g_strdup (mount->mount_point));
+		}
+	}
+	g_ptr_array_sort (skipped, compare_strings);
+
+	for (i = 0; i < skipped->len; i++) {
+		gchar * mount_point = g_ptr_array_index (skipped, i);
+		guint j;
+
+		for (j = 0; j < kept; j++) {
+			const gchar * outer = g_ptr_array_index (skipped, j);
+			gsize length = strlen (outer);
+
+			if ((strncmp (mount_point, outer, length) == 0) &&
+			    ((mount_point[length] == '\0') || (mount_point[length] == G_DIR_SEPARATOR))) {
+				break;
+			}
+		}
+		if (j < kept) {
+			g_free (mount_point);
+			continue;
+		}
+		g_ptr_array_index (skipped, kept++) = mount_point;
+	}
+	g_ptr_array_set_size (skipped, kept);
+	g_ptr_array_add (skipped, NULL);
+
+	g_strfreev (policy_names);
+	g_free (prefix);
+
+	return (gchar **) g_ptr_array_free (skipped, FALSE);
+}
@@ -0,0 +1,105 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-device.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_DEVICE_H_
+#define _GSEARCHTOOL_DEVICE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+typedef enum {
+	GSEARCH_DEVICE_OTHER,
+	GSEARCH_DEVICE_SOLID,
+	GSEARCH_DEVICE_ROTATIONAL,
+	GSEARCH_DEVICE_NETWORK,
+	GSEARCH_DEVICE_N_KINDS
+} GSearchDeviceKind;
+
+typedef enum {
+	GSEARCH_FILESYSTEM_LOCAL,
+	GSEARCH_FILESYSTEM_PSEUDO,
+	GSEARCH_FILESYSTEM_NETWORK
+} GSearchFilesystemClass;
+
+typedef struct _GSearchDeviceQueue GSearchDeviceQueue;
+typedef struct _GSearchMount GSearchMount;
+
+/* A line of the mount table. */
+struct _GSearchMount {
+	gchar                 * mount_point;
+	gchar                 * fstype;
+};
+
+GSearchDeviceKind
+gsearchtool_device_get_kind (guint64 device);
+
+GSearchDeviceKind
+gsearchtool_device_lookup_kind (const gchar * sys_folder,
+                                const gchar * mountinfo,
+                                guint64 device);
+guint
+gsearchtool_device_get_concurrency (GSearchDeviceKind kind);
+
+void
+gsearchtool_device_set_concurrency (GSearchDeviceKind kind,
+                                    guint value);
+gboolean
+gsearchtool_device_is_inode_ordered (GSearchDeviceKind kind);
+
+GSearchFilesystemClass
+gsearchtool_device_get_filesystem_class (const gchar * fstype);
+
+GPtrArray *
+gsearchtool_device_read_mounts (const gchar * mountinfo);
+
+gchar **
+gsearchtool_device_get_skipped_mounts (GPtrArray * mounts,
+                                       const gchar * folder,
+                                       const gchar * policy);
+
+GSearchDeviceQueue *
+gsearchtool_device_queue_new (gboolean is_inode_ordered);
+
+void
+gsearchtool_device_queue_free (GSearchDeviceQueue * queue,
+                               GDestroyNotify free_func);
+void
+gsearchtool_device_queue_push (GSearchDeviceQueue * queue,
+                               gpointer data,
+                               guint64 inode);
+gpointer
+gsearchtool_device_queue_pop (GSearchDeviceQueue * queue);
+
+guint
+gsearchtool_device_queue_get_length (GSearchDeviceQueue * queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_DEVICE_H_ */
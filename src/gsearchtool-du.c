@@ -0,0 +1,232 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-du.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Sums the sizes and counts of the files found per folder.  A file is
+ * only added to its own folder while the search runs; the totals of the
+ * folders above it are worked out once, deepest folders first, when the
+ * search is over.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gsearchtool-du.h"
+
+struct _GSearchDiskUsage {
+	GSearchDiskUsageFolder * root;
+	GSearchDiskUsageFolder * last_folder;
+	GHashTable            * folders;
+	guint64                 files;
+};
+
+static GSearchDiskUsageFolder *
+new_folder (GSearchDiskUsage * du,
+            gchar * path,
+            GSearchDiskUsageFolder * parent)
+{
+	GSearchDiskUsageFolder * folder;
+
+	folder = g_slice_new0 (GSearchDiskUsageFolder);
+	folder->path = path;
+	folder->parent = parent;
+	folder->children = g_ptr_array_new ();
+	if (parent != NULL) {
+		folder->depth = parent->depth + 1;
+		g_ptr_array_add (parent->children, folder);
+	}
+	g_hash_table_insert (du->folders, folder->path, folder);
+
+	return folder;
+}
+
+static void
+free_folder (gpointer key,
+             GSearchDiskUsageFolder * folder,
+             gpointer data)
+{
+	g_ptr_array_free (folder->children, TRUE);
+	g_free (folder->path);
+	g_slice_free (GSearchDiskUsageFolder, folder);
+}
+
+/* Finds the folder @path, @length bytes long, adding it and any folder
+   between it and the root that is not known yet. */
+static GSearchDiskUsageFolder *
+get_folder (GSearchDiskUsage * du,
+            const gchar * path,
+            gsize length)
+{
+	GSearchDiskUsageFolder * folder;
+	GSearchDiskUsageFolder * parent;
+	const gchar * separator;
+	gchar * folder_path;
+
+	folder_path = g_strndup (path, length);
+	folder = g_hash_table_lookup (du->folders, folder_path);
+	if (folder != NULL) {
+		g_free (folder_path);
+		return folder;
+	}
+
+	separator = g_strrstr_len (path, length, G_DIR_SEPARATOR_S);
+	if (separator == NULL || length <= strlen (du->root->path)) {
+		/* Outside of the root, the search never reports these. */
+		g_free (folder_path);
+		return du->root;
+	}
+
+	parent = get_folder (du, path, (separator == path) ? 1 : (gsize) (separator - path));
+	return new_folder (du, folder_path, parent);
+}
+
+GSearchDiskUsage *
+gsearchtool_du_new (const gchar * root)
+{
+	GSearchDiskUsage * du;
+	gchar * root_path;
+	gsize length;
+
+	root_path = g_strdup (root);
+	length = strlen (root_path);
+	while (length > 1 && root_path[length - 1] == G_DIR_SEPARATOR) {
+		root_path[--length] = '\0';
+	}
+
+	du = g_slice_new0 (GSearchDiskUsage);
+	du->folders = g_hash_table_new (g_str_hash, g_str_equal);
+	du->root = new_folder (du, root_path, NULL);
+
+	return du;
+}
+
+void
+gsearchtool_du_free (GSearchDiskUsage * du)
+{
+	if (du == NULL) {
+		return;
+	}
+	g_hash_table_foreach (du->folders, (GHFunc) free_folder, NULL);
+	g_hash_table_destroy (du->folders);
+	g_slice_free (GSearchDiskUsage, du);
+}
+
+void
+gsearchtool_du_add_file (GSearchDiskUsage * du,
+                         const gchar * path,
+                         gint64 size)
+{
+	GSearchDiskUsageFolder * folder;
+	const gchar * separator;
+	gsize length;
+
+	separator = strrchr (path, G_DIR_SEPARATOR);
+	if (separator == NULL) {
+		return;
+	}
+	length = (separator == path) ? 1 : (gsize) (separator - path);
+
+	/* find lists the files of a folder one after the other. */
+	folder = du->last_folder;
+	if (folder == NULL || strncmp (folder->path, path, length) != 0 || folder->path[length] != '\0') {
+		folder = get_folder (du, path, length);
+		du->last_folder = folder;
+	}
+
+	folder->size += size;
+	folder->files++;
+	du->files++;
+}
+
+static gint
+compare_depth (gconstpointer a,
+               gconstpointer b)
+{
+	const GSearchDiskUsageFolder * folder_a = *(const GSearchDiskUsageFolder **) a;
+	const GSearchDiskUsageFolder * folder_b = *(const GSearchDiskUsageFolder **) b;
+
+	if (folder_a->depth != folder_b->depth) {
+		return (folder_a->depth > folder_b->depth) ? -1 : 1;
+	}
+	return 0;
+}
+
+static gint
+compare_total_size (gconstpointer a,
+                    gconstpointer b)
+{
+	const GSearchDiskUsageFolder * folder_a = *(const GSearchDiskUsageFolder **) a;
+	const GSearchDiskUsageFolder * folder_b = *(const GSearchDiskUsageFolder **) b;
+
+	if (folder_a->total_size != folder_b->total_size) {
+		return (folder_a->total_size > folder_b->total_size) ? -1 : 1;
+	}
+	return strcmp (folder_a->path, folder_b->path);
+}
+
+void
+gsearchtool_du_finish (GSearchDiskUsage * du)
+{
+	GHashTableIter iter;
+	GPtrArray * folders;
+	gpointer value;
+	guint idx;
+
+	folders = g_ptr_array_sized_new (g_hash_table_size (du->folders));
+	g_hash_table_iter_init (&iter, du->folders);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		GSearchDiskUsageFolder * folder = value;
+
+		folder->total_size = folder->size;
+		folder->total_files = folder->files;
+		g_ptr_array_add (folders, folder);
+	}
+	g_ptr_array_sort (folders, compare_depth);
+
+	for (idx = 0; idx < folders->len; idx++) {
+		GSearchDiskUsageFolder * folder = g_ptr_array_index (folders, idx);
+
+		if (folder->parent != NULL) {
+			folder->parent->total_size += folder->total_size;
+			folder->parent->total_files += folder->total_files;
+		}
+		g_ptr_array_sort (folder->children, compare_total_size);
+	}
+	g_ptr_array_free (folders, TRUE);
+}
+
+GSearchDiskUsageFolder *
+gsearchtool_du_get_root (GSearchDiskUsage * du)
+{
+	return du->root;
+}
+
+guint64
+gsearchtool_du_get_files (GSearchDiskUsage * du)
+{
+	return du->files;
+}
@@ -0,0 +1,74 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-du.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_DU_H_
+#define _GSEARCHTOOL_DU_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+typedef struct _GSearchDiskUsage GSearchDiskUsage;
+typedef struct _GSearchDiskUsageFolder GSearchDiskUsageFolder;
+
+/* The totals include the subfolders.  They, and the order of the
+   children, largest first, are only set by gsearchtool_du_finish(). */
+struct _GSearchDiskUsageFolder {
+	gchar                 * path;
+	GSearchDiskUsageFolder * parent;
+	GPtrArray             * children;
+	guint                   depth;
+	gint64                  size;
+	guint64                 files;
+	gint64                  total_size;
+	guint64                 total_files;
+};
+
+GSearchDiskUsage *
+gsearchtool_du_new (const gchar * root);
+
+void
+gsearchtool_du_free (GSearchDiskUsage * du);
+
+void
+gsearchtool_du_add_file (GSearchDiskUsage * du,
+                         const gchar * path,
+                         gint64 size);
+void
+gsearchtool_du_finish (GSearchDiskUsage * du);
+
+GSearchDiskUsageFolder *
+gsearchtool_du_get_root (GSearchDiskUsage * du);
+
+guint64
+gsearchtool_du_get_files (GSearchDiskUsage * du);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_DU_H_ */
@@ -0,0 +1,578 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-dupes.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Finds the files with the same contents among the files added to it.
+ *
+ * The files are first put in buckets by size, and the sizes only one
+ * file has are dropped.  Hard links are spotted as they are added, a
+ * file is only read once however many paths it has.  The first and last
+ * GSEARCH_DUPES_BLOCK_SIZE bytes of the files left are then hashed on a
+ * pool of threads, and the files that still collide are hashed whole.
+ * A group of duplicates is queued for gsearchtool_dupes_pop_group() as
+ * soon as its last file is hashed.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include "gsearchtool-dupes.h"
+
+#define GSEARCH_DUPES_READ_SIZE 65536
+#define GSEARCH_DUPES_DIGEST_LENGTH 32
+
+typedef struct _GSearchDupesFile GSearchDupesFile;
+typedef struct _GSearchDupesBucket GSearchDupesBucket;
+
+struct _GSearchDupesFile {
+	guint64                 device;
+	guint64                 inode;
+	gint64                  size;
+	GPtrArray             * paths;
+	GSearchDupesBucket    * bucket;
+	gboolean                is_failed;
+	guint8                  digest[GSEARCH_DUPES_DIGEST_LENGTH];
+};
+
+/* The files a hash pass has to be over for before they are regrouped. */
+struct _GSearchDupesBucket {
+	gint64                  size;
+	GPtrArray             * files;
+	gint                    pending;
+	gboolean                is_hashed_whole;
+};
+
+struct _GSearchDupes {
+	guint                   threads;
+	GHashTable            * inodes;
+	GHashTable            * sizes;
+	GPtrArray             * files;
+	GPtrArray             * buckets;
+	GThreadPool           * pool;
+
+	/* The lock guards everything below. */
+	GMutex                  lock;
+	GCond                   cond;
+	GQueue                  groups;
+	gint                    jobs;
+	guint64                 bytes_read;
+	gboolean                is_started;
+	gboolean                is_finished;
+	gboolean                is_cancelled;
+};
+
+static guint
+inode_hash (gconstpointer key)
+{
+	const GSearchDupesFile * file = key;
+
+	return (guint) (file->inode ^ (file->inode >> 32) ^ (file->device * 31));
+}
+
+static gboolean
+inode_equal (gconstpointer a,
+             gconstpointer b)
+{
+	const GSearchDupesFile * file_a = a;
+	const GSearchDupesFile * file_b = b;
+
+	return (file_a->inode == file_b->inode) && (file_a->device == file_b->device);
+}
+
+static GSearchDupesBucket *
+new_bucket (GSearchDupes * dupes,
+            gint64 size,
+            gboolean is_hashed_whole)
+{
+	GSearchDupesBucket * bucket;
+
+	bucket = g_slice_new0 (GSearchDupesBucket);
+	bucket->size = size;
+	bucket->files = g_ptr_array_new ();
+	bucket->is_hashed_whole = is_hashed_whole;
+	g_ptr_array_add (dupes->buckets, bucket);
+
+	return bucket;
+}
+
+static void
+free_bucket (GSearchDupesBucket * bucket)
+{
+	g_ptr_array_free (bucket->files, TRUE);
+	g_slice_free (GSearchDupesBucket, bucket);
+}
+
+static void
+free_file (GSearchDupesFile * file)
+{
+	g_ptr_array_foreach (file->paths, (GFunc) g_free, NULL);
+	g_ptr_array_free (file->paths, TRUE);
+	g_slice_free (GSearchDupesFile, file);
+}
+
+static gboolean
+is_cancelled (GSearchDupes * dupes)
+{
+	gboolean cancelled;
+
+	g_mutex_lock (&dupes->lock);
+	cancelled = dupes->is_cancelled;
+	g_mutex_unlock (&dupes->lock);
+
+	return cancelled;
+}
+
+static gboolean
+read_block (gint fd,
+            guchar * buffer,
+            gsize length,
+            GChecksum * checksum,
+            guint64 * bytes_read)
+{
+	while (length > 0) {
+		gssize count;
+
+		count = read (fd, buffer, MIN (length, GSEARCH_DUPES_READ_SIZE));
+		if (count <= 0) {
+			/* An error, or the file got shorter since it was found. */
+			return FALSE;
+		}
+		g_checksum_update (checksum, buffer, count);
+		*bytes_read += count;
+		length -= count;
+	}
+	return TRUE;
+}
+
+/* Hashes the whole file, or only its first and last blocks.  Files of up
+   to two blocks are read whole either way. */
+static guint64
+hash_file (GSearchDupes * dupes,
+           GSearchDupesFile * file,
+           gboolean whole)
+{
+	GChecksum * checksum;
+	guchar * buffer;
+	guint64 bytes_read = 0;
+	gsize digest_length = GSEARCH_DUPES_DIGEST_LENGTH;
+	gint fd;
+
+	fd = g_open (g_ptr_array_index (file->paths, 0), O_RDONLY, 0);
+	if (fd < 0) {
+		file->is_failed = TRUE;
+		return 0;
+	}
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	buffer = g_malloc (GSEARCH_DUPES_READ_SIZE);
+
+	if (whole == TRUE || file->size <= 2 * GSEARCH_DUPES_BLOCK_SIZE) {
+		gint64 left = file->size;
+
+		while (left > 0 && file->is_failed == FALSE) {
+			gsize length = MIN (left, GSEARCH_DUPES_READ_SIZE);
+
+			if (is_cancelled (dupes) == TRUE ||
+			    read_block (fd, buffer, length, checksum, &bytes_read) == FALSE) {
+				file->is_failed = TRUE;
+			}
+			left -= length;
+		}
+	}
+	else if (read_block (fd, buffer, GSEARCH_DUPES_BLOCK_SIZE, checksum, &bytes_read) == FALSE ||
+	         lseek (fd, file->size - GSEARCH_DUPES_BLOCK_SIZE, SEEK_SET) < 0 ||
+	         read_block (fd, buffer, GSEARCH_DUPES_BLOCK_SIZE, checksum, &bytes_read) == FALSE) {
+		file->is_failed = TRUE;
+	}
+
+	if (file->is_failed == FALSE) {
+		g_checksum_get_digest (checksum, file->digest, &digest_length);
+	}
+	g_checksum_free (checksum);
+	g_free (buffer);
+	close (fd);
+
+	return bytes_read;
+}
+
+static gint
+compare_files (gconstpointer a,
+               gconstpointer b)
+{
+	const GSearchDupesFile * file_a = *(const GSearchDupesFile **) a;
+	const GSearchDupesFile * file_b = *(const GSearchDupesFile **) b;
+	gint result;
+
+	result = memcmp (file_a->digest, file_b->digest, GSEARCH_DUPES_DIGEST_LENGTH);
+	if (result != 0) {
+		return result;
+	}
+	return strcmp (g_ptr_array_index (file_a->paths, 0), g_ptr_array_index (file_b->paths, 0));
+}
+
+static gint
+compare_paths (gconstpointer a,
+               gconstpointer b)
+{
+	return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* Both push_file() and queue_group() are called with the lock held. */
+static void
+push_file (GSearchDupes * dupes,
+           GSearchDupesFile * file)
+{
+	dupes->jobs++;
+	g_thread_pool_push (dupes->pool, file, NULL);
+}
+
+static void
+queue_group (GSearchDupes * dupes,
+             GPtrArray * files,
+             guint first,
+             guint last)
+{
+	GSearchDupesGroup * group;
+	guint idx;
+
+	group = g_slice_new0 (GSearchDupesGroup);
+	group->size = ((GSearchDupesFile *) g_ptr_array_index (files, first))->size;
+	group->paths = g_ptr_array_new_with_free_func (g_free);
+	for (idx = first; idx < last; idx++) {
+		GSearchDupesFile * file = g_ptr_array_index (files, idx);
+		guint path;
+
+		for (path = 0; path < file->paths->len; path++) {
+			g_ptr_array_add (group->paths, g_strdup (g_ptr_array_index (file->paths, path)));
+		}
+	}
+	g_ptr_array_sort (group->paths, compare_paths);
+
+	g_queue_push_tail (&dupes->groups, group);
+	g_cond_broadcast (&dupes->cond);
+}
+
+/* Called by the thread that hashed the last file of @bucket.  The files
+   with the same digest are either a group of duplicates, or have to be
+   hashed whole. */
+static void
+split_bucket (GSearchDupes * dupes,
+              GSearchDupesBucket * bucket)
+{
+	GPtrArray * files;
+	gboolean is_complete;
+	guint first;
+	guint idx;
+
+	files = g_ptr_array_sized_new (bucket->files->len);
+	for (idx = 0; idx < bucket->files->len; idx++) {
+		GSearchDupesFile * file = g_ptr_array_index (bucket->files, idx);
+
+		if (file->is_failed == FALSE) {
+			g_ptr_array_add (files, file);
+		}
+	}
+	g_ptr_array_sort (files, compare_files);
+
+	is_complete = (bucket->is_hashed_whole == TRUE) || (bucket->size <= 2 * GSEARCH_DUPES_BLOCK_SIZE);
+
+	g_mutex_lock (&dupes->lock);
+	for (first = 0; first < files->len && dupes->is_cancelled == FALSE; first = idx) {
+		GSearchDupesFile * file = g_ptr_array_index (files, first);
+
+		for (idx = first + 1; idx < files->len; idx++) {
+			GSearchDupesFile * next = g_ptr_array_index (files, idx);
+
+			if (memcmp (file->digest, next->digest, GSEARCH_DUPES_DIGEST_LENGTH) != 0) {
+				break;
+			}
+		}
+		if (idx - first < 2) {
+			continue;
+		}
+
+		if (is_complete == TRUE) {
+			queue_group (dupes, files, first, idx);
+		}
+		else {
+			GSearchDupesBucket * collisions;
+			guint collision;
+
+			collisions = new_bucket (dupes, bucket->size, TRUE);
+			collisions->pending = idx - first;
+			for (collision = first; collision < idx; collision++) {
+				GSearchDupesFile * colliding_file = g_ptr_array_index (files, collision);
+
+				colliding_file->bucket = collisions;
+				g_ptr_array_add (collisions->files, colliding_file);
+			}
+			for (collision = first; collision < idx; collision++) {
+				push_file (dupes, g_ptr_array_index (files, collision));
+			}
+		}
+	}
+	g_mutex_unlock (&dupes->lock);
+
+	g_ptr_array_free (files, TRUE);
+}
+
+static void
+job_done (GSearchDupes * dupes,
+          guint64 bytes_read)
+{
+	g_mutex_lock (&dupes->lock);
+	dupes->bytes_read += bytes_read;
+	if (--dupes->jobs == 0) {
+		dupes->is_finished = TRUE;
+		g_cond_broadcast (&dupes->cond);
+	}
+	g_mutex_unlock (&dupes->lock);
+}
+
+static void
+hash_file_job (GSearchDupesFile * file,
+               GSearchDupes * dupes)
+{
+	GSearchDupesBucket * bucket = file->bucket;
+	guint64 bytes_read = 0;
+
+	if (is_cancelled (dupes) == FALSE) {
+		bytes_read = hash_file (dupes, file, bucket->is_hashed_whole);
+	}
+	if (g_atomic_int_dec_and_test (&bucket->pending)) {
+		split_bucket (dupes, bucket);
+	}
+	job_done (dupes, bytes_read);
+}
+
+/* @threads is the number of files read at once, 0 for one per processor. */
+GSearchDupes *
+gsearchtool_dupes_new (guint threads)
+{
+	GSearchDupes * dupes;
+
+	dupes = g_slice_new0 (GSearchDupes);
+	dupes->threads = (threads > 0) ? threads : g_get_num_processors ();
+	dupes->inodes = g_hash_table_new (inode_hash, inode_equal);
+	dupes->sizes = g_hash_table_new (g_int64_hash, g_int64_equal);
+	dupes->files = g_ptr_array_new ();
+	dupes->buckets = g_ptr_array_new ();
+	g_mutex_init (&dupes->lock);
+	g_cond_init (&dupes->cond);
+	g_queue_init (&dupes->groups);
+
+	return dupes;
+}
+
+/* Stops the hashing, waiting for the files being read. */
+void
+gsearchtool_dupes_free (GSearchDupes * dupes)
+{
+	if (dupes == NULL) {
+		return;
+	}
+
+	g_mutex_lock (&dupes->lock);
+	dupes->is_cancelled = TRUE;
+	g_mutex_unlock (&dupes->lock);
+
+	if (dupes->pool != NULL) {
+		g_thread_pool_free (dupes->pool, FALSE, TRUE);
+	}
+
+	g_queue_foreach (&dupes->groups, (GFunc) gsearchtool_dupes_group_free, NULL);
+	g_queue_clear (&dupes->groups);
+	g_ptr_array_foreach (dupes->buckets, (GFunc) free_bucket, NULL);
+	g_ptr_array_free (dupes->buckets, TRUE);
+	g_ptr_array_foreach (dupes->files, (GFunc) free_file, NULL);
+	g_ptr_array_free (dupes->files, TRUE);
+	g_hash_table_destroy (dupes->sizes);
+	g_hash_table_destroy (dupes->inodes);
+	g_mutex_clear (&dupes->lock);
+	g_cond_clear (&dupes->cond);
+	g_slice_free (GSearchDupes, dupes);
+}
+
+/* Empty files are left out, they would all be duplicates of each other. */
+void
+gsearchtool_dupes_add_file (GSearchDupes * dupes,
+                            const gchar * path,
+                            gint64 size,
+                            guint64 device,
+                            guint64 inode)
+{
+	GSearchDupesFile key;
+	GSearchDupesFile * file;
+	GSearchDupesBucket * bucket;
+
+	g_return_if_fail (dupes->is_started == FALSE);
+
+	if (size <= 0) {
+		return;
+	}
+
+	key.device = device;
+	key.inode = inode;
+	file = g_hash_table_lookup (dupes->inodes, &key);
+	if (file != NULL) {
+		guint idx;
+
+		for (idx = 0; idx < file->paths->len; idx++) {
+			if (strcmp (g_ptr_array_index (file->paths, idx), path) == 0) {
+				return;
+			}
+		}
+		g_ptr_array_add (file->paths, g_strdup (path));
+		return;
+	}
+
+	file = g_slice_new0 (GSearchDupesFile);
+	file->device = device;
+	file->inode = inode;
+	file->size = size;
+	file->paths = g_ptr_array_new ();
+	g_ptr_array_add (file->paths, g_strdup (path));
+	g_ptr_array_add (dupes->files, file);
+	g_hash_table_insert (dupes->inodes, file, file);
+
+	bucket = g_hash_table_lookup (dupes->sizes, &size);
+	if (bucket == NULL) {
+		bucket = new_bucket (dupes, size, FALSE);
+		g_hash_table_insert (dupes->sizes, &bucket->size, bucket);
+	}
+	file->bucket = bucket;
+	g_ptr_array_add (bucket->files, file);
+}
+
+static gint
+compare_bucket_sizes (gconstpointer a,
+                      gconstpointer b)
+{
+	const GSearchDupesBucket * bucket_a = *(const GSearchDupesBucket **) a;
+	const GSearchDupesBucket * bucket_b = *(const GSearchDupesBucket **) b;
+
+	if (bucket_a->size != bucket_b->size) {
+		return (bucket_a->size > bucket_b->size) ? -1 : 1;
+	}
+	return 0;
+}
+
+/* Starts hashing the files added so far, the largest ones first. */
+void
+gsearchtool_dupes_start (GSearchDupes * dupes)
+{
+	GPtrArray * buckets;
+	guint idx;
+
+	g_return_if_fail (dupes->is_started == FALSE);
+
+	buckets = g_ptr_array_new ();
+	for (idx = 0; idx < dupes->buckets->len; idx++) {
+		GSearchDupesBucket * bucket = g_ptr_array_index (dupes->buckets, idx);
+
+		if (bucket->files->len > 1) {
+			g_ptr_array_add (buckets, bucket);
+		}
+	}
+	g_ptr_array_sort (buckets, compare_bucket_sizes);
+
+	dupes->pool = g_thread_pool_new ((GFunc) hash_file_job, dupes, dupes->threads, FALSE, NULL);
+
+	/* The start holds a job of its own, so the hashing cannot be over
+	   before all the files are queued. */
+	g_mutex_lock (&dupes->lock);
+	dupes->is_started = TRUE;
+	dupes->jobs = 1;
+	for (idx = 0; idx < buckets->len; idx++) {
+		GSearchDupesBucket * bucket = g_ptr_array_index (buckets, idx);
+		guint file;
+
+		bucket->pending = bucket->files->len;
+		for (file = 0; file < bucket->files->len; file++) {
+			push_file (dupes, g_ptr_array_index (bucket->files, file));
+		}
+	}
+	g_mutex_unlock (&dupes->lock);
+	g_ptr_array_free (buckets, TRUE);
+
+	job_done (dupes, 0);
+}
+
+/* Returns the next group of duplicates found, or NULL if there is none
+   yet.  With @wait, only returns NULL once the hashing is over. */
+GSearchDupesGroup *
+gsearchtool_dupes_pop_group (GSearchDupes * dupes,
+                             gboolean wait)
+{
+	GSearchDupesGroup * group;
+
+	g_mutex_lock (&dupes->lock);
+	while (wait == TRUE && dupes->is_started == TRUE && dupes->is_finished == FALSE &&
+	       g_queue_is_empty (&dupes->groups)) {
+		g_cond_wait (&dupes->cond, &dupes->lock);
+	}
+	group = g_queue_pop_head (&dupes->groups);
+	g_mutex_unlock (&dupes->lock);
+
+	return group;
+}
+
+/* Once this returns TRUE, the groups still queued are all there is. */
+gboolean
+gsearchtool_dupes_is_finished (GSearchDupes * dupes)
+{
+	gboolean finished;
+
+	g_mutex_lock (&dupes->lock);
+	finished = dupes->is_finished;
+	g_mutex_unlock (&dupes->lock);
+
+	return finished;
+}
+
+guint64
+gsearchtool_dupes_get_bytes_read (GSearchDupes * dupes)
+{
+	guint64 bytes_read;
+
+	g_mutex_lock (&dupes->lock);
+	bytes_read = dupes->bytes_read;
+	g_mutex_unlock (&dupes->lock);
+
+	return bytes_read;
+}
+
+void
+gsearchtool_dupes_group_free (GSearchDupesGroup * group)
+{
+	g_ptr_array_free (group->paths, TRUE);
+	g_slice_free (GSearchDupesGroup, group);
+}
@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-dupes.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_DUPES_H_
+#define _GSEARCHTOOL_DUPES_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+/* The bytes read from the start and from the end of a file before it is
+   read whole. */
+#define GSEARCH_DUPES_BLOCK_SIZE 4096
+
+typedef struct _GSearchDupes GSearchDupes;
+typedef struct _GSearchDupesGroup GSearchDupesGroup;
+
+/* The paths of files with the same contents, in order.  Hard links to
+   the same file are all listed. */
+struct _GSearchDupesGroup {
+	gint64                  size;
+	GPtrArray             * paths;
+};
+
+GSearchDupes *
+gsearchtool_dupes_new (guint threads);
+
+void
+gsearchtool_dupes_free (GSearchDupes * dupes);
+
+void
+gsearchtool_dupes_add_file (GSearchDupes * dupes,
+                            const gchar * path,
+                            gint64 size,
+                            guint64 device,
+                            guint64 inode);
+void
+gsearchtool_dupes_start (GSearchDupes * dupes);
+
+GSearchDupesGroup *
+gsearchtool_dupes_pop_group (GSearchDupes * dupes,
+                             gboolean wait);
+gboolean
+gsearchtool_dupes_is_finished (GSearchDupes * dupes);
+
+guint64
+gsearchtool_dupes_get_bytes_read (GSearchDupes * dupes);
+
+void
+gsearchtool_dupes_group_free (GSearchDupesGroup * group);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_DUPES_H_ */
@@ -0,0 +1,1329 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-index.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+
+/*
+ * The index of the files in a folder, kept by gnome-search-tool itself
+ * in the user cache folder.  The file is mapped and read in place, so
+ * opening it only checks the header and a search only touches the
+ * pages of the folder it looks in.
+ *
+ * The file starts with a header of GSEARCH_INDEX_HEADER_SIZE bytes and
+ * the path of the indexed folder.  The folders follow, one record each,
+ * in the order of compare_folder_paths() so the folders inside a folder
+ * come right after it.  A record is the path of the folder, its device,
+ * inode, modification and change times, then an entry for each of its
+ * files in the order of their names, then a GSEARCH_INDEX_END byte.  An
+ * entry is the type of the file, its name, then its mode, size,
+ * modification time, owner and group, so the tests of a search other
+ * than the name can be run on the index too.  Each
+ * path and name is front coded: the length it shares with the one
+ * before it and the rest, both lengths as base 128 varints.  The other
+ * numbers are varints too, the time zigzag coded.
+ * The records are grouped in blocks of about GSEARCH_INDEX_BLOCK_SIZE
+ * bytes, the first path of a block is written out in full, so a block
+ * can be read on its own.
+ *
+ * After the blocks come the first folder path of each block, a filter
+ * of the names in each block and the block directory: where each block
+ * starts, its length, its CRC-32 and where its filter is.  A search
+ * finds its first block by a binary search of the directory and checks
+ * the CRC-32 of a block the first time it reads it.  All numbers are
+ * little endian.
+ *
+ * The filter of a block is a Bloom filter of the groups of three
+ * characters in its names, in ASCII lower case, followed by its own
+ * CRC-32.  A search for a name with a run of plain characters passes
+ * over the blocks whose filter does not have all the groups in it,
+ * without reading them, see get_name_pattern_literals().
+ *
+ * Building the index again reads the one before it alongside the walk.
+ * A folder with the same stamp as before, older than that index, has
+ * the same files, so their names are taken from it without reading the
+ * folder.  Each file still gets an lstat, since a file written in place
+ * leaves the times of its folder as they were, so a rebuild saves the
+ * reading of the folders that did not change but not the walk itself.
+ * The filters are made again from the names as they are written.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-index.h"
+#include "gsearchtool-match.h"
+
+#define GSEARCH_INDEX_MAGIC               "GSINDEX1"
+#define GSEARCH_INDEX_MAGIC_LENGTH        8
+#define GSEARCH_INDEX_VERSION             4
+#define GSEARCH_INDEX_HEADER_SIZE         64
+#define GSEARCH_INDEX_BLOCK_SIZE          (16 * 1024)
+#define GSEARCH_INDEX_DIRECTORY_RECORD_SIZE 32
+#define GSEARCH_INDEX_FILTER_SIZE         2048
+#define GSEARCH_INDEX_FILTER_RECORD_SIZE  (GSEARCH_INDEX_FILTER_SIZE + 8)
+#define GSEARCH_INDEX_TRIGRAM_LENGTH      3
+#define GSEARCH_INDEX_END                 0xff
+#define GSEARCH_INDEX_CACHE_FOLDER        "gnome-search-tool"
+#define GSEARCH_INDEX_FILENAME            "index"
+
+/* Where the fields of the header are. */
+enum {
+	GSEARCH_INDEX_HEADER_VERSION = 8,
+	GSEARCH_INDEX_HEADER_FLAGS = 12,
+	GSEARCH_INDEX_HEADER_TIME = 16,
+	GSEARCH_INDEX_HEADER_ENTRIES = 24,
+	GSEARCH_INDEX_HEADER_FOLDERS = 32,
+	GSEARCH_INDEX_HEADER_PATHS = 40,
+	GSEARCH_INDEX_HEADER_DIRECTORY = 48,
+	GSEARCH_INDEX_HEADER_BLOCKS = 56,
+	GSEARCH_INDEX_HEADER_CHECKSUM = 60
+};
+
+/* A block as the directory has it. */
+typedef struct {
+	guint64                 offset;
+	guint64                 first_folder;
+	guint32                 length;
+	guint32                 checksum;
+} GSearchIndexBlock;
+
+struct _GSearchIndexWriter {
+	gchar                 * root;
+	GByteArray            * data;
+	GByteArray            * block;
+	GArray                * blocks;
+	GString               * first_folders;
+	GString               * previous_folder;
+	GString               * previous_name;
+	guint8                * filter;
+	GByteArray            * filters;
+	guint64                 entries;
+	guint64                 folders;
+	gboolean                has_folder;
+};
+
+struct _GSearchIndex {
+	gint                    ref_count;
+	gchar                 * path;
+	const guchar          * data;
+	gsize                   length;
+	guint64                 paths;
+	guint64                 directory;
+	guint32                 blocks;
+	guint8                * checked_blocks;
+	guint8                * checked_filters;
+	dev_t                   device;
+	ino_t                   inode;
+	time_t                  mtime;
+	off_t                   size;
+};
+
+typedef enum {
+	GSEARCH_INDEX_CURSOR_FOLDER,
+	GSEARCH_INDEX_CURSOR_MATCHING,
+	GSEARCH_INDEX_CURSOR_SKIPPING
+} GSearchIndexCursorState;
+
+struct _GSearchIndexCursor {
+	GSearchIndex          * index;
+	gchar                 * folder;
+	gsize                   folder_length;
+	gchar                 * name_pattern;
+	GArray                * trigrams;
+	guint32                 block;
+	const guchar          * position;
+	const guchar          * end;
+	GSearchIndexCursorState state;
+	GString               * folder_path;
+	GString               * name;
+	GSearchIndexStamp       stamp;
+	GSearchIndexEntry       entry;
+	GSearchPredicate      * predicate;
+	gint64                  now;
+	gboolean                is_finished;
+	gboolean                is_damaged;
+};
+
+/* A folder to index, with its lstat. */
+typedef struct {
+	gchar                 * path;
+	GStatBuf                stat;
+} GSearchIndexFolder;
+
+/* What gsearchtool_index_build() takes from folder to folder. */
+typedef struct {
+	GSearchIndexWriter    * writer;
+	dev_t                   device;
+	GSearchIndexCursor    * previous;
+	gint64                  previous_time;
+} GSearchIndexBuild;
+
+static guint32 crc_table[256];
+
+/* Made once, whichever thread reads or writes an index first. */
+static void
+init_crc_table (void)
+{
+	static gsize is_initialized = 0;
+
+	if (g_once_init_enter (&is_initialized)) {
+		guint32 n;
+
+		for (n = 0; n < 256; n++) {
+			guint32 c = n;
+			gint k;
+
+			for (k = 0; k < 8; k++) {
+				c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+			}
+			crc_table[n] = c;
+		}
+		g_once_init_leave (&is_initialized, 1);
+	}
+}
+
+static guint32
+compute_checksum (const guchar * data,
+                  gsize length)
+{
+	guint32 crc = 0xffffffff;
+	gsize i;
+
+	init_crc_table ();
+	for (i = 0; i < length; i++) {
+		crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc ^ 0xffffffff;
+}
+
+static guint32
+read_uint32 (const guchar * data)
+{
+	guint32 value;
+
+	memcpy (&value, data, sizeof (value));
+	return GUINT32_FROM_LE (value);
+}
+
+static guint64
+read_uint64 (const guchar * data)
+{
+	guint64 value;
+
+	memcpy (&value, data, sizeof (value));
+	return GUINT64_FROM_LE (value);
+}
+
+static void
+write_uint32 (guchar * data,
+              guint32 value)
+{
+	value = GUINT32_TO_LE (value);
+	memcpy (data, &value, sizeof (value));
+}
+
+static void
+write_uint64 (guchar * data,
+              guint64 value)
+{
+	value = GUINT64_TO_LE (value);
+	memcpy (data, &value, sizeof (value));
+}
+
+static void
+append_varint (GByteArray * array,
+               guint64 value)
+{
+	guint8 byte;
+
+	while (value >= 0x80) {
+		byte = (value & 0x7f) | 0x80;
+		g_byte_array_append (array, &byte, 1);
+		value >>= 7;
+	}
+	byte = value;
+	g_byte_array_append (array, &byte, 1);
+}
+
+static gboolean
+read_varint (const guchar ** position,
+             const guchar * end,
+             guint64 * value)
+{
+	gint shift = 0;
+
+	*value = 0;
+	while ((*position < end) && (shift < 64)) {
+		guint8 byte = *(*position)++;
+
+		*value |= (guint64) (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return TRUE;
+		}
+		shift += 7;
+	}
+	return FALSE;
+}
+
+static void
+append_time (GByteArray * array,
+             gint64 value)
+{
+	append_varint (array, ((guint64) value << 1) ^ (guint64) (value >> 63));
+}
+
+static gboolean
+read_time (const guchar ** position,
+           const guchar * end,
+           gint64 * value)
+{
+	guint64 coded;
+
+	if (read_varint (position, end, &coded) == FALSE) {
+		return FALSE;
+	}
+	*value = (gint64) (coded >> 1) ^ -(gint64) (coded & 1);
+	return TRUE;
+}
+
+static gboolean
+read_entry (const guchar ** position,
+            const guchar * end,
+            GSearchIndexEntry * entry)
+{
+	guint64 mode;
+	guint64 size;
+	guint64 uid;
+	guint64 gid;
+
+	if ((read_varint (position, end, &mode) == FALSE) ||
+	    (read_varint (position, end, &size) == FALSE) ||
+	    (read_time (position, end, &entry->mtime) == FALSE) ||
+	    (read_varint (position, end, &uid) == FALSE) ||
+	    (read_varint (position, end, &gid) == FALSE)) {
+		return FALSE;
+	}
+	entry->mode = mode;
+	entry->size = size;
+	entry->uid = uid;
+	entry->gid = gid;
+	return TRUE;
+}
+
+/* Writes @text as the part it shares with @previous and the rest, and
+   makes it the one the next is written against. */
+static void
+append_front_coded (GByteArray * array,
+                    GString * previous,
+                    const gchar * text)
+{
+	gsize length = strlen (text);
+	gsize shared = 0;
+
+	while ((shared < previous->len) && (shared < length) && (previous->str[shared] == text[shared])) {
+		shared++;
+	}
+	append_varint (array, shared);
+	append_varint (array, length - shared);
+	g_byte_array_append (array, (const guint8 *) text + shared, length - shared);
+	g_string_assign (previous, text);
+}
+
+static gboolean
+read_front_coded (const guchar ** position,
+                  const guchar * end,
+                  GString * text)
+{
+	guint64 shared;
+	guint64 length;
+
+	if ((read_varint (position, end, &shared) == FALSE) ||
+	    (read_varint (position, end, &length) == FALSE) ||
+	    (shared > text->len) ||
+	    (length > (guint64) (end - *position))) {
+		return FALSE;
+	}
+	g_string_truncate (text, shared);
+	g_string_append_len (text, (const gchar *) *position, length);
+	*position += length;
+	return TRUE;
+}
+
+static guint32
+hash_trigram (const gchar * trigram)
+{
+	guint32 hash = 2166136261u;
+	gint i;
+
+	for (i = 0; i < GSEARCH_INDEX_TRIGRAM_LENGTH; i++) {
+		hash ^= (guchar) g_ascii_tolower (trigram[i]);
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+/* The two bits of a filter @hash sets. */
+static void
+get_filter_bits (guint32 hash,
+                 guint32 * first,
+                 guint32 * second)
+{
+	*first = hash % (GSEARCH_INDEX_FILTER_SIZE * 8);
+	*second = ((hash ^ (hash >> 15)) * 0x2c1b3c6d >> 7) % (GSEARCH_INDEX_FILTER_SIZE * 8);
+}
+
+static void
+add_name_to_filter (guint8 * filter,
+                    const gchar * name)
+{
+	gsize length = strlen (name);
+	gsize i;
+
+	for (i = 0; i + GSEARCH_INDEX_TRIGRAM_LENGTH <= length; i++) {
+		guint32 first;
+		guint32 second;
+
+		/* The match may fold other characters in other ways, see
+		   get_name_pattern_literals(). */
+		if (((guchar) name[i] >= 0x80) || ((guchar) name[i + 1] >= 0x80) || ((guchar) name[i + 2] >= 0x80)) {
+			continue;
+		}
+		get_filter_bits (hash_trigram (name + i), &first, &second);
+		filter[first / 8] |= 1 << (first % 8);
+		filter[second / 8] |= 1 << (second % 8);
+	}
+}
+
+/* Strips the trailing '/' off @folder, but for the root folder. */
+static gchar *
+normalize_folder (const gchar * folder)
+{
+	gchar * normalized = g_strdup (folder);
+	gsize length = strlen (normalized);
+
+	while ((length > 1) && (normalized[length - 1] == '/')) {
+		normalized[--length] = '\0';
+	}
+	return normalized;
+}
+
+static gboolean
+is_folder_inside (const gchar * path,
+                  const gchar * folder,
+                  gsize folder_length)
+{
+	if (strncmp (path, folder, folder_length) != 0) {
+		return FALSE;
+	}
+	return (folder_length == 1) ||
+	       (path[folder_length] == '\0') ||
+	       (path[folder_length] == '/');
+}
+
+GSearchIndexWriter *
+gsearchtool_index_writer_new (const gchar * root)
+{
+	GSearchIndexWriter * writer;
+
+	writer = g_slice_new0 (GSearchIndexWriter);
+	writer->root = normalize_folder (root);
+	writer->data = g_byte_array_new ();
+	writer->block = g_byte_array_new ();
+	writer->blocks = g_array_new (FALSE, FALSE, sizeof (GSearchIndexBlock));
+	writer->first_folders = g_string_new (NULL);
+	writer->previous_folder = g_string_new (NULL);
+	writer->previous_name = g_string_new (NULL);
+	writer->filter = g_malloc0 (GSEARCH_INDEX_FILTER_SIZE);
+	writer->filters = g_byte_array_new ();
+
+	g_byte_array_set_size (writer->data, GSEARCH_INDEX_HEADER_SIZE);
+	memset (writer->data->data, 0, GSEARCH_INDEX_HEADER_SIZE);
+	g_byte_array_append (writer->data, (const guint8 *) writer->root, strlen (writer->root) + 1);
+	return writer;
+}
+
+static void
+end_folder (GSearchIndexWriter * writer)
+{
+	guint8 end = GSEARCH_INDEX_END;
+
+	if (writer->has_folder == TRUE) {
+		g_byte_array_append (writer->block, &end, 1);
+		writer->has_folder = FALSE;
+	}
+}
+
+static void
+end_block (GSearchIndexWriter * writer)
+{
+	GSearchIndexBlock * block;
+	guchar trailer[GSEARCH_INDEX_FILTER_RECORD_SIZE - GSEARCH_INDEX_FILTER_SIZE] = { 0 };
+
+	if (writer->block->len == 0) {
+		return;
+	}
+	block = &g_array_index (writer->blocks, GSearchIndexBlock, writer->blocks->len - 1);
+	block->offset = writer->data->len;
+	block->length = writer->block->len;
+	block->checksum = compute_checksum (writer->block->data, writer->block->len);
+	g_byte_array_append (writer->data, writer->block->data, writer->block->len);
+	g_byte_array_set_size (writer->block, 0);
+
+	write_uint32 (trailer, compute_checksum (writer->filter, GSEARCH_INDEX_FILTER_SIZE));
+	g_byte_array_append (writer->filters, writer->filter, GSEARCH_INDEX_FILTER_SIZE);
+	g_byte_array_append (writer->filters, trailer, sizeof (trailer));
+	memset (writer->filter, 0, GSEARCH_INDEX_FILTER_SIZE);
+}
+
+/* Starts the record of the folder at @path.  The folders are added in
+   the order of compare_folder_paths(), which a walk taking the names of
+   each folder in the order of strcmp() gives.  @stamp may be NULL, the
+   record is then never reused. */
+void
+gsearchtool_index_writer_add_folder (GSearchIndexWriter * writer,
+                                     const gchar * path,
+                                     const GSearchIndexStamp * stamp)
+{
+	GSearchIndexStamp none = { 0 };
+
+	end_folder (writer);
+	if (writer->block->len >= GSEARCH_INDEX_BLOCK_SIZE) {
+		end_block (writer);
+	}
+	if (writer->block->len == 0) {
+		GSearchIndexBlock block = { 0 };
+
+		block.first_folder = writer->first_folders->len;
+		g_string_append_len (writer->first_folders, path, strlen (path) + 1);
+		g_array_append_val (writer->blocks, block);
+		g_string_truncate (writer->previous_folder, 0);
+	}
+	append_front_coded (writer->block, writer->previous_folder, path);
+	if (stamp == NULL) {
+		stamp = &none;
+	}
+	append_varint (writer->block, stamp->device);
+	append_varint (writer->block, stamp->inode);
+	append_time (writer->block, stamp->mtime);
+	append_time (writer->block, stamp->ctime);
+	g_string_truncate (writer->previous_name, 0);
+	writer->has_folder = TRUE;
+	writer->folders++;
+}
+
+/* Adds a file of the folder last added, in the order of strcmp(). */
+void
+gsearchtool_index_writer_add_entry (GSearchIndexWriter * writer,
+                                    const gchar * name,
+                                    const GSearchIndexEntry * entry)
+{
+	guint8 type = entry->type;
+
+	g_return_if_fail (writer->has_folder == TRUE);
+
+	g_byte_array_append (writer->block, &type, 1);
+	append_front_coded (writer->block, writer->previous_name, name);
+	add_name_to_filter (writer->filter, name);
+	append_varint (writer->block, entry->mode);
+	append_varint (writer->block, entry->size);
+	append_time (writer->block, entry->mtime);
+	append_varint (writer->block, entry->uid);
+	append_varint (writer->block, entry->gid);
+	writer->entries++;
+}
+
+gboolean
+gsearchtool_index_writer_write (GSearchIndexWriter * writer,
+                                const gchar * path,
+                                GError ** error)
+{
+	guchar * header;
+	guint64 paths;
+	guint64 filters;
+	guint64 directory;
+	guint i;
+
+	end_folder (writer);
+	end_block (writer);
+
+	paths = writer->data->len;
+	g_byte_array_append (writer->data, (const guint8 *) writer->first_folders->str, writer->first_folders->len);
+	while ((writer->data->len % 8) != 0) {
+		guint8 padding = 0;
+
+		g_byte_array_append (writer->data, &padding, 1);
+	}
+	filters = writer->data->len;
+	g_byte_array_append (writer->data, writer->filters->data, writer->filters->len);
+	directory = writer->data->len;
+	for (i = 0; i < writer->blocks->len; i++) {
+		GSearchIndexBlock * block = &g_array_index (writer->blocks, GSearchIndexBlock, i);
+		guchar record[GSEARCH_INDEX_DIRECTORY_RECORD_SIZE];
+
+		write_uint64 (record, block->offset);
+		write_uint64 (record + 8, paths + block->first_folder);
+		write_uint32 (record + 16, block->length);
+		write_uint32 (record + 20, block->checksum);
+		write_uint64 (record + 24, filters + (guint64) i * GSEARCH_INDEX_FILTER_RECORD_SIZE);
+		g_byte_array_append (writer->data, record, sizeof (record));
+	}
+
+	header = writer->data->data;
+	memcpy (header, GSEARCH_INDEX_MAGIC, GSEARCH_INDEX_MAGIC_LENGTH);
+	write_uint32 (header + GSEARCH_INDEX_HEADER_VERSION, GSEARCH_INDEX_VERSION);
+	write_uint32 (header + GSEARCH_INDEX_HEADER_FLAGS, 0);
+	write_uint64 (header + GSEARCH_INDEX_HEADER_TIME, time (NULL));
+	write_uint64 (header + GSEARCH_INDEX_HEADER_ENTRIES, writer->entries);
+	write_uint64 (header + GSEARCH_INDEX_HEADER_FOLDERS, writer->folders);
+	write_uint64 (header + GSEARCH_INDEX_HEADER_PATHS, paths);
+	write_uint64 (header + GSEARCH_INDEX_HEADER_DIRECTORY, directory);
+	write_uint32 (header + GSEARCH_INDEX_HEADER_BLOCKS, writer->blocks->len);
+	write_uint32 (header + GSEARCH_INDEX_HEADER_CHECKSUM, compute_checksum (header, GSEARCH_INDEX_HEADER_CHECKSUM));
+
+	/* The new index takes the place of the old one at once, a search
+	   reading the old one keeps its mapping. */
+	return g_file_set_contents (path, (const gchar *) writer->data->data, writer->data->len, error);
+}
+
+void
+gsearchtool_index_writer_free (GSearchIndexWriter * writer)
+{
+	g_free (writer->root);
+	g_byte_array_free (writer->data, TRUE);
+	g_byte_array_free (writer->block, TRUE);
+	g_array_free (writer->blocks, TRUE);
+	g_string_free (writer->first_folders, TRUE);
+	g_string_free (writer->previous_folder, TRUE);
+	g_string_free (writer->previous_name, TRUE);
+	g_free (writer->filter);
+	g_byte_array_free (writer->filters, TRUE);
+	g_slice_free (GSearchIndexWriter, writer);
+}
+
+gchar *
+gsearchtool_index_get_default_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), GSEARCH_INDEX_CACHE_FOLDER, GSEARCH_INDEX_FILENAME, NULL);
+}
+
+/* Maps the index at @path and checks its header, NULL if it is not an
+   index or not one of this version. */
+GSearchIndex *
+gsearchtool_index_open (const gchar * path)
+{
+	GSearchIndex * index;
+	struct stat index_stat;
+	gpointer data;
+	gint fd;
+
+	fd = g_open (path, O_RDONLY, 0);
+	if (fd < 0) {
+		return NULL;
+	}
+	if ((fstat (fd, &index_stat) != 0) ||
+	    (index_stat.st_size <= GSEARCH_INDEX_HEADER_SIZE) ||
+	    ((guint64) index_stat.st_size > G_MAXSIZE)) {
+		close (fd);
+		return NULL;
+	}
+	data = mmap (NULL, index_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+
+	index = g_slice_new0 (GSearchIndex);
+	index->ref_count = 1;
+	index->path = g_strdup (path);
+	index->data = data;
+	index->length = index_stat.st_size;
+	index->device = index_stat.st_dev;
+	index->inode = index_stat.st_ino;
+	index->mtime = index_stat.st_mtime;
+	index->size = index_stat.st_size;
+
+	if ((memcmp (index->data, GSEARCH_INDEX_MAGIC, GSEARCH_INDEX_MAGIC_LENGTH) != 0) ||
+	    (read_uint32 (index->data + GSEARCH_INDEX_HEADER_VERSION) != GSEARCH_INDEX_VERSION) ||
+	    (read_uint32 (index->data + GSEARCH_INDEX_HEADER_CHECKSUM) !=
+	     compute_checksum (index->data, GSEARCH_INDEX_HEADER_CHECKSUM))) {
+		gsearchtool_index_unref (index);
+		return NULL;
+	}
+	index->paths = read_uint64 (index->data + GSEARCH_INDEX_HEADER_PATHS);
+	index->directory = read_uint64 (index->data + GSEARCH_INDEX_HEADER_DIRECTORY);
+	index->blocks = read_uint32 (index->data + GSEARCH_INDEX_HEADER_BLOCKS);
+	if ((index->paths > index->directory) ||
+	    (index->directory > index->length) ||
+	    ((index->length - index->directory) / GSEARCH_INDEX_DIRECTORY_RECORD_SIZE < index->blocks) ||
+	    (memchr (index->data + GSEARCH_INDEX_HEADER_SIZE, '\0', index->length - GSEARCH_INDEX_HEADER_SIZE) == NULL)) {
+		gsearchtool_index_unref (index);
+		return NULL;
+	}
+	return index;
+}
+
+GSearchIndex *
+gsearchtool_index_ref (GSearchIndex * index)
+{
+	index->ref_count++;
+	return index;
+}
+
+void
+gsearchtool_index_unref (GSearchIndex * index)
+{
+	if (--index->ref_count > 0) {
+		return;
+	}
+	munmap ((gpointer) index->data, index->length);
+	g_free (index->checked_blocks);
+	g_free (index->checked_filters);
+	g_free (index->path);
+	g_slice_free (GSearchIndex, index);
+}
+
+/* FALSE once the index has been built again. */
+gboolean
+gsearchtool_index_is_current (GSearchIndex * index)
+{
+	GStatBuf index_stat;
+
+	if (g_stat (index->path, &index_stat) != 0) {
+		return FALSE;
+	}
+	return (index_stat.st_dev == index->device) &&
+	       (index_stat.st_ino == index->inode) &&
+	       (index_stat.st_mtime == index->mtime) &&
+	       (index_stat.st_size == index->size);
+}
+
+const gchar *
+gsearchtool_index_get_root (GSearchIndex * index)
+{
+	return (const gchar *) index->data + GSEARCH_INDEX_HEADER_SIZE;
+}
+
+/* When the index was built. */
+gint64
+gsearchtool_index_get_time (GSearchIndex * index)
+{
+	return read_uint64 (index->data + GSEARCH_INDEX_HEADER_TIME);
+}
+
+guint64
+gsearchtool_index_get_entries (GSearchIndex * index)
+{
+	return read_uint64 (index->data + GSEARCH_INDEX_HEADER_ENTRIES);
+}
+
+/* Whether the files in @folder are all in the index. */
+gboolean
+gsearchtool_index_covers (GSearchIndex * index,
+                          const gchar * folder)
+{
+	const gchar * root = gsearchtool_index_get_root (index);
+	gchar * normalized;
+	gboolean is_covered;
+
+	normalized = normalize_folder (folder);
+	is_covered = is_folder_inside (normalized, root, strlen (root));
+	g_free (normalized);
+	return is_covered;
+}
+
+static const guchar *
+get_block_record (GSearchIndex * index,
+                  guint32 block)
+{
+	return index->data + index->directory + (gsize) block * GSEARCH_INDEX_DIRECTORY_RECORD_SIZE;
+}
+
+/* The path of the first folder of @block, NULL if the index is damaged. */
+static const gchar *
+get_block_first_folder (GSearchIndex * index,
+                        guint32 block)
+{
+	guint64 offset = read_uint64 (get_block_record (index, block) + 8);
+
+	if ((offset < index->paths) || (offset >= index->directory) ||
+	    (memchr (index->data + offset, '\0', index->directory - offset) == NULL)) {
+		return NULL;
+	}
+	return (const gchar *) index->data + offset;
+}
+
+/* Starts reading @block, FALSE if its checksum does not match. */
+static gboolean
+enter_block (GSearchIndexCursor * cursor)
+{
+	GSearchIndex * index = cursor->index;
+	const guchar * record = get_block_record (index, cursor->block);
+	guint64 offset = read_uint64 (record);
+	guint32 length = read_uint32 (record + 16);
+
+	if ((offset > index->paths) || (length > index->paths - offset)) {
+		return FALSE;
+	}
+	if (index->checked_blocks == NULL) {
+		index->checked_blocks = g_new0 (guint8, index->blocks);
+	}
+	if (index->checked_blocks[cursor->block] == FALSE) {
+		if (compute_checksum (index->data + offset, length) != read_uint32 (record + 20)) {
+			return FALSE;
+		}
+		index->checked_blocks[cursor->block] = TRUE;
+	}
+	cursor->position = index->data + offset;
+	cursor->end = cursor->position + length;
+	cursor->state = GSEARCH_INDEX_CURSOR_FOLDER;
+	g_string_truncate (cursor->folder_path, 0);
+	return TRUE;
+}
+
+/* Whether the filter of the block @cursor is on rules out every name it
+   looks for.  A damaged filter rules out none. */
+static gboolean
+is_block_ruled_out (GSearchIndexCursor * cursor)
+{
+	GSearchIndex * index = cursor->index;
+	guint64 offset = read_uint64 (get_block_record (index, cursor->block) + 24);
+	const guchar * filter;
+	guint i;
+
+	if ((cursor->trigrams->len == 0) ||
+	    (offset < index->paths) || (offset > index->directory) ||
+	    (index->directory - offset < GSEARCH_INDEX_FILTER_RECORD_SIZE)) {
+		return FALSE;
+	}
+	filter = index->data + offset;
+	if (index->checked_filters == NULL) {
+		index->checked_filters = g_new0 (guint8, index->blocks);
+	}
+	if (index->checked_filters[cursor->block] == FALSE) {
+		if (compute_checksum (filter, GSEARCH_INDEX_FILTER_SIZE) != read_uint32 (filter + GSEARCH_INDEX_FILTER_SIZE)) {
+			return FALSE;
+		}
+		index->checked_filters[cursor->block] = TRUE;
+	}
+	for (i = 0; i < cursor->trigrams->len; i++) {
+		guint32 first;
+		guint32 second;
+
+		get_filter_bits (g_array_index (cursor->trigrams, guint32, i), &first, &second);
+		if (((filter[first / 8] & (1 << (first % 8))) == 0) ||
+		    ((filter[second / 8] & (1 << (second % 8))) == 0)) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* Reads the path and stamp of the next folder record. */
+static gboolean
+read_folder (GSearchIndexCursor * cursor)
+{
+	GSearchIndexStamp * stamp = &cursor->stamp;
+
+	g_string_truncate (cursor->name, 0);
+	return (read_front_coded (&cursor->position, cursor->end, cursor->folder_path) == TRUE) &&
+	       (read_varint (&cursor->position, cursor->end, &stamp->device) == TRUE) &&
+	       (read_varint (&cursor->position, cursor->end, &stamp->inode) == TRUE) &&
+	       (read_time (&cursor->position, cursor->end, &stamp->mtime) == TRUE) &&
+	       (read_time (&cursor->position, cursor->end, &stamp->ctime) == TRUE);
+}
+
+/* Reads the rest of the files of the folder record, their names into
+   @names and what the index has of them into @entries, either of which
+   may be NULL. */
+static gboolean
+read_folder_entries (GSearchIndexCursor * cursor,
+                     GPtrArray * names,
+                     GArray * entries)
+{
+	while (cursor->position < cursor->end) {
+		guint8 type = *cursor->position++;
+
+		if (type == GSEARCH_INDEX_END) {
+			cursor->state = GSEARCH_INDEX_CURSOR_FOLDER;
+			return TRUE;
+		}
+		if ((read_front_coded (&cursor->position, cursor->end, cursor->name) == FALSE) ||
+		    (read_entry (&cursor->position, cursor->end, &cursor->entry) == FALSE)) {
+			return FALSE;
+		}
+		cursor->entry.type = type;
+		if (names != NULL) {
+			g_ptr_array_add (names, g_strndup (cursor->name->str, cursor->name->len));
+		}
+		if (entries != NULL) {
+			g_array_append_val (entries, cursor->entry);
+		}
+	}
+	return FALSE;
+}
+
+/* Looks for the names matching @name_pattern in @folder and the folders
+   inside it. */
+GSearchIndexCursor *
+gsearchtool_index_cursor_new (GSearchIndex * index,
+                              const gchar * folder,
+                              const gchar * name_pattern)
+{
+	GSearchIndexCursor * cursor;
+	guint32 low = 0;
+	guint32 high = index->blocks;
+	gchar ** literals;
+	gint i;
+
+	cursor = g_slice_new0 (GSearchIndexCursor);
+	cursor->index = gsearchtool_index_ref (index);
+	cursor->folder = normalize_folder (folder);
+	cursor->folder_length = strlen (cursor->folder);
+	cursor->name_pattern = g_strdup (name_pattern);
+	cursor->trigrams = g_array_new (FALSE, FALSE, sizeof (guint32));
+	cursor->folder_path = g_string_new (NULL);
+	cursor->name = g_string_new (NULL);
+
+	literals = (name_pattern != NULL) ? get_name_pattern_literals (name_pattern, GSEARCH_INDEX_TRIGRAM_LENGTH) : NULL;
+	for (i = 0; (literals != NULL) && (literals[i] != NULL); i++) {
+		const gchar * trigram;
+
+		for (trigram = literals[i]; strlen (trigram) >= GSEARCH_INDEX_TRIGRAM_LENGTH; trigram++) {
+			guint32 hash = hash_trigram (trigram);
+
+			g_array_append_val (cursor->trigrams, hash);
+		}
+	}
+	g_strfreev (literals);
+
+	/* The last block starting before the folder holds its record, or
+	   the folder starts the block after it. */
+	while (low < high) {
+		guint32 middle = low + (high - low) / 2;
+		const gchar * first_folder = get_block_first_folder (index, middle);
+
+		if (first_folder == NULL) {
+			cursor->is_damaged = TRUE;
+			break;
+		}
+		if (compare_folder_paths (first_folder, cursor->folder) < 0) {
+			cursor->block = middle;
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	cursor->is_finished = (cursor->is_damaged == TRUE) || (index->blocks == 0);
+	return cursor;
+}
+
+/* Only finds the files @predicate holds for in the index, see
+   gsearchtool_predicate_evaluate().  The index may be older than the
+   files, so the ones found are still to be tested on a stat. */
+void
+gsearchtool_index_cursor_set_predicate (GSearchIndexCursor * cursor,
+                                        GSearchPredicate * predicate,
+                                        gint64 now)
+{
+	cursor->predicate = predicate;
+	cursor->now = now;
+}
+
+/* Sets @path to the next file found, FALSE when there are no more or
+   the index turned out to be damaged.  When @budget is not NULL it is
+   the number of records and blocks that may still be read, taken down
+   as they are, and FALSE with a @budget of 0 means the search is not
+   over, so a caller can look at the time between calls. */
+gboolean
+gsearchtool_index_cursor_next (GSearchIndexCursor * cursor,
+                               GString * path,
+                               guint * budget)
+{
+	while (cursor->is_finished == FALSE) {
+		guint8 type;
+
+		if (budget != NULL) {
+			if (*budget == 0) {
+				return FALSE;
+			}
+			(*budget)--;
+		}
+
+		if (cursor->position == NULL) {
+			if (cursor->block >= cursor->index->blocks) {
+				cursor->is_finished = TRUE;
+				break;
+			}
+			if (is_block_ruled_out (cursor) == TRUE) {
+				const gchar * first_folder = get_block_first_folder (cursor->index, cursor->block);
+
+				/* Passed over unread, but for the one past the
+				   folder, which ends the search. */
+				if ((first_folder != NULL) &&
+				    (is_folder_inside (first_folder, cursor->folder, cursor->folder_length) == FALSE) &&
+				    (compare_folder_paths (first_folder, cursor->folder) > 0)) {
+					cursor->is_finished = TRUE;
+					break;
+				}
+				cursor->block++;
+				continue;
+			}
+			if (enter_block (cursor) == FALSE) {
+				cursor->is_damaged = TRUE;
+				cursor->is_finished = TRUE;
+				break;
+			}
+		}
+
+		if (cursor->state == GSEARCH_INDEX_CURSOR_FOLDER) {
+			if (cursor->position == cursor->end) {
+				cursor->block++;
+				cursor->position = NULL;
+				continue;
+			}
+			if (read_folder (cursor) == FALSE) {
+				cursor->is_damaged = TRUE;
+				cursor->is_finished = TRUE;
+				break;
+			}
+			if (is_folder_inside (cursor->folder_path->str, cursor->folder, cursor->folder_length)) {
+				cursor->state = GSEARCH_INDEX_CURSOR_MATCHING;
+			}
+			else if (compare_folder_paths (cursor->folder_path->str, cursor->folder) > 0) {
+				cursor->is_finished = TRUE;
+				break;
+			}
+			else {
+				cursor->state = GSEARCH_INDEX_CURSOR_SKIPPING;
+			}
+			continue;
+		}
+
+		if (cursor->position == cursor->end) {
+			cursor->is_damaged = TRUE;
+			cursor->is_finished = TRUE;
+			break;
+		}
+		type = *cursor->position++;
+		if (type == GSEARCH_INDEX_END) {
+			cursor->state = GSEARCH_INDEX_CURSOR_FOLDER;
+			continue;
+		}
+		if ((read_front_coded (&cursor->position, cursor->end, cursor->name) == FALSE) ||
+		    (read_entry (&cursor->position, cursor->end, &cursor->entry) == FALSE)) {
+			cursor->is_damaged = TRUE;
+			cursor->is_finished = TRUE;
+			break;
+		}
+		if ((cursor->state == GSEARCH_INDEX_CURSOR_MATCHING) &&
+		    compare_name_pattern (cursor->name_pattern, cursor->name->str)) {
+			cursor->entry.type = type;
+			g_string_assign (path, cursor->folder_path->str);
+			if ((path->len == 0) || (path->str[path->len - 1] != '/')) {
+				g_string_append_c (path, '/');
+			}
+			g_string_append_len (path, cursor->name->str, cursor->name->len);
+
+			if (cursor->predicate != NULL) {
+				GSearchIoStat io_stat = { 0 };
+
+				io_stat.mode = cursor->entry.mode;
+				io_stat.size = cursor->entry.size;
+				io_stat.mtime = cursor->entry.mtime;
+				io_stat.uid = cursor->entry.uid;
+				io_stat.gid = cursor->entry.gid;
+				if (gsearchtool_predicate_evaluate (cursor->predicate, cursor->folder, path->str,
+				                                    &io_stat, cursor->now) == FALSE) {
+					continue;
+				}
+			}
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* What the index holds of the file last found. */
+const GSearchIndexEntry *
+gsearchtool_index_cursor_get_entry (GSearchIndexCursor * cursor)
+{
+	return &cursor->entry;
+}
+
+gboolean
+gsearchtool_index_cursor_is_damaged (GSearchIndexCursor * cursor)
+{
+	return cursor->is_damaged;
+}
+
+void
+gsearchtool_index_cursor_free (GSearchIndexCursor * cursor)
+{
+	gsearchtool_index_unref (cursor->index);
+	g_free (cursor->folder);
+	g_free (cursor->name_pattern);
+	g_array_free (cursor->trigrams, TRUE);
+	g_string_free (cursor->folder_path, TRUE);
+	g_string_free (cursor->name, TRUE);
+	g_slice_free (GSearchIndexCursor, cursor);
+}
+
+static gint
+compare_names (gconstpointer a,
+               gconstpointer b)
+{
+	return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+static void
+get_stamp (const GStatBuf * folder_stat,
+           GSearchIndexStamp * stamp)
+{
+	stamp->device = folder_stat->st_dev;
+	stamp->inode = folder_stat->st_ino;
+	stamp->mtime = folder_stat->st_mtime;
+	stamp->ctime = folder_stat->st_ctime;
+}
+
+/* Moves @cursor to the record of @folder, FALSE when the index has none.
+   The folders are to be looked for in the order of the index. */
+static gboolean
+seek_folder (GSearchIndexCursor * cursor,
+             const gchar * folder)
+{
+	while (cursor->is_finished == FALSE) {
+		gint order;
+
+		if (cursor->position == NULL) {
+			if ((cursor->block >= cursor->index->blocks) ||
+			    (enter_block (cursor) == FALSE)) {
+				cursor->is_finished = TRUE;
+				break;
+			}
+		}
+		if (cursor->state == GSEARCH_INDEX_CURSOR_FOLDER) {
+			if (cursor->position == cursor->end) {
+				cursor->block++;
+				cursor->position = NULL;
+				continue;
+			}
+			if (read_folder (cursor) == FALSE) {
+				cursor->is_finished = TRUE;
+				break;
+			}
+			cursor->state = GSEARCH_INDEX_CURSOR_SKIPPING;
+		}
+
+		order = compare_folder_paths (cursor->folder_path->str, folder);
+		if (order == 0) {
+			return TRUE;
+		}
+		if (order > 0) {
+			return FALSE;
+		}
+		if (read_folder_entries (cursor, NULL, NULL) == FALSE) {
+			cursor->is_finished = TRUE;
+			break;
+		}
+	}
+	return FALSE;
+}
+
+/* The names of the files @build->previous has in @folder, when they
+   are still those in @folder.  A folder changed in the second the index
+   was built may not show it in its times, so only the ones older than
+   that count. */
+static gboolean
+read_previous_folder (GSearchIndexBuild * build,
+                      const gchar * folder,
+                      const GSearchIndexStamp * stamp,
+                      GPtrArray * names)
+{
+	GSearchIndexCursor * previous = build->previous;
+
+	if ((previous == NULL) ||
+	    (stamp->mtime >= build->previous_time) ||
+	    (stamp->ctime >= build->previous_time) ||
+	    (seek_folder (previous, folder) == FALSE) ||
+	    (memcmp (&previous->stamp, stamp, sizeof (GSearchIndexStamp)) != 0)) {
+		return FALSE;
+	}
+	if (read_folder_entries (previous, names, NULL) == FALSE) {
+		previous->is_finished = TRUE;
+		g_ptr_array_set_size (names, 0);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* Reads the names of the files in @folder, in the order of strcmp(). */
+static void
+read_folder_names (const gchar * folder,
+                   GPtrArray * names)
+{
+	const gchar * name;
+	GDir * dir;
+
+	dir = g_dir_open (folder, 0, NULL);
+	if (dir == NULL) {
+		return;
+	}
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		g_ptr_array_add (names, g_strdup (name));
+	}
+	g_dir_close (dir);
+	g_ptr_array_sort (names, compare_names);
+}
+
+/* Takes the lstat of each of the files @names in @folder, the folders
+   inside it on the same filesystem are added to @folders. */
+static void
+stat_folder_files (GSearchIndexBuild * build,
+                   const gchar * folder,
+                   GPtrArray * names,
+                   GArray * entries,
+                   GArray * folders)
+{
+	guint i;
+
+	g_array_set_size (entries, names->len);
+	for (i = 0; i < names->len; i++) {
+		GSearchIndexEntry * entry = &g_array_index (entries, GSearchIndexEntry, i);
+		GSearchIndexFolder child;
+
+		memset (entry, 0, sizeof (GSearchIndexEntry));
+		entry->type = GSEARCH_INDEX_OTHER;
+		child.path = g_build_filename (folder, g_ptr_array_index (names, i), NULL);
+		if (g_lstat (child.path, &child.stat) == 0) {
+			entry->mode = child.stat.st_mode;
+			entry->size = child.stat.st_size;
+			entry->mtime = child.stat.st_mtime;
+			entry->uid = child.stat.st_uid;
+			entry->gid = child.stat.st_gid;
+			if (S_ISREG (child.stat.st_mode)) {
+				entry->type = GSEARCH_INDEX_REGULAR;
+			}
+			else if (S_ISDIR (child.stat.st_mode)) {
+				entry->type = GSEARCH_INDEX_FOLDER;
+				if (child.stat.st_dev == build->device) {
+					g_array_append_val (folders, child);
+					child.path = NULL;
+				}
+			}
+			else if (S_ISLNK (child.stat.st_mode)) {
+				entry->type = GSEARCH_INDEX_LINK;
+			}
+		}
+		g_free (child.path);
+	}
+}
+
+/* Adds @folder and the folders inside it on the same filesystem. */
+static void
+index_folder (GSearchIndexBuild * build,
+              const gchar * folder,
+              const GStatBuf * folder_stat)
+{
+	GSearchIndexStamp stamp;
+	GPtrArray * names;
+	GArray * entries;
+	GArray * folders;
+	guint i;
+
+	get_stamp (folder_stat, &stamp);
+	names = g_ptr_array_new_with_free_func (g_free);
+	entries = g_array_new (FALSE, FALSE, sizeof (GSearchIndexEntry));
+	folders = g_array_new (FALSE, FALSE, sizeof (GSearchIndexFolder));
+
+	if (read_previous_folder (build, folder, &stamp, names) == FALSE) {
+		read_folder_names (folder, names);
+	}
+	stat_folder_files (build, folder, names, entries, folders);
+
+	gsearchtool_index_writer_add_folder (build->writer, folder, &stamp);
+	for (i = 0; i < names->len; i++) {
+		gsearchtool_index_writer_add_entry (build->writer, g_ptr_array_index (names, i),
+		                                    &g_array_index (entries, GSearchIndexEntry, i));
+	}
+	g_ptr_array_free (names, TRUE);
+	g_array_free (entries, TRUE);
+
+	for (i = 0; i < folders->len; i++) {
+		GSearchIndexFolder * child = &g_array_index (folders, GSearchIndexFolder, i);
+
+		index_folder (build, child->path, &child->stat);
+		g_free (child->path);
+	}
+	g_array_free (folders, TRUE);
+}
+
+/* Indexes the files in @root and the folders inside it, without going
+   into other filesystems, and writes the index to @path.  The names in
+   the folders unchanged since the index at @path was built are taken
+   from it, their files are still stated. */
+gboolean
+gsearchtool_index_build (const gchar * root,
+                         const gchar * path,
+                         GError ** error)
+{
+	GSearchIndexBuild build = { NULL };
+	GSearchIndex * previous;
+	GStatBuf root_stat;
+	gchar * directory;
+	gboolean is_written;
+
+	if (g_stat (root, &root_stat) != 0 || !S_ISDIR (root_stat.st_mode)) {
+		g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_NOTDIR, "%s", root);
+		return FALSE;
+	}
+	directory = g_path_get_dirname (path);
+	g_mkdir_with_parents (directory, 0700);
+	g_free (directory);
+
+	build.writer = gsearchtool_index_writer_new (root);
+	build.device = root_stat.st_dev;
+	previous = gsearchtool_index_open (path);
+	if (previous != NULL) {
+		build.previous = gsearchtool_index_cursor_new (previous, "/", NULL);
+		build.previous_time = gsearchtool_index_get_time (previous);
+		gsearchtool_index_unref (previous);
+	}
+
+	index_folder (&build, build.writer->root, &root_stat);
+	is_written = gsearchtool_index_writer_write (build.writer, path, error);
+	if (build.previous != NULL) {
+		gsearchtool_index_cursor_free (build.previous);
+	}
+	gsearchtool_index_writer_free (build.writer);
+	return is_written;
+}
@@ -0,0 +1,132 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-index.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_INDEX_H_
+#define _GSEARCHTOOL_INDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+#include "gsearchtool-predicate.h"
+
+typedef enum {
+	GSEARCH_INDEX_REGULAR,
+	GSEARCH_INDEX_FOLDER,
+	GSEARCH_INDEX_LINK,
+	GSEARCH_INDEX_OTHER
+} GSearchIndexType;
+
+typedef struct _GSearchIndex GSearchIndex;
+typedef struct _GSearchIndexWriter GSearchIndexWriter;
+typedef struct _GSearchIndexCursor GSearchIndexCursor;
+
+/* What the index holds of a file besides its path, from an lstat. */
+typedef struct {
+	GSearchIndexType        type;
+	guint32                 mode;
+	gint64                  size;
+	gint64                  mtime;
+	guint32                 uid;
+	guint32                 gid;
+} GSearchIndexEntry;
+
+/* What the index holds of a folder, to tell whether its files changed
+   since it was indexed. */
+typedef struct {
+	guint64                 device;
+	guint64                 inode;
+	gint64                  mtime;
+	gint64                  ctime;
+} GSearchIndexStamp;
+
+GSearchIndexWriter *
+gsearchtool_index_writer_new (const gchar * root);
+void
+gsearchtool_index_writer_add_folder (GSearchIndexWriter * writer,
+                                     const gchar * path,
+                                     const GSearchIndexStamp * stamp);
+void
+gsearchtool_index_writer_add_entry (GSearchIndexWriter * writer,
+                                    const gchar * name,
+                                    const GSearchIndexEntry * entry);
+gboolean
+gsearchtool_index_writer_write (GSearchIndexWriter * writer,
+                                const gchar * path,
+                                GError ** error);
+void
+gsearchtool_index_writer_free (GSearchIndexWriter * writer);
+
+gboolean
+gsearchtool_index_build (const gchar * root,
+                         const gchar * path,
+                         GError ** error);
+gchar *
+gsearchtool_index_get_default_path (void);
+
+GSearchIndex *
+gsearchtool_index_open (const gchar * path);
+GSearchIndex *
+gsearchtool_index_ref (GSearchIndex * index);
+void
+gsearchtool_index_unref (GSearchIndex * index);
+gboolean
+gsearchtool_index_is_current (GSearchIndex * index);
+const gchar *
+gsearchtool_index_get_root (GSearchIndex * index);
+gint64
+gsearchtool_index_get_time (GSearchIndex * index);
+guint64
+gsearchtool_index_get_entries (GSearchIndex * index);
+gboolean
+gsearchtool_index_covers (GSearchIndex * index,
+                          const gchar * folder);
+
+GSearchIndexCursor *
+gsearchtool_index_cursor_new (GSearchIndex * index,
+                              const gchar * folder,
+                              const gchar * name_pattern);
+void
+gsearchtool_index_cursor_set_predicate (GSearchIndexCursor * cursor,
+                                        GSearchPredicate * predicate,
+                                        gint64 now);
+gboolean
+gsearchtool_index_cursor_next (GSearchIndexCursor * cursor,
+                               GString * path,
+                               guint * budget);
+const GSearchIndexEntry *
+gsearchtool_index_cursor_get_entry (GSearchIndexCursor * cursor);
+gboolean
+gsearchtool_index_cursor_is_damaged (GSearchIndexCursor * cursor);
+void
+gsearchtool_index_cursor_free (GSearchIndexCursor * cursor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_INDEX_H_ */
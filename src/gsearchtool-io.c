@@ -0,0 +1,813 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-io.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Stats, opens and reads the start of many files at once.
+ *
+ * On Linux, when the kernel has io_uring and supports the requests used
+ * here, a batch of files goes to the kernel as one submission per ring
+ * full, instead of one system call per file and per step.  Each thread
+ * has a ring of its own, made the first time it is needed.  Anywhere
+ * else, or with the rings turned off, the files of a large stat batch
+ * are spread over a pool of threads, and the rest is done one file at
+ * a time.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_SYSMACROS_H
+#  include <sys/sysmacros.h>
+#endif
+#include <glib/gstdio.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#  include <linux/io_uring.h>
+#  include <linux/stat.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  if defined (__NR_io_uring_setup) && defined (__NR_io_uring_enter) && defined (__NR_io_uring_register)
+#    define GSEARCH_IO_URING 1
+#  endif
+#endif
+
+#include "gsearchtool-io.h"
+
+#define GSEARCH_IO_RING_ENTRIES 128
+#define GSEARCH_IO_THREAD_BATCH 32
+
+static gboolean is_uring_enabled = TRUE;
+static gboolean is_uring_broken = FALSE;
+
+/* The files of a stat batch handed to one thread of the pool. */
+typedef struct {
+	const gchar * const   * paths;
+	GSearchIoStat         * stats;
+	guint                   n_paths;
+	guint                   remaining;
+	GMutex                  lock;
+	GCond                   cond;
+} GSearchIoBatch;
+
+typedef struct {
+	GSearchIoBatch        * batch;
+	guint                   first;
+	guint                   last;
+} GSearchIoSlice;
+
+static void
+stat_file (const gchar * path,
+           GSearchIoStat * io_stat)
+{
+	GStatBuf file_stat;
+
+	memset (io_stat, 0, sizeof (*io_stat));
+	if (g_stat (path, &file_stat) != 0) {
+		io_stat->error = errno;
+		if (io_stat->error != ENOENT || g_lstat (path, &file_stat) != 0) {
+			return;
+		}
+		io_stat->error = 0;
+	}
+	io_stat->mode = file_stat.st_mode;
+	io_stat->size = file_stat.st_size;
+	io_stat->mtime = file_stat.st_mtime;
+	io_stat->uid = file_stat.st_uid;
+	io_stat->gid = file_stat.st_gid;
+	io_stat->device = file_stat.st_dev;
+	io_stat->inode = file_stat.st_ino;
+}
+
+static void
+stat_slice (GSearchIoSlice * slice,
+            gpointer data)
+{
+	GSearchIoBatch * batch = slice->batch;
+	guint i;
+
+	for (i = slice->first; i < slice->last; i++) {
+		stat_file (batch->paths[i], &batch->stats[i]);
+	}
+
+	g_mutex_lock (&batch->lock);
+	batch->remaining--;
+	g_cond_signal (&batch->cond);
+	g_mutex_unlock (&batch->lock);
+
+	g_slice_free (GSearchIoSlice, slice);
+}
+
+static GThreadPool *
+get_stat_pool (void)
+{
+	static gsize pool = 0;
+
+	if (g_once_init_enter (&pool)) {
+		GThreadPool * new_pool;
+
+		new_pool = g_thread_pool_new ((GFunc) stat_slice, NULL, g_get_num_processors (), FALSE, NULL);
+		g_once_init_leave (&pool, (gsize) new_pool);
+	}
+	return (GThreadPool *) pool;
+}
+
+/* Waits for the slices of @paths, with the calling thread taking the
+   first of them. */
+static void
+stat_files_on_pool (const gchar * const * paths,
+                    guint n_paths,
+                    GSearchIoStat * stats)
+{
+	GSearchIoBatch batch;
+	guint n_slices;
+	guint slice_size;
+	guint i;
+
+	n_slices = MIN (g_get_num_processors (), (n_paths + GSEARCH_IO_THREAD_BATCH - 1) / GSEARCH_IO_THREAD_BATCH);
+	slice_size = (n_paths + n_slices - 1) / n_slices;
+
+	batch.paths = paths;
+	batch.stats = stats;
+	batch.n_paths = n_paths;
+	batch.remaining = n_slices;
+	g_mutex_init (&batch.lock);
+	g_cond_init (&batch.cond);
+
+	for (i = 1; i < n_slices; i++) {
+		GSearchIoSlice * slice;
+
+		slice = g_slice_new (GSearchIoSlice);
+		slice->batch = &batch;
+		slice->first = i * slice_size;
+		slice->last = MIN (n_paths, slice->first + slice_size);
+		g_thread_pool_push (get_stat_pool (), slice, NULL);
+	}
+	for (i = 0; i < slice_size; i++) {
+		stat_file (paths[i], &stats[i]);
+	}
+
+	g_mutex_lock (&batch.lock);
+	batch.remaining--;
+	while (batch.remaining > 0) {
+		g_cond_wait (&batch.cond, &batch.lock);
+	}
+	g_mutex_unlock (&batch.lock);
+
+	g_mutex_clear (&batch.lock);
+	g_cond_clear (&batch.cond);
+}
+
+#ifdef GSEARCH_IO_URING
+
+typedef struct {
+	gint                    fd;
+	guint                   entries;
+	guint                   features;
+
+	guint                 * sq_head;
+	guint                 * sq_tail;
+	guint                   sq_mask;
+	guint                 * sq_array;
+	struct io_uring_sqe   * sqes;
+
+	guint                 * cq_head;
+	guint                 * cq_tail;
+	guint                   cq_mask;
+	struct io_uring_cqe   * cqes;
+
+	gpointer                sq_ring;
+	gsize                   sq_ring_size;
+	gpointer                cq_ring;
+	gsize                   cq_ring_size;
+	gsize                   sqes_size;
+} GSearchIoRing;
+
+/* Fills in the request for the entry @index of a batch. */
+typedef void (* GSearchIoPrepareFunc) (struct io_uring_sqe * sqe,
+                                       guint index,
+                                       gpointer data);
+/* Takes the result of the entry @index, a negated errno on failure. */
+typedef void (* GSearchIoCompleteFunc) (guint index,
+                                        gint result,
+                                        gpointer data);
+
+static void
+ring_free (GSearchIoRing * ring)
+{
+	if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+		munmap (ring->sqes, ring->sqes_size);
+	}
+	if (ring->cq_ring != NULL && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+		munmap (ring->cq_ring, ring->cq_ring_size);
+	}
+	if (ring->sq_ring != NULL && ring->sq_ring != MAP_FAILED) {
+		munmap (ring->sq_ring, ring->sq_ring_size);
+	}
+	close (ring->fd);
+	g_free (ring);
+}
+
+static GSearchIoRing *
+ring_new (void)
+{
+	struct io_uring_params params;
+	GSearchIoRing * ring;
+	gint fd;
+
+	memset (&params, 0, sizeof (params));
+	fd = syscall (__NR_io_uring_setup, GSEARCH_IO_RING_ENTRIES, &params);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	ring = g_new0 (GSearchIoRing, 1);
+	ring->fd = fd;
+	ring->entries = params.sq_entries;
+	ring->features = params.features;
+	ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (guint);
+	ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->sq_ring_size = MAX (ring->sq_ring_size, ring->cq_ring_size);
+	}
+
+	ring->sq_ring = mmap (NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+	                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (ring->sq_ring == MAP_FAILED) {
+		ring_free (ring);
+		return NULL;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_ring = ring->sq_ring;
+	}
+	else {
+		ring->cq_ring = mmap (NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+		                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (ring->cq_ring == MAP_FAILED) {
+			ring_free (ring);
+			return NULL;
+		}
+	}
+	ring->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+	ring->sqes = mmap (NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+	                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring_free (ring);
+		return NULL;
+	}
+
+	ring->sq_head = (guint *) ((gchar *) ring->sq_ring + params.sq_off.head);
+	ring->sq_tail = (guint *) ((gchar *) ring->sq_ring + params.sq_off.tail);
+	ring->sq_mask = *(guint *) ((gchar *) ring->sq_ring + params.sq_off.ring_mask);
+	ring->sq_array = (guint *) ((gchar *) ring->sq_ring + params.sq_off.array);
+	ring->cq_head = (guint *) ((gchar *) ring->cq_ring + params.cq_off.head);
+	ring->cq_tail = (guint *) ((gchar *) ring->cq_ring + params.cq_off.tail);
+	ring->cq_mask = *(guint *) ((gchar *) ring->cq_ring + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) ((gchar *) ring->cq_ring + params.cq_off.cqes);
+
+	return ring;
+}
+
+/* Older kernels have io_uring without some of the requests used here. */
+static gboolean
+ring_has_requests (GSearchIoRing * ring)
+{
+	static const guint8 requests[] = {
+		IORING_OP_STATX,
+		IORING_OP_OPENAT,
+		IORING_OP_READ,
+		IORING_OP_CLOSE
+	};
+	struct io_uring_probe * probe;
+	gboolean has_requests;
+	guint i;
+
+	probe = g_malloc0 (sizeof (struct io_uring_probe) + 256 * sizeof (struct io_uring_probe_op));
+	has_requests = (syscall (__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0);
+	for (i = 0; has_requests == TRUE && i < G_N_ELEMENTS (requests); i++) {
+		if (requests[i] > probe->last_op || (probe->ops[requests[i]].flags & IO_URING_OP_SUPPORTED) == 0) {
+			has_requests = FALSE;
+		}
+	}
+	g_free (probe);
+
+	return has_requests;
+}
+
+static GPrivate thread_ring = G_PRIVATE_INIT ((GDestroyNotify) ring_free);
+
+static GSearchIoRing *
+get_ring (void)
+{
+	GSearchIoRing * ring;
+
+	if (gsearchtool_io_has_uring () == FALSE) {
+		return NULL;
+	}
+	ring = g_private_get (&thread_ring);
+	if (ring == NULL) {
+		/* NULL again, and the batch done without it, if the
+		   thread is over the limit of locked memory. */
+		ring = ring_new ();
+		g_private_set (&thread_ring, ring);
+	}
+	return ring;
+}
+
+/* Gives up on io_uring for the rest of the session.  The ring of the
+   thread is left as it is, with the requests still in flight, since
+   their buffers cannot be let go of until they complete. */
+static void
+ring_break (gint error)
+{
+	g_warning ("io_uring_enter: %s, going on without io_uring", g_strerror (error));
+	g_atomic_int_set (&is_uring_broken, TRUE);
+	g_private_set (&thread_ring, NULL);
+}
+
+/* Runs @n_requests requests through @ring, a ring full at a time, and
+   returns once they are all complete, marking each in @is_completed.
+   FALSE if the ring failed, the requests not marked are then to be
+   done another way, without their buffers, which the kernel may still
+   write to. */
+static gboolean
+ring_run (GSearchIoRing * ring,
+          guint n_requests,
+          GSearchIoPrepareFunc prepare,
+          GSearchIoCompleteFunc complete,
+          gpointer data,
+          gboolean * is_completed)
+{
+	guint done = 0;
+
+	while (done < n_requests) {
+		guint chunk = MIN (n_requests - done, ring->entries);
+		guint submitted = 0;
+		guint completed = 0;
+		guint tail;
+		guint i;
+
+		tail = *ring->sq_tail;
+		for (i = 0; i < chunk; i++) {
+			struct io_uring_sqe * sqe;
+			guint index = (tail + i) & ring->sq_mask;
+
+			sqe = &ring->sqes[index];
+			memset (sqe, 0, sizeof (*sqe));
+			prepare (sqe, done + i, data);
+			sqe->user_data = done + i;
+			ring->sq_array[index] = index;
+		}
+		g_atomic_int_set ((gint *) ring->sq_tail, tail + chunk);
+
+		while (completed < chunk) {
+			guint head;
+			gint result;
+
+			result = syscall (__NR_io_uring_enter, ring->fd, chunk - submitted,
+			                  chunk - completed, IORING_ENTER_GETEVENTS, NULL, 0);
+			if (result < 0) {
+				if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+					continue;
+				}
+				ring_break (errno);
+				return FALSE;
+			}
+			submitted += result;
+
+			head = *ring->cq_head;
+			while (head != (guint) g_atomic_int_get ((gint *) ring->cq_tail)) {
+				struct io_uring_cqe * cqe = &ring->cqes[head & ring->cq_mask];
+
+				complete ((guint) cqe->user_data, cqe->res, data);
+				is_completed[cqe->user_data] = TRUE;
+				head++;
+				completed++;
+			}
+			g_atomic_int_set ((gint *) ring->cq_head, head);
+		}
+		done += chunk;
+	}
+	return TRUE;
+}
+
+typedef struct {
+	const gchar * const   * paths;
+	GSearchIoStat         * stats;
+	struct statx          * buffers;
+	guint                 * indices;
+	gint                    flags;
+} GSearchIoStatRequests;
+
+static void
+prepare_statx (struct io_uring_sqe * sqe,
+               guint index,
+               GSearchIoStatRequests * requests)
+{
+	guint i = requests->indices[index];
+
+	sqe->opcode = IORING_OP_STATX;
+	sqe->fd = AT_FDCWD;
+	sqe->addr = (guint64) (guintptr) requests->paths[i];
+	sqe->len = STATX_BASIC_STATS;
+	sqe->off = (guint64) (guintptr) &requests->buffers[i];
+	sqe->statx_flags = requests->flags;
+}
+
+static void
+complete_statx (guint index,
+                gint result,
+                GSearchIoStatRequests * requests)
+{
+	guint i = requests->indices[index];
+	GSearchIoStat * io_stat = &requests->stats[i];
+	struct statx * buffer = &requests->buffers[i];
+
+	memset (io_stat, 0, sizeof (*io_stat));
+	if (result < 0) {
+		io_stat->error = -result;
+		return;
+	}
+	io_stat->mode = buffer->stx_mode;
+	io_stat->size = buffer->stx_size;
+	io_stat->mtime = buffer->stx_mtime.tv_sec;
+	io_stat->uid = buffer->stx_uid;
+	io_stat->gid = buffer->stx_gid;
+	io_stat->device = makedev (buffer->stx_dev_major, buffer->stx_dev_minor);
+	io_stat->inode = buffer->stx_ino;
+}
+
+static void
+ring_stat_files (GSearchIoRing * ring,
+                 const gchar * const * paths,
+                 guint n_paths,
+                 GSearchIoStat * stats)
+{
+	GSearchIoStatRequests requests;
+	gboolean * is_completed;
+	gboolean is_run;
+	guint n_missing = 0;
+	guint i;
+
+	requests.paths = paths;
+	requests.stats = stats;
+	requests.buffers = g_new (struct statx, n_paths);
+	requests.indices = g_new (guint, n_paths);
+	requests.flags = 0;
+	is_completed = g_new0 (gboolean, n_paths);
+	for (i = 0; i < n_paths; i++) {
+		requests.indices[i] = i;
+	}
+	is_run = ring_run (ring, n_paths, (GSearchIoPrepareFunc) prepare_statx,
+	                   (GSearchIoCompleteFunc) complete_statx, &requests, is_completed);
+
+	/* A dangling symbolic link is still reported, as itself. */
+	for (i = 0; is_run == TRUE && i < n_paths; i++) {
+		if (stats[i].error == ENOENT) {
+			requests.indices[n_missing++] = i;
+		}
+	}
+	if (n_missing > 0) {
+		requests.flags = AT_SYMLINK_NOFOLLOW;
+		memset (is_completed, 0, n_missing * sizeof (gboolean));
+		is_run = ring_run (ring, n_missing, (GSearchIoPrepareFunc) prepare_statx,
+		                   (GSearchIoCompleteFunc) complete_statx, &requests, is_completed);
+		for (i = 0; is_run == FALSE && i < n_missing; i++) {
+			if (is_completed[i] == FALSE) {
+				stat_file (paths[requests.indices[i]], &stats[requests.indices[i]]);
+			}
+		}
+	}
+	else {
+		for (i = 0; is_run == FALSE && i < n_paths; i++) {
+			if (is_completed[i] == FALSE) {
+				stat_file (paths[i], &stats[i]);
+			}
+		}
+	}
+
+	if (is_run == TRUE) {
+		g_free (requests.buffers);
+	}
+	g_free (requests.indices);
+	g_free (is_completed);
+}
+
+typedef struct {
+	const gchar * const   * paths;
+	GSearchIoHead         * heads;
+	gsize                   head_size;
+	guchar                * buffers;
+	guint                 * indices;
+} GSearchIoOpenRequests;
+
+static void
+prepare_openat (struct io_uring_sqe * sqe,
+                guint index,
+                GSearchIoOpenRequests * requests)
+{
+	sqe->opcode = IORING_OP_OPENAT;
+	sqe->fd = AT_FDCWD;
+	sqe->addr = (guint64) (guintptr) requests->paths[index];
+	sqe->open_flags = O_RDONLY | O_CLOEXEC;
+}
+
+static void
+complete_openat (guint index,
+                 gint result,
+                 GSearchIoOpenRequests * requests)
+{
+	requests->heads[index].fd = (result < 0) ? -1 : result;
+	requests->heads[index].length = 0;
+}
+
+/* With IORING_FEAT_RW_CUR_POS, an offset of -1 reads from and moves the
+   offset of the file, as read () does.  The read goes to a buffer of
+   the batch, which is left behind if the ring fails, and is copied to
+   the head once complete. */
+static void
+prepare_read (struct io_uring_sqe * sqe,
+              guint index,
+              GSearchIoOpenRequests * requests)
+{
+	GSearchIoHead * head = &requests->heads[requests->indices[index]];
+
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = head->fd;
+	sqe->addr = (guint64) (guintptr) (requests->buffers + (gsize) index * requests->head_size);
+	sqe->len = requests->head_size;
+	sqe->off = (guint64) -1;
+}
+
+static void
+complete_read (guint index,
+               gint result,
+               GSearchIoOpenRequests * requests)
+{
+	GSearchIoHead * head = &requests->heads[requests->indices[index]];
+
+	head->length = (result < 0) ? -1 : result;
+	if (result > 0) {
+		memcpy (head->head, requests->buffers + (gsize) index * requests->head_size, result);
+	}
+}
+
+static void
+ring_open_files (GSearchIoRing * ring,
+                 const gchar * const * paths,
+                 guint n_paths,
+                 GSearchIoHead * heads,
+                 gsize head_size)
+{
+	GSearchIoOpenRequests requests;
+	gboolean * is_completed;
+	guint n_opened = 0;
+	guint i;
+
+	requests.paths = paths;
+	requests.heads = heads;
+	requests.head_size = head_size;
+	requests.buffers = NULL;
+	requests.indices = g_new (guint, n_paths);
+	is_completed = g_new0 (gboolean, n_paths);
+	if (ring_run (ring, n_paths, (GSearchIoPrepareFunc) prepare_openat,
+	              (GSearchIoCompleteFunc) complete_openat, &requests, is_completed) == FALSE) {
+		/* The files the ring may still open are left to it. */
+		for (i = 0; i < n_paths; i++) {
+			if (is_completed[i] == FALSE) {
+				heads[i].fd = g_open (paths[i], O_RDONLY, 0);
+			}
+			heads[i].length = 0;
+			if (heads[i].fd >= 0) {
+				heads[i].length = read (heads[i].fd, heads[i].head, head_size);
+			}
+		}
+		g_free (requests.indices);
+		g_free (is_completed);
+		return;
+	}
+
+	for (i = 0; i < n_paths; i++) {
+		if (heads[i].fd >= 0) {
+			requests.indices[n_opened++] = i;
+		}
+	}
+	requests.buffers = g_malloc (MAX (n_opened, 1) * head_size);
+	memset (is_completed, 0, n_paths * sizeof (gboolean));
+	if (ring_run (ring, n_opened, (GSearchIoPrepareFunc) prepare_read,
+	              (GSearchIoCompleteFunc) complete_read, &requests, is_completed) == FALSE) {
+		/* A read still in flight moves the offset of its file, so
+		   the head is reported as failed. */
+		for (i = 0; i < n_opened; i++) {
+			if (is_completed[i] == FALSE) {
+				heads[requests.indices[i]].length = -1;
+			}
+		}
+	}
+	else {
+		g_free (requests.buffers);
+	}
+
+	g_free (requests.indices);
+	g_free (is_completed);
+}
+
+static void
+prepare_close (struct io_uring_sqe * sqe,
+               guint index,
+               guint * fds)
+{
+	sqe->opcode = IORING_OP_CLOSE;
+	sqe->fd = fds[index];
+}
+
+static void
+complete_close (guint index,
+                gint result,
+                gpointer data)
+{
+}
+
+static void
+ring_close_files (GSearchIoRing * ring,
+                  GSearchIoHead * heads,
+                  guint n_heads)
+{
+	gboolean * is_completed;
+	guint * fds;
+	guint n_fds = 0;
+	guint i;
+
+	fds = g_new (guint, n_heads);
+	is_completed = g_new0 (gboolean, n_heads);
+	for (i = 0; i < n_heads; i++) {
+		if (heads[i].fd >= 0) {
+			fds[n_fds++] = heads[i].fd;
+		}
+	}
+	/* A close still in flight may yet close its descriptor, closing it
+	   again could close another file, so it is left open. */
+	ring_run (ring, n_fds, (GSearchIoPrepareFunc) prepare_close,
+	          (GSearchIoCompleteFunc) complete_close, fds, is_completed);
+	g_free (fds);
+	g_free (is_completed);
+}
+
+static gboolean
+detect_uring (void)
+{
+	GSearchIoRing * ring;
+	gboolean has_uring;
+
+	ring = ring_new ();
+	if (ring == NULL) {
+		return FALSE;
+	}
+	has_uring = ring_has_requests (ring) && (ring->features & IORING_FEAT_RW_CUR_POS);
+	ring_free (ring);
+
+	return has_uring;
+}
+
+#endif /* GSEARCH_IO_URING */
+
+/* Whether the batches go through io_uring: the kernel has it, with all
+   of the requests needed, and it has not been turned off. */
+gboolean
+gsearchtool_io_has_uring (void)
+{
+#ifdef GSEARCH_IO_URING
+	static gsize detected = 0;
+
+	if (g_once_init_enter (&detected)) {
+		g_once_init_leave (&detected, detect_uring () ? 2 : 1);
+	}
+	return detected == 2 && g_atomic_int_get (&is_uring_enabled) && !g_atomic_int_get (&is_uring_broken);
+#else
+	return FALSE;
+#endif
+}
+
+void
+gsearchtool_io_set_uring_enabled (gboolean is_enabled)
+{
+	g_atomic_int_set (&is_uring_enabled, is_enabled);
+}
+
+/* Fills in @stats for each of @paths, following symbolic links but for
+   the dangling ones. */
+void
+gsearchtool_io_stat_files (const gchar * const * paths,
+                           guint n_paths,
+                           GSearchIoStat * stats)
+{
+	guint i;
+
+	if (n_paths == 0) {
+		return;
+	}
+#ifdef GSEARCH_IO_URING
+	{
+		GSearchIoRing * ring = get_ring ();
+
+		if (ring != NULL) {
+			ring_stat_files (ring, paths, n_paths, stats);
+			return;
+		}
+	}
+#endif
+	if (n_paths > GSEARCH_IO_THREAD_BATCH && g_get_num_processors () > 1) {
+		stat_files_on_pool (paths, n_paths, stats);
+		return;
+	}
+	for (i = 0; i < n_paths; i++) {
+		stat_file (paths[i], &stats[i]);
+	}
+}
+
+/* Opens each of @paths and reads up to @head_size bytes of it into the
+   head buffer set in @heads, which must then be closed with
+   gsearchtool_io_close_files ().  @length is -1 if the read failed. */
+void
+gsearchtool_io_open_files (const gchar * const * paths,
+                           guint n_paths,
+                           GSearchIoHead * heads,
+                           gsize head_size)
+{
+	guint i;
+
+	if (n_paths == 0) {
+		return;
+	}
+#ifdef GSEARCH_IO_URING
+	{
+		GSearchIoRing * ring = get_ring ();
+
+		if (ring != NULL) {
+			ring_open_files (ring, paths, n_paths, heads, head_size);
+			return;
+		}
+	}
+#endif
+	for (i = 0; i < n_paths; i++) {
+		heads[i].fd = g_open (paths[i], O_RDONLY, 0);
+		heads[i].length = 0;
+		if (heads[i].fd >= 0) {
+			heads[i].length = read (heads[i].fd, heads[i].head, head_size);
+		}
+	}
+}
+
+void
+gsearchtool_io_close_files (GSearchIoHead * heads,
+                            guint n_heads)
+{
+	guint i;
+
+#ifdef GSEARCH_IO_URING
+	{
+		GSearchIoRing * ring = get_ring ();
+
+		if (ring != NULL) {
+			ring_close_files (ring, heads, n_heads);
+			for (i = 0; i < n_heads; i++) {
+				heads[i].fd = -1;
+			}
+			return;
+		}
+	}
+#endif
+	for (i = 0; i < n_heads; i++) {
+		if (heads[i].fd >= 0) {
+			close (heads[i].fd);
+			heads[i].fd = -1;
+		}
+	}
+}
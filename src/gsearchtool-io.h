@@ -0,0 +1,79 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-io.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_IO_H_
+#define _GSEARCHTOOL_IO_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+/* What the search needs to know of a file, or why it could not be had. */
+typedef struct {
+	gint                    error;
+	guint32                 mode;
+	gint64                  size;
+	gint64                  mtime;
+	guint32                 uid;
+	guint32                 gid;
+	guint64                 device;
+	guint64                 inode;
+} GSearchIoStat;
+
+/* A file opened with the start of its contents read into @head, the
+   offset of @fd is left after them.  @fd is -1 and @length 0 when the
+   file could not be opened. */
+typedef struct {
+	gint                    fd;
+	guchar                * head;
+	gssize                  length;
+} GSearchIoHead;
+
+gboolean
+gsearchtool_io_has_uring (void);
+
+void
+gsearchtool_io_set_uring_enabled (gboolean is_enabled);
+
+void
+gsearchtool_io_stat_files (const gchar * const * paths,
+                           guint n_paths,
+                           GSearchIoStat * stats);
+void
+gsearchtool_io_open_files (const gchar * const * paths,
+                           guint n_paths,
+                           GSearchIoHead * heads,
+                           gsize head_size);
+void
+gsearchtool_io_close_files (GSearchIoHead * heads,
+                            guint n_heads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_IO_H_ */
@@ -0,0 +1,485 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-locate.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+
+/*
+ * Reads the mlocate database in place, so the quick search needs no
+ * locate command.  The database is a header followed by one record per
+ * folder: its path, then the names of its files and subfolders.  The
+ * folders are in the order of their paths with '/' before any other
+ * character, so the folders inside a folder come right after it.  The
+ * database is mapped whole and, when it is opened, every sixty-fourth
+ * folder record is noted, so a search seeks to the folder it looks in
+ * by a binary search of those and matches the names without copying
+ * them.
+ *
+ * The plocate database is compressed and the old findutils one is
+ * front coded across folders, neither is read here and the locate
+ * command looks in them instead.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-locate.h"
+#include "gsearchtool-match.h"
+
+#define GSEARCH_LOCATE_MAGIC              "\0mlocate"
+#define GSEARCH_LOCATE_MAGIC_LENGTH       8
+#define GSEARCH_LOCATE_HEADER_LENGTH      16	/* magic, configuration size, version, visibility and padding */
+#define GSEARCH_LOCATE_FOLDER_HEADER_LENGTH 16	/* time in seconds and nanoseconds, and padding */
+#define GSEARCH_LOCATE_SAMPLE_INTERVAL    64
+
+enum {
+	GSEARCH_LOCATE_ENTRY_FILE,
+	GSEARCH_LOCATE_ENTRY_FOLDER,
+	GSEARCH_LOCATE_ENTRY_END
+};
+
+struct _GSearchLocateDatabase {
+	gint                    ref_count;
+	gchar                 * path;
+	const guchar          * data;
+	gsize                   length;
+	gsize                   folders;	/* where the first folder record starts */
+	GArray                * samples;	/* where every sixty-fourth one starts */
+	gint64                  n_entries;
+	gboolean                is_sorted;
+	gboolean                is_visibility_checked;
+	dev_t                   device;
+	ino_t                   inode;
+	time_t                  mtime;
+	off_t                   size;
+};
+
+struct _GSearchLocateCursor {
+	GSearchLocateDatabase * database;
+	gchar                 * folder;
+	gsize                   folder_length;
+	gchar                 * name_pattern;
+	gsize                   offset;		/* of the next folder record */
+	gsize                   entry;		/* of the next name in the folder, 0 between folders */
+	const gchar           * folder_path;
+	gboolean                is_finished;
+};
+
+static const gchar * locate_databases[] = {
+	"/var/lib/plocate/plocate.db",
+	"/var/lib/mlocate/mlocate.db",
+	"/var/cache/locate/locatedb",
+	NULL
+};
+
+/* The offset just past the string at @offset, or 0 when it runs past
+   the end of the database. */
+static gsize
+skip_string (GSearchLocateDatabase * database,
+             gsize offset)
+{
+	const guchar * end;
+
+	if (offset >= database->length) {
+		return 0;
+	}
+	end = memchr (database->data + offset, '\0', database->length - offset);
+	if (end == NULL) {
+		return 0;
+	}
+	return end - database->data + 1;
+}
+
+/* The offset of the folder record after the one at @offset, or 0 when
+   it is cut short.  The names in it are added to @n_entries when it is
+   not NULL. */
+static gsize
+skip_folder (GSearchLocateDatabase * database,
+             gsize offset,
+             gint64 * n_entries)
+{
+	offset = skip_string (database, offset + GSEARCH_LOCATE_FOLDER_HEADER_LENGTH);
+
+	while (offset > 0) {
+		guchar type;
+
+		if (offset >= database->length) {
+			return 0;
+		}
+		type = database->data[offset++];
+		if (type == GSEARCH_LOCATE_ENTRY_END) {
+			return offset;
+		}
+		if (type != GSEARCH_LOCATE_ENTRY_FILE && type != GSEARCH_LOCATE_ENTRY_FOLDER) {
+			return 0;
+		}
+		if (n_entries != NULL) {
+			(*n_entries)++;
+		}
+		offset = skip_string (database, offset);
+	}
+	return 0;
+}
+
+static const gchar *
+get_folder_path (GSearchLocateDatabase * database,
+                 gsize offset)
+{
+	return (const gchar *) database->data + offset + GSEARCH_LOCATE_FOLDER_HEADER_LENGTH;
+}
+
+/* Notes where the folder records start and checks they are whole, so
+   the names can be read without bounds checks later. */
+static gboolean
+index_database (GSearchLocateDatabase * database)
+{
+	const gchar * previous = NULL;
+	gsize offset = database->folders;
+	guint count = 0;
+
+	database->samples = g_array_new (FALSE, FALSE, sizeof (gsize));
+	database->is_sorted = TRUE;
+
+	while (offset < database->length) {
+		const gchar * path;
+		gsize next;
+
+		next = skip_folder (database, offset, &database->n_entries);
+		if (next == 0) {
+			return FALSE;
+		}
+		path = get_folder_path (database, offset);
+		if ((previous != NULL) && (compare_folder_paths (previous, path) >= 0)) {
+			database->is_sorted = FALSE;
+		}
+		if ((count++ % GSEARCH_LOCATE_SAMPLE_INTERVAL) == 0) {
+			g_array_append_val (database->samples, offset);
+		}
+		previous = path;
+		offset = next;
+	}
+	return TRUE;
+}
+
+GSearchLocateDatabase *
+gsearchtool_locate_database_open (const gchar * path)
+{
+	GSearchLocateDatabase * database;
+	struct stat database_stat;
+	gpointer data;
+	gsize offset;
+	guint32 configuration_length;
+	gint fd;
+
+	fd = g_open (path, O_RDONLY, 0);
+	if (fd < 0) {
+		return NULL;
+	}
+	if ((fstat (fd, &database_stat) != 0) ||
+	    (database_stat.st_size < GSEARCH_LOCATE_HEADER_LENGTH) ||
+	    ((guint64) database_stat.st_size > G_MAXSIZE)) {
+		close (fd);
+		return NULL;
+	}
+	data = mmap (NULL, database_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+
+	database = g_slice_new0 (GSearchLocateDatabase);
+	database->ref_count = 1;
+	database->path = g_strdup (path);
+	database->data = data;
+	database->length = database_stat.st_size;
+	database->device = database_stat.st_dev;
+	database->inode = database_stat.st_ino;
+	database->mtime = database_stat.st_mtime;
+	database->size = database_stat.st_size;
+
+	/* The configuration block follows the path of the folder the
+	   database was made from, only its length matters here. */
+	if ((memcmp (database->data, GSEARCH_LOCATE_MAGIC, GSEARCH_LOCATE_MAGIC_LENGTH) != 0) ||
+	    (database->data[12] != 0)) {
+		gsearchtool_locate_database_unref (database);
+		return NULL;
+	}
+	configuration_length = ((guint32) database->data[8] << 24) |
+	                       ((guint32) database->data[9] << 16) |
+	                       ((guint32) database->data[10] << 8) |
+	                       (guint32) database->data[11];
+	database->is_visibility_checked = (database->data[13] != 0);
+
+	offset = skip_string (database, GSEARCH_LOCATE_HEADER_LENGTH);
+	if ((offset == 0) || (database->length - offset < configuration_length)) {
+		gsearchtool_locate_database_unref (database);
+		return NULL;
+	}
+	database->folders = offset + configuration_length;
+
+	if (index_database (database) == FALSE) {
+		gsearchtool_locate_database_unref (database);
+		return NULL;
+	}
+	return database;
+}
+
+/* The first of the databases the locate commands read that is one read
+   here, the plocate database is not. */
+GSearchLocateDatabase *
+gsearchtool_locate_database_open_default (void)
+{
+	gint i;
+
+	for (i = 0; locate_databases[i] != NULL; i++) {
+		GSearchLocateDatabase * database;
+
+		database = gsearchtool_locate_database_open (locate_databases[i]);
+		if (database != NULL) {
+			return database;
+		}
+	}
+	return NULL;
+}
+
+GSearchLocateDatabase *
+gsearchtool_locate_database_ref (GSearchLocateDatabase * database)
+{
+	database->ref_count++;
+	return database;
+}
+
+void
+gsearchtool_locate_database_unref (GSearchLocateDatabase * database)
+{
+	if (--database->ref_count > 0) {
+		return;
+	}
+	munmap ((gpointer) database->data, database->length);
+	if (database->samples != NULL) {
+		g_array_free (database->samples, TRUE);
+	}
+	g_free (database->path);
+	g_slice_free (GSearchLocateDatabase, database);
+}
+
+/* The names of files and folders in the database, counted when it was
+   opened. */
+gint64
+gsearchtool_locate_database_get_entries (GSearchLocateDatabase * database)
+{
+	return database->n_entries;
+}
+
+/* FALSE once updatedb has put a new database in place of this one. */
+gboolean
+gsearchtool_locate_database_is_current (GSearchLocateDatabase * database)
+{
+	GStatBuf database_stat;
+
+	if (g_stat (database->path, &database_stat) != 0) {
+		return FALSE;
+	}
+	return (database_stat.st_dev == database->device) &&
+	       (database_stat.st_ino == database->inode) &&
+	       (database_stat.st_mtime == database->mtime) &&
+	       (database_stat.st_size == database->size);
+}
+
+static gboolean
+is_in_folder (GSearchLocateCursor * cursor,
+              const gchar * path)
+{
+	if (strncmp (path, cursor->folder, cursor->folder_length) != 0) {
+		return FALSE;
+	}
+	return (cursor->folder_length == 1) ||
+	       (path[cursor->folder_length] == '\0') ||
+	       (path[cursor->folder_length] == '/');
+}
+
+/* Looks for the names matching @name_pattern in @folder and the folders
+   inside it. */
+GSearchLocateCursor *
+gsearchtool_locate_cursor_new (GSearchLocateDatabase * database,
+                               const gchar * folder,
+                               const gchar * name_pattern)
+{
+	GSearchLocateCursor * cursor;
+	gsize offset = database->folders;
+
+	cursor = g_slice_new0 (GSearchLocateCursor);
+	cursor->database = gsearchtool_locate_database_ref (database);
+	cursor->folder = g_strdup (folder);
+	cursor->folder_length = strlen (cursor->folder);
+	while ((cursor->folder_length > 1) && (cursor->folder[cursor->folder_length - 1] == '/')) {
+		cursor->folder[--cursor->folder_length] = '\0';
+	}
+	cursor->name_pattern = g_strdup (name_pattern);
+
+	/* The folders inside the folder come right after it in a sorted
+	   database, so the search starts at the last noted folder before
+	   it. */
+	if (database->is_sorted == TRUE) {
+		guint low = 0;
+		guint high = database->samples->len;
+
+		while (low < high) {
+			guint middle = low + (high - low) / 2;
+			gsize sample = g_array_index (database->samples, gsize, middle);
+
+			if (compare_folder_paths (get_folder_path (database, sample), cursor->folder) < 0) {
+				offset = sample;
+				low = middle + 1;
+			}
+			else {
+				high = middle;
+			}
+		}
+		while ((offset < database->length) &&
+		       (compare_folder_paths (get_folder_path (database, offset), cursor->folder) < 0)) {
+			offset = skip_folder (database, offset, NULL);
+		}
+	}
+	cursor->offset = offset;
+	return cursor;
+}
+
+/* Sets @path to the next file found, FALSE when there are no more.
+   When @budget is not NULL it is the number of folders and names that
+   may still be read, taken down as they are, and FALSE with a @budget
+   of 0 means the search is not over. */
+gboolean
+gsearchtool_locate_cursor_next (GSearchLocateCursor * cursor,
+                                GString * path,
+                                guint * budget)
+{
+	GSearchLocateDatabase * database = cursor->database;
+
+	while (cursor->is_finished == FALSE) {
+		const gchar * name;
+
+		if (budget != NULL) {
+			if (*budget == 0) {
+				return FALSE;
+			}
+			(*budget)--;
+		}
+
+		if (cursor->entry == 0) {
+			const gchar * folder_path;
+			gsize next;
+
+			if (cursor->offset >= database->length) {
+				cursor->is_finished = TRUE;
+				break;
+			}
+			folder_path = get_folder_path (database, cursor->offset);
+			next = skip_folder (database, cursor->offset, NULL);
+
+			if (is_in_folder (cursor, folder_path) == FALSE) {
+				/* Past the folder, unless the database is not sorted
+				   and it has to be read through. */
+				if (database->is_sorted == TRUE) {
+					cursor->is_finished = TRUE;
+					break;
+				}
+				cursor->offset = next;
+				continue;
+			}
+			/* A database made for everyone only shows what the user
+			   may see, as the locate command does. */
+			if ((database->is_visibility_checked == TRUE) &&
+			    (g_access (folder_path, R_OK | X_OK) != 0)) {
+				cursor->offset = next;
+				continue;
+			}
+			cursor->folder_path = folder_path;
+			cursor->entry = cursor->offset + GSEARCH_LOCATE_FOLDER_HEADER_LENGTH + strlen (folder_path) + 1;
+			cursor->offset = next;
+			continue;
+		}
+
+		if (database->data[cursor->entry] == GSEARCH_LOCATE_ENTRY_END) {
+			cursor->entry = 0;
+			continue;
+		}
+		name = (const gchar *) database->data + cursor->entry + 1;
+		cursor->entry += strlen (name) + 2;
+
+		if (compare_name_pattern (cursor->name_pattern, name)) {
+			g_string_assign (path, cursor->folder_path);
+			if ((path->len == 0) || (path->str[path->len - 1] != '/')) {
+				g_string_append_c (path, '/');
+			}
+			g_string_append (path, name);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* The names in @folder and the folders inside it, counting no further
+   than @limit. */
+gint64
+gsearchtool_locate_database_count_entries (GSearchLocateDatabase * database,
+                                           const gchar * folder,
+                                           gint64 limit)
+{
+	GSearchLocateCursor * cursor;
+	gint64 n_entries = 0;
+
+	cursor = gsearchtool_locate_cursor_new (database, folder, NULL);
+	while ((cursor->offset < database->length) && (n_entries < limit)) {
+		const gchar * folder_path = get_folder_path (database, cursor->offset);
+
+		if (is_in_folder (cursor, folder_path) == TRUE) {
+			cursor->offset = skip_folder (database, cursor->offset, &n_entries);
+		}
+		else if (database->is_sorted == TRUE) {
+			break;
+		}
+		else {
+			cursor->offset = skip_folder (database, cursor->offset, NULL);
+		}
+	}
+	gsearchtool_locate_cursor_free (cursor);
+
+	return MIN (n_entries, limit);
+}
+
+void
+gsearchtool_locate_cursor_free (GSearchLocateCursor * cursor)
+{
+	gsearchtool_locate_database_unref (cursor->database);
+	g_free (cursor->folder);
+	g_free (cursor->name_pattern);
+	g_slice_free (GSearchLocateCursor, cursor);
+}
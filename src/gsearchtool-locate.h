@@ -0,0 +1,70 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-locate.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_LOCATE_H_
+#define _GSEARCHTOOL_LOCATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+typedef struct _GSearchLocateDatabase GSearchLocateDatabase;
+typedef struct _GSearchLocateCursor GSearchLocateCursor;
+
+GSearchLocateDatabase *
+gsearchtool_locate_database_open (const gchar * path);
+GSearchLocateDatabase *
+gsearchtool_locate_database_open_default (void);
+GSearchLocateDatabase *
+gsearchtool_locate_database_ref (GSearchLocateDatabase * database);
+void
+gsearchtool_locate_database_unref (GSearchLocateDatabase * database);
+gboolean
+gsearchtool_locate_database_is_current (GSearchLocateDatabase * database);
+gint64
+gsearchtool_locate_database_get_entries (GSearchLocateDatabase * database);
+gint64
+gsearchtool_locate_database_count_entries (GSearchLocateDatabase * database,
+                                           const gchar * folder,
+                                           gint64 limit);
+
+GSearchLocateCursor *
+gsearchtool_locate_cursor_new (GSearchLocateDatabase * database,
+                               const gchar * folder,
+                               const gchar * name_pattern);
+gboolean
+gsearchtool_locate_cursor_next (GSearchLocateCursor * cursor,
+                                GString * path,
+                                guint * budget);
+void
+gsearchtool_locate_cursor_free (GSearchLocateCursor * cursor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_LOCATE_H_ */
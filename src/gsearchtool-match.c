@@ -0,0 +1,352 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-match.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  Authors:	Dennis Cranston  <dennis_cranston@yahoo.com>
+ *		George Lebl
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <fnmatch.h>
+#ifndef FNM_CASEFOLD
+#  define FNM_CASEFOLD 0
+#endif
+
+#include <string.h>
+#include <regex.h>
+#include <glib.h>
+
+#include "gsearchtool-match.h"
+
+/* Matches a file name the way the results of the search command are
+   filtered: case insensitive where supported, backslashes are literal. */
+gboolean
+compare_name_pattern (const gchar * pattern,
+                      const gchar * name)
+{
+	return (fnmatch (pattern, name, FNM_NOESCAPE | FNM_CASEFOLD) != FNM_NOMATCH);
+}
+
+/* Takes the '*' off both ends of @pattern, FALSE if there are other
+   wildcards in it. */
+static gboolean
+split_name_pattern (const gchar * pattern,
+                    gchar ** text,
+                    gboolean * is_leading,
+                    gboolean * is_trailing)
+{
+	gsize length = strlen (pattern);
+	gchar * folded;
+
+	*is_leading = (length > 0) && (pattern[0] == '*');
+	if (*is_leading == TRUE) {
+		pattern++;
+		length--;
+	}
+	*is_trailing = (length > 0) && (pattern[length - 1] == '*');
+	if (*is_trailing == TRUE) {
+		length--;
+	}
+	*text = g_strndup (pattern, length);
+	if (strpbrk (*text, "*?[\\") != NULL) {
+		g_free (*text);
+		return FALSE;
+	}
+	folded = g_utf8_casefold (*text, -1);
+	g_free (*text);
+	*text = folded;
+	return TRUE;
+}
+
+/* Whether every name compare_name_pattern() matches with @pattern it
+   also matches with @other, when that can be told from the two: "*"
+   matches every name, "*report*" all that "*report.txt*" does, "log*"
+   all that "logfile*" does and "*.c" all that "*main.c" does. */
+gboolean
+is_name_pattern_narrower (const gchar * pattern,
+                          const gchar * other)
+{
+	gchar * text;
+	gchar * other_text;
+	gboolean is_leading;
+	gboolean is_trailing;
+	gboolean is_other_leading;
+	gboolean is_other_trailing;
+	gboolean is_narrower = FALSE;
+
+	if ((strcmp (other, "*") == 0) || (strcmp (pattern, other) == 0)) {
+		return TRUE;
+	}
+	if (split_name_pattern (pattern, &text, &is_leading, &is_trailing) == FALSE) {
+		return FALSE;
+	}
+	if (split_name_pattern (other, &other_text, &is_other_leading, &is_other_trailing) == FALSE) {
+		g_free (text);
+		return FALSE;
+	}
+
+	if ((is_other_leading == TRUE) && (is_other_trailing == TRUE)) {
+		is_narrower = (strstr (text, other_text) != NULL);
+	}
+	else if ((is_other_leading == TRUE) && (is_trailing == FALSE)) {
+		is_narrower = g_str_has_suffix (text, other_text);
+	}
+	else if ((is_other_trailing == TRUE) && (is_leading == FALSE)) {
+		is_narrower = g_str_has_prefix (text, other_text);
+	}
+	else if ((is_other_leading == is_leading) && (is_other_trailing == is_trailing)) {
+		is_narrower = (strcmp (text, other_text) == 0);
+	}
+	g_free (text);
+	g_free (other_text);
+
+	return is_narrower;
+}
+
+gboolean
+is_path_hidden (const gchar * path)
+{
+	gint results = FALSE;
+	gchar * sub_str;
+	gchar * hidden_path_substr = g_strconcat (G_DIR_SEPARATOR_S, ".", NULL);
+
+	sub_str = g_strstr_len (path, strlen (path), hidden_path_substr);
+
+	if (sub_str != NULL) {
+		gchar * gnome_desktop_str;
+
+		gnome_desktop_str = g_strconcat (G_DIR_SEPARATOR_S, ".gnome-desktop", G_DIR_SEPARATOR_S, NULL);
+
+		/* exclude the .gnome-desktop folder */
+		if (strncmp (sub_str, gnome_desktop_str, strlen (gnome_desktop_str)) == 0) {
+			sub_str++;
+			results = (g_strstr_len (sub_str, strlen (sub_str), hidden_path_substr) != NULL);
+		}
+		else {
+			results = TRUE;
+		}
+
+		g_free (gnome_desktop_str);
+	}
+
+	g_free (hidden_path_substr);
+	return results;
+}
+
+/* Compares two folder paths with '/' before any other character, so
+   the folders inside a folder sort right after it, the order of the
+   mlocate database and of gsearchtool-index.c. */
+gint
+compare_folder_paths (const gchar * a,
+                      const gchar * b)
+{
+	while ((*a == *b) && (*a != '\0')) {
+		a++;
+		b++;
+	}
+	if ((*a == '/') && (*b != '\0')) {
+		return -1;
+	}
+	if ((*b == '/') && (*a != '\0')) {
+		return 1;
+	}
+	return (guchar) *a - (guchar) *b;
+}
+
+/* The runs of at least @min_length characters every name matched by
+   @pattern with compare_name_pattern() holds, in ASCII lower case.
+   Wildcards and bytes outside ASCII, which the match may fold in other
+   ways, end a run. */
+gchar **
+get_name_pattern_literals (const gchar * pattern,
+                           gsize min_length)
+{
+	GPtrArray * literals;
+	GString * run;
+	const gchar * position;
+
+	literals = g_ptr_array_new ();
+	run = g_string_new (NULL);
+	for (position = pattern; ; position++) {
+		gboolean is_literal = (*position != '\0') &&
+		                      (*position != '*') &&
+		                      (*position != '?') &&
+		                      (*position != '[') &&
+		                      ((guchar) *position < 0x80);
+
+		if (is_literal == TRUE) {
+			g_string_append_c (run, g_ascii_tolower (*position));
+			continue;
+		}
+		if (run->len >= min_length) {
+			g_ptr_array_add (literals, g_strndup (run->str, run->len));
+		}
+		g_string_truncate (run, 0);
+		if (*position == '\0') {
+			break;
+		}
+		if (*position == '[') {
+			/* A ']' right after the '[' or its '!' is in the set. */
+			const gchar * end = position + 1;
+
+			if ((*end == '!') || (*end == '^')) {
+				end++;
+			}
+			end = (*end != '\0') ? strchr (end + 1, ']') : NULL;
+			if (end == NULL) {
+				break;
+			}
+			position = end;
+		}
+	}
+	g_ptr_array_add (literals, NULL);
+	g_string_free (run, TRUE);
+	return (gchar **) g_ptr_array_free (literals, FALSE);
+}
+
+/* Checks @path against a list of excluded paths.  Entries with a '*'
+   are matched with g_pattern_match_simple(), the others must be equal
+   to @path once a trailing G_DIR_SEPARATOR is added. */
+gboolean
+is_path_excluded (const gchar * path,
+                  GSList * exclude_path_list)
+{
+	GSList     * tmp_list;
+	gchar      * dir;
+	gboolean     results = FALSE;
+
+	for (tmp_list = exclude_path_list; tmp_list; tmp_list = tmp_list->next) {
+
+		/* Skip empty or null values. */
+		if ((tmp_list->data == NULL) || (strlen (tmp_list->data) == 0)) {
+			continue;
+		}
+
+		dir = g_strdup (tmp_list->data);
+
+		/* Wild-card comparisons. */
+		if (g_strstr_len (dir, strlen (dir), "*") != NULL) {
+
+			if (g_pattern_match_simple (dir, path) == TRUE) {
+
+				results = TRUE;
+				g_free (dir);
+				break;
+			}
+		}
+		/* Non-wild-card comparisons. */
+		else {
+			/* Add a trailing G_DIR_SEPARATOR. */
+			if (g_str_has_suffix (dir, G_DIR_SEPARATOR_S) == FALSE) {
+
+				gchar *tmp;
+
+				tmp = dir;
+				dir = g_strconcat (dir, G_DIR_SEPARATOR_S, NULL);
+				g_free (tmp);
+			}
+
+			if (strcmp (path, dir) == 0) {
+
+				results = TRUE;
+				g_free (dir);
+				break;
+			}
+		}
+		g_free (dir);
+	}
+
+	return results;
+}
+
+gboolean
+compare_regex (const gchar * regex,
+	       const gchar * string)
+{
+	regex_t regexec_pattern;
+
+	if (regex == NULL) {
+		return TRUE;
+	}
+
+	if (!regcomp (&regexec_pattern, regex, REG_EXTENDED|REG_NOSUB)) {
+		if (regexec (&regexec_pattern, string, 0, 0, 0) != REG_NOMATCH) {
+			regfree (&regexec_pattern);
+			return TRUE;
+		}
+		regfree (&regexec_pattern);
+	}
+	return FALSE;
+}
+
+gchar *
+setup_find_name_options (const gchar * find_name_argument,
+                         const gchar * file)
+{
+	/* This function builds the name options for the find command.  This in
+	   done to insure that the find command returns hidden files and folders. */
+
+	GString * command;
+	command = g_string_new ("");
+
+	if (strstr (file, "*") == NULL) {
+
+		if ((strlen (file) == 0) || (file[0] != '.')) {
+	 		g_string_append_printf (command, "\\( %s \"*%s*\" -o %s \".*%s*\" \\) ",
+					find_name_argument, file,
+					find_name_argument, file);
+		}
+		else {
+			g_string_append_printf (command, "\\( %s \"*%s*\" -o %s \".*%s*\" -o %s \"%s*\" \\) ",
+					find_name_argument, file,
+					find_name_argument, file,
+					find_name_argument, file);
+		}
+	}
+	else {
+		if (file[0] == '.') {
+			g_string_append_printf (command, "\\( %s \"%s\" -o %s \".*%s\" \\) ",
+					find_name_argument, file,
+					find_name_argument, file);
+		}
+		else if (file[0] != '*') {
+			g_string_append_printf (command, "%s \"%s\" ",
+					find_name_argument, file);
+		}
+		else {
+			if ((strlen (file) >= 1) && (file[1] == '.')) {
+				g_string_append_printf (command, "\\( %s \"%s\" -o %s \"%s\" \\) ",
+					find_name_argument, file,
+					find_name_argument, &file[1]);
+			}
+			else {
+				g_string_append_printf (command, "\\( %s \"%s\" -o %s \".%s\" \\) ",
+					find_name_argument, file,
+					find_name_argument, file);
+			}
+		}
+	}
+	return g_string_free (command, FALSE);
+}
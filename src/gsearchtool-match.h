@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-match.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_MATCH_H_
+#define _GSEARCHTOOL_MATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+/* The matching layer only depends on GLib, so it can be unit tested and
+   benchmarked without a display, see test-gsearchtool-match.c and
+   bench-gsearchtool-match.c. */
+
+#include <glib.h>
+
+gboolean
+compare_name_pattern (const gchar * pattern,
+                      const gchar * name);
+gboolean
+is_name_pattern_narrower (const gchar * pattern,
+                          const gchar * other);
+gboolean
+is_path_hidden (const gchar * path);
+gint
+compare_folder_paths (const gchar * a,
+                      const gchar * b);
+gchar **
+get_name_pattern_literals (const gchar * pattern,
+                           gsize min_length);
+
+gboolean
+is_path_excluded (const gchar * path,
+                  GSList * exclude_path_list);
+gboolean
+compare_regex (const gchar * regex,
+               const gchar * string);
+gchar *
+setup_find_name_options (const gchar * find_name_argument,
+                         const gchar * file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_MATCH_H_ */
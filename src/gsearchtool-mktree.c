@@ -0,0 +1,357 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-mktree.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Generates a synthetic file tree for the benchmark suite, see
+ * gsearchtool-bench.sh.  The same options and seed always produce the
+ * same tree: names, sizes and contents only depend on a GRand seeded
+ * from the command line.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#define GSEARCH_MKTREE_NEEDLE "gsearchneedle"
+#define GSEARCH_MKTREE_LINE_LENGTH 72
+
+static const gchar * GSearchMkTreeWords[] = {
+	"report", "draft", "notes", "budget", "photo", "invoice", "backup", "config",
+	"index", "readme", "summary", "letter", "schedule", "thesis", "minutes", "agenda",
+	"screenshot", "scan", "holiday", "project", "module", "test", "build", "cache",
+	"session", "profile", "manual", "chapter", "figure", "table", "source", "header",
+	"album", "track", "playlist", "movie", "trailer", "archive", "export", "import",
+	"contract", "offer", "receipt", "statement", "payslip", "resume", "paper", "slides"
+};
+
+static const gchar * GSearchMkTreeExtensions[] = {
+	".txt", ".c", ".h", ".log", ".conf", ".py", ".html", ".xml",
+	".jpg", ".png", ".pdf", ".odt", ".ogg", ".gz", ".bak", ""
+};
+
+/* Extensions before this index get text content, the others binary. */
+#define GSEARCH_MKTREE_TEXT_EXTENSIONS 8
+
+static gint depth = 4;
+static gint fanout = 4;
+static gint files_per_folder = 16;
+static gint min_size = 0;
+static gint max_size = 65536;
+static gint seed = 1;
+static gdouble needle_ratio = 0.01;
+static gchar * distribution = NULL;
+
+static GOptionEntry GSearchMkTreeEntries[] = {
+	{ "depth", 0, 0, G_OPTION_ARG_INT, &depth, "Folder nesting depth", "N" },
+	{ "fanout", 0, 0, G_OPTION_ARG_INT, &fanout, "Subfolders per folder", "N" },
+	{ "files", 0, 0, G_OPTION_ARG_INT, &files_per_folder, "Files per folder", "N" },
+	{ "min-size", 0, 0, G_OPTION_ARG_INT, &min_size, "Smallest file size in bytes", "BYTES" },
+	{ "max-size", 0, 0, G_OPTION_ARG_INT, &max_size, "Largest file size in bytes", "BYTES" },
+	{ "seed", 0, 0, G_OPTION_ARG_INT, &seed, "Random seed", "N" },
+	{ "needle-ratio", 0, 0, G_OPTION_ARG_DOUBLE, &needle_ratio,
+	  "Fraction of text files containing the word \"" GSEARCH_MKTREE_NEEDLE "\"", "RATIO" },
+	{ "distribution", 0, 0, G_OPTION_ARG_STRING, &distribution,
+	  "Filename distribution: uniform or zipf (default)", "NAME" },
+	{ NULL }
+};
+
+typedef struct _GSearchMkTree GSearchMkTree;
+
+struct _GSearchMkTree {
+	GRand                 * rand;
+	gboolean                is_zipf;
+	gdouble               * zipf_words;
+	gdouble               * zipf_extensions;
+	gint64                  folders;
+	gint64                  files;
+	gint64                  bytes;
+};
+
+/* Cumulative weights 1/(k+1), so a few names are much more common than
+   the rest, like in a real home folder. */
+static gdouble *
+create_zipf_table (gint count)
+{
+	gdouble * table;
+	gdouble total = 0;
+	gint idx;
+
+	table = g_new (gdouble, count);
+	for (idx = 0; idx < count; idx++) {
+		total += 1.0 / (idx + 1);
+		table[idx] = total;
+	}
+	for (idx = 0; idx < count; idx++) {
+		table[idx] /= total;
+	}
+	return table;
+}
+
+static gint
+pick_index (GSearchMkTree * tree,
+            gdouble * zipf_table,
+            gint count)
+{
+	gdouble value;
+	gint idx;
+
+	if (tree->is_zipf == FALSE) {
+		return g_rand_int_range (tree->rand, 0, count);
+	}
+
+	value = g_rand_double (tree->rand);
+	for (idx = 0; idx < count - 1; idx++) {
+		if (value < zipf_table[idx]) {
+			break;
+		}
+	}
+	return idx;
+}
+
+/* File sizes are spread evenly on a logarithmic scale. */
+static gint
+pick_size (GSearchMkTree * tree)
+{
+	gdouble low;
+	gdouble high;
+
+	if (max_size <= min_size) {
+		return min_size;
+	}
+	low = log (min_size + 1);
+	high = log (max_size + 1);
+
+	return (gint) (exp (low + (high - low) * g_rand_double (tree->rand)) - 1);
+}
+
+/* Text files are whole lines of words, so they end up slightly larger
+   than @size. */
+static gchar *
+create_text_contents (GSearchMkTree * tree,
+                      gint size)
+{
+	GString * contents;
+	gboolean has_needle;
+	gsize needle_offset;
+
+	contents = g_string_sized_new (size + GSEARCH_MKTREE_LINE_LENGTH);
+	has_needle = (g_rand_double (tree->rand) < needle_ratio);
+	needle_offset = (size > 0) ? g_rand_int_range (tree->rand, 0, size) : 0;
+
+	while (contents->len < (gsize) size) {
+		gsize line_start = contents->len;
+
+		while (contents->len - line_start < GSEARCH_MKTREE_LINE_LENGTH) {
+			if (has_needle && contents->len >= needle_offset) {
+				g_string_append (contents, GSEARCH_MKTREE_NEEDLE);
+				has_needle = FALSE;
+			}
+			else {
+				g_string_append (contents, GSearchMkTreeWords[pick_index (tree, tree->zipf_words,
+				                                                       G_N_ELEMENTS (GSearchMkTreeWords))]);
+			}
+			g_string_append_c (contents, ' ');
+		}
+		g_string_append_c (contents, '\n');
+	}
+	if (has_needle) {
+		g_string_append (contents, GSEARCH_MKTREE_NEEDLE "\n");
+	}
+
+	return g_string_free (contents, FALSE);
+}
+
+static gchar *
+create_binary_contents (GSearchMkTree * tree,
+                        gint size)
+{
+	gchar * contents;
+	gint idx;
+
+	contents = g_malloc (size + 1);
+	for (idx = 0; idx < size; idx++) {
+		contents[idx] = (gchar) g_rand_int_range (tree->rand, 0, 256);
+	}
+	contents[size] = '\0';
+
+	return contents;
+}
+
+static gboolean
+create_file (GSearchMkTree * tree,
+             const gchar * folder,
+             gint number)
+{
+	gchar * name;
+	gchar * filename;
+	gchar * contents;
+	GError * error = NULL;
+	gint word;
+	gint extension;
+	gint size;
+	gsize length;
+
+	word = pick_index (tree, tree->zipf_words, G_N_ELEMENTS (GSearchMkTreeWords));
+	extension = pick_index (tree, tree->zipf_extensions, G_N_ELEMENTS (GSearchMkTreeExtensions));
+	size = pick_size (tree);
+
+	name = g_strdup_printf ("%s-%04d%s", GSearchMkTreeWords[word], number, GSearchMkTreeExtensions[extension]);
+	filename = g_build_filename (folder, name, NULL);
+
+	if (extension < GSEARCH_MKTREE_TEXT_EXTENSIONS) {
+		contents = create_text_contents (tree, size);
+		length = strlen (contents);
+	}
+	else {
+		contents = create_binary_contents (tree, size);
+		length = size;
+	}
+
+	if (!g_file_set_contents (filename, contents, length, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_free (contents);
+		g_free (filename);
+		g_free (name);
+		return FALSE;
+	}
+
+	tree->files++;
+	tree->bytes += length;
+
+	g_free (contents);
+	g_free (filename);
+	g_free (name);
+
+	return TRUE;
+}
+
+static gboolean
+create_folder (GSearchMkTree * tree,
+               const gchar * folder,
+               gint level)
+{
+	gint idx;
+
+	if (g_mkdir_with_parents (folder, 0755) != 0) {
+		g_printerr ("%s: %s\n", folder, g_strerror (errno));
+		return FALSE;
+	}
+	tree->folders++;
+
+	for (idx = 0; idx < files_per_folder; idx++) {
+		if (create_file (tree, folder, idx) == FALSE) {
+			return FALSE;
+		}
+	}
+
+	if (level >= depth) {
+		return TRUE;
+	}
+
+	for (idx = 0; idx < fanout; idx++) {
+		gchar * name;
+		gchar * subfolder;
+		gboolean result;
+
+		/* Some folders are hidden, the search tool skips them by default. */
+		name = g_strdup_printf ("%s%s-%d", (g_rand_int_range (tree->rand, 0, 16) == 0) ? "." : "",
+		                        GSearchMkTreeWords[pick_index (tree, tree->zipf_words,
+		                                                       G_N_ELEMENTS (GSearchMkTreeWords))],
+		                        idx);
+		subfolder = g_build_filename (folder, name, NULL);
+		result = create_folder (tree, subfolder, level + 1);
+		g_free (subfolder);
+		g_free (name);
+
+		if (result == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	GOptionContext * context;
+	GSearchMkTree tree;
+	GError * error = NULL;
+	GDir * dir;
+
+	context = g_option_context_new ("FOLDER - create a synthetic file tree for benchmarks");
+	g_option_context_add_main_entries (context, GSearchMkTreeEntries, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	if (argc != 2 || depth < 0 || fanout < 0 || files_per_folder < 0 || min_size < 0 || max_size < 0) {
+		g_printerr ("Usage: %s [OPTION...] FOLDER\n", g_get_prgname ());
+		return 1;
+	}
+
+	/* Refuse to mix the tree with existing files. */
+	dir = g_dir_open (argv[1], 0, NULL);
+	if (dir != NULL) {
+		gboolean is_empty = (g_dir_read_name (dir) == NULL);
+
+		g_dir_close (dir);
+		if (is_empty == FALSE) {
+			g_printerr ("%s: folder is not empty\n", argv[1]);
+			return 1;
+		}
+	}
+
+	memset (&tree, 0, sizeof (tree));
+	tree.rand = g_rand_new_with_seed (seed);
+	tree.is_zipf = (distribution == NULL) || (strcmp (distribution, "zipf") == 0);
+	tree.zipf_words = create_zipf_table (G_N_ELEMENTS (GSearchMkTreeWords));
+	tree.zipf_extensions = create_zipf_table (G_N_ELEMENTS (GSearchMkTreeExtensions));
+
+	if (create_folder (&tree, argv[1], 0) == FALSE) {
+		return 1;
+	}
+
+	g_print ("{\"seed\":%d,\"depth\":%d,\"fanout\":%d,\"files_per_folder\":%d,"
+	         "\"folders\":%" G_GINT64_FORMAT ",\"files\":%" G_GINT64_FORMAT ",\"bytes\":%" G_GINT64_FORMAT "}\n",
+	         seed, depth, fanout, files_per_folder, tree.folders, tree.files, tree.bytes);
+
+	g_rand_free (tree.rand);
+	g_free (tree.zipf_words);
+	g_free (tree.zipf_extensions);
+
+	return 0;
+}
@@ -0,0 +1,242 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-planner.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+
+/*
+ * Chooses where the names of the files come from.  find walks the
+ * folders and runs every test, the locate database has the names of
+ * the files without a walk but nothing else, so the other tests take a
+ * stat of each file whose name matches.  Each way is given an estimated
+ * time from the number of entries in the folders and in the database
+ * and from what the tests cost and let through, and the quickest wins.
+ * When either number is not known the folders are walked.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-planner.h"
+
+/* The estimated costs, in microseconds. */
+#define GSEARCH_PLANNER_SPAWN_COST            2000.0	/* a command started */
+#define GSEARCH_PLANNER_WALK_ENTRY_COST       2.0	/* an entry read and its name matched by find */
+#define GSEARCH_PLANNER_LOCATE_ENTRY_COST     0.2	/* an entry of the database matched by locate */
+#define GSEARCH_PLANNER_STAT_COST             20.0	/* a stat of a file found by locate, seldom cached */
+
+#define GSEARCH_PLANNER_DEFAULT_ENTRIES       100000
+#define GSEARCH_PLANNER_MIN_NAME_SELECTIVITY  0.001
+
+/* Counting the entries of a folder stops here, beyond it the walk is
+   slower than reading any database anyway. */
+#define GSEARCH_PLANNER_MAX_COUNTED_ENTRIES   (16 * 1024 * 1024)
+
+/* The entries read from the folder itself when there is no database. */
+#define GSEARCH_PLANNER_SAMPLE_ENTRIES        4096
+
+/* Each character of @name_pattern that is not a wildcard halves the
+   names it is expected to match. */
+gdouble
+gsearchtool_planner_get_name_selectivity (const gchar * name_pattern)
+{
+	gdouble selectivity = 1.0;
+	const gchar * p;
+
+	if (name_pattern == NULL) {
+		return 1.0;
+	}
+	for (p = name_pattern; *p != '\0'; p++) {
+		if ((*p != '*') && (*p != '?')) {
+			selectivity /= 2.0;
+		}
+	}
+	return MAX (selectivity, GSEARCH_PLANNER_MIN_NAME_SELECTIVITY);
+}
+
+/* Reads the folders under @folder, nearest first, until a few thousand
+   entries were seen.  The folders left are taken to hold as many
+   entries as the ones read did on average. */
+static gint64
+sample_folder_entries (const gchar * folder)
+{
+	GQueue * folders;
+	gint64 n_entries = 0;
+	guint n_folders_read = 0;
+	gchar * path;
+
+	folders = g_queue_new ();
+	g_queue_push_tail (folders, g_strdup (folder));
+
+	while ((n_entries < GSEARCH_PLANNER_SAMPLE_ENTRIES) &&
+	       ((path = g_queue_pop_head (folders)) != NULL)) {
+		const gchar * name;
+		GDir * dir;
+
+		dir = g_dir_open (path, 0, NULL);
+		if (dir != NULL) {
+			while ((name = g_dir_read_name (dir)) != NULL) {
+				GStatBuf file_stat;
+				gchar * file;
+
+				n_entries++;
+				file = g_build_filename (path, name, NULL);
+				if ((g_lstat (file, &file_stat) == 0) && S_ISDIR (file_stat.st_mode)) {
+					g_queue_push_tail (folders, file);
+				}
+				else {
+					g_free (file);
+				}
+			}
+			g_dir_close (dir);
+			n_folders_read++;
+		}
+		g_free (path);
+	}
+
+	if (n_folders_read > 0) {
+		n_entries += n_entries * g_queue_get_length (folders) / n_folders_read;
+	}
+	g_queue_foreach (folders, (GFunc) g_free, NULL);
+	g_queue_free (folders);
+
+	return (n_folders_read > 0) ? n_entries : -1;
+}
+
+/* The entries in @folder and the folders inside it, counted in the
+   locate @database when there is one, or -1 when they cannot be told. */
+gint64
+gsearchtool_planner_estimate_folder_entries (const gchar * folder,
+                                             GSearchLocateDatabase * database)
+{
+	if (database != NULL) {
+		return gsearchtool_locate_database_count_entries (database, folder,
+		                                                  GSEARCH_PLANNER_MAX_COUNTED_ENTRIES);
+	}
+	return sample_folder_entries (folder);
+}
+
+void
+gsearchtool_planner_choose (const GSearchPlanQuery * query,
+                            GSearchPlan * plan)
+{
+	gdouble name_selectivity;
+	gdouble predicate_cost = 0.0;
+	gdouble candidates;
+	gdouble locate_cost;
+	gint64 folder_entries;
+	gint kind;
+
+	name_selectivity = gsearchtool_planner_get_name_selectivity (query->name_pattern);
+	if (query->predicate != NULL) {
+		predicate_cost = gsearchtool_predicate_get_cost (query->predicate);
+	}
+	folder_entries = (query->folder_entries >= 0) ? query->folder_entries : GSEARCH_PLANNER_DEFAULT_ENTRIES;
+	candidates = folder_entries * name_selectivity;
+
+	/* find matches the name first, the other tests only run on the
+	   files that have it. */
+	plan->costs[GSEARCH_PLAN_WALK] = (gint64) (GSEARCH_PLANNER_SPAWN_COST +
+	                                            folder_entries * GSEARCH_PLANNER_WALK_ENTRY_COST +
+	                                            candidates * predicate_cost);
+
+	plan->costs[GSEARCH_PLAN_LOCATE] = GSEARCH_PLAN_IMPOSSIBLE;
+	plan->costs[GSEARCH_PLAN_LOCATE_THEN_STAT] = GSEARCH_PLAN_IMPOSSIBLE;
+	if ((query->has_locate == TRUE) && (query->is_walk_required == FALSE) &&
+	    (query->folder_entries >= 0) && (query->database_entries >= 0)) {
+		locate_cost = GSEARCH_PLANNER_SPAWN_COST + query->database_entries * GSEARCH_PLANNER_LOCATE_ENTRY_COST;
+		if (query->predicate == NULL) {
+			plan->costs[GSEARCH_PLAN_LOCATE] = (gint64) locate_cost;
+		}
+		else if (gsearchtool_predicate_has_kind (query->predicate, GSEARCH_PREDICATE_FIND_TEST) == FALSE) {
+			gdouble stated = candidates;
+
+			/* With the metadata in the database only the files that
+			   pass the tests there get a stat to check them. */
+			if (query->has_metadata == TRUE) {
+				stated *= gsearchtool_predicate_get_selectivity (query->predicate);
+			}
+			plan->costs[GSEARCH_PLAN_LOCATE_THEN_STAT] = (gint64) (locate_cost +
+			                                                        candidates * predicate_cost +
+			                                                        stated * GSEARCH_PLANNER_STAT_COST);
+		}
+	}
+
+	plan->kind = GSEARCH_PLAN_WALK;
+	for (kind = 0; kind < GSEARCH_PLAN_NUM_KINDS; kind++) {
+		if ((plan->costs[kind] != GSEARCH_PLAN_IMPOSSIBLE) &&
+		    (plan->costs[kind] < plan->costs[plan->kind])) {
+			plan->kind = kind;
+		}
+	}
+}
+
+/* The name of the plan in the search statistics. */
+const gchar *
+gsearchtool_planner_get_kind_name (GSearchPlanKind kind)
+{
+	switch (kind) {
+	case GSEARCH_PLAN_LOCATE:
+		return "locate";
+	case GSEARCH_PLAN_LOCATE_THEN_STAT:
+		return "locate+stat";
+	default:
+		return "find";
+	}
+}
+
+/* Returns the plans that could be run with their estimated times, one
+   per line, the chosen one first. */
+gchar *
+gsearchtool_planner_explain (const GSearchPlan * plan)
+{
+	const gchar * descriptions[GSEARCH_PLAN_NUM_KINDS];
+	GString * explanation;
+	gint kind;
+
+	descriptions[GSEARCH_PLAN_WALK] = _("Walk the folders with find");
+	descriptions[GSEARCH_PLAN_LOCATE] = _("Look the names up with locate");
+	descriptions[GSEARCH_PLAN_LOCATE_THEN_STAT] = _("Look the names up with locate, then test each file");
+
+	explanation = g_string_new (NULL);
+	/* Translators: the plan a search runs and its estimated time in
+	   seconds, for example "Walk the folders with find (estimated 0.52 s)". */
+	g_string_append_printf (explanation, _("%s (estimated %.2f s)"), descriptions[plan->kind],
+	                        (gdouble) plan->costs[plan->kind] / G_USEC_PER_SEC);
+	for (kind = 0; kind < GSEARCH_PLAN_NUM_KINDS; kind++) {
+		if ((kind == plan->kind) || (plan->costs[kind] == GSEARCH_PLAN_IMPOSSIBLE)) {
+			continue;
+		}
+		g_string_append_c (explanation, '\n');
+		/* Translators: a plan the search did not choose and its
+		   estimated time in seconds. */
+		g_string_append_printf (explanation, _("Not chosen: %s (estimated %.2f s)"), descriptions[kind],
+		                        (gdouble) plan->costs[kind] / G_USEC_PER_SEC);
+	}
+	return g_string_free (explanation, FALSE);
+}
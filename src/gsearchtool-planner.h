@@ -0,0 +1,88 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-planner.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_PLANNER_H_
+#define _GSEARCHTOOL_PLANNER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+#include "gsearchtool-predicate.h"
+#include "gsearchtool-locate.h"
+
+typedef enum {
+	GSEARCH_PLAN_WALK,			/* find walks the folders */
+	GSEARCH_PLAN_LOCATE,			/* locate has the names */
+	GSEARCH_PLAN_LOCATE_THEN_STAT,		/* locate has the names, a stat the rest */
+	GSEARCH_PLAN_NUM_KINDS
+} GSearchPlanKind;
+
+#define GSEARCH_PLAN_IMPOSSIBLE (-1)
+
+/* What the planner is told of a search.  @predicate holds the tests
+   other than the name, NULL when there are none.  @has_metadata is set
+   when the database also has what the tests need, see
+   gsearchtool-index.c.  The entries are -1 when they are not known. */
+typedef struct {
+	const gchar           * name_pattern;
+	GSearchPredicate      * predicate;
+	gboolean                has_locate;
+	gboolean                has_metadata;
+	gboolean                is_walk_required;
+	gint64                  folder_entries;
+	gint64                  database_entries;
+} GSearchPlanQuery;
+
+/* The plan chosen and the estimated time of each, in microseconds, or
+   GSEARCH_PLAN_IMPOSSIBLE. */
+typedef struct {
+	GSearchPlanKind         kind;
+	gint64                  costs[GSEARCH_PLAN_NUM_KINDS];
+} GSearchPlan;
+
+gdouble
+gsearchtool_planner_get_name_selectivity (const gchar * name_pattern);
+
+gint64
+gsearchtool_planner_estimate_folder_entries (const gchar * folder,
+                                             GSearchLocateDatabase * database);
+
+void
+gsearchtool_planner_choose (const GSearchPlanQuery * query,
+                            GSearchPlan * plan);
+const gchar *
+gsearchtool_planner_get_kind_name (GSearchPlanKind kind);
+
+gchar *
+gsearchtool_planner_explain (const GSearchPlan * plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_PLANNER_H_ */
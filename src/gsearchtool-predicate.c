@@ -0,0 +1,709 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-predicate.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+
+/*
+ * The search constraints compiled into a tree of typed predicates.  User
+ * and group names are turned into ids once, when the tree is built,
+ * instead of by find for every file, and the operands of each AND and
+ * OR are put in the order that is expected to settle it the soonest for
+ * the least work.  The tree is run by find, as the arguments it gives,
+ * or in process on the stat of a file.  A hidden folder fails the tree
+ * with everything inside it, so find prunes it instead of reading it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <fnmatch.h>
+#include <grp.h>
+#include <pwd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "gsearchtool-match.h"
+#include "gsearchtool-predicate.h"
+
+struct _GSearchPredicate {
+	GSearchPredicateKind    kind;
+	gint64                  number;
+	gchar                 * text;
+	GPtrArray             * children;
+
+	/* The last owner looked up by GSEARCH_PREDICATE_NO_OWNER, most
+	   files in a folder have the same one. */
+	gboolean                has_owner;
+	guint32                 owner_uid;
+	guint32                 owner_gid;
+	gboolean                is_owner_unknown;
+};
+
+/* How much work a test is relative to the others, a stat counts for a
+   few name matches, a passwd lookup for a few stats and a command run
+   by find for far more, and the part of the files expected to pass it. */
+static const struct {
+	gdouble                 cost;
+	gdouble                 selectivity;
+} leaf_estimates[] = {
+	[GSEARCH_PREDICATE_NAME] =            {    1.0, 0.10 },
+	[GSEARCH_PREDICATE_INAME] =           {    1.0, 0.10 },
+	[GSEARCH_PREDICATE_REGULAR] =         {    1.0, 0.80 },
+	[GSEARCH_PREDICATE_DIRECTORY] =       {    1.0, 0.10 },
+	[GSEARCH_PREDICATE_MODIFIED_WITHIN] = {    4.0, 0.20 },
+	[GSEARCH_PREDICATE_MODIFIED_BEFORE] = {    4.0, 0.80 },
+	[GSEARCH_PREDICATE_SIZE_AT_LEAST] =   {    4.0, 0.20 },
+	[GSEARCH_PREDICATE_SIZE_AT_MOST] =    {    4.0, 0.80 },
+	[GSEARCH_PREDICATE_EMPTY] =           {    4.0, 0.05 },
+	[GSEARCH_PREDICATE_UID] =             {    4.0, 0.50 },
+	[GSEARCH_PREDICATE_GID] =             {    4.0, 0.50 },
+	[GSEARCH_PREDICATE_USER] =            {    4.0, 0.00 },
+	[GSEARCH_PREDICATE_GROUP] =           {    4.0, 0.00 },
+	[GSEARCH_PREDICATE_NO_OWNER] =        {   16.0, 0.01 },
+	[GSEARCH_PREDICATE_NOT_HIDDEN] =      {    1.0, 0.90 },
+	[GSEARCH_PREDICATE_FIND_TEST] =       { 1000.0, 0.50 }
+};
+
+GSearchPredicate *
+gsearchtool_predicate_new (GSearchPredicateKind kind)
+{
+	GSearchPredicate * predicate;
+
+	predicate = g_slice_new0 (GSearchPredicate);
+	predicate->kind = kind;
+	if ((kind == GSEARCH_PREDICATE_AND) ||
+	    (kind == GSEARCH_PREDICATE_OR) ||
+	    (kind == GSEARCH_PREDICATE_NOT)) {
+		predicate->children = g_ptr_array_new_with_free_func ((GDestroyNotify) gsearchtool_predicate_free);
+	}
+	return predicate;
+}
+
+GSearchPredicate *
+gsearchtool_predicate_new_number (GSearchPredicateKind kind,
+                                  gint64 number)
+{
+	GSearchPredicate * predicate;
+
+	predicate = gsearchtool_predicate_new (kind);
+	predicate->number = number;
+	return predicate;
+}
+
+static gboolean
+is_number (const gchar * text)
+{
+	if (*text == '\0') {
+		return FALSE;
+	}
+	for (; *text != '\0'; text++) {
+		if (g_ascii_isdigit (*text) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* A GSEARCH_PREDICATE_USER or GSEARCH_PREDICATE_GROUP of a name that is
+   known, or a number, becomes a GSEARCH_PREDICATE_UID or
+   GSEARCH_PREDICATE_GID. */
+GSearchPredicate *
+gsearchtool_predicate_new_text (GSearchPredicateKind kind,
+                                const gchar * text)
+{
+	GSearchPredicate * predicate;
+
+	if (kind == GSEARCH_PREDICATE_USER) {
+		struct passwd * pwd = getpwnam (text);
+
+		if (pwd != NULL) {
+			return gsearchtool_predicate_new_number (GSEARCH_PREDICATE_UID, pwd->pw_uid);
+		}
+		if (is_number (text) == TRUE) {
+			return gsearchtool_predicate_new_number (GSEARCH_PREDICATE_UID, g_ascii_strtoll (text, NULL, 10));
+		}
+	}
+	else if (kind == GSEARCH_PREDICATE_GROUP) {
+		struct group * grp = getgrnam (text);
+
+		if (grp != NULL) {
+			return gsearchtool_predicate_new_number (GSEARCH_PREDICATE_GID, grp->gr_gid);
+		}
+		if (is_number (text) == TRUE) {
+			return gsearchtool_predicate_new_number (GSEARCH_PREDICATE_GID, g_ascii_strtoll (text, NULL, 10));
+		}
+	}
+	predicate = gsearchtool_predicate_new (kind);
+	predicate->text = g_strdup (text);
+	return predicate;
+}
+
+void
+gsearchtool_predicate_free (GSearchPredicate * predicate)
+{
+	if (predicate == NULL) {
+		return;
+	}
+	if (predicate->children != NULL) {
+		g_ptr_array_free (predicate->children, TRUE);
+	}
+	g_free (predicate->text);
+	g_slice_free (GSearchPredicate, predicate);
+}
+
+void
+gsearchtool_predicate_add (GSearchPredicate * parent,
+                           GSearchPredicate * child)
+{
+	g_return_if_fail (parent->children != NULL);
+	g_return_if_fail ((parent->kind != GSEARCH_PREDICATE_NOT) || (parent->children->len == 0));
+
+	g_ptr_array_add (parent->children, child);
+}
+
+GSearchPredicateKind
+gsearchtool_predicate_get_kind (GSearchPredicate * predicate)
+{
+	return predicate->kind;
+}
+
+/* The part of the files expected to pass @predicate. */
+gdouble
+gsearchtool_predicate_get_selectivity (GSearchPredicate * predicate)
+{
+	gdouble selectivity;
+	guint i;
+
+	switch (predicate->kind) {
+	case GSEARCH_PREDICATE_AND:
+		selectivity = 1.0;
+		for (i = 0; i < predicate->children->len; i++) {
+			selectivity *= gsearchtool_predicate_get_selectivity (g_ptr_array_index (predicate->children, i));
+		}
+		return selectivity;
+	case GSEARCH_PREDICATE_OR:
+		selectivity = 1.0;
+		for (i = 0; i < predicate->children->len; i++) {
+			selectivity *= 1.0 - gsearchtool_predicate_get_selectivity (g_ptr_array_index (predicate->children, i));
+		}
+		return 1.0 - selectivity;
+	case GSEARCH_PREDICATE_NOT:
+		if (predicate->children->len == 0) {
+			return 0.0;
+		}
+		return 1.0 - gsearchtool_predicate_get_selectivity (g_ptr_array_index (predicate->children, 0));
+	default:
+		return leaf_estimates[predicate->kind].selectivity;
+	}
+}
+
+/* The expected cost of a test, the operands of an AND or OR after the
+   first only count for the files that get that far.  The unit is about
+   a microsecond. */
+gdouble
+gsearchtool_predicate_get_cost (GSearchPredicate * predicate)
+{
+	gdouble cost = 0.0;
+	gdouble reached = 1.0;
+	guint i;
+
+	switch (predicate->kind) {
+	case GSEARCH_PREDICATE_AND:
+	case GSEARCH_PREDICATE_OR:
+		for (i = 0; i < predicate->children->len; i++) {
+			GSearchPredicate * child = g_ptr_array_index (predicate->children, i);
+			gdouble selectivity = gsearchtool_predicate_get_selectivity (child);
+
+			cost += reached * gsearchtool_predicate_get_cost (child);
+			reached *= (predicate->kind == GSEARCH_PREDICATE_AND) ? selectivity : 1.0 - selectivity;
+		}
+		return cost;
+	case GSEARCH_PREDICATE_NOT:
+		if (predicate->children->len == 0) {
+			return 0.0;
+		}
+		return gsearchtool_predicate_get_cost (g_ptr_array_index (predicate->children, 0));
+	default:
+		return leaf_estimates[predicate->kind].cost;
+	}
+}
+
+/* An operand of an AND goes first the cheaper it is and the more files
+   it rules out, one of an OR the more files it lets through. */
+static gdouble
+get_rank (GSearchPredicate * predicate,
+          GSearchPredicateKind parent_kind)
+{
+	gdouble settled;
+
+	settled = gsearchtool_predicate_get_selectivity (predicate);
+	if (parent_kind == GSEARCH_PREDICATE_AND) {
+		settled = 1.0 - settled;
+	}
+	if (settled <= 0.0) {
+		return G_MAXDOUBLE;
+	}
+	return gsearchtool_predicate_get_cost (predicate) / settled;
+}
+
+static gint
+compare_ranks (gconstpointer a,
+               gconstpointer b,
+               gpointer data)
+{
+	GSearchPredicate * predicate_a = *(GSearchPredicate **) a;
+	GSearchPredicate * predicate_b = *(GSearchPredicate **) b;
+	GSearchPredicateKind parent_kind = GPOINTER_TO_INT (data);
+	gdouble rank_a = get_rank (predicate_a, parent_kind);
+	gdouble rank_b = get_rank (predicate_b, parent_kind);
+
+	if (rank_a != rank_b) {
+		return (rank_a < rank_b) ? -1 : 1;
+	}
+	return (gint) predicate_a->kind - (gint) predicate_b->kind;
+}
+
+/* Whether @predicate has a test of @kind anywhere in it. */
+gboolean
+gsearchtool_predicate_has_kind (GSearchPredicate * predicate,
+                                GSearchPredicateKind kind)
+{
+	guint i;
+
+	if (predicate->kind == kind) {
+		return TRUE;
+	}
+	if (predicate->children == NULL) {
+		return FALSE;
+	}
+	for (i = 0; i < predicate->children->len; i++) {
+		if (gsearchtool_predicate_has_kind (g_ptr_array_index (predicate->children, i), kind) == TRUE) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gboolean
+is_equal (GSearchPredicate * predicate,
+          GSearchPredicate * other)
+{
+	guint i;
+
+	if ((predicate->kind != other->kind) ||
+	    (predicate->number != other->number) ||
+	    (g_strcmp0 (predicate->text, other->text) != 0)) {
+		return FALSE;
+	}
+	if (predicate->children == NULL) {
+		return TRUE;
+	}
+	if (predicate->children->len != other->children->len) {
+		return FALSE;
+	}
+	for (i = 0; i < predicate->children->len; i++) {
+		if (is_equal (g_ptr_array_index (predicate->children, i),
+		              g_ptr_array_index (other->children, i)) == FALSE) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/* Whether every file that passes @predicate passes @other, as far as
+   can be told from the two tests alone. */
+static gboolean
+is_implying (GSearchPredicate * predicate,
+             GSearchPredicate * other)
+{
+	if (is_equal (predicate, other) == TRUE) {
+		return TRUE;
+	}
+	if (predicate->kind != other->kind) {
+		return (predicate->kind == GSEARCH_PREDICATE_EMPTY) && (other->kind == GSEARCH_PREDICATE_SIZE_AT_MOST);
+	}
+	switch (predicate->kind) {
+	case GSEARCH_PREDICATE_SIZE_AT_LEAST:
+	case GSEARCH_PREDICATE_MODIFIED_BEFORE:
+		return predicate->number >= other->number;
+	case GSEARCH_PREDICATE_SIZE_AT_MOST:
+	case GSEARCH_PREDICATE_MODIFIED_WITHIN:
+		return predicate->number <= other->number;
+	default:
+		return FALSE;
+	}
+}
+
+/* The operands of @predicate that must all pass, those of the ANDs in
+   it, in @conjuncts. */
+static void
+get_conjuncts (GSearchPredicate * predicate,
+               GPtrArray * conjuncts)
+{
+	guint i;
+
+	if (predicate->kind != GSEARCH_PREDICATE_AND) {
+		g_ptr_array_add (conjuncts, predicate);
+		return;
+	}
+	for (i = 0; i < predicate->children->len; i++) {
+		get_conjuncts (g_ptr_array_index (predicate->children, i), conjuncts);
+	}
+}
+
+/* Whether the files that pass @predicate are those of the files that
+   passed @previous that gsearchtool_predicate_evaluate() lets through,
+   so a search narrowed down need not walk the folders again.  Each test
+   of @previous must follow from one of @predicate, and the tests left
+   to find must have been run on the files already. */
+gboolean
+gsearchtool_predicate_refines (GSearchPredicate * predicate,
+                               GSearchPredicate * previous)
+{
+	GPtrArray * conjuncts;
+	GPtrArray * previous_conjuncts;
+	gboolean is_refining = TRUE;
+	guint i;
+	guint j;
+
+	conjuncts = g_ptr_array_new ();
+	previous_conjuncts = g_ptr_array_new ();
+	get_conjuncts (predicate, conjuncts);
+	get_conjuncts (previous, previous_conjuncts);
+
+	for (i = 0; (is_refining == TRUE) && (i < previous_conjuncts->len); i++) {
+		is_refining = FALSE;
+		for (j = 0; (is_refining == FALSE) && (j < conjuncts->len); j++) {
+			is_refining = is_implying (g_ptr_array_index (conjuncts, j),
+			                           g_ptr_array_index (previous_conjuncts, i));
+		}
+	}
+	for (i = 0; (is_refining == TRUE) && (i < conjuncts->len); i++) {
+		GSearchPredicate * conjunct = g_ptr_array_index (conjuncts, i);
+
+		if (gsearchtool_predicate_has_kind (conjunct, GSEARCH_PREDICATE_FIND_TEST) == FALSE) {
+			continue;
+		}
+		is_refining = FALSE;
+		for (j = 0; (is_refining == FALSE) && (j < previous_conjuncts->len); j++) {
+			is_refining = is_equal (conjunct, g_ptr_array_index (previous_conjuncts, j));
+		}
+	}
+	g_ptr_array_free (conjuncts, TRUE);
+	g_ptr_array_free (previous_conjuncts, TRUE);
+
+	return is_refining;
+}
+
+/* Reorders the operands of each AND and OR of @predicate, cheapest and
+   most decisive first. */
+void
+gsearchtool_predicate_optimize (GSearchPredicate * predicate)
+{
+	guint i;
+
+	if (predicate->children == NULL) {
+		return;
+	}
+	for (i = 0; i < predicate->children->len; i++) {
+		gsearchtool_predicate_optimize (g_ptr_array_index (predicate->children, i));
+	}
+	if (predicate->kind != GSEARCH_PREDICATE_NOT) {
+		g_ptr_array_sort_with_data (predicate->children, compare_ranks, GINT_TO_POINTER (predicate->kind));
+	}
+}
+
+static void
+append_find_arguments (GString * arguments,
+                       GSearchPredicate * predicate,
+                       gboolean is_nested)
+{
+	gchar * quoted;
+	guint i;
+
+	switch (predicate->kind) {
+	case GSEARCH_PREDICATE_AND:
+		if (predicate->children->len == 0) {
+			if (is_nested == TRUE) {
+				g_string_append (arguments, "-true ");
+			}
+			break;
+		}
+		if ((is_nested == TRUE) && (predicate->children->len > 1)) {
+			g_string_append (arguments, "\\( ");
+		}
+		for (i = 0; i < predicate->children->len; i++) {
+			append_find_arguments (arguments, g_ptr_array_index (predicate->children, i),
+			                       (predicate->children->len == 1) ? is_nested : FALSE);
+		}
+		if ((is_nested == TRUE) && (predicate->children->len > 1)) {
+			g_string_append (arguments, "\\) ");
+		}
+		break;
+	case GSEARCH_PREDICATE_OR:
+		if (predicate->children->len == 0) {
+			g_string_append (arguments, "-false ");
+			break;
+		}
+		g_string_append (arguments, "\\( ");
+		for (i = 0; i < predicate->children->len; i++) {
+			if (i > 0) {
+				g_string_append (arguments, "-o ");
+			}
+			append_find_arguments (arguments, g_ptr_array_index (predicate->children, i), TRUE);
+		}
+		g_string_append (arguments, "\\) ");
+		break;
+	case GSEARCH_PREDICATE_NOT:
+		g_string_append (arguments, "'!' ");
+		if (predicate->children->len == 0) {
+			g_string_append (arguments, "-false ");
+			break;
+		}
+		append_find_arguments (arguments, g_ptr_array_index (predicate->children, 0), TRUE);
+		break;
+	case GSEARCH_PREDICATE_NAME:
+		quoted = g_shell_quote (predicate->text);
+		g_string_append_printf (arguments, "-name %s ", quoted);
+		g_free (quoted);
+		break;
+	case GSEARCH_PREDICATE_INAME:
+		quoted = g_shell_quote (predicate->text);
+		g_string_append_printf (arguments, "-iname %s ", quoted);
+		g_free (quoted);
+		break;
+	case GSEARCH_PREDICATE_REGULAR:
+		g_string_append (arguments, "-type f ");
+		break;
+	case GSEARCH_PREDICATE_DIRECTORY:
+		g_string_append (arguments, "-type d ");
+		break;
+	case GSEARCH_PREDICATE_MODIFIED_WITHIN:
+		g_string_append_printf (arguments, "-mtime -%" G_GINT64_FORMAT " ", predicate->number);
+		break;
+	case GSEARCH_PREDICATE_MODIFIED_BEFORE:
+		g_string_append_printf (arguments, "\\( -mtime +%" G_GINT64_FORMAT " -o -mtime %" G_GINT64_FORMAT " \\) ",
+		                        predicate->number, predicate->number);
+		break;
+	case GSEARCH_PREDICATE_SIZE_AT_LEAST:
+		g_string_append_printf (arguments, "\\( -size %" G_GINT64_FORMAT "c -o -size +%" G_GINT64_FORMAT "c \\) ",
+		                        predicate->number, predicate->number);
+		break;
+	case GSEARCH_PREDICATE_SIZE_AT_MOST:
+		g_string_append_printf (arguments, "\\( -size %" G_GINT64_FORMAT "c -o -size -%" G_GINT64_FORMAT "c \\) ",
+		                        predicate->number, predicate->number);
+		break;
+	case GSEARCH_PREDICATE_EMPTY:
+		g_string_append (arguments, (is_nested == TRUE) ? "\\( -size 0c \\( -type f -o -type d \\) \\) " :
+		                                                  "-size 0c \\( -type f -o -type d \\) ");
+		break;
+	case GSEARCH_PREDICATE_UID:
+		g_string_append_printf (arguments, "-uid %" G_GINT64_FORMAT " ", predicate->number);
+		break;
+	case GSEARCH_PREDICATE_GID:
+		g_string_append_printf (arguments, "-gid %" G_GINT64_FORMAT " ", predicate->number);
+		break;
+	case GSEARCH_PREDICATE_USER:
+	case GSEARCH_PREDICATE_GROUP:
+		quoted = g_shell_quote (predicate->text);
+		g_string_append_printf (arguments, "%s %s ",
+		                        (predicate->kind == GSEARCH_PREDICATE_USER) ? "-user" : "-group", quoted);
+		g_free (quoted);
+		break;
+	case GSEARCH_PREDICATE_NO_OWNER:
+		g_string_append (arguments, "\\( -nouser -o -nogroup \\) ");
+		break;
+	case GSEARCH_PREDICATE_FIND_TEST:
+		if (is_nested == TRUE) {
+			g_string_append_printf (arguments, "\\( %s \\) ", predicate->text);
+		}
+		else {
+			g_string_append_printf (arguments, "%s ", predicate->text);
+		}
+		break;
+	case GSEARCH_PREDICATE_NOT_HIDDEN:
+		/* Done by the pruning. */
+		if (is_nested == TRUE) {
+			g_string_append (arguments, "-true ");
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* Returns the find tests of @predicate, for an expression that is
+   already ANDed with others, an empty string when there are none. */
+gchar *
+gsearchtool_predicate_to_find_arguments (GSearchPredicate * predicate)
+{
+	GString * arguments;
+
+	arguments = g_string_new ("");
+	append_find_arguments (arguments, predicate, FALSE);
+	return g_string_free (arguments, FALSE);
+}
+
+/* Returns the find arguments that prune what fails the folder level
+   tests of @predicate under @folder, to go before all the others.  Only
+   the tests at the top of the tree can be done that way. */
+gchar *
+gsearchtool_predicate_to_find_prune_arguments (GSearchPredicate * predicate,
+                                               const gchar * folder)
+{
+	GSearchPredicate * hidden = NULL;
+	guint i;
+
+	if (predicate->kind == GSEARCH_PREDICATE_NOT_HIDDEN) {
+		hidden = predicate;
+	}
+	else if (predicate->kind == GSEARCH_PREDICATE_AND) {
+		for (i = 0; i < predicate->children->len; i++) {
+			GSearchPredicate * child = g_ptr_array_index (predicate->children, i);
+
+			if (child->kind == GSEARCH_PREDICATE_NOT_HIDDEN) {
+				hidden = child;
+			}
+		}
+	}
+
+	/* Inside a hidden folder nothing is hidden, like in the results. */
+	if ((hidden == NULL) || (is_path_hidden (folder) == TRUE)) {
+		return g_strdup ("");
+	}
+	return g_strdup ("\\( -name '.*' '!' -name .gnome-desktop \\) -prune -o ");
+}
+
+/* The days find counts for -mtime, with the part of a day left out. */
+static gint64
+get_age_in_days (gint64 mtime,
+                 gint64 now)
+{
+	gint64 age = now - mtime;
+
+	if (age >= 0) {
+		return age / (24 * 60 * 60);
+	}
+	return -((-age + (24 * 60 * 60) - 1) / (24 * 60 * 60));
+}
+
+static gboolean
+is_owner_unknown (GSearchPredicate * predicate,
+                  guint32 uid,
+                  guint32 gid)
+{
+	if ((predicate->has_owner == FALSE) ||
+	    (predicate->owner_uid != uid) ||
+	    (predicate->owner_gid != gid)) {
+		predicate->has_owner = TRUE;
+		predicate->owner_uid = uid;
+		predicate->owner_gid = gid;
+		predicate->is_owner_unknown = (getpwuid (uid) == NULL) || (getgrgid (gid) == NULL);
+	}
+	return predicate->is_owner_unknown;
+}
+
+/* Runs @predicate on @path, found under @folder, as find would.  The
+   tests on the name need no @io_stat, the others fail when it holds an
+   error. */
+gboolean
+gsearchtool_predicate_evaluate (GSearchPredicate * predicate,
+                                const gchar * folder,
+                                const gchar * path,
+                                const GSearchIoStat * io_stat,
+                                gint64 now)
+{
+	const gchar * name;
+	guint i;
+
+	switch (predicate->kind) {
+	case GSEARCH_PREDICATE_AND:
+		for (i = 0; i < predicate->children->len; i++) {
+			if (gsearchtool_predicate_evaluate (g_ptr_array_index (predicate->children, i),
+			                                    folder, path, io_stat, now) == FALSE) {
+				return FALSE;
+			}
+		}
+		return TRUE;
+	case GSEARCH_PREDICATE_OR:
+		for (i = 0; i < predicate->children->len; i++) {
+			if (gsearchtool_predicate_evaluate (g_ptr_array_index (predicate->children, i),
+			                                    folder, path, io_stat, now) == TRUE) {
+				return TRUE;
+			}
+		}
+		return FALSE;
+	case GSEARCH_PREDICATE_NOT:
+		if (predicate->children->len == 0) {
+			return TRUE;
+		}
+		return !gsearchtool_predicate_evaluate (g_ptr_array_index (predicate->children, 0),
+		                                        folder, path, io_stat, now);
+	case GSEARCH_PREDICATE_NAME:
+		name = strrchr (path, G_DIR_SEPARATOR);
+		name = (name != NULL) ? name + 1 : path;
+		return (fnmatch (predicate->text, name, 0) == 0);
+	case GSEARCH_PREDICATE_INAME:
+		name = strrchr (path, G_DIR_SEPARATOR);
+		name = (name != NULL) ? name + 1 : path;
+		return (fnmatch (predicate->text, name, FNM_CASEFOLD) == 0);
+	case GSEARCH_PREDICATE_NOT_HIDDEN:
+		return (is_path_hidden (path) == FALSE) || (is_path_hidden (folder) == TRUE);
+	case GSEARCH_PREDICATE_FIND_TEST:
+		/* Left to find, see gsearchtool_predicate_to_find_arguments(). */
+		return TRUE;
+	default:
+		break;
+	}
+
+	if (io_stat->error != 0) {
+		return FALSE;
+	}
+	switch (predicate->kind) {
+	case GSEARCH_PREDICATE_REGULAR:
+		return S_ISREG (io_stat->mode);
+	case GSEARCH_PREDICATE_DIRECTORY:
+		return S_ISDIR (io_stat->mode);
+	case GSEARCH_PREDICATE_MODIFIED_WITHIN:
+		return get_age_in_days (io_stat->mtime, now) < predicate->number;
+	case GSEARCH_PREDICATE_MODIFIED_BEFORE:
+		return get_age_in_days (io_stat->mtime, now) >= predicate->number;
+	case GSEARCH_PREDICATE_SIZE_AT_LEAST:
+		return io_stat->size >= predicate->number;
+	case GSEARCH_PREDICATE_SIZE_AT_MOST:
+		return io_stat->size <= predicate->number;
+	case GSEARCH_PREDICATE_EMPTY:
+		return (io_stat->size == 0) && (S_ISREG (io_stat->mode) || S_ISDIR (io_stat->mode));
+	case GSEARCH_PREDICATE_UID:
+		return io_stat->uid == predicate->number;
+	case GSEARCH_PREDICATE_GID:
+		return io_stat->gid == predicate->number;
+	case GSEARCH_PREDICATE_NO_OWNER:
+		return is_owner_unknown (predicate, io_stat->uid, io_stat->gid);
+	default:
+		/* A user or group that is not known owns nothing. */
+		return FALSE;
+	}
+}
@@ -0,0 +1,111 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-predicate.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_PREDICATE_H_
+#define _GSEARCHTOOL_PREDICATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+#include "gsearchtool-io.h"
+
+typedef enum {
+	GSEARCH_PREDICATE_AND,
+	GSEARCH_PREDICATE_OR,
+	GSEARCH_PREDICATE_NOT,
+	GSEARCH_PREDICATE_NAME,			/* the name matches a glob */
+	GSEARCH_PREDICATE_INAME,		/* the same, whatever the case */
+	GSEARCH_PREDICATE_REGULAR,		/* a regular file */
+	GSEARCH_PREDICATE_DIRECTORY,
+	GSEARCH_PREDICATE_MODIFIED_WITHIN,	/* less than a number of days ago */
+	GSEARCH_PREDICATE_MODIFIED_BEFORE,	/* at least a number of days ago */
+	GSEARCH_PREDICATE_SIZE_AT_LEAST,	/* in bytes */
+	GSEARCH_PREDICATE_SIZE_AT_MOST,
+	GSEARCH_PREDICATE_EMPTY,
+	GSEARCH_PREDICATE_UID,
+	GSEARCH_PREDICATE_GID,
+	GSEARCH_PREDICATE_USER,			/* a user name that is not known */
+	GSEARCH_PREDICATE_GROUP,
+	GSEARCH_PREDICATE_NO_OWNER,
+	GSEARCH_PREDICATE_NOT_HIDDEN,		/* prunes the hidden folders */
+	GSEARCH_PREDICATE_FIND_TEST		/* find arguments, like an -exec */
+} GSearchPredicateKind;
+
+typedef struct _GSearchPredicate GSearchPredicate;
+
+GSearchPredicate *
+gsearchtool_predicate_new (GSearchPredicateKind kind);
+
+GSearchPredicate *
+gsearchtool_predicate_new_number (GSearchPredicateKind kind,
+                                  gint64 number);
+GSearchPredicate *
+gsearchtool_predicate_new_text (GSearchPredicateKind kind,
+                                const gchar * text);
+void
+gsearchtool_predicate_free (GSearchPredicate * predicate);
+
+void
+gsearchtool_predicate_add (GSearchPredicate * parent,
+                           GSearchPredicate * child);
+GSearchPredicateKind
+gsearchtool_predicate_get_kind (GSearchPredicate * predicate);
+
+gboolean
+gsearchtool_predicate_has_kind (GSearchPredicate * predicate,
+                                GSearchPredicateKind kind);
+gboolean
+gsearchtool_predicate_refines (GSearchPredicate * predicate,
+                               GSearchPredicate * previous);
+gdouble
+gsearchtool_predicate_get_selectivity (GSearchPredicate * predicate);
+
+gdouble
+gsearchtool_predicate_get_cost (GSearchPredicate * predicate);
+
+void
+gsearchtool_predicate_optimize (GSearchPredicate * predicate);
+
+gchar *
+gsearchtool_predicate_to_find_arguments (GSearchPredicate * predicate);
+
+gchar *
+gsearchtool_predicate_to_find_prune_arguments (GSearchPredicate * predicate,
+                                               const gchar * folder);
+gboolean
+gsearchtool_predicate_evaluate (GSearchPredicate * predicate,
+                                const gchar * folder,
+                                const gchar * path,
+                                const GSearchIoStat * io_stat,
+                                gint64 now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_PREDICATE_H_ */
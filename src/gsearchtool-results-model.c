@@ -0,0 +1,810 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-results-model.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * A flat GtkTreeModel over the result store.  Rows are not kept in the
+ * model: the columns are computed from the record of a row when the view
+ * asks for them.  The columns that need to look at the file again, the
+ * icon and the type description, are kept for the most recently shown
+ * rows only.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib/gi18n.h>
+
+#include "gsearchtool.h"
+#include "gsearchtool-support.h"
+#include "gsearchtool-results-model.h"
+
+#define GSEARCH_RESULTS_MODEL_ROW_CACHE_SIZE 512
+#define GSEARCH_RESULTS_MODEL_SPILL_FOLDER "gnome-search-tool"
+
+typedef struct _GSearchResultsModelRow GSearchResultsModelRow;
+
+struct _GSearchResultsModelRow {
+	guint                   id;
+	GdkPixbuf             * pixbuf;
+	gchar                 * description;
+	gchar                 * readable_size;
+	gchar                 * readable_date;
+	GList                 * link;
+};
+
+static GObjectClass * parent_class;
+
+static void
+free_row (GSearchResultsModelRow * row)
+{
+	if (row->pixbuf != NULL) {
+		g_object_unref (row->pixbuf);
+	}
+	g_free (row->description);
+	g_free (row->readable_size);
+	g_free (row->readable_date);
+	g_slice_free (GSearchResultsModelRow, row);
+}
+
+static void
+clear_row_cache (GSearchResultsModel * model)
+{
+	g_hash_table_remove_all (model->row_cache);
+	g_queue_clear (model->row_cache_queue);
+}
+
+static void
+forget_row (GSearchResultsModel * model,
+            guint id)
+{
+	GSearchResultsModelRow * row;
+
+	row = g_hash_table_lookup (model->row_cache, GUINT_TO_POINTER (id));
+	if (row != NULL) {
+		g_queue_delete_link (model->row_cache_queue, row->link);
+		g_hash_table_remove (model->row_cache, GUINT_TO_POINTER (id));
+	}
+}
+
+static GSearchResultsModelRow *
+get_row (GSearchResultsModel * model,
+         GSearchResultsRecord * record)
+{
+	GSearchResultsModelRow * row;
+	GFileInfo * file_info;
+	GFile * g_file;
+	gchar * file;
+
+	row = g_hash_table_lookup (model->row_cache, GUINT_TO_POINTER (record->id));
+	if (row != NULL) {
+		g_queue_unlink (model->row_cache_queue, row->link);
+		g_queue_push_head_link (model->row_cache_queue, row->link);
+		return row;
+	}
+
+	if (g_queue_get_length (model->row_cache_queue) >= GSEARCH_RESULTS_MODEL_ROW_CACHE_SIZE) {
+		GList * last = g_queue_pop_tail_link (model->row_cache_queue);
+
+		g_hash_table_remove (model->row_cache, last->data);
+		g_list_free_1 (last);
+	}
+
+	/* The record does not survive other lookups in the store. */
+	file = g_strdup (record->path);
+
+	row = g_slice_new0 (GSearchResultsModelRow);
+	row->id = record->id;
+	row->readable_size = g_format_size (record->size);
+	row->readable_date = get_readable_date (model->date_format, record->mtime);
+
+	g_file = g_file_new_for_path (file);
+	file_info = g_file_query_info (g_file, "standard::*,thumbnail::path", 0, NULL, NULL);
+	if (file_info != NULL) {
+		row->pixbuf = model->icon_func (file_info, model->icon_data);
+		row->description = get_file_type_description (file, file_info);
+		g_object_unref (file_info);
+	}
+	else {
+		row->description = g_strdup (g_content_type_get_description ((record->content_type != NULL) ?
+		                                                              record->content_type : "application/octet-stream"));
+	}
+	g_object_unref (g_file);
+	g_free (file);
+
+	g_queue_push_head (model->row_cache_queue, GUINT_TO_POINTER (row->id));
+	row->link = g_queue_peek_head_link (model->row_cache_queue);
+	g_hash_table_insert (model->row_cache, GUINT_TO_POINTER (row->id), row);
+
+	return row;
+}
+
+/* The folder a file was found in, when several were searched, is the
+   deepest one holding it. */
+static const gchar *
+get_look_in_folder (GSearchResultsModel * model,
+                    const gchar * file)
+{
+	const gchar * look_in_folder = NULL;
+	gint i;
+
+	if (model->look_in_folders == NULL) {
+		return NULL;
+	}
+	for (i = 0; model->look_in_folders[i] != NULL; i++) {
+		if (g_str_has_prefix (file, model->look_in_folders[i]) &&
+		    (look_in_folder == NULL || strlen (model->look_in_folders[i]) > strlen (look_in_folder))) {
+			look_in_folder = model->look_in_folders[i];
+		}
+	}
+	return look_in_folder;
+}
+
+static gchar *
+get_relative_folder (GSearchResultsModel * model,
+                     const gchar * file)
+{
+	gchar * relative_dir_name;
+	gchar * look_in_folder;
+	gchar * dir_name;
+	gchar * utf8_relative_dir_name;
+
+	dir_name = g_path_get_dirname (file);
+
+	look_in_folder = g_strdup (get_look_in_folder (model, file));
+	if (look_in_folder != NULL && strlen (look_in_folder) > 1) {
+		gchar * path_str;
+
+		if (g_str_has_suffix (look_in_folder, G_DIR_SEPARATOR_S) == TRUE) {
+			look_in_folder[strlen (look_in_folder) - 1] = '\0';
+		}
+		path_str = g_path_get_dirname (look_in_folder);
+		if (strcmp (path_str, G_DIR_SEPARATOR_S) == 0) {
+			relative_dir_name = g_strdup (&dir_name[strlen (path_str)]);
+		}
+		else {
+			relative_dir_name = g_strdup (&dir_name[strlen (path_str) + 1]);
+		}
+		g_free (path_str);
+	}
+	else {
+		relative_dir_name = g_strdup (dir_name);
+	}
+
+	utf8_relative_dir_name = g_filename_display_name (relative_dir_name);
+
+	g_free (relative_dir_name);
+	g_free (look_in_folder);
+	g_free (dir_name);
+
+	return utf8_relative_dir_name;
+}
+
+static GtkTreeModelFlags
+gsearch_results_model_get_flags (GtkTreeModel * tree_model)
+{
+	return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gsearch_results_model_get_n_columns (GtkTreeModel * tree_model)
+{
+	return NUM_COLUMNS;
+}
+
+static GType
+gsearch_results_model_get_column_type (GtkTreeModel * tree_model,
+                                       gint index)
+{
+	switch (index) {
+	case COLUMN_ICON:
+		return GDK_TYPE_PIXBUF;
+	case COLUMN_SIZE:
+	case COLUMN_DATE:
+		return G_TYPE_DOUBLE;
+	case COLUMN_NO_FILES_FOUND:
+		return G_TYPE_BOOLEAN;
+	default:
+		return G_TYPE_STRING;
+	}
+}
+
+static gint
+get_n_rows (GSearchResultsModel * model)
+{
+	return gsearchtool_results_get_length (model->results) + (model->has_no_files_found_row ? 1 : 0);
+}
+
+static gboolean
+gsearch_results_model_get_iter (GtkTreeModel * tree_model,
+                                GtkTreeIter * iter,
+                                GtkTreePath * path)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (tree_model);
+	gint index;
+
+	g_return_val_if_fail (gtk_tree_path_get_depth (path) > 0, FALSE);
+
+	index = gtk_tree_path_get_indices (path)[0];
+	if (index < 0 || index >= get_n_rows (model)) {
+		return FALSE;
+	}
+	iter->stamp = model->stamp;
+	iter->user_data = GINT_TO_POINTER (index);
+
+	return TRUE;
+}
+
+static GtkTreePath *
+gsearch_results_model_get_path (GtkTreeModel * tree_model,
+                                GtkTreeIter * iter)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (tree_model);
+
+	g_return_val_if_fail (iter->stamp == model->stamp, NULL);
+
+	return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
+}
+
+static void
+gsearch_results_model_get_value (GtkTreeModel * tree_model,
+                                 GtkTreeIter * iter,
+                                 gint column,
+                                 GValue * value)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (tree_model);
+	GSearchResultsRecord record;
+	gint index;
+
+	g_return_if_fail (iter->stamp == model->stamp);
+
+	g_value_init (value, gsearch_results_model_get_column_type (tree_model, column));
+	index = GPOINTER_TO_INT (iter->user_data);
+
+	if (model->has_no_files_found_row) {
+		switch (column) {
+		case COLUMN_NAME:
+			g_value_set_string (value, _("No files found"));
+			break;
+		case COLUMN_NO_FILES_FOUND:
+			g_value_set_boolean (value, TRUE);
+			break;
+		case COLUMN_ICON:
+		case COLUMN_SIZE:
+		case COLUMN_DATE:
+			break;
+		default:
+			g_value_set_string (value, "");
+			break;
+		}
+		return;
+	}
+
+	if (gsearchtool_results_get (model->results, index, &record) == FALSE) {
+		return;
+	}
+
+	switch (column) {
+	case COLUMN_ICON:
+		g_value_set_object (value, get_row (model, &record)->pixbuf);
+		break;
+	case COLUMN_NAME:
+		g_value_take_string (value, g_filename_display_basename (record.path));
+		break;
+	case COLUMN_RELATIVE_PATH:
+		g_value_take_string (value, get_relative_folder (model, record.path));
+		break;
+	case COLUMN_LOCALE_FILE:
+		g_value_set_string (value, record.path);
+		break;
+	case COLUMN_READABLE_SIZE:
+		g_value_set_string (value, get_row (model, &record)->readable_size);
+		break;
+	case COLUMN_SIZE:
+		g_value_set_double (value, (-1) * (gdouble) record.size);
+		break;
+	case COLUMN_TYPE:
+		g_value_set_string (value, get_row (model, &record)->description);
+		break;
+	case COLUMN_READABLE_DATE:
+		g_value_set_string (value, get_row (model, &record)->readable_date);
+		break;
+	case COLUMN_DATE:
+		g_value_set_double (value, (-1) * (gdouble) record.mtime);
+		break;
+	case COLUMN_NO_FILES_FOUND:
+		g_value_set_boolean (value, FALSE);
+		break;
+	default:
+		break;
+	}
+}
+
+static gboolean
+gsearch_results_model_iter_next (GtkTreeModel * tree_model,
+                                 GtkTreeIter * iter)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (tree_model);
+	gint index = GPOINTER_TO_INT (iter->user_data) + 1;
+
+	if (index >= get_n_rows (model)) {
+		iter->stamp = 0;
+		return FALSE;
+	}
+	iter->user_data = GINT_TO_POINTER (index);
+
+	return TRUE;
+}
+
+static gboolean
+gsearch_results_model_iter_nth_child (GtkTreeModel * tree_model,
+                                      GtkTreeIter * iter,
+                                      GtkTreeIter * parent,
+                                      gint n)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (tree_model);
+
+	if (parent != NULL || n < 0 || n >= get_n_rows (model)) {
+		return FALSE;
+	}
+	iter->stamp = model->stamp;
+	iter->user_data = GINT_TO_POINTER (n);
+
+	return TRUE;
+}
+
+static gboolean
+gsearch_results_model_iter_children (GtkTreeModel * tree_model,
+                                     GtkTreeIter * iter,
+                                     GtkTreeIter * parent)
+{
+	return gsearch_results_model_iter_nth_child (tree_model, iter, parent, 0);
+}
+
+static gboolean
+gsearch_results_model_iter_has_child (GtkTreeModel * tree_model,
+                                      GtkTreeIter * iter)
+{
+	return FALSE;
+}
+
+static gint
+gsearch_results_model_iter_n_children (GtkTreeModel * tree_model,
+                                       GtkTreeIter * iter)
+{
+	if (iter != NULL) {
+		return 0;
+	}
+	return get_n_rows (GSEARCH_RESULTS_MODEL (tree_model));
+}
+
+static gboolean
+gsearch_results_model_iter_parent (GtkTreeModel * tree_model,
+                                   GtkTreeIter * iter,
+                                   GtkTreeIter * child)
+{
+	return FALSE;
+}
+
+static void
+gsearch_results_model_tree_model_init (GtkTreeModelIface * iface)
+{
+	iface->get_flags = gsearch_results_model_get_flags;
+	iface->get_n_columns = gsearch_results_model_get_n_columns;
+	iface->get_column_type = gsearch_results_model_get_column_type;
+	iface->get_iter = gsearch_results_model_get_iter;
+	iface->get_path = gsearch_results_model_get_path;
+	iface->get_value = gsearch_results_model_get_value;
+	iface->iter_next = gsearch_results_model_iter_next;
+	iface->iter_children = gsearch_results_model_iter_children;
+	iface->iter_has_child = gsearch_results_model_iter_has_child;
+	iface->iter_n_children = gsearch_results_model_iter_n_children;
+	iface->iter_nth_child = gsearch_results_model_iter_nth_child;
+	iface->iter_parent = gsearch_results_model_iter_parent;
+}
+
+static gboolean
+gsearch_results_model_get_sort_column_id (GtkTreeSortable * sortable,
+                                          gint * sort_column_id,
+                                          GtkSortType * order)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (sortable);
+
+	if (sort_column_id != NULL) {
+		*sort_column_id = model->sort_column_id;
+	}
+	if (order != NULL) {
+		*order = model->sort_order;
+	}
+	return (model->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
+	        model->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID);
+}
+
+static void
+gsearch_results_model_set_sort_column_id (GtkTreeSortable * sortable,
+                                          gint sort_column_id,
+                                          GtkSortType order)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (sortable);
+	GSearchResultsSortColumn column;
+	gboolean descending = (order == GTK_SORT_DESCENDING);
+
+	if (model->sort_column_id == sort_column_id && model->sort_order == order) {
+		return;
+	}
+	model->sort_column_id = sort_column_id;
+	model->sort_order = order;
+
+	/* The size and date columns hold negated values, so that ascending
+	   order puts the largest and newest files first. */
+	switch (sort_column_id) {
+	case COLUMN_NAME:
+		column = GSEARCH_RESULTS_SORT_NAME;
+		break;
+	case COLUMN_RELATIVE_PATH:
+		column = GSEARCH_RESULTS_SORT_FOLDER;
+		break;
+	case COLUMN_SIZE:
+		column = GSEARCH_RESULTS_SORT_SIZE;
+		descending = !descending;
+		break;
+	case COLUMN_TYPE:
+		column = GSEARCH_RESULTS_SORT_TYPE;
+		break;
+	case COLUMN_DATE:
+		column = GSEARCH_RESULTS_SORT_DATE;
+		descending = !descending;
+		break;
+	default:
+		column = GSEARCH_RESULTS_SORT_NONE;
+		descending = FALSE;
+		break;
+	}
+	gsearchtool_results_set_sort (model->results, column, descending);
+
+	gtk_tree_sortable_sort_column_changed (sortable);
+	gsearch_results_model_sort (model);
+}
+
+static gboolean
+gsearch_results_model_has_default_sort_func (GtkTreeSortable * sortable)
+{
+	return FALSE;
+}
+
+static void
+gsearch_results_model_tree_sortable_init (GtkTreeSortableIface * iface)
+{
+	iface->get_sort_column_id = gsearch_results_model_get_sort_column_id;
+	iface->set_sort_column_id = gsearch_results_model_set_sort_column_id;
+	iface->has_default_sort_func = gsearch_results_model_has_default_sort_func;
+}
+
+static void
+gsearch_results_model_init (GSearchResultsModel * model)
+{
+	gchar * spill_folder;
+
+	spill_folder = g_build_filename (g_get_user_cache_dir (), GSEARCH_RESULTS_MODEL_SPILL_FOLDER, NULL);
+
+	model->results = gsearchtool_results_new (GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET, spill_folder);
+	model->stamp = g_random_int ();
+	model->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+	model->sort_order = GTK_SORT_ASCENDING;
+	model->row_cache = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) free_row);
+	model->row_cache_queue = g_queue_new ();
+
+	g_free (spill_folder);
+}
+
+static void
+gsearch_results_model_finalize (GObject * object)
+{
+	GSearchResultsModel * model = GSEARCH_RESULTS_MODEL (object);
+
+	g_hash_table_destroy (model->row_cache);
+	g_queue_free (model->row_cache_queue);
+	gsearchtool_results_free (model->results);
+	g_strfreev (model->look_in_folders);
+	g_free (model->date_format);
+
+	parent_class->finalize (object);
+}
+
+static void
+gsearch_results_model_class_init (GSearchResultsModelClass * klass)
+{
+	GObjectClass * object_class = (GObjectClass *) klass;
+
+	object_class->finalize = gsearch_results_model_finalize;
+	parent_class = g_type_class_peek_parent (klass);
+}
+
+GType
+gsearch_results_model_get_type (void)
+{
+	static GType object_type = 0;
+
+	if (!object_type) {
+		static const GTypeInfo object_info = {
+			sizeof (GSearchResultsModelClass),
+			NULL,
+			NULL,
+			(GClassInitFunc) gsearch_results_model_class_init,
+			NULL,
+			NULL,
+			sizeof (GSearchResultsModel),
+			0,
+			(GInstanceInitFunc) gsearch_results_model_init
+		};
+		static const GInterfaceInfo tree_model_info = {
+			(GInterfaceInitFunc) gsearch_results_model_tree_model_init,
+			NULL,
+			NULL
+		};
+		static const GInterfaceInfo tree_sortable_info = {
+			(GInterfaceInitFunc) gsearch_results_model_tree_sortable_init,
+			NULL,
+			NULL
+		};
+		object_type = g_type_register_static (G_TYPE_OBJECT, "GSearchResultsModel", &object_info, 0);
+		g_type_add_interface_static (object_type, GTK_TYPE_TREE_MODEL, &tree_model_info);
+		g_type_add_interface_static (object_type, GTK_TYPE_TREE_SORTABLE, &tree_sortable_info);
+	}
+	return object_type;
+}
+
+GSearchResultsModel *
+gsearch_results_model_new (GSearchResultsModelIconFunc icon_func,
+                           gpointer icon_data)
+{
+	GSearchResultsModel * model;
+
+	model = g_object_new (GSEARCH_TYPE_RESULTS_MODEL, NULL);
+	model->icon_func = icon_func;
+	model->icon_data = icon_data;
+
+	return model;
+}
+
+/* Detach the model from its views first when it holds many rows, every
+   row is deleted one by one otherwise. */
+void
+gsearch_results_model_clear (GSearchResultsModel * model,
+                             const gchar * const * look_in_folders,
+                             gsize memory_budget)
+{
+	gint n_rows;
+
+	for (n_rows = get_n_rows (model); n_rows > 0; n_rows--) {
+		GtkTreePath * path = gtk_tree_path_new_from_indices (n_rows - 1, -1);
+
+		if (model->has_no_files_found_row) {
+			model->has_no_files_found_row = FALSE;
+		}
+		else {
+			gsearchtool_results_remove (model->results, n_rows - 1);
+		}
+		gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
+		gtk_tree_path_free (path);
+	}
+
+	gsearchtool_results_clear (model->results);
+	gsearchtool_results_set_memory_budget (model->results, memory_budget);
+	clear_row_cache (model);
+	model->stamp++;
+
+	g_strfreev (model->look_in_folders);
+	model->look_in_folders = g_strdupv ((gchar **) look_in_folders);
+}
+
+void
+gsearch_results_model_set_date_format (GSearchResultsModel * model,
+                                       const gchar * date_format)
+{
+	g_free (model->date_format);
+	model->date_format = g_strdup (date_format);
+	clear_row_cache (model);
+}
+
+gboolean
+gsearch_results_model_contains (GSearchResultsModel * model,
+                                const gchar * file)
+{
+	return gsearchtool_results_contains (model->results, file);
+}
+
+/* Returns FALSE when the store could not take the result, the rows
+   already in it are kept. */
+gboolean
+gsearch_results_model_append (GSearchResultsModel * model,
+                              const gchar * file,
+                              GFileInfo * file_info)
+{
+	GtkTreePath * path;
+	GtkTreeIter iter;
+	GTimeVal time_val = { 0, 0 };
+	gint row;
+
+	if (file_info != NULL) {
+		g_file_info_get_modification_time (file_info, &time_val);
+	}
+
+	row = gsearchtool_results_append (model->results, file,
+	                                  (file_info != NULL) ? g_file_info_get_content_type (file_info) : NULL,
+	                                  (file_info != NULL) ? g_file_info_get_size (file_info) : 0,
+	                                  time_val.tv_sec);
+	if (row < 0) {
+		return FALSE;
+	}
+
+	iter.stamp = model->stamp;
+	iter.user_data = GINT_TO_POINTER (row);
+	path = gtk_tree_path_new_from_indices (row, -1);
+	gtk_tree_model_row_inserted (GTK_TREE_MODEL (model), path, &iter);
+	gtk_tree_path_free (path);
+
+	return TRUE;
+}
+
+void
+gsearch_results_model_remove (GSearchResultsModel * model,
+                              GtkTreeIter * iter)
+{
+	GtkTreePath * path;
+	gint row;
+
+	g_return_if_fail (iter->stamp == model->stamp);
+
+	row = GPOINTER_TO_INT (iter->user_data);
+	if (model->has_no_files_found_row) {
+		model->has_no_files_found_row = FALSE;
+	}
+	else {
+		gsearchtool_results_remove (model->results, row);
+	}
+
+	path = gtk_tree_path_new_from_indices (row, -1);
+	gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
+	gtk_tree_path_free (path);
+}
+
+gboolean
+gsearch_results_model_remove_file (GSearchResultsModel * model,
+                                   const gchar * file)
+{
+	GtkTreeIter iter;
+	gint row;
+
+	row = gsearchtool_results_find (model->results, file);
+	if (row < 0) {
+		return FALSE;
+	}
+	iter.stamp = model->stamp;
+	iter.user_data = GINT_TO_POINTER (row);
+	gsearch_results_model_remove (model, &iter);
+
+	return TRUE;
+}
+
+/* Takes the results @keep_func does not keep out at once.  The rows are
+   reported deleted from the last one up, so that the rows reported
+   later keep their number. */
+void
+gsearch_results_model_filter (GSearchResultsModel * model,
+                              GSearchResultsKeepFunc keep_func,
+                              gpointer data)
+{
+	GArray * removed;
+	guint idx;
+
+	removed = gsearchtool_results_filter (model->results, keep_func, data);
+	for (idx = removed->len; idx-- > 0; ) {
+		GtkTreePath * path = gtk_tree_path_new_from_indices (g_array_index (removed, guint, idx), -1);
+
+		gtk_tree_model_row_deleted (GTK_TREE_MODEL (model), path);
+		gtk_tree_path_free (path);
+	}
+	g_array_free (removed, TRUE);
+}
+
+/* Shows the new size, date and type of @file, a result that changed.
+   Returns FALSE when it is not among the results. */
+gboolean
+gsearch_results_model_update_file (GSearchResultsModel * model,
+                                   const gchar * file,
+                                   GFileInfo * file_info)
+{
+	GSearchResultsRecord record;
+	GtkTreePath * path;
+	GtkTreeIter iter;
+	GTimeVal time_val = { 0, 0 };
+	gint row;
+
+	row = gsearchtool_results_find (model->results, file);
+	if (row < 0) {
+		return FALSE;
+	}
+
+	g_file_info_get_modification_time (file_info, &time_val);
+	gsearchtool_results_update (model->results, row,
+	                            g_file_info_get_content_type (file_info),
+	                            g_file_info_get_size (file_info),
+	                            time_val.tv_sec);
+	if (gsearchtool_results_get (model->results, row, &record) == TRUE) {
+		forget_row (model, record.id);
+	}
+
+	iter.stamp = model->stamp;
+	iter.user_data = GINT_TO_POINTER (row);
+	path = gtk_tree_path_new_from_indices (row, -1);
+	gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+	gtk_tree_path_free (path);
+
+	return TRUE;
+}
+
+void
+gsearch_results_model_add_no_files_found_row (GSearchResultsModel * model)
+{
+	GtkTreePath * path;
+	GtkTreeIter iter;
+
+	if (model->has_no_files_found_row || gsearchtool_results_get_length (model->results) > 0) {
+		return;
+	}
+	model->has_no_files_found_row = TRUE;
+
+	iter.stamp = model->stamp;
+	iter.user_data = GINT_TO_POINTER (0);
+	path = gtk_tree_path_new_from_indices (0, -1);
+	gtk_tree_model_row_inserted (GTK_TREE_MODEL (model), path, &iter);
+	gtk_tree_path_free (path);
+}
+
+gint
+gsearch_results_model_get_length (GSearchResultsModel * model)
+{
+	return gsearchtool_results_get_length (model->results);
+}
+
+/* Results found after the store grew too large to keep them in order as
+   they come are sorted here. */
+void
+gsearch_results_model_sort (GSearchResultsModel * model)
+{
+	GtkTreePath * path;
+	gint * new_order;
+
+	new_order = gsearchtool_results_sort (model->results);
+	if (new_order == NULL) {
+		return;
+	}
+
+	path = gtk_tree_path_new ();
+	gtk_tree_model_rows_reordered (GTK_TREE_MODEL (model), path, NULL, new_order);
+	gtk_tree_path_free (path);
+	g_free (new_order);
+}
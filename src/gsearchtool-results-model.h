@@ -0,0 +1,116 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-results-model.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_RESULTS_MODEL_H_
+#define _GSEARCHTOOL_RESULTS_MODEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include "gsearchtool-results.h"
+
+#define GSEARCH_TYPE_RESULTS_MODEL            (gsearch_results_model_get_type ())
+#define GSEARCH_RESULTS_MODEL(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GSEARCH_TYPE_RESULTS_MODEL, GSearchResultsModel))
+#define GSEARCH_RESULTS_MODEL_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GSEARCH_TYPE_RESULTS_MODEL, GSearchResultsModelClass))
+#define GSEARCH_IS_RESULTS_MODEL(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GSEARCH_TYPE_RESULTS_MODEL))
+
+typedef struct _GSearchResultsModel GSearchResultsModel;
+typedef struct _GSearchResultsModelClass GSearchResultsModelClass;
+
+/* Returns a new reference to the icon of a result. */
+typedef GdkPixbuf * (* GSearchResultsModelIconFunc) (GFileInfo * file_info,
+                                                     gpointer data);
+
+struct _GSearchResultsModel {
+	GObject                 parent_instance;
+	GSearchResults        * results;
+	gint                    stamp;
+	gint                    sort_column_id;
+	GtkSortType             sort_order;
+	gboolean                has_no_files_found_row;
+	gchar                ** look_in_folders;
+	gchar                 * date_format;
+	GSearchResultsModelIconFunc icon_func;
+	gpointer                icon_data;
+	GHashTable            * row_cache;
+	GQueue                * row_cache_queue;
+};
+
+struct _GSearchResultsModelClass {
+	GObjectClass            parent_class;
+};
+
+GType
+gsearch_results_model_get_type (void);
+
+GSearchResultsModel *
+gsearch_results_model_new (GSearchResultsModelIconFunc icon_func,
+                           gpointer icon_data);
+void
+gsearch_results_model_clear (GSearchResultsModel * model,
+                             const gchar * const * look_in_folders,
+                             gsize memory_budget);
+void
+gsearch_results_model_set_date_format (GSearchResultsModel * model,
+                                       const gchar * date_format);
+gboolean
+gsearch_results_model_contains (GSearchResultsModel * model,
+                                const gchar * file);
+gboolean
+gsearch_results_model_append (GSearchResultsModel * model,
+                              const gchar * file,
+                              GFileInfo * file_info);
+void
+gsearch_results_model_remove (GSearchResultsModel * model,
+                              GtkTreeIter * iter);
+gboolean
+gsearch_results_model_remove_file (GSearchResultsModel * model,
+                                   const gchar * file);
+void
+gsearch_results_model_filter (GSearchResultsModel * model,
+                              GSearchResultsKeepFunc keep_func,
+                              gpointer data);
+gboolean
+gsearch_results_model_update_file (GSearchResultsModel * model,
+                                   const gchar * file,
+                                   GFileInfo * file_info);
+void
+gsearch_results_model_add_no_files_found_row (GSearchResultsModel * model);
+
+gint
+gsearch_results_model_get_length (GSearchResultsModel * model);
+
+void
+gsearch_results_model_sort (GSearchResultsModel * model);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_RESULTS_MODEL_H_ */
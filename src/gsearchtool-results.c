@@ -0,0 +1,1384 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-results.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * The result store keeps one compact record per search result: the
+ * locale path, size, modification time and content type.  Everything
+ * else shown in the results list is derived from the record when the
+ * row becomes visible.
+ *
+ * The store is made of five segments: the records themselves, the
+ * record offsets, the display order, the row of each record and a hash
+ * set of the paths used to drop duplicates.  The segments live in memory until together they
+ * grow beyond the memory budget.  From then on each segment is backed by
+ * an unlinked temporary file and only a bounded number of chunks of each
+ * file are mapped at any time, so the resident size of the store stays
+ * around the budget however many results there are.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-results.h"
+
+/* Segments are mapped in chunks of this size.  A record never crosses a
+   chunk boundary, so a chunk must hold the longest path. */
+#define GSEARCH_RESULTS_CHUNK_SIZE (256 * 1024)
+
+/* A record returned by a lookup must survive the next one, so at least
+   two chunks of each segment stay mapped. */
+#define GSEARCH_RESULTS_MIN_CHUNKS 2
+
+/* Spill files grow by this many chunks at a time. */
+#define GSEARCH_RESULTS_GROW_CHUNKS 16
+
+/* Results are inserted in sorted position while the store is in memory
+   and holds less rows than this.  Beyond it they are appended and the
+   whole store is sorted again when asked to. */
+#define GSEARCH_RESULTS_SORTED_INSERT_LIMIT 65536
+
+#define GSEARCH_RESULTS_DEDUP_INITIAL_SLOTS 1024
+#define GSEARCH_RESULTS_NO_CONTENT_TYPE G_MAXUINT32
+#define GSEARCH_RESULTS_NO_ROW G_MAXUINT32
+#define GSEARCH_RESULTS_RECORD_REMOVED (1 << 0)
+
+typedef struct _GSearchResultsChunk GSearchResultsChunk;
+typedef struct _GSearchResultsSpill GSearchResultsSpill;
+typedef struct _GSearchResultsHeader GSearchResultsHeader;
+typedef struct _GSearchResultsSlot GSearchResultsSlot;
+typedef struct _GSearchResultsEntry GSearchResultsEntry;
+typedef struct _GSearchResultsCursor GSearchResultsCursor;
+
+struct _GSearchResultsChunk {
+	gsize                   index;
+	guchar                * data;
+	guint64                 last_used;
+};
+
+/* A growable byte array, either in memory or in a mapped file. */
+struct _GSearchResultsSpill {
+	guchar                * memory;
+	gsize                   allocated;
+	gsize                   length;
+	gint                    fd;
+	gsize                   file_size;
+	GSearchResultsChunk   * chunks;
+	guint                   n_chunks;
+	guint                   max_chunks;
+	guint                   last_chunk;
+	guint64                 clock;
+	guint                   n_failures;
+};
+
+struct _GSearchResultsHeader {
+	gint64                  size;
+	gint64                  mtime;
+	guint32                 content_type;
+	guint16                 path_length;
+	guint16                 flags;
+};
+
+struct _GSearchResultsSlot {
+	guint64                 hash;
+	guint32                 id;
+	guint32                 unused;
+};
+
+struct _GSearchResultsEntry {
+	guint64                 key;
+	guint32                 id;
+	guint32                 unused;
+};
+
+struct _GSearchResultsCursor {
+	GSearchResultsEntry     entry;
+	gsize                   position;
+	gsize                   end;
+};
+
+struct _GSearchResults {
+	gsize                   memory_budget;
+	gchar                 * spill_folder;
+	gboolean                is_spilled;
+	gboolean                is_spill_failed;
+
+	GSearchResultsSpill     records;
+	GSearchResultsSpill     offsets;
+	GSearchResultsSpill     order;
+	GSearchResultsSpill     rows;
+	GSearchResultsSpill     dedup;
+	guint                   n_records;
+	guint                   n_rows;
+	guint                   n_slots;
+	guint                   n_used_slots;
+
+	GPtrArray             * content_types;
+	GHashTable            * content_type_hash_table;
+
+	gchar                 * first_path;
+	gsize                   common_prefix_length;
+
+	GSearchResultsSortColumn sort_column;
+	gboolean                sort_descending;
+	gboolean                is_sorted;
+	gboolean                is_sort_key_exact;
+};
+
+/* Each segment gets a share of the budget once the store has spilled,
+   in eighths. */
+enum {
+	GSEARCH_RESULTS_SHARE_RECORDS = 2,
+	GSEARCH_RESULTS_SHARE_DEDUP = 2,
+	GSEARCH_RESULTS_SHARE_OFFSETS = 1,
+	GSEARCH_RESULTS_SHARE_ORDER = 1,
+	GSEARCH_RESULTS_SHARE_ROWS = 1,
+	GSEARCH_RESULTS_SHARE_SORT = 1
+};
+
+/* Handed out in place of a chunk that could not be mapped. */
+static guchar failed_chunk[GSEARCH_RESULTS_CHUNK_SIZE];
+
+static guint
+get_chunk_limit (GSearchResults * results,
+                 guint share)
+{
+	gsize chunks;
+
+	chunks = (results->memory_budget / 8 * share) / GSEARCH_RESULTS_CHUNK_SIZE;
+	return MAX (GSEARCH_RESULTS_MIN_CHUNKS, chunks);
+}
+
+static void
+spill_init (GSearchResultsSpill * spill)
+{
+	memset (spill, 0, sizeof (GSearchResultsSpill));
+	spill->fd = -1;
+}
+
+static void
+spill_clear (GSearchResultsSpill * spill)
+{
+	guint idx;
+
+	for (idx = 0; idx < spill->n_chunks; idx++) {
+		munmap (spill->chunks[idx].data, GSEARCH_RESULTS_CHUNK_SIZE);
+	}
+	if (spill->fd != -1) {
+		close (spill->fd);
+	}
+	g_free (spill->chunks);
+	g_free (spill->memory);
+	spill_init (spill);
+}
+
+static gsize
+spill_get_memory_size (GSearchResultsSpill * spill)
+{
+	if (spill->fd == -1) {
+		return spill->allocated;
+	}
+	return spill->n_chunks * GSEARCH_RESULTS_CHUNK_SIZE;
+}
+
+static gboolean
+spill_grow_file (GSearchResultsSpill * spill,
+                 gsize size)
+{
+	gint result;
+
+	if (size <= spill->file_size) {
+		return TRUE;
+	}
+	size = MAX (size, spill->file_size + GSEARCH_RESULTS_GROW_CHUNKS * GSEARCH_RESULTS_CHUNK_SIZE);
+	size = (size + GSEARCH_RESULTS_CHUNK_SIZE - 1) / GSEARCH_RESULTS_CHUNK_SIZE * GSEARCH_RESULTS_CHUNK_SIZE;
+
+	/* Reserve the blocks up front, writing through a mapping of a sparse
+	   file on a full disk would crash instead of failing. */
+#ifdef HAVE_POSIX_FALLOCATE
+	result = posix_fallocate (spill->fd, 0, size);
+	if (result == EINVAL || result == EOPNOTSUPP) {
+		result = (ftruncate (spill->fd, size) == 0) ? 0 : errno;
+	}
+#else
+	result = (ftruncate (spill->fd, size) == 0) ? 0 : errno;
+#endif
+	if (result != 0) {
+		g_warning ("Could not grow the search results file: %s", g_strerror (result));
+		return FALSE;
+	}
+	spill->file_size = size;
+	return TRUE;
+}
+
+/* Moves the contents of @spill to an unlinked file in @folder. */
+static gboolean
+spill_to_file (GSearchResultsSpill * spill,
+               const gchar * folder,
+               guint max_chunks)
+{
+	gchar * template;
+	gsize written = 0;
+	gint fd;
+
+	template = g_build_filename (folder, "results-XXXXXX", NULL);
+	fd = g_mkstemp (template);
+	if (fd == -1) {
+		g_warning ("Could not create the search results file %s: %s", template, g_strerror (errno));
+		g_free (template);
+		return FALSE;
+	}
+	g_unlink (template);
+	g_free (template);
+
+	/* Keep the room already reserved in memory. */
+	spill->fd = fd;
+	spill->file_size = 0;
+	if (spill_grow_file (spill, MAX (spill->allocated, 1)) == FALSE) {
+		close (fd);
+		spill->fd = -1;
+		return FALSE;
+	}
+
+	while (written < spill->length) {
+		gssize count;
+
+		count = pwrite (fd, spill->memory + written, spill->length - written, written);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			g_warning ("Could not write the search results file: %s", g_strerror (errno));
+			close (fd);
+			spill->fd = -1;
+			spill->file_size = 0;
+			return FALSE;
+		}
+		written += count;
+	}
+
+	g_free (spill->memory);
+	spill->memory = NULL;
+	spill->allocated = 0;
+	spill->max_chunks = max_chunks;
+	spill->chunks = g_new0 (GSearchResultsChunk, max_chunks);
+
+	return TRUE;
+}
+
+/* A chunk that cannot be mapped, with the address space or the disk
+   used up, must not take the application down.  The lookup gets a
+   zeroed chunk that is not kept and the failure is counted, so that the
+   store can refuse more results and its caller stop the search. */
+static guchar *
+spill_lookup (GSearchResultsSpill * spill,
+              gsize offset)
+{
+	GSearchResultsChunk * chunk;
+	gsize index;
+	guint idx;
+	guint victim = 0;
+
+	if (spill->fd == -1) {
+		return spill->memory + offset;
+	}
+
+	index = offset / GSEARCH_RESULTS_CHUNK_SIZE;
+	offset = offset % GSEARCH_RESULTS_CHUNK_SIZE;
+
+	/* Most lookups are sequential. */
+	if (spill->last_chunk < spill->n_chunks && spill->chunks[spill->last_chunk].index == index) {
+		chunk = &spill->chunks[spill->last_chunk];
+		chunk->last_used = ++spill->clock;
+		return chunk->data + offset;
+	}
+
+	for (idx = 0; idx < spill->n_chunks; idx++) {
+		if (spill->chunks[idx].index == index) {
+			spill->last_chunk = idx;
+			spill->chunks[idx].last_used = ++spill->clock;
+			return spill->chunks[idx].data + offset;
+		}
+		if (spill->chunks[idx].last_used < spill->chunks[victim].last_used) {
+			victim = idx;
+		}
+	}
+
+	if (spill->n_chunks < spill->max_chunks) {
+		victim = spill->n_chunks++;
+	}
+	else {
+		munmap (spill->chunks[victim].data, GSEARCH_RESULTS_CHUNK_SIZE);
+	}
+
+	chunk = &spill->chunks[victim];
+	chunk->index = index;
+	chunk->last_used = ++spill->clock;
+	chunk->data = mmap (NULL, GSEARCH_RESULTS_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+	                    spill->fd, (off_t) index * GSEARCH_RESULTS_CHUNK_SIZE);
+	if (chunk->data == MAP_FAILED) {
+		if (spill->n_failures++ == 0) {
+			g_warning ("Could not map the search results file: %s", g_strerror (errno));
+		}
+		spill->chunks[victim] = spill->chunks[--spill->n_chunks];
+		spill->last_chunk = spill->n_chunks;
+		memset (failed_chunk, 0, sizeof (failed_chunk));
+		return failed_chunk + offset;
+	}
+	spill->last_chunk = victim;
+
+	return chunk->data + offset;
+}
+
+static guint32
+spill_get_uint32 (GSearchResultsSpill * spill,
+                  gsize index)
+{
+	return *(guint32 *) spill_lookup (spill, index * sizeof (guint32));
+}
+
+static void
+spill_set_uint32 (GSearchResultsSpill * spill,
+                  gsize index,
+                  guint32 value)
+{
+	*(guint32 *) spill_lookup (spill, index * sizeof (guint32)) = value;
+}
+
+static guint64
+spill_get_uint64 (GSearchResultsSpill * spill,
+                  gsize index)
+{
+	return *(guint64 *) spill_lookup (spill, index * sizeof (guint64));
+}
+
+static GSearchResultsSlot *
+spill_get_slot (GSearchResultsSpill * spill,
+                gsize index)
+{
+	return (GSearchResultsSlot *) spill_lookup (spill, index * sizeof (GSearchResultsSlot));
+}
+
+/* Moves @length bytes from @source down to @destination, a chunk at a
+   time when the segment is in a file. */
+static void
+spill_move_down (GSearchResultsSpill * spill,
+                 gsize destination,
+                 gsize source,
+                 gsize length)
+{
+	if (spill->fd == -1) {
+		memmove (spill->memory + destination, spill->memory + source, length);
+		return;
+	}
+
+	while (length > 0) {
+		gsize count;
+		guchar * from;
+		guchar * to;
+
+		count = MIN (length, GSEARCH_RESULTS_CHUNK_SIZE - source % GSEARCH_RESULTS_CHUNK_SIZE);
+		count = MIN (count, GSEARCH_RESULTS_CHUNK_SIZE - destination % GSEARCH_RESULTS_CHUNK_SIZE);
+
+		from = spill_lookup (spill, source);
+		to = spill_lookup (spill, destination);
+		memmove (to, from, count);
+
+		destination += count;
+		source += count;
+		length -= count;
+	}
+}
+
+static void results_spill (GSearchResults * results);
+
+/* Makes room for @length bytes in @spill, spilling the whole store when
+   it outgrows the memory budget. */
+static gboolean
+results_reserve (GSearchResults * results,
+                 GSearchResultsSpill * spill,
+                 gsize length)
+{
+	if (spill->fd != -1) {
+		return spill_grow_file (spill, length);
+	}
+
+	if (length > spill->allocated) {
+		gsize allocated = MAX (spill->allocated, 4096);
+
+		while (allocated < length) {
+			allocated *= 2;
+		}
+		spill->memory = g_realloc (spill->memory, allocated);
+		spill->allocated = allocated;
+
+		if (results->is_spilled == FALSE &&
+		    results->is_spill_failed == FALSE &&
+		    gsearchtool_results_get_memory_size (results) > results->memory_budget) {
+			results_spill (results);
+			if (spill->fd != -1) {
+				return spill_grow_file (spill, length);
+			}
+		}
+	}
+	return TRUE;
+}
+
+static void
+results_spill (GSearchResults * results)
+{
+	gboolean is_spilled = TRUE;
+
+	if (g_mkdir_with_parents (results->spill_folder, 0700) != 0) {
+		g_warning ("Could not create %s: %s", results->spill_folder, g_strerror (errno));
+		results->is_spill_failed = TRUE;
+		return;
+	}
+
+	is_spilled &= spill_to_file (&results->records, results->spill_folder,
+	                             get_chunk_limit (results, GSEARCH_RESULTS_SHARE_RECORDS));
+	is_spilled &= spill_to_file (&results->offsets, results->spill_folder,
+	                             get_chunk_limit (results, GSEARCH_RESULTS_SHARE_OFFSETS));
+	is_spilled &= spill_to_file (&results->order, results->spill_folder,
+	                             get_chunk_limit (results, GSEARCH_RESULTS_SHARE_ORDER));
+	is_spilled &= spill_to_file (&results->rows, results->spill_folder,
+	                             get_chunk_limit (results, GSEARCH_RESULTS_SHARE_ROWS));
+	is_spilled &= spill_to_file (&results->dedup, results->spill_folder,
+	                             get_chunk_limit (results, GSEARCH_RESULTS_SHARE_DEDUP));
+
+	/* Segments that could not be moved stay in memory and the budget is
+	   exceeded, but the results are kept. */
+	results->is_spilled = TRUE;
+	results->is_spill_failed = !is_spilled;
+}
+
+static guint
+get_failure_count (GSearchResults * results)
+{
+	return results->records.n_failures +
+	       results->offsets.n_failures +
+	       results->order.n_failures +
+	       results->rows.n_failures +
+	       results->dedup.n_failures;
+}
+
+static guint64
+get_path_hash (const gchar * path)
+{
+	guint64 hash = G_GUINT64_CONSTANT (14695981039346656037);
+
+	/* 64-bit FNV-1a, zero marks an empty slot. */
+	for (; *path != '\0'; path++) {
+		hash ^= (guchar) *path;
+		hash *= G_GUINT64_CONSTANT (1099511628211);
+	}
+	return (hash != 0) ? hash : 1;
+}
+
+static GSearchResultsHeader *
+get_record_header (GSearchResults * results,
+                   guint32 id)
+{
+	return (GSearchResultsHeader *) spill_lookup (&results->records, spill_get_uint64 (&results->offsets, id));
+}
+
+static void
+get_record (GSearchResults * results,
+            guint32 id,
+            GSearchResultsRecord * record)
+{
+	GSearchResultsHeader * header;
+
+	header = get_record_header (results, id);
+
+	record->id = id;
+	record->path = (const gchar *) (header + 1);
+	record->size = header->size;
+	record->mtime = header->mtime;
+	record->content_type = (header->content_type == GSEARCH_RESULTS_NO_CONTENT_TYPE) ? NULL :
+	                       g_ptr_array_index (results->content_types, header->content_type);
+}
+
+static void
+dedup_init (GSearchResults * results,
+            GSearchResultsSpill * spill,
+            guint n_slots)
+{
+	gsize length = (gsize) n_slots * sizeof (GSearchResultsSlot);
+
+	spill_init (spill);
+	if (results->is_spilled && results->is_spill_failed == FALSE) {
+		if (spill_to_file (spill, results->spill_folder,
+		                   get_chunk_limit (results, GSEARCH_RESULTS_SHARE_DEDUP)) == TRUE &&
+		    spill_grow_file (spill, length) == TRUE) {
+			spill->length = length;
+			return;
+		}
+		spill_clear (spill);
+	}
+	spill->memory = g_malloc0 (length);
+	spill->allocated = length;
+	spill->length = length;
+}
+
+static void
+dedup_insert (GSearchResultsSpill * spill,
+              guint n_slots,
+              guint64 hash,
+              guint32 id)
+{
+	guint idx = hash & (n_slots - 1);
+
+	while (TRUE) {
+		GSearchResultsSlot * slot = spill_get_slot (spill, idx);
+
+		if (slot->hash == 0) {
+			slot->hash = hash;
+			slot->id = id;
+			return;
+		}
+		idx = (idx + 1) & (n_slots - 1);
+	}
+}
+
+static void
+dedup_grow (GSearchResults * results)
+{
+	GSearchResultsSpill dedup;
+	guint n_slots = results->n_slots * 2;
+	guint idx;
+
+	dedup_init (results, &dedup, n_slots);
+
+	for (idx = 0; idx < results->n_slots; idx++) {
+		GSearchResultsSlot slot = *spill_get_slot (&results->dedup, idx);
+
+		if (slot.hash != 0) {
+			dedup_insert (&dedup, n_slots, slot.hash, slot.id);
+		}
+	}
+	dedup.n_failures += results->dedup.n_failures;
+	spill_clear (&results->dedup);
+	results->dedup = dedup;
+	results->n_slots = n_slots;
+}
+
+/* Returns the id of the record for @path, or -1.  A file removed and
+   added again has two records, the removed one is only returned when
+   @is_removed_found. */
+static gint64
+dedup_lookup (GSearchResults * results,
+              const gchar * path,
+              guint64 hash,
+              gboolean is_removed_found)
+{
+	guint idx = hash & (results->n_slots - 1);
+
+	while (TRUE) {
+		GSearchResultsSlot slot = *spill_get_slot (&results->dedup, idx);
+
+		if (slot.hash == 0) {
+			return -1;
+		}
+		if (slot.hash == hash) {
+			GSearchResultsHeader * header = get_record_header (results, slot.id);
+
+			/* Hashes only narrow the search, the paths decide. */
+			if (strcmp ((const gchar *) (header + 1), path) == 0 &&
+			    (is_removed_found || (header->flags & GSEARCH_RESULTS_RECORD_REMOVED) == 0)) {
+				return slot.id;
+			}
+		}
+		idx = (idx + 1) & (results->n_slots - 1);
+	}
+}
+
+static const gchar *
+get_basename (const gchar * path)
+{
+	const gchar * separator = strrchr (path, G_DIR_SEPARATOR);
+
+	return (separator != NULL) ? separator + 1 : path;
+}
+
+/* ASCII case insensitive first, byte values break the ties. */
+static gint
+compare_names (const gchar * name_a,
+               const gchar * name_b)
+{
+	const guchar * a = (const guchar *) name_a;
+	const guchar * b = (const guchar *) name_b;
+
+	for (; *a != '\0' && g_ascii_tolower (*a) == g_ascii_tolower (*b); a++, b++);
+
+	if (*a != '\0' || *b != '\0') {
+		return (g_ascii_tolower (*a) < g_ascii_tolower (*b)) ? -1 : 1;
+	}
+	return strcmp (name_a, name_b);
+}
+
+static gint
+compare_content_types (const gchar ** a,
+                       const gchar ** b)
+{
+	return strcmp (*a, *b);
+}
+
+static gint
+compare_folders (const gchar * path_a,
+                 const gchar * path_b)
+{
+	gsize length_a = get_basename (path_a) - path_a;
+	gsize length_b = get_basename (path_b) - path_b;
+	gint result;
+
+	result = strncmp (path_a, path_b, MIN (length_a, length_b));
+	if (result == 0) {
+		result = (length_a < length_b) ? -1 : (length_a > length_b);
+	}
+	return result;
+}
+
+static gint
+compare_records (GSearchResults * results,
+                 guint32 id_a,
+                 guint32 id_b)
+{
+	GSearchResultsRecord a;
+	GSearchResultsRecord b;
+	gint result = 0;
+
+	get_record (results, id_a, &a);
+	get_record (results, id_b, &b);
+
+	switch (results->sort_column) {
+	case GSEARCH_RESULTS_SORT_NAME:
+		result = compare_names (get_basename (a.path), get_basename (b.path));
+		break;
+	case GSEARCH_RESULTS_SORT_FOLDER:
+		result = compare_folders (a.path, b.path);
+		break;
+	case GSEARCH_RESULTS_SORT_SIZE:
+		result = (a.size < b.size) ? -1 : (a.size > b.size);
+		break;
+	case GSEARCH_RESULTS_SORT_TYPE:
+		result = g_strcmp0 (a.content_type, b.content_type);
+		break;
+	case GSEARCH_RESULTS_SORT_DATE:
+		result = (a.mtime < b.mtime) ? -1 : (a.mtime > b.mtime);
+		break;
+	default:
+		break;
+	}
+
+	if (results->sort_descending) {
+		result = -result;
+	}
+	/* Equal rows keep the order they were found in. */
+	if (result == 0) {
+		result = (id_a < id_b) ? -1 : (id_a > id_b);
+	}
+	return result;
+}
+
+GSearchResults *
+gsearchtool_results_new (gsize memory_budget,
+                         const gchar * spill_folder)
+{
+	GSearchResults * results;
+
+	results = g_slice_new0 (GSearchResults);
+	results->memory_budget = memory_budget;
+	results->spill_folder = g_strdup (spill_folder);
+	results->content_types = g_ptr_array_new_with_free_func (g_free);
+	results->content_type_hash_table = g_hash_table_new (g_str_hash, g_str_equal);
+
+	spill_init (&results->records);
+	spill_init (&results->offsets);
+	spill_init (&results->order);
+	spill_init (&results->rows);
+	spill_init (&results->dedup);
+	gsearchtool_results_clear (results);
+
+	return results;
+}
+
+void
+gsearchtool_results_free (GSearchResults * results)
+{
+	if (results == NULL) {
+		return;
+	}
+	spill_clear (&results->records);
+	spill_clear (&results->offsets);
+	spill_clear (&results->order);
+	spill_clear (&results->rows);
+	spill_clear (&results->dedup);
+	g_hash_table_destroy (results->content_type_hash_table);
+	g_ptr_array_free (results->content_types, TRUE);
+	g_free (results->spill_folder);
+	g_free (results->first_path);
+	g_slice_free (GSearchResults, results);
+}
+
+void
+gsearchtool_results_clear (GSearchResults * results)
+{
+	spill_clear (&results->records);
+	spill_clear (&results->offsets);
+	spill_clear (&results->order);
+	spill_clear (&results->rows);
+	spill_clear (&results->dedup);
+
+	g_hash_table_remove_all (results->content_type_hash_table);
+	g_ptr_array_set_size (results->content_types, 0);
+
+	results->is_spilled = FALSE;
+	results->is_spill_failed = FALSE;
+	results->n_records = 0;
+	results->n_rows = 0;
+	results->n_slots = GSEARCH_RESULTS_DEDUP_INITIAL_SLOTS;
+	results->n_used_slots = 0;
+	results->is_sorted = TRUE;
+	g_free (results->first_path);
+	results->first_path = NULL;
+	results->common_prefix_length = 0;
+	dedup_init (results, &results->dedup, results->n_slots);
+}
+
+void
+gsearchtool_results_set_memory_budget (GSearchResults * results,
+                                       gsize memory_budget)
+{
+	results->memory_budget = memory_budget;
+}
+
+gboolean
+gsearchtool_results_contains (GSearchResults * results,
+                              const gchar * path)
+{
+	return dedup_lookup (results, path, get_path_hash (path), TRUE) != -1;
+}
+
+static guint32
+get_content_type_index (GSearchResults * results,
+                        const gchar * content_type)
+{
+	gpointer index;
+
+	if (content_type == NULL) {
+		return GSEARCH_RESULTS_NO_CONTENT_TYPE;
+	}
+
+	/* There are only a few hundred content types, they stay in memory. */
+	if (g_hash_table_lookup_extended (results->content_type_hash_table, content_type, NULL, &index) == FALSE) {
+		gchar * copy = g_strdup (content_type);
+
+		index = GUINT_TO_POINTER (results->content_types->len);
+		g_ptr_array_add (results->content_types, copy);
+		g_hash_table_insert (results->content_type_hash_table, copy, index);
+	}
+	return GPOINTER_TO_UINT (index);
+}
+
+/* Points the records shown in rows @first to @last, excluded, back at
+   their row once rows moved. */
+static void
+set_rows (GSearchResults * results,
+          guint first,
+          guint last)
+{
+	guint row;
+
+	for (row = first; row < last; row++) {
+		spill_set_uint32 (&results->rows, spill_get_uint32 (&results->order, row), row);
+	}
+}
+
+/* Returns the first row that sorts after @id. */
+static guint
+find_sorted_position (GSearchResults * results,
+                      guint32 id)
+{
+	guint low = 0;
+	guint high = results->n_rows;
+
+	while (low < high) {
+		guint middle = low + (high - low) / 2;
+
+		if (compare_records (results, spill_get_uint32 (&results->order, middle), id) <= 0) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/* Adds a result that is not in the store yet and returns its row, or -1
+   when the store could not grow.  Once it could not, the store takes no
+   more results until it is cleared. */
+gint
+gsearchtool_results_append (GSearchResults * results,
+                            const gchar * path,
+                            const gchar * content_type,
+                            gint64 size,
+                            gint64 mtime)
+{
+	GSearchResultsHeader header;
+	gsize path_length;
+	gsize record_size;
+	gsize offset;
+	guint n_failures;
+	guint row;
+	guint32 id;
+
+	path_length = strlen (path);
+	g_return_val_if_fail (path_length <= G_MAXUINT16, -1);
+
+	n_failures = get_failure_count (results);
+	if (n_failures > 0) {
+		return -1;
+	}
+
+	record_size = sizeof (GSearchResultsHeader) + path_length + 1;
+	record_size = (record_size + 7) & ~((gsize) 7);
+
+	offset = results->records.length;
+	if (offset / GSEARCH_RESULTS_CHUNK_SIZE != (offset + record_size - 1) / GSEARCH_RESULTS_CHUNK_SIZE) {
+		offset = (offset / GSEARCH_RESULTS_CHUNK_SIZE + 1) * GSEARCH_RESULTS_CHUNK_SIZE;
+	}
+
+	if (results_reserve (results, &results->records, offset + record_size) == FALSE ||
+	    results_reserve (results, &results->offsets, (results->n_records + 1) * sizeof (guint64)) == FALSE ||
+	    results_reserve (results, &results->order, (results->n_rows + 1) * sizeof (guint32)) == FALSE ||
+	    results_reserve (results, &results->rows, (results->n_records + 1) * sizeof (guint32)) == FALSE) {
+		return -1;
+	}
+
+	/* Map the places the new record goes to before anything changes. */
+	spill_lookup (&results->records, offset);
+	spill_lookup (&results->offsets, results->n_records * sizeof (guint64));
+	spill_lookup (&results->order, results->n_rows * sizeof (guint32));
+	spill_lookup (&results->rows, results->n_records * sizeof (guint32));
+	if (get_failure_count (results) != n_failures) {
+		return -1;
+	}
+
+	if ((results->n_used_slots + 1) * 2 > results->n_slots) {
+		dedup_grow (results);
+	}
+
+	id = results->n_records++;
+	results->records.length = offset + record_size;
+	results->offsets.length = results->n_records * sizeof (guint64);
+	results->order.length = (results->n_rows + 1) * sizeof (guint32);
+	results->rows.length = results->n_records * sizeof (guint32);
+
+	header.size = size;
+	header.mtime = mtime;
+	header.content_type = get_content_type_index (results, content_type);
+	header.path_length = path_length;
+	header.flags = 0;
+	memcpy (spill_lookup (&results->records, offset), &header, sizeof (GSearchResultsHeader));
+	memcpy (spill_lookup (&results->records, offset) + sizeof (GSearchResultsHeader), path, path_length + 1);
+	*(guint64 *) spill_lookup (&results->offsets, id * sizeof (guint64)) = offset;
+
+	dedup_insert (&results->dedup, results->n_slots, get_path_hash (path), id);
+	results->n_used_slots++;
+
+	if (results->first_path == NULL) {
+		results->first_path = g_strdup (path);
+		results->common_prefix_length = path_length;
+	}
+	else {
+		gsize idx;
+
+		for (idx = 0; idx < results->common_prefix_length && path[idx] == results->first_path[idx]; idx++);
+		results->common_prefix_length = idx;
+	}
+
+	row = results->n_rows;
+	if (results->sort_column != GSEARCH_RESULTS_SORT_NONE) {
+		if (results->is_sorted &&
+		    results->order.fd == -1 &&
+		    results->n_rows < GSEARCH_RESULTS_SORTED_INSERT_LIMIT) {
+			row = find_sorted_position (results, id);
+			memmove (results->order.memory + (row + 1) * sizeof (guint32),
+			         results->order.memory + row * sizeof (guint32),
+			         (results->n_rows - row) * sizeof (guint32));
+			set_rows (results, row + 1, results->n_rows + 1);
+		}
+		else {
+			results->is_sorted = FALSE;
+		}
+	}
+	spill_set_uint32 (&results->order, row, id);
+	spill_set_uint32 (&results->rows, id, row);
+	results->n_rows++;
+
+	return row;
+}
+
+guint
+gsearchtool_results_get_length (GSearchResults * results)
+{
+	return results->n_rows;
+}
+
+/* Returns FALSE for a row the store cannot read back. */
+gboolean
+gsearchtool_results_get (GSearchResults * results,
+                         guint row,
+                         GSearchResultsRecord * record)
+{
+	guint n_failures = get_failure_count (results);
+
+	if (row >= results->n_rows) {
+		return FALSE;
+	}
+	get_record (results, spill_get_uint32 (&results->order, row), record);
+	return get_failure_count (results) == n_failures;
+}
+
+/* Returns the row of @path, or -1. */
+gint
+gsearchtool_results_find (GSearchResults * results,
+                          const gchar * path)
+{
+	gint64 id;
+	guint32 row;
+
+	id = dedup_lookup (results, path, get_path_hash (path), FALSE);
+	if (id == -1) {
+		return -1;
+	}
+	row = spill_get_uint32 (&results->rows, id);
+	return (row != GSEARCH_RESULTS_NO_ROW) ? (gint) row : -1;
+}
+
+/* Changes the size, date and type of the result in @row, for a file
+   that changed.  The store has to be sorted again when it is sorted by
+   one of them. */
+void
+gsearchtool_results_update (GSearchResults * results,
+                            guint row,
+                            const gchar * content_type,
+                            gint64 size,
+                            gint64 mtime)
+{
+	GSearchResultsHeader * header;
+	guint32 content_type_index;
+
+	g_return_if_fail (row < results->n_rows);
+
+	content_type_index = get_content_type_index (results, content_type);
+	header = get_record_header (results, spill_get_uint32 (&results->order, row));
+	header->size = size;
+	header->mtime = mtime;
+	header->content_type = content_type_index;
+
+	if (results->sort_column == GSEARCH_RESULTS_SORT_SIZE ||
+	    results->sort_column == GSEARCH_RESULTS_SORT_TYPE ||
+	    results->sort_column == GSEARCH_RESULTS_SORT_DATE) {
+		results->is_sorted = (results->n_rows < 2);
+	}
+}
+
+void
+gsearchtool_results_remove (GSearchResults * results,
+                            guint row)
+{
+	guint32 id;
+
+	g_return_if_fail (row < results->n_rows);
+
+	/* The record and its hash stay, so a removed file that shows up
+	   again in the second pass is still dropped. */
+	id = spill_get_uint32 (&results->order, row);
+	get_record_header (results, id)->flags |= GSEARCH_RESULTS_RECORD_REMOVED;
+	spill_set_uint32 (&results->rows, id, GSEARCH_RESULTS_NO_ROW);
+
+	spill_move_down (&results->order, row * sizeof (guint32), (row + 1) * sizeof (guint32),
+	                 (results->n_rows - row - 1) * sizeof (guint32));
+	results->n_rows--;
+	results->order.length = results->n_rows * sizeof (guint32);
+	set_rows (results, row, results->n_rows);
+}
+
+/* Removes the rows @keep_func does not keep in a single pass over the
+   order, the rows kept stay in the same order.  Returns the rows that
+   were removed, as guint in increasing order. */
+GArray *
+gsearchtool_results_filter (GSearchResults * results,
+                            GSearchResultsKeepFunc keep_func,
+                            gpointer data)
+{
+	GArray * removed;
+	guint length = 0;
+	guint row;
+
+	removed = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	for (row = 0; row < results->n_rows; row++) {
+		GSearchResultsRecord record;
+		guint32 id = spill_get_uint32 (&results->order, row);
+
+		get_record (results, id, &record);
+		if (keep_func (&record, data) == TRUE) {
+			spill_set_uint32 (&results->order, length, id);
+			spill_set_uint32 (&results->rows, id, length);
+			length++;
+		}
+		else {
+			get_record_header (results, id)->flags |= GSEARCH_RESULTS_RECORD_REMOVED;
+			spill_set_uint32 (&results->rows, id, GSEARCH_RESULTS_NO_ROW);
+			g_array_append_val (removed, row);
+		}
+	}
+	results->n_rows = length;
+	results->order.length = length * sizeof (guint32);
+
+	return removed;
+}
+
+void
+gsearchtool_results_set_sort (GSearchResults * results,
+                              GSearchResultsSortColumn column,
+                              gboolean descending)
+{
+	if (results->sort_column != column || results->sort_descending != descending) {
+		results->sort_column = column;
+		results->sort_descending = descending;
+		results->is_sorted = (results->n_rows < 2);
+	}
+}
+
+gboolean
+gsearchtool_results_is_sorted (GSearchResults * results)
+{
+	return results->is_sorted;
+}
+
+static gint
+compare_entries (GSearchResults * results,
+                 const GSearchResultsEntry * a,
+                 const GSearchResultsEntry * b)
+{
+	if (a->key != b->key) {
+		return (a->key < b->key) ? -1 : 1;
+	}
+	if (results->is_sort_key_exact) {
+		return (a->id < b->id) ? -1 : (a->id > b->id);
+	}
+	return compare_records (results, a->id, b->id);
+}
+
+static gint
+compare_entries_with_data (gconstpointer a,
+                           gconstpointer b,
+                           gpointer data)
+{
+	return compare_entries (data, a, b);
+}
+
+/* Packs the first bytes of @string in a key that sorts like it. */
+static guint64
+get_string_key (const gchar * string,
+                gsize length,
+                gboolean is_casefold)
+{
+	guint64 key = 0;
+	gsize idx;
+
+	for (idx = 0; idx < sizeof (guint64); idx++) {
+		guchar c = (idx < length) ? string[idx] : 0;
+
+		key = (key << 8) | (is_casefold ? g_ascii_tolower (c) : c);
+	}
+	return key;
+}
+
+static guint32 *
+get_content_type_ranks (GSearchResults * results)
+{
+	GPtrArray * sorted;
+	guint32 * ranks;
+	guint idx;
+
+	sorted = g_ptr_array_sized_new (results->content_types->len);
+	for (idx = 0; idx < results->content_types->len; idx++) {
+		g_ptr_array_add (sorted, g_ptr_array_index (results->content_types, idx));
+	}
+	g_ptr_array_sort (sorted, (GCompareFunc) compare_content_types);
+
+	ranks = g_new (guint32, results->content_types->len);
+	for (idx = 0; idx < sorted->len; idx++) {
+		gpointer index;
+
+		g_hash_table_lookup_extended (results->content_type_hash_table,
+		                              g_ptr_array_index (sorted, idx), NULL, &index);
+		ranks[GPOINTER_TO_UINT (index)] = idx + 1;
+	}
+	g_ptr_array_free (sorted, TRUE);
+
+	return ranks;
+}
+
+/* Sort keys only need the record, so comparisons rarely touch the
+   records again, which matters once they are on disk.  Strings are
+   keyed on their first eight bytes and fall back to the records when
+   those are equal. */
+static void
+get_sort_entry (GSearchResults * results,
+                guint32 id,
+                guint32 * content_type_ranks,
+                GSearchResultsEntry * entry)
+{
+	GSearchResultsHeader * header = get_record_header (results, id);
+	const gchar * path = (const gchar *) (header + 1);
+	const gchar * name;
+	guint64 key = 0;
+
+	switch (results->sort_column) {
+	case GSEARCH_RESULTS_SORT_NAME:
+		name = get_basename (path);
+		key = get_string_key (name, header->path_length - (name - path), TRUE);
+		break;
+	case GSEARCH_RESULTS_SORT_FOLDER:
+		/* All the results share the folder that was searched. */
+		name = get_basename (path);
+		key = get_string_key (path + MIN (results->common_prefix_length, name - path),
+		                      name - path - MIN (results->common_prefix_length, name - path), FALSE);
+		break;
+	case GSEARCH_RESULTS_SORT_SIZE:
+		key = (guint64) header->size ^ G_GUINT64_CONSTANT (0x8000000000000000);
+		break;
+	case GSEARCH_RESULTS_SORT_TYPE:
+		key = (header->content_type == GSEARCH_RESULTS_NO_CONTENT_TYPE) ? 0 :
+		      content_type_ranks[header->content_type];
+		break;
+	case GSEARCH_RESULTS_SORT_DATE:
+		key = (guint64) header->mtime ^ G_GUINT64_CONSTANT (0x8000000000000000);
+		break;
+	default:
+		key = id;
+		break;
+	}
+
+	entry->key = results->sort_descending ? ~key : key;
+	entry->id = id;
+}
+
+static void
+sift_down_cursor (GSearchResults * results,
+                  GSearchResultsCursor * cursors,
+                  guint n_cursors,
+                  guint idx)
+{
+	while (TRUE) {
+		GSearchResultsCursor cursor;
+		guint smallest = idx;
+		guint left = idx * 2 + 1;
+		guint right = left + 1;
+
+		if (left < n_cursors && compare_entries (results, &cursors[left].entry, &cursors[smallest].entry) < 0) {
+			smallest = left;
+		}
+		if (right < n_cursors && compare_entries (results, &cursors[right].entry, &cursors[smallest].entry) < 0) {
+			smallest = right;
+		}
+		if (smallest == idx) {
+			return;
+		}
+		cursor = cursors[idx];
+		cursors[idx] = cursors[smallest];
+		cursors[smallest] = cursor;
+		idx = smallest;
+	}
+}
+
+/* Sorts the rows in runs that fit in the sort share of the budget and
+   merges the runs into the order segment.  A store that has not spilled
+   is sorted in a single run. */
+static gboolean
+sort_order (GSearchResults * results)
+{
+	GSearchResultsSpill runs;
+	GSearchResultsCursor * cursors;
+	GSearchResultsEntry * buffer;
+	guint32 * content_type_ranks;
+	gsize run_length;
+	guint n_cursors = 0;
+	guint n_runs;
+	gsize length = 0;
+	gsize row = 0;
+	guint32 id;
+
+	run_length = results->n_rows;
+	if (results->is_spilled) {
+		run_length = MAX (results->memory_budget / 8 / sizeof (GSearchResultsEntry), 1024);
+	}
+	n_runs = (results->n_rows + run_length - 1) / run_length;
+
+	spill_init (&runs);
+	if (n_runs > 1 &&
+	    (spill_to_file (&runs, results->spill_folder,
+	                    MAX (n_runs, get_chunk_limit (results, GSEARCH_RESULTS_SHARE_SORT))) == FALSE ||
+	     spill_grow_file (&runs, (gsize) results->n_rows * sizeof (GSearchResultsEntry)) == FALSE)) {
+		spill_clear (&runs);
+		return FALSE;
+	}
+
+	content_type_ranks = get_content_type_ranks (results);
+	buffer = g_new (GSearchResultsEntry, MIN (run_length, results->n_rows));
+	cursors = g_new (GSearchResultsCursor, n_runs);
+
+	/* Walk the records in the order they were stored, removed ones are
+	   skipped. */
+	for (id = 0; id < results->n_records; id++) {
+		if (get_record_header (results, id)->flags & GSEARCH_RESULTS_RECORD_REMOVED) {
+			continue;
+		}
+		get_sort_entry (results, id, content_type_ranks, &buffer[length++]);
+
+		if (length == run_length || row + length == results->n_rows) {
+			gsize idx;
+
+			g_qsort_with_data (buffer, length, sizeof (GSearchResultsEntry),
+			                   compare_entries_with_data, results);
+
+			if (n_runs == 1) {
+				for (idx = 0; idx < length; idx++) {
+					spill_set_uint32 (&results->order, idx, buffer[idx].id);
+				}
+				break;
+			}
+			for (idx = 0; idx < length; idx++) {
+				*(GSearchResultsEntry *) spill_lookup (&runs, (row + idx) * sizeof (GSearchResultsEntry)) = buffer[idx];
+			}
+			cursors[n_cursors].entry = buffer[0];
+			cursors[n_cursors].position = row;
+			cursors[n_cursors].end = row + length;
+			n_cursors++;
+
+			row += length;
+			length = 0;
+		}
+	}
+	g_free (buffer);
+	g_free (content_type_ranks);
+
+	if (n_runs > 1) {
+		for (row = n_cursors / 2; row-- > 0; ) {
+			sift_down_cursor (results, cursors, n_cursors, row);
+		}
+
+		for (row = 0; row < results->n_rows; row++) {
+			spill_set_uint32 (&results->order, row, cursors[0].entry.id);
+
+			if (++cursors[0].position < cursors[0].end) {
+				cursors[0].entry = *(GSearchResultsEntry *) spill_lookup (&runs, cursors[0].position * sizeof (GSearchResultsEntry));
+			}
+			else {
+				cursors[0] = cursors[--n_cursors];
+			}
+			sift_down_cursor (results, cursors, n_cursors, 0);
+		}
+	}
+
+	/* An order merged from runs that could not be read back is wrong. */
+	results->order.n_failures += runs.n_failures;
+
+	g_free (cursors);
+	spill_clear (&runs);
+
+	return TRUE;
+}
+
+/* Sorts the whole store by the sort column.  Returns the old row of each
+   new row, as gtk_tree_model_rows_reordered() wants it, or NULL when
+   nothing moved.  The old rows are still in the rows segment when the
+   order has been sorted, so that array is the only one that takes
+   memory for each row. */
+gint *
+gsearchtool_results_sort (GSearchResults * results)
+{
+	gint * new_order;
+	guint n_failures;
+	guint row;
+
+	if (results->is_sorted || results->n_rows < 2) {
+		results->is_sorted = TRUE;
+		return NULL;
+	}
+
+	n_failures = get_failure_count (results);
+	results->is_sort_key_exact = (results->sort_column != GSEARCH_RESULTS_SORT_NAME &&
+	                              results->sort_column != GSEARCH_RESULTS_SORT_FOLDER);
+	if (sort_order (results) == FALSE) {
+		return NULL;
+	}
+
+	new_order = g_new (gint, results->n_rows);
+	for (row = 0; row < results->n_rows; row++) {
+		guint32 id = spill_get_uint32 (&results->order, row);
+
+		new_order[row] = spill_get_uint32 (&results->rows, id);
+		spill_set_uint32 (&results->rows, id, row);
+	}
+
+	results->is_sorted = TRUE;
+
+	if (get_failure_count (results) != n_failures) {
+		g_free (new_order);
+		return NULL;
+	}
+	return new_order;
+}
+
+gboolean
+gsearchtool_results_is_spilled (GSearchResults * results)
+{
+	return results->is_spilled;
+}
+
+gsize
+gsearchtool_results_get_memory_size (GSearchResults * results)
+{
+	return spill_get_memory_size (&results->records) +
+	       spill_get_memory_size (&results->offsets) +
+	       spill_get_memory_size (&results->order) +
+	       spill_get_memory_size (&results->rows) +
+	       spill_get_memory_size (&results->dedup);
+}
@@ -0,0 +1,127 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-results.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_RESULTS_H_
+#define _GSEARCHTOOL_RESULTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+#define GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET (64 * 1024 * 1024)
+
+typedef enum {
+	GSEARCH_RESULTS_SORT_NONE,
+	GSEARCH_RESULTS_SORT_NAME,
+	GSEARCH_RESULTS_SORT_FOLDER,
+	GSEARCH_RESULTS_SORT_SIZE,
+	GSEARCH_RESULTS_SORT_TYPE,
+	GSEARCH_RESULTS_SORT_DATE
+} GSearchResultsSortColumn;
+
+typedef struct _GSearchResults GSearchResults;
+typedef struct _GSearchResultsRecord GSearchResultsRecord;
+
+/* A record is a view into the store.  The path and content type stay
+   valid until the store is changed or two more records are looked up. */
+struct _GSearchResultsRecord {
+	guint                   id;
+	const gchar           * path;
+	const gchar           * content_type;
+	gint64                  size;
+	gint64                  mtime;
+};
+
+/* Returns TRUE for a result that is to stay in the store. */
+typedef gboolean (* GSearchResultsKeepFunc) (const GSearchResultsRecord * record,
+                                             gpointer data);
+
+GSearchResults *
+gsearchtool_results_new (gsize memory_budget,
+                         const gchar * spill_folder);
+void
+gsearchtool_results_free (GSearchResults * results);
+
+void
+gsearchtool_results_clear (GSearchResults * results);
+
+void
+gsearchtool_results_set_memory_budget (GSearchResults * results,
+                                       gsize memory_budget);
+gboolean
+gsearchtool_results_contains (GSearchResults * results,
+                              const gchar * path);
+gint
+gsearchtool_results_append (GSearchResults * results,
+                            const gchar * path,
+                            const gchar * content_type,
+                            gint64 size,
+                            gint64 mtime);
+guint
+gsearchtool_results_get_length (GSearchResults * results);
+
+gboolean
+gsearchtool_results_get (GSearchResults * results,
+                         guint row,
+                         GSearchResultsRecord * record);
+gint
+gsearchtool_results_find (GSearchResults * results,
+                          const gchar * path);
+void
+gsearchtool_results_update (GSearchResults * results,
+                            guint row,
+                            const gchar * content_type,
+                            gint64 size,
+                            gint64 mtime);
+void
+gsearchtool_results_remove (GSearchResults * results,
+                            guint row);
+GArray *
+gsearchtool_results_filter (GSearchResults * results,
+                            GSearchResultsKeepFunc keep_func,
+                            gpointer data);
+void
+gsearchtool_results_set_sort (GSearchResults * results,
+                              GSearchResultsSortColumn column,
+                              gboolean descending);
+gboolean
+gsearchtool_results_is_sorted (GSearchResults * results);
+
+gint *
+gsearchtool_results_sort (GSearchResults * results);
+
+gboolean
+gsearchtool_results_is_spilled (GSearchResults * results);
+
+gsize
+gsearchtool_results_get_memory_size (GSearchResults * results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_RESULTS_H_ */
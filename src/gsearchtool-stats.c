@@ -0,0 +1,506 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-stats.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <glib/gi18n.h>
+#include <glib.h>
+
+#include "gsearchtool-stats.h"
+
+#define GSEARCH_STATS_LOG_DIRECTORY "gnome-search-tool"
+#define GSEARCH_STATS_LOG_FILENAME  "search-statistics.log"
+#define GSEARCH_STATS_UNKNOWN_VALUE "\342\200\224"   /* em dash */
+
+static const gchar * GSearchStatsCounterNames[GSEARCH_STATS_NUM_COUNTERS] = {
+	"directories_visited",
+	"entries_examined",
+	"stat_calls",
+	"bytes_read",
+	"matches",
+	"dedup_dropped"
+};
+
+static const gchar * GSearchStatsPhaseNames[GSEARCH_STATS_NUM_PHASES] = {
+	"probe",
+	"first_pass",
+	"second_pass",
+	"metadata",
+	"ui_insertion",
+	"duplicates"
+};
+
+GSearchStats *
+gsearchtool_stats_new (void)
+{
+	GSearchStats * stats;
+
+	stats = g_slice_new0 (GSearchStats);
+	gsearchtool_stats_reset (stats);
+
+	return stats;
+}
+
+void
+gsearchtool_stats_free (GSearchStats * stats)
+{
+	if (stats == NULL) {
+		return;
+	}
+	g_free (stats->name_pattern);
+	g_free (stats->look_in_folder);
+	g_free (stats->first_pass_engine);
+	g_free (stats->plan);
+	g_slice_free (GSearchStats, stats);
+}
+
+void
+gsearchtool_stats_reset (GSearchStats * stats)
+{
+	gint idx;
+
+	g_return_if_fail (stats != NULL);
+
+	g_free (stats->name_pattern);
+	g_free (stats->look_in_folder);
+	g_free (stats->first_pass_engine);
+	g_free (stats->plan);
+
+	stats->name_pattern = NULL;
+	stats->look_in_folder = NULL;
+	stats->first_pass_engine = NULL;
+	stats->plan = NULL;
+	stats->plan_estimated_time = GSEARCH_STATS_UNKNOWN;
+	stats->start_time = g_get_monotonic_time ();
+	stats->wall_time = 0;
+	stats->first_result_time = GSEARCH_STATS_UNKNOWN;
+	stats->peak_rss = 0;
+	stats->peak_rss_children = 0;
+	stats->is_stopped = FALSE;
+
+	for (idx = 0; idx < GSEARCH_STATS_NUM_PHASES; idx++) {
+		stats->phase_start[idx] = 0;
+		stats->phase_time[idx] = 0;
+	}
+	for (idx = 0; idx < GSEARCH_STATS_NUM_COUNTERS; idx++) {
+		stats->counters[idx] = 0;
+	}
+}
+
+void
+gsearchtool_stats_set_query (GSearchStats * stats,
+                             const gchar * name_pattern,
+                             const gchar * look_in_folder,
+                             const gchar * first_pass_engine)
+{
+	g_return_if_fail (stats != NULL);
+
+	g_free (stats->name_pattern);
+	g_free (stats->look_in_folder);
+	g_free (stats->first_pass_engine);
+
+	stats->name_pattern = g_strdup (name_pattern);
+	stats->look_in_folder = g_strdup (look_in_folder);
+	stats->first_pass_engine = g_strdup (first_pass_engine);
+}
+
+/* The plan the first pass runs, as explained by gsearchtool-planner.c,
+   and its estimated time, to be compared with the time it takes. */
+void
+gsearchtool_stats_set_plan (GSearchStats * stats,
+                            const gchar * plan,
+                            gint64 estimated_time)
+{
+	g_return_if_fail (stats != NULL);
+
+	g_free (stats->plan);
+	stats->plan = g_strdup (plan);
+	stats->plan_estimated_time = estimated_time;
+}
+
+void
+gsearchtool_stats_add (GSearchStats * stats,
+                       GSearchStatsCounter counter,
+                       gint64 value)
+{
+	g_return_if_fail (counter < GSEARCH_STATS_NUM_COUNTERS);
+
+	if (stats->counters[counter] == GSEARCH_STATS_UNKNOWN) {
+		stats->counters[counter] = 0;
+	}
+	stats->counters[counter] += value;
+}
+
+/* Mark a counter the running search engine cannot measure, for example
+   the directories visited by find(1). */
+void
+gsearchtool_stats_set_unknown (GSearchStats * stats,
+                               GSearchStatsCounter counter)
+{
+	g_return_if_fail (counter < GSEARCH_STATS_NUM_COUNTERS);
+
+	stats->counters[counter] = GSEARCH_STATS_UNKNOWN;
+}
+
+/* Phases accumulate, the metadata and UI insertion phases are entered once
+   per result while a pass is running. */
+void
+gsearchtool_stats_phase_begin (GSearchStats * stats,
+                               GSearchStatsPhase phase)
+{
+	g_return_if_fail (phase < GSEARCH_STATS_NUM_PHASES);
+
+	stats->phase_start[phase] = g_get_monotonic_time ();
+}
+
+void
+gsearchtool_stats_phase_end (GSearchStats * stats,
+                             GSearchStatsPhase phase)
+{
+	g_return_if_fail (phase < GSEARCH_STATS_NUM_PHASES);
+
+	if (stats->phase_start[phase] == 0) {
+		return;
+	}
+	stats->phase_time[phase] += g_get_monotonic_time () - stats->phase_start[phase];
+	stats->phase_start[phase] = 0;
+}
+
+void
+gsearchtool_stats_first_result (GSearchStats * stats)
+{
+	if (stats->first_result_time == GSEARCH_STATS_UNKNOWN) {
+		stats->first_result_time = g_get_monotonic_time () - stats->start_time;
+	}
+}
+
+void
+gsearchtool_stats_finish (GSearchStats * stats,
+                          gboolean stopped)
+{
+	struct rusage usage;
+	gint idx;
+
+	g_return_if_fail (stats != NULL);
+
+	for (idx = 0; idx < GSEARCH_STATS_NUM_PHASES; idx++) {
+		gsearchtool_stats_phase_end (stats, idx);
+	}
+	stats->wall_time = g_get_monotonic_time () - stats->start_time;
+	stats->is_stopped = stopped;
+
+	/* ru_maxrss is in kilobytes.  The children figure only covers the
+	   commands that were already reaped when the search finished. */
+	if (getrusage (RUSAGE_SELF, &usage) == 0) {
+		stats->peak_rss = usage.ru_maxrss;
+	}
+	if (getrusage (RUSAGE_CHILDREN, &usage) == 0) {
+		stats->peak_rss_children = usage.ru_maxrss;
+	}
+}
+
+static void
+json_append_string (GString * json,
+                    const gchar * string)
+{
+	const gchar * p;
+
+	if (string == NULL) {
+		g_string_append (json, "null");
+		return;
+	}
+
+	g_string_append_c (json, '"');
+	for (p = string; *p != '\0'; p++) {
+		switch (*p) {
+		case '"':
+			g_string_append (json, "\\\"");
+			break;
+		case '\\':
+			g_string_append (json, "\\\\");
+			break;
+		case '\n':
+			g_string_append (json, "\\n");
+			break;
+		case '\t':
+			g_string_append (json, "\\t");
+			break;
+		default:
+			if ((guchar) *p < 0x20) {
+				g_string_append_printf (json, "\\u%04x", (guint) *p);
+			}
+			else {
+				g_string_append_c (json, *p);
+			}
+			break;
+		}
+	}
+	g_string_append_c (json, '"');
+}
+
+static void
+json_append_seconds (GString * json,
+                     gint64 usec)
+{
+	gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+
+	if (usec == GSEARCH_STATS_UNKNOWN) {
+		g_string_append (json, "null");
+		return;
+	}
+	g_string_append (json, g_ascii_formatd (buffer, sizeof (buffer), "%.6f",
+	                                        (gdouble) usec / G_USEC_PER_SEC));
+}
+
+/* Returns a single line JSON object, unknown values are written as null. */
+gchar *
+gsearchtool_stats_to_json (GSearchStats * stats)
+{
+	GString * json;
+	gchar * folder = NULL;
+	gint idx;
+
+	g_return_val_if_fail (stats != NULL, NULL);
+
+	if (stats->look_in_folder != NULL) {
+		folder = g_filename_display_name (stats->look_in_folder);
+	}
+
+	json = g_string_new ("{");
+
+	g_string_append (json, "\"name\":");
+	json_append_string (json, stats->name_pattern);
+	g_string_append (json, ",\"folder\":");
+	json_append_string (json, folder);
+	g_string_append (json, ",\"first_pass_engine\":");
+	json_append_string (json, stats->first_pass_engine);
+	g_string_append_printf (json, ",\"stopped\":%s", stats->is_stopped ? "true" : "false");
+
+	for (idx = 0; idx < GSEARCH_STATS_NUM_COUNTERS; idx++) {
+		g_string_append_printf (json, ",\"%s\":", GSearchStatsCounterNames[idx]);
+		if (stats->counters[idx] == GSEARCH_STATS_UNKNOWN) {
+			g_string_append (json, "null");
+		}
+		else {
+			g_string_append_printf (json, "%" G_GINT64_FORMAT, stats->counters[idx]);
+		}
+	}
+
+	g_string_append (json, ",\"time_to_first_result\":");
+	json_append_seconds (json, stats->first_result_time);
+	g_string_append (json, ",\"wall_time\":");
+	json_append_seconds (json, stats->wall_time);
+	g_string_append (json, ",\"plan_estimated_time\":");
+	json_append_seconds (json, stats->plan_estimated_time);
+
+	g_string_append (json, ",\"phases\":{");
+	for (idx = 0; idx < GSEARCH_STATS_NUM_PHASES; idx++) {
+		g_string_append_printf (json, "%s\"%s\":", (idx > 0) ? "," : "", GSearchStatsPhaseNames[idx]);
+		json_append_seconds (json, stats->phase_time[idx]);
+	}
+	g_string_append_c (json, '}');
+
+	g_string_append_printf (json, ",\"peak_rss_kb\":%ld,\"peak_rss_children_kb\":%ld",
+	                        stats->peak_rss, stats->peak_rss_children);
+	g_string_append_c (json, '}');
+
+	g_free (folder);
+
+	return g_string_free (json, FALSE);
+}
+
+static gchar *
+format_counter (GSearchStats * stats,
+                GSearchStatsCounter counter)
+{
+	if (stats->counters[counter] == GSEARCH_STATS_UNKNOWN) {
+		return g_strdup (GSEARCH_STATS_UNKNOWN_VALUE);
+	}
+	return g_strdup_printf ("%'" G_GINT64_FORMAT, stats->counters[counter]);
+}
+
+static gchar *
+format_seconds (gint64 usec)
+{
+	if (usec == GSEARCH_STATS_UNKNOWN) {
+		return g_strdup (GSEARCH_STATS_UNKNOWN_VALUE);
+	}
+	/* Translators: a duration in seconds in the search statistics. */
+	return g_strdup_printf (_("%.2f s"), (gdouble) usec / G_USEC_PER_SEC);
+}
+
+/* Returns the one line summary shown next to the files found label. */
+gchar *
+gsearchtool_stats_get_summary (GSearchStats * stats)
+{
+	gchar * entries;
+	gchar * wall_time;
+	gchar * first_result;
+	gchar * summary;
+
+	entries = format_counter (stats, GSEARCH_STATS_ENTRIES_EXAMINED);
+	wall_time = format_seconds (stats->wall_time);
+	first_result = format_seconds (stats->first_result_time);
+
+	/* Translators: the search statistics summary, for example
+	   "1,024 entries examined in 0.52 s, first result after 0.03 s". */
+	summary = g_strdup_printf (_("%s entries examined in %s, first result after %s"),
+	                           entries, wall_time, first_result);
+	g_free (entries);
+	g_free (wall_time);
+	g_free (first_result);
+
+	return summary;
+}
+
+/* Returns every counter and phase, one per line. */
+gchar *
+gsearchtool_stats_get_details (GSearchStats * stats)
+{
+	const gchar * counter_labels[GSEARCH_STATS_NUM_COUNTERS];
+	const gchar * phase_labels[GSEARCH_STATS_NUM_PHASES];
+	GString * details;
+	gchar * value;
+	gint idx;
+
+	counter_labels[GSEARCH_STATS_DIRECTORIES_VISITED] = _("Folders visited");
+	counter_labels[GSEARCH_STATS_ENTRIES_EXAMINED] = _("Entries examined");
+	counter_labels[GSEARCH_STATS_STAT_CALLS] = _("File status calls");
+	counter_labels[GSEARCH_STATS_BYTES_READ] = _("Bytes read for content matching");
+	counter_labels[GSEARCH_STATS_MATCHES] = _("Matches");
+	counter_labels[GSEARCH_STATS_DEDUP_DROPPED] = _("Duplicate results dropped");
+
+	phase_labels[GSEARCH_STATS_PHASE_PROBE] = _("Command probe");
+	phase_labels[GSEARCH_STATS_PHASE_FIRST_PASS] = _("First pass");
+	phase_labels[GSEARCH_STATS_PHASE_SECOND_PASS] = _("Second pass");
+	phase_labels[GSEARCH_STATS_PHASE_METADATA] = _("File information");
+	phase_labels[GSEARCH_STATS_PHASE_UI_INSERTION] = _("Results list insertion");
+	phase_labels[GSEARCH_STATS_PHASE_DUPLICATES] = _("Duplicate file hashing");
+
+	details = g_string_new (NULL);
+
+	if (stats->plan != NULL) {
+		gchar * estimated;
+
+		estimated = format_seconds (stats->plan_estimated_time);
+		value = format_seconds (stats->phase_time[GSEARCH_STATS_PHASE_FIRST_PASS]);
+		g_string_append_printf (details, "%s: %s\n", _("Plan"), stats->plan);
+		/* Translators: the estimated and the actual time of the plan
+		   of the search, for example "0.10 s estimated, 0.25 s taken". */
+		g_string_append_printf (details, _("%s estimated, %s taken"), estimated, value);
+		g_string_append_c (details, '\n');
+		g_free (estimated);
+		g_free (value);
+	}
+
+	for (idx = 0; idx < GSEARCH_STATS_NUM_COUNTERS; idx++) {
+		value = format_counter (stats, idx);
+		g_string_append_printf (details, "%s: %s\n", counter_labels[idx], value);
+		g_free (value);
+	}
+
+	value = format_seconds (stats->first_result_time);
+	g_string_append_printf (details, "%s: %s\n", _("Time to first result"), value);
+	g_free (value);
+
+	for (idx = 0; idx < GSEARCH_STATS_NUM_PHASES; idx++) {
+		value = format_seconds (stats->phase_time[idx]);
+		g_string_append_printf (details, "%s: %s\n", phase_labels[idx], value);
+		g_free (value);
+	}
+
+	value = format_seconds (stats->wall_time);
+	g_string_append_printf (details, "%s: %s", _("Total time"), value);
+	g_free (value);
+
+	return g_string_free (details, FALSE);
+}
+
+/* Appends the statistics of a search to the log in the user cache folder,
+   keeping only the last @max_entries searches. */
+void
+gsearchtool_stats_log (GSearchStats * stats,
+                       gint max_entries)
+{
+	GString * contents;
+	gchar * directory;
+	gchar * filename;
+	gchar * old_contents = NULL;
+	gchar * json;
+	GError * error = NULL;
+
+	if (max_entries <= 0) {
+		return;
+	}
+
+	directory = g_build_filename (g_get_user_cache_dir (), GSEARCH_STATS_LOG_DIRECTORY, NULL);
+	filename = g_build_filename (directory, GSEARCH_STATS_LOG_FILENAME, NULL);
+
+	if (g_mkdir_with_parents (directory, 0700) != 0) {
+		g_free (directory);
+		g_free (filename);
+		return;
+	}
+
+	contents = g_string_new (NULL);
+
+	if (g_file_get_contents (filename, &old_contents, NULL, NULL)) {
+		gchar ** lines;
+		gint count;
+		gint idx;
+
+		lines = g_strsplit (old_contents, "\n", -1);
+		count = g_strv_length (lines);
+
+		/* The file ends with a newline, so the last element is empty. */
+		if ((count > 0) && (*lines[count - 1] == '\0')) {
+			count--;
+		}
+		for (idx = MAX (0, count - (max_entries - 1)); idx < count; idx++) {
+			g_string_append (contents, lines[idx]);
+			g_string_append_c (contents, '\n');
+		}
+		g_strfreev (lines);
+		g_free (old_contents);
+	}
+
+	json = gsearchtool_stats_to_json (stats);
+	g_string_append (contents, json);
+	g_string_append_c (contents, '\n');
+
+	if (!g_file_set_contents (filename, contents->str, contents->len, &error)) {
+		g_warning ("gsearchtool_stats_log(): %s", error->message);
+		g_error_free (error);
+	}
+
+	g_string_free (contents, TRUE);
+	g_free (json);
+	g_free (directory);
+	g_free (filename);
+}
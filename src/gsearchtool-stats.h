@@ -0,0 +1,130 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-stats.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_STATS_H_
+#define _GSEARCHTOOL_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+#define GSEARCH_STATS_UNKNOWN (-1)
+
+typedef enum {
+	GSEARCH_STATS_DIRECTORIES_VISITED,
+	GSEARCH_STATS_ENTRIES_EXAMINED,
+	GSEARCH_STATS_STAT_CALLS,
+	GSEARCH_STATS_BYTES_READ,
+	GSEARCH_STATS_MATCHES,
+	GSEARCH_STATS_DEDUP_DROPPED,
+	GSEARCH_STATS_NUM_COUNTERS
+} GSearchStatsCounter;
+
+typedef enum {
+	GSEARCH_STATS_PHASE_PROBE,
+	GSEARCH_STATS_PHASE_FIRST_PASS,
+	GSEARCH_STATS_PHASE_SECOND_PASS,
+	GSEARCH_STATS_PHASE_METADATA,
+	GSEARCH_STATS_PHASE_UI_INSERTION,
+	GSEARCH_STATS_PHASE_DUPLICATES,
+	GSEARCH_STATS_NUM_PHASES
+} GSearchStatsPhase;
+
+typedef struct _GSearchStats GSearchStats;
+
+struct _GSearchStats {
+	gchar                 * name_pattern;
+	gchar                 * look_in_folder;
+	gchar                 * first_pass_engine;
+	gchar                 * plan;
+	gint64                  plan_estimated_time;
+	gint64                  start_time;
+	gint64                  wall_time;
+	gint64                  first_result_time;
+	gint64                  phase_start[GSEARCH_STATS_NUM_PHASES];
+	gint64                  phase_time[GSEARCH_STATS_NUM_PHASES];
+	gint64                  counters[GSEARCH_STATS_NUM_COUNTERS];
+	glong                   peak_rss;
+	glong                   peak_rss_children;
+	gboolean                is_stopped;
+};
+
+GSearchStats *
+gsearchtool_stats_new (void);
+
+void
+gsearchtool_stats_free (GSearchStats * stats);
+
+void
+gsearchtool_stats_reset (GSearchStats * stats);
+
+void
+gsearchtool_stats_set_query (GSearchStats * stats,
+                             const gchar * name_pattern,
+                             const gchar * look_in_folder,
+                             const gchar * first_pass_engine);
+void
+gsearchtool_stats_set_plan (GSearchStats * stats,
+                            const gchar * plan,
+                            gint64 estimated_time);
+void
+gsearchtool_stats_add (GSearchStats * stats,
+                       GSearchStatsCounter counter,
+                       gint64 value);
+void
+gsearchtool_stats_set_unknown (GSearchStats * stats,
+                               GSearchStatsCounter counter);
+void
+gsearchtool_stats_phase_begin (GSearchStats * stats,
+                               GSearchStatsPhase phase);
+void
+gsearchtool_stats_phase_end (GSearchStats * stats,
+                             GSearchStatsPhase phase);
+void
+gsearchtool_stats_first_result (GSearchStats * stats);
+
+void
+gsearchtool_stats_finish (GSearchStats * stats,
+                          gboolean stopped);
+gchar *
+gsearchtool_stats_to_json (GSearchStats * stats);
+
+gchar *
+gsearchtool_stats_get_summary (GSearchStats * stats);
+
+gchar *
+gsearchtool_stats_get_details (GSearchStats * stats);
+
+void
+gsearchtool_stats_log (GSearchStats * stats,
+                       gint max_entries);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_STATS_H_ */
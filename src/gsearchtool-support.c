@@ -32,7 +32,6 @@
 #include <string.h>
 #include <glib/gi18n.h>
 #include <glib.h>
-#include <regex.h>
 #include <stdlib.h>
 #include <gdk/gdkx.h>
 #include <gio/gio.h>
@@ -301,36 +300,6 @@ gsearchtool_gconf_watch_key (const gchar * dir,
 
 /* START OF GENERIC GNOME-SEARCH-TOOL FUNCTIONS */
 
-gboolean
-is_path_hidden (const gchar * path)
-{
-	gint results = FALSE;
-	gchar * sub_str;
-	gchar * hidden_path_substr = g_strconcat (G_DIR_SEPARATOR_S, ".", NULL);
-
-	sub_str = g_strstr_len (path, strlen (path), hidden_path_substr);
-
-	if (sub_str != NULL) {
-		gchar * gnome_desktop_str;
-
-		gnome_desktop_str = g_strconcat (G_DIR_SEPARATOR_S, ".gnome-desktop", G_DIR_SEPARATOR_S, NULL);
-
-		/* exclude the .gnome-desktop folder */
-		if (strncmp (sub_str, gnome_desktop_str, strlen (gnome_desktop_str)) == 0) {
-			sub_str++;
-			results = (g_strstr_len (sub_str, strlen (sub_str), hidden_path_substr) != NULL);
-		}
-		else {
-			results = TRUE;
-		}
-
-		g_free (gnome_desktop_str);
-	}
-
-	g_free (hidden_path_substr);
-	return results;
-}
-
 gboolean
 is_quick_search_excluded_path (const gchar * path)
 {
@@ -358,46 +327,7 @@ is_quick_search_excluded_path (const gchar * path)
 	exclude_path_list = gsearchtool_gconf_get_list ("/apps/gnome-search-tool/quick_search_excluded_paths",
 	                                                GCONF_VALUE_STRING);
 
-	for (tmp_list = exclude_path_list; tmp_list; tmp_list = tmp_list->next) {
-
-		/* Skip empty or null values. */
-		if ((tmp_list->data == NULL) || (strlen (tmp_list->data) == 0)) {
-			continue;
-		}
-
-		dir = g_strdup (tmp_list->data);
-
-		/* Wild-card comparisons. */
-		if (g_strstr_len (dir, strlen (dir), "*") != NULL) {
-
-			if (g_pattern_match_simple (dir, path) == TRUE) {
-
-				results = TRUE;
-				g_free (dir);
-				break;
-			}
-		}
-		/* Non-wild-card comparisons. */
-		else {
-			/* Add a trailing G_DIR_SEPARATOR. */
-			if (g_str_has_suffix (dir, G_DIR_SEPARATOR_S) == FALSE) {
-
-				gchar *tmp;
-
-				tmp = dir;
-				dir = g_strconcat (dir, G_DIR_SEPARATOR_S, NULL);
-				g_free (tmp);
-			}
-
-			if (strcmp (path, dir) == 0) {
-
-				results = TRUE;
-				g_free (dir);
-				break;
-			}
-		}
-		g_free (dir);
-	}
+	results = is_path_excluded (path, exclude_path_list);
 
 	for (tmp_list = exclude_path_list; tmp_list; tmp_list = tmp_list->next) {
 		g_free (tmp_list->data);
@@ -434,46 +364,7 @@ is_second_scan_excluded_path (const gchar * path)
 	exclude_path_list = gsearchtool_gconf_get_list ("/apps/gnome-search-tool/quick_search_second_scan_excluded_paths",
 	                                                GCONF_VALUE_STRING);
 
-	for (tmp_list = exclude_path_list; tmp_list; tmp_list = tmp_list->next) {
-
-		/* Skip empty or null values. */
-		if ((tmp_list->data == NULL) || (strlen (tmp_list->data) == 0)) {
-			continue;
-		}
-
-		dir = g_strdup (tmp_list->data);
-
-		/* Wild-card comparisons. */
-		if (g_strstr_len (dir, strlen (dir), "*") != NULL) {
-
-			if (g_pattern_match_simple (dir, path) == TRUE) {
-
-				results = TRUE;
-				g_free (dir);
-				break;
-			}
-		}
-		/* Non-wild-card comparisons. */
-		else {
-			/* Add a trailing G_DIR_SEPARATOR. */
-			if (g_str_has_suffix (dir, G_DIR_SEPARATOR_S) == FALSE) {
-
-				gchar *tmp;
-
-				tmp = dir;
-				dir = g_strconcat (dir, G_DIR_SEPARATOR_S, NULL);
-				g_free (tmp);
-			}
-
-			if (strcmp (path, dir) == 0) {
-
-				results = TRUE;
-				g_free (dir);
-				break;
-			}
-		}
-		g_free (dir);
-	}
+	results = is_path_excluded (path, exclude_path_list);
 
 	for (tmp_list = exclude_path_list; tmp_list; tmp_list = tmp_list->next) {
 		g_free (tmp_list->data);
@@ -483,26 +374,6 @@ is_second_scan_excluded_path (const gchar * path)
 	return results;
 }
 
-gboolean
-compare_regex (const gchar * regex,
-	       const gchar * string)
-{
-	regex_t regexec_pattern;
-
-	if (regex == NULL) {
-		return TRUE;
-	}
-
-	if (!regcomp (&regexec_pattern, regex, REG_EXTENDED|REG_NOSUB)) {
-		if (regexec (&regexec_pattern, string, 0, 0, 0) != REG_NOMATCH) {
-			regfree (&regexec_pattern);
-			return TRUE;
-		}
-		regfree (&regexec_pattern);
-	}
-	return FALSE;
-}
-
 gboolean
 limit_string_to_x_lines (GString * string,
 			 gint x)
@@ -1178,11 +1049,16 @@ get_file_pixbuf (GSearchWindow * gsearch,
 		gchar * icon_string;
 
 		icon_string = g_icon_to_string (icon);		
-		pixbuf = (GdkPixbuf *) g_hash_table_lookup (gsearch->search_results_filename_hash_table, icon_string);
+		pixbuf = (GdkPixbuf *) g_hash_table_lookup (gsearch->search_results_pixbuf_hash_table, icon_string);
 
 		if (pixbuf == NULL) {
 			pixbuf = get_themed_icon_pixbuf (G_THEMED_ICON (icon), ICON_SIZE, gtk_icon_theme_get_default ());
-			g_hash_table_insert (gsearch->search_results_filename_hash_table, g_strdup (icon_string), pixbuf);
+			if (pixbuf != NULL) {
+				g_hash_table_insert (gsearch->search_results_pixbuf_hash_table, g_strdup (icon_string), pixbuf);
+			}
+		}
+		if (pixbuf != NULL) {
+			g_object_ref (pixbuf);
 		}
 		g_free (icon_string);
 	}
@@ -34,6 +34,7 @@ extern "C" {
 #endif
 
 #include "gsearchtool.h"
+#include "gsearchtool-match.h"
 
 #define ICON_SIZE 24
 
@@ -71,18 +72,12 @@ gsearchtool_gconf_watch_key (const gchar * dir,
                              const gchar * key,
                              GConfClientNotifyFunc callback,
                              gpointer user_data);
-gboolean
-is_path_hidden (const gchar * path);
-
 gboolean
 is_quick_search_excluded_path (const gchar * path);
 
 gboolean
 is_second_scan_excluded_path (const gchar * path);
 
-gboolean
-compare_regex (const gchar * regex,
-               const gchar * string);
 gboolean
 limit_string_to_x_lines (GString * string,
                          gint x);
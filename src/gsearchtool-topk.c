@@ -0,0 +1,225 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-topk.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Keeps the K largest, newest or oldest files offered to it.  The files
+ * are held in a heap with the one to drop next at the top, so a
+ * file that does not make it costs a single comparison.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gsearchtool-topk.h"
+
+struct _GSearchTopK {
+	GSearchTopKKind         kind;
+	guint                   count;
+	GPtrArray             * heap;
+	GHashTable            * paths;
+};
+
+static void
+free_entry (GSearchTopKEntry * entry)
+{
+	g_free (entry->path);
+	g_slice_free (GSearchTopKEntry, entry);
+}
+
+/* Returns a negative value when @a ranks before @b in the results.  Ties
+   are broken on the path, so the same files are kept whatever the order
+   they are found in. */
+static gint
+compare_entries (GSearchTopKKind kind,
+                 const GSearchTopKEntry * a,
+                 const GSearchTopKEntry * b)
+{
+	switch (kind) {
+	case GSEARCH_TOPK_LARGEST:
+		if (a->size != b->size) {
+			return (a->size > b->size) ? -1 : 1;
+		}
+		break;
+	case GSEARCH_TOPK_NEWEST:
+		if (a->mtime != b->mtime) {
+			return (a->mtime > b->mtime) ? -1 : 1;
+		}
+		break;
+	case GSEARCH_TOPK_OLDEST:
+		if (a->mtime != b->mtime) {
+			return (a->mtime < b->mtime) ? -1 : 1;
+		}
+		break;
+	default:
+		break;
+	}
+	return strcmp (a->path, b->path);
+}
+
+static void
+sift_up (GSearchTopK * topk,
+         guint idx)
+{
+	GSearchTopKEntry * entry = g_ptr_array_index (topk->heap, idx);
+
+	while (idx > 0) {
+		guint parent = (idx - 1) / 2;
+		GSearchTopKEntry * parent_entry = g_ptr_array_index (topk->heap, parent);
+
+		if (compare_entries (topk->kind, entry, parent_entry) < 0) {
+			break;
+		}
+		g_ptr_array_index (topk->heap, idx) = parent_entry;
+		idx = parent;
+	}
+	g_ptr_array_index (topk->heap, idx) = entry;
+}
+
+static void
+sift_down (GSearchTopK * topk,
+           guint idx)
+{
+	GSearchTopKEntry * entry = g_ptr_array_index (topk->heap, idx);
+	guint length = topk->heap->len;
+
+	while (2 * idx + 1 < length) {
+		guint child = 2 * idx + 1;
+
+		if (child + 1 < length &&
+		    compare_entries (topk->kind, g_ptr_array_index (topk->heap, child + 1),
+		                     g_ptr_array_index (topk->heap, child)) > 0) {
+			child++;
+		}
+		if (compare_entries (topk->kind, entry, g_ptr_array_index (topk->heap, child)) >= 0) {
+			break;
+		}
+		g_ptr_array_index (topk->heap, idx) = g_ptr_array_index (topk->heap, child);
+		idx = child;
+	}
+	g_ptr_array_index (topk->heap, idx) = entry;
+}
+
+GSearchTopK *
+gsearchtool_topk_new (GSearchTopKKind kind,
+                      guint count)
+{
+	GSearchTopK * topk;
+
+	topk = g_slice_new0 (GSearchTopK);
+	topk->kind = kind;
+	topk->count = MAX (count, 1);
+	topk->heap = g_ptr_array_sized_new (MIN (topk->count, 4096));
+	topk->paths = g_hash_table_new (g_str_hash, g_str_equal);
+
+	return topk;
+}
+
+void
+gsearchtool_topk_free (GSearchTopK * topk)
+{
+	if (topk == NULL) {
+		return;
+	}
+	g_ptr_array_foreach (topk->heap, (GFunc) free_entry, NULL);
+	g_ptr_array_free (topk->heap, TRUE);
+	g_hash_table_destroy (topk->paths);
+	g_slice_free (GSearchTopK, topk);
+}
+
+/* Returns TRUE if the file is among the K best so far.  A file offered
+   twice, as locate and find may both report it, is only kept once. */
+gboolean
+gsearchtool_topk_offer (GSearchTopK * topk,
+                        const gchar * path,
+                        gint64 size,
+                        gint64 mtime)
+{
+	GSearchTopKEntry candidate = { (gchar *) path, size, mtime };
+	GSearchTopKEntry * entry;
+
+	if (topk->heap->len == topk->count &&
+	    compare_entries (topk->kind, &candidate, g_ptr_array_index (topk->heap, 0)) >= 0) {
+		return FALSE;
+	}
+	if (g_hash_table_lookup (topk->paths, path) != NULL) {
+		return TRUE;
+	}
+
+	entry = g_slice_new (GSearchTopKEntry);
+	entry->path = g_strdup (path);
+	entry->size = size;
+	entry->mtime = mtime;
+	g_hash_table_insert (topk->paths, entry->path, entry);
+
+	if (topk->heap->len == topk->count) {
+		GSearchTopKEntry * last = g_ptr_array_index (topk->heap, 0);
+
+		g_hash_table_remove (topk->paths, last->path);
+		free_entry (last);
+		g_ptr_array_index (topk->heap, 0) = entry;
+		sift_down (topk, 0);
+	}
+	else {
+		g_ptr_array_add (topk->heap, entry);
+		sift_up (topk, topk->heap->len - 1);
+	}
+	return TRUE;
+}
+
+guint
+gsearchtool_topk_get_length (GSearchTopK * topk)
+{
+	return topk->heap->len;
+}
+
+static gint
+compare_sorted_entries (gconstpointer a,
+                        gconstpointer b,
+                        gpointer data)
+{
+	GSearchTopK * topk = data;
+
+	return compare_entries (topk->kind,
+	                        *(const GSearchTopKEntry **) a,
+	                        *(const GSearchTopKEntry **) b);
+}
+
+/* Returns the entries kept, best first.  They belong to @topk. */
+GPtrArray *
+gsearchtool_topk_get_sorted (GSearchTopK * topk)
+{
+	GPtrArray * sorted;
+	guint idx;
+
+	sorted = g_ptr_array_sized_new (topk->heap->len);
+	for (idx = 0; idx < topk->heap->len; idx++) {
+		g_ptr_array_add (sorted, g_ptr_array_index (topk->heap, idx));
+	}
+	g_ptr_array_sort_with_data (sorted, compare_sorted_entries, topk);
+
+	return sorted;
+}
@@ -0,0 +1,71 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  gsearchtool-topk.h
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef _GSEARCHTOOL_TOPK_H_
+#define _GSEARCHTOOL_TOPK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#pragma }
+#endif
+
+#include <glib.h>
+
+typedef enum {
+	GSEARCH_TOPK_LARGEST,
+	GSEARCH_TOPK_NEWEST,
+	GSEARCH_TOPK_OLDEST
+} GSearchTopKKind;
+
+typedef struct _GSearchTopK GSearchTopK;
+typedef struct _GSearchTopKEntry GSearchTopKEntry;
+
+struct _GSearchTopKEntry {
+	gchar                 * path;
+	gint64                  size;
+	gint64                  mtime;
+};
+
+GSearchTopK *
+gsearchtool_topk_new (GSearchTopKKind kind,
+                      guint count);
+void
+gsearchtool_topk_free (GSearchTopK * topk);
+
+gboolean
+gsearchtool_topk_offer (GSearchTopK * topk,
+                        const gchar * path,
+                        gint64 size,
+                        gint64 mtime);
+guint
+gsearchtool_topk_get_length (GSearchTopK * topk);
+
+GPtrArray *
+gsearchtool_topk_get_sorted (GSearchTopK * topk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _GSEARCHTOOL_TOPK_H_ */
@@ -29,18 +29,15 @@
 #  include <config.h>
 #endif
 
-#include <fnmatch.h>
-#ifndef FNM_CASEFOLD
-#  define FNM_CASEFOLD 0
-#endif
-
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <gdk/gdk.h>
 #include <gio/gio.h>
 #include <locale.h>
@@ -53,7 +50,19 @@
 #define GNOME_SEARCH_TOOL_DEFAULT_ICON_SIZE 16
 #define GNOME_SEARCH_TOOL_STOCK "panel-searchtool"
 #define GNOME_SEARCH_TOOL_REFRESH_DURATION  50000
+#define GNOME_SEARCH_TOOL_METADATA_BATCH_SIZE 256
+#define GNOME_SEARCH_TOOL_DATABASE_BUDGET 4096	/* entries between looks at the time */
+#define GNOME_SEARCH_TOOL_LIVE_SEARCH_DELAY  300	/* milliseconds */
+#define GNOME_SEARCH_TOOL_DEFAULT_SKIPPED_FILESYSTEMS "pseudo,network"
 #define LEFT_LABEL_SPACING "     "
+#define MAX_FOLDER_MONITORS 1024
+#define MAX_WATCHED_FOLDERS 8192
+#define GNOME_SEARCH_TOOL_WATCH_DELAY        500	/* milliseconds */
+#define GNOME_SEARCH_TOOL_WATCH_WALK_BATCH    64	/* folders per idle */
+
+#ifdef HAVE_GETPGID
+extern pid_t getpgid (pid_t);
+#endif
 
 static GObjectClass * parent_class;
 
@@ -79,6 +88,10 @@ struct _GSearchOptionTemplate {
 
 static GSearchOptionTemplate GSearchOptionTemplates[] = {
 	{ SEARCH_CONSTRAINT_TYPE_TEXT, NULL, N_("Contains the _text"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_TEXT, "CONTAINS_ANY_OF_THE_WORDS", N_("Contains an_y of the words"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_TEXT, "CONTAINS_ALL_OF_THE_WORDS", N_("Contains all o_f the words"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "SEARCH_COMPRESSED_FILES", N_("Look for the words in compressed files"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "MATCH_ARCHIVE_MEMBER_NAMES", N_("Look for the words in archive member names"), NULL, FALSE },
 	{ SEARCH_CONSTRAINT_TYPE_SEPARATOR, NULL, NULL, NULL, TRUE },
 	{ SEARCH_CONSTRAINT_TYPE_DATE_BEFORE, "-mtime -%d", N_("_Date modified less than"), N_("days"), FALSE },
 	{ SEARCH_CONSTRAINT_TYPE_DATE_AFTER, "\\( -mtime +%d -o -mtime %d \\)", N_("Date modified more than"), N_("days"), FALSE },
@@ -97,11 +110,24 @@ static GSearchOptionTemplate GSearchOptionTemplates[] = {
 	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "SHOW_HIDDEN_FILES", N_("Show hidden and backup files"), NULL, FALSE },
 	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "-follow", N_("Follow symbolic links"), NULL, FALSE },
 	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "EXCLUDE_OTHER_FILESYSTEMS", N_("Exclude other filesystems"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_TEXT, "ALSO_LOOK_IN_FOLDERS", N_("Also look in folders"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_TEXT, "SKIP_FILESYSTEMS", N_("Skip filesystems"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_SEPARATOR, NULL, NULL, NULL, TRUE },
+	{ SEARCH_CONSTRAINT_TYPE_NUMERIC, "TOP_LARGEST_FILES", N_("Only the _largest files"), N_("files"), FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_NUMERIC, "TOP_NEWEST_FILES", N_("Only the _newest files"), N_("files"), FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_NUMERIC, "TOP_OLDEST_FILES", N_("Only the _oldest files"), N_("files"), FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "DISK_USAGE_BY_FOLDER", N_("Summarize disk usage by folder"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "COUNT_ONLY", N_("Only count the files"), NULL, FALSE },
+	{ SEARCH_CONSTRAINT_TYPE_BOOLEAN, "FIND_DUPLICATES", N_("Find duplicate files"), NULL, FALSE },
 	{ SEARCH_CONSTRAINT_TYPE_NONE, NULL, NULL, NULL, FALSE}
 };
 
 enum {
 	SEARCH_CONSTRAINT_CONTAINS_THE_TEXT,
+	SEARCH_CONSTRAINT_CONTAINS_ANY_OF_THE_WORDS,
+	SEARCH_CONSTRAINT_CONTAINS_ALL_OF_THE_WORDS,
+	SEARCH_CONSTRAINT_SEARCH_COMPRESSED_FILES,
+	SEARCH_CONSTRAINT_MATCH_ARCHIVE_MEMBER_NAMES,
 	SEARCH_CONSTRAINT_TYPE_SEPARATOR_00,
 	SEARCH_CONSTRAINT_DATE_MODIFIED_BEFORE,
 	SEARCH_CONSTRAINT_DATE_MODIFIED_AFTER,
@@ -120,6 +146,15 @@ enum {
 	SEARCH_CONSTRAINT_SHOW_HIDDEN_FILES_AND_FOLDERS,
 	SEARCH_CONSTRAINT_FOLLOW_SYMBOLIC_LINKS,
 	SEARCH_CONSTRAINT_SEARCH_OTHER_FILESYSTEMS,
+	SEARCH_CONSTRAINT_ALSO_LOOK_IN_FOLDERS,
+	SEARCH_CONSTRAINT_SKIP_FILESYSTEMS,
+	SEARCH_CONSTRAINT_TYPE_SEPARATOR_05,
+	SEARCH_CONSTRAINT_TOP_LARGEST_FILES,
+	SEARCH_CONSTRAINT_TOP_NEWEST_FILES,
+	SEARCH_CONSTRAINT_TOP_OLDEST_FILES,
+	SEARCH_CONSTRAINT_DISK_USAGE_BY_FOLDER,
+	SEARCH_CONSTRAINT_COUNT_ONLY,
+	SEARCH_CONSTRAINT_FIND_DUPLICATES,
 	SEARCH_CONSTRAINT_MAXIMUM_POSSIBLE
 };
 
@@ -135,6 +170,10 @@ struct _GSearchGOptionArguments {
 	gchar * name;
 	gchar * path;
 	gchar * contains;
+	gchar * contains_any;
+	gchar * contains_all;
+	gboolean compressed;
+	gboolean member_names;
 	gchar * user;
 	gchar * group;
 	gboolean nouser;
@@ -148,9 +187,19 @@ struct _GSearchGOptionArguments {
 	gboolean hidden;
 	gboolean follow;
 	gboolean mounts;
+	gchar * also_path;
+	gchar * skip_filesystems;
+	gchar * top_largest;
+	gchar * top_newest;
+	gchar * top_oldest;
+	gboolean disk_usage;
+	gboolean count_only;
+	gboolean duplicates;
 	gchar * sortby;
 	gboolean descending;
 	gboolean start;
+	gboolean batch;
+	gchar * update_index;
 } GSearchGOptionArguments;
 
 static GOptionEntry GSearchGOptionEntries[] = {
@@ -161,6 +210,10 @@ static GOptionEntry GSearchGOptionEntries[] = {
 	{ "descending", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.descending, NULL, NULL },
 	{ "start", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.start, NULL, NULL },
 	{ "contains", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.contains, NULL, N_("STRING") },
+	{ "contains-any", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.contains_any, NULL, N_("WORDS") },
+	{ "contains-all", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.contains_all, NULL, N_("WORDS") },
+	{ "compressed", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.compressed, NULL, NULL },
+	{ "member-names", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.member_names, NULL, NULL },
 	{ "mtimeless", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.mtimeless, NULL, N_("DAYS") },
 	{ "mtimemore", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.mtimemore, NULL, N_("DAYS") },
 	{ "sizemore", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.sizemore, NULL, N_("KILOBYTES") },
@@ -174,273 +227,363 @@ static GOptionEntry GSearchGOptionEntries[] = {
 	{ "hidden", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.hidden, NULL, NULL },
 	{ "follow", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.follow, NULL, NULL },
 	{ "mounts", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.mounts, NULL, NULL },
+	{ "also-path", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.also_path, NULL, N_("FOLDERS") },
+	{ "skip-fs", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.skip_filesystems, NULL, N_("TYPES") },
+	{ "top-largest", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.top_largest, NULL, N_("COUNT") },
+	{ "top-newest", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.top_newest, NULL, N_("COUNT") },
+	{ "top-oldest", 0, 0, G_OPTION_ARG_STRING, &GSearchGOptionArguments.top_oldest, NULL, N_("COUNT") },
+	{ "du", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.disk_usage, NULL, NULL },
+	{ "count", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.count_only, NULL, NULL },
+	{ "duplicates", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.duplicates, NULL, NULL },
+	{ "batch", 0, 0, G_OPTION_ARG_NONE, &GSearchGOptionArguments.batch, NULL, NULL },
+	{ "update-index", 0, 0, G_OPTION_ARG_FILENAME, &GSearchGOptionArguments.update_index, NULL, N_("FOLDER") },
 	{ NULL }
 };
 
 static gchar * find_command_default_name_argument;
+static gboolean find_command_has_printf_argument;
 static gchar * locate_command_default_options;
-pid_t locate_database_check_command_pid;
+
+typedef enum {
+	SEARCH_PROBE_FIND_IGNORE_CASE,
+	SEARCH_PROBE_FIND_PRINTF,
+	SEARCH_PROBE_GREP_IGNORE_CASE,
+	SEARCH_PROBE_GREP_BINARY_FILES,
+	SEARCH_PROBE_LOCATE_IGNORE_CASE,
+	SEARCH_PROBE_LOCATE,
+	SEARCH_PROBE_FINISHED
+} GSearchProbeStep;
+
+typedef struct _GSearchProbe GSearchProbe;
+
+struct _GSearchProbe {
+	GSearchWindow         * gsearch;
+	GSearchProbeStep        step;
+	GPid                    pid;
+	gint                    open_pipes;
+	gboolean                is_spawned;
+	gboolean                has_stderr_output;
+	gboolean                has_stdout_path;
+};
+
+/* A file waiting in search_results_pending to be stated. */
+typedef struct {
+	gchar                 * path;
+	guint64                 inode;
+} GSearchPendingFile;
+
+/* The command probe runs once per process.  It is shared by every search
+   started while it is still running, see probe_search_commands(). */
+static GSearchProbe * search_probe = NULL;
+static gboolean search_probe_finished = FALSE;
+
+static void run_search_probe_step (GSearchProbe * probe);
+static void search_command_probe_finished (GSearchWindow * gsearch);
+static void search_command_pass_finished (GSearchWindow * gsearch);
+static gint start_search_roots (GSearchWindow * gsearch);
+static void finalize_search_command (GSearchWindow * gsearch);
+static gboolean content_scan_timeout_cb (gpointer data);
+static gboolean live_search_timeout_cb (gpointer data);
+static void search_command_content_scan_finished (GSearchWindow * gsearch);
+
+static void
+search_probe_child_exited_cb (GPid pid,
+                              gint status,
+                              gpointer data)
+{
+	g_spawn_close_pid (pid);
+}
+
+static void
+finish_search_probe_step (GSearchProbe * probe)
+{
+	gboolean supported = (probe->is_spawned == TRUE) && (probe->has_stderr_output == FALSE);
+
+	switch (probe->step) {
+	case SEARCH_PROBE_FIND_IGNORE_CASE:
+		/* check find command for -iname argument compatibility */
+		if (supported) {
+			find_command_default_name_argument = g_strdup ("-iname");
+			GSearchOptionTemplates[SEARCH_CONSTRAINT_FILE_IS_NOT_NAMED].option = g_strdup ("'!' -iname '*%s*'");
+		}
+		else {
+			find_command_default_name_argument = g_strdup ("-name");
+		}
+		probe->step = SEARCH_PROBE_FIND_PRINTF;
+		break;
+	case SEARCH_PROBE_FIND_PRINTF:
+		/* check find command for -printf argument compatibility */
+		find_command_has_printf_argument = supported;
+		probe->step = SEARCH_PROBE_GREP_IGNORE_CASE;
+		break;
+	case SEARCH_PROBE_GREP_IGNORE_CASE:
+		/* check grep command for -i argument compatibility */
+		if (supported) {
+			probe->step = SEARCH_PROBE_GREP_BINARY_FILES;
+		}
+		else {
+	 		GSearchOptionTemplates[SEARCH_CONSTRAINT_CONTAINS_THE_TEXT].option =
+			    g_strdup_printf ("'!' -type p -exec %s -c '%%s' {} \\;", GREP_COMMAND);
+			probe->step = SEARCH_PROBE_LOCATE_IGNORE_CASE;
+		}
+		break;
+	case SEARCH_PROBE_GREP_BINARY_FILES:
+		/* check grep command for -I argument compatibility, bug 568840 */
+		if (supported) {
+	 		GSearchOptionTemplates[SEARCH_CONSTRAINT_CONTAINS_THE_TEXT].option =
+			    g_strdup_printf ("'!' -type p -exec %s -i -I -c '%%s' {} \\;", GREP_COMMAND);
+		}
+		else {
+	 		GSearchOptionTemplates[SEARCH_CONSTRAINT_CONTAINS_THE_TEXT].option =
+			    g_strdup_printf ("'!' -type p -exec %s -i -c '%%s' {} \\;", GREP_COMMAND);
+		}
+		probe->step = SEARCH_PROBE_LOCATE_IGNORE_CASE;
+		break;
+	case SEARCH_PROBE_LOCATE_IGNORE_CASE:
+		/* check locate command for -i argument compatibility */
+		if (probe->has_stdout_path) {
+			locate_command_default_options = g_strdup ("-i");
+			probe->gsearch->is_locate_database_available = TRUE;
+			probe->step = SEARCH_PROBE_FINISHED;
+		}
+		else {
+			probe->step = SEARCH_PROBE_LOCATE;
+		}
+		break;
+	case SEARCH_PROBE_LOCATE:
+		/* check if locate can find anything at all */
+		locate_command_default_options = g_strdup ("");
+		probe->gsearch->is_locate_database_available = probe->has_stdout_path;
+		if (probe->has_stdout_path == FALSE) {
+			g_warning (_("A locate database has probably not been created."));
+		}
+		probe->step = SEARCH_PROBE_FINISHED;
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+search_probe_pipe_closed (GSearchProbe * probe)
+{
+	if (--probe->open_pipes > 0) {
+		return;
+	}
+
+	finish_search_probe_step (probe);
+	run_search_probe_step (probe);
+}
 
 static gboolean
-handle_locate_command_stdout_io (GIOChannel * ioc,
-                                 GIOCondition condition,
-                                 gpointer data)
+handle_search_probe_stdout_io (GIOChannel * ioc,
+                               GIOCondition condition,
+                               gpointer data)
 {
-	GSearchWindow * gsearch = data;
+	GSearchProbe * probe = data;
 	gboolean broken_pipe = FALSE;
 
 	if (condition & G_IO_IN) {
 
-		GError * error = NULL;
 		GString * string;
 
 		string = g_string_new (NULL);
 
-		while (ioc->is_readable != TRUE);
-
-		do {
-			gint status;
-
-			do {
-				status = g_io_channel_read_line_string (ioc, string, NULL, &error);
-
-				if (status == G_IO_STATUS_EOF) {
-					broken_pipe = TRUE;
-				}
-				else if (status == G_IO_STATUS_AGAIN) {
-					if (gtk_events_pending ()) {
-						while (gtk_events_pending ()) {
-							gtk_main_iteration ();
-						}
-					}
-				}
-				else if ((string->len != 0) && (strncmp (string->str, "/", 1) == 0)) {
-					gsearch->is_locate_database_available = TRUE;
-					broken_pipe = TRUE;
-				}
+		while (TRUE) {
+			GIOStatus status;
 
-			} while (status == G_IO_STATUS_AGAIN && broken_pipe == FALSE);
+			status = g_io_channel_read_line_string (ioc, string, NULL, NULL);
 
-			if (broken_pipe == TRUE) {
+			if (status == G_IO_STATUS_AGAIN) {
 				break;
 			}
-
-			if (status != G_IO_STATUS_NORMAL) {
-				if (error != NULL) {
-					g_warning ("handle_locate_command_stdout_io(): %s", error->message);
-					g_error_free (error);
-				}
+			else if (status != G_IO_STATUS_NORMAL) {
+				broken_pipe = TRUE;
+				break;
 			}
-
-		} while (g_io_channel_get_buffer_condition (ioc) & G_IO_IN);
-
-		waitpid (locate_database_check_command_pid, NULL, 0);
+			else if ((string->len != 0) && (strncmp (string->str, "/", 1) == 0)) {
+				/* One path is enough, the rest of the database is not needed. */
+				probe->has_stdout_path = TRUE;
+				broken_pipe = TRUE;
+				break;
+			}
+		}
 		g_string_free (string, TRUE);
 	}
 
 	if (!(condition & G_IO_IN) || broken_pipe == TRUE) {
-		gsearch->is_locate_database_check_finished = TRUE;
-		g_io_channel_shutdown (ioc, TRUE, NULL);
+		g_io_channel_shutdown (ioc, FALSE, NULL);
+		search_probe_pipe_closed (probe);
 		return FALSE;
 	}
 	return TRUE;
 }
 
-static void
-setup_case_insensitive_arguments (GSearchWindow * gsearch)
+static gboolean
+handle_search_probe_stderr_io (GIOChannel * ioc,
+                               GIOCondition condition,
+                               gpointer data)
 {
-	static gboolean case_insensitive_arguments_initialized = FALSE;
-	gchar * cmd_stderr;
-	gchar * grep_cmd;
-	gchar * locate;
+	GSearchProbe * probe = data;
+	gboolean broken_pipe = FALSE;
 
-	if (case_insensitive_arguments_initialized == TRUE) {
-		return;
-	}
-	case_insensitive_arguments_initialized = TRUE;
+	if (condition & G_IO_IN) {
 
-	/* check find command for -iname argument compatibility */
-	g_spawn_command_line_sync ("find /dev/null -iname 'string'", NULL, &cmd_stderr, NULL, NULL);
+		gchar buffer[256];
 
-	if ((cmd_stderr != NULL) && (strlen (cmd_stderr) == 0)) {
-		find_command_default_name_argument = g_strdup ("-iname");
-		GSearchOptionTemplates[SEARCH_CONSTRAINT_FILE_IS_NOT_NAMED].option = g_strdup ("'!' -iname '*%s*'");
+		while (TRUE) {
+			GIOStatus status;
+			gsize length = 0;
+
+			status = g_io_channel_read_chars (ioc, buffer, sizeof (buffer), &length, NULL);
+
+			if (length > 0) {
+				probe->has_stderr_output = TRUE;
+			}
+			if (status == G_IO_STATUS_AGAIN) {
+				break;
+			}
+			else if (status != G_IO_STATUS_NORMAL) {
+				broken_pipe = TRUE;
+				break;
+			}
+		}
 	}
-	else {
-		find_command_default_name_argument = g_strdup ("-name");
+
+	if (!(condition & G_IO_IN) || broken_pipe == TRUE) {
+		g_io_channel_shutdown (ioc, FALSE, NULL);
+		search_probe_pipe_closed (probe);
+		return FALSE;
 	}
-	g_free (cmd_stderr);
+	return TRUE;
+}
 
-	/* check grep command for -i argument compatibility */
-	grep_cmd = g_strdup_printf ("%s -i 'string' /dev/null", GREP_COMMAND);
- 	g_spawn_command_line_sync (grep_cmd, NULL, &cmd_stderr, NULL, NULL);
+static gchar *
+get_search_probe_command (GSearchProbe * probe)
+{
+	gchar * command = NULL;
+	gchar * locate;
 
-	if ((cmd_stderr != NULL) && (strlen (cmd_stderr) == 0)) {
-		g_free (cmd_stderr);
-		g_free (grep_cmd);
-		
-		/* check grep command for -I argument compatibility, bug 568840 */
-		grep_cmd = g_strdup_printf ("%s -i -I 'string' /dev/null", GREP_COMMAND);
-	 	g_spawn_command_line_sync (grep_cmd, NULL, &cmd_stderr, NULL, NULL);
-		
-		if ((cmd_stderr != NULL) && (strlen (cmd_stderr) == 0)) {
-	 		GSearchOptionTemplates[SEARCH_CONSTRAINT_CONTAINS_THE_TEXT].option =
-			    g_strdup_printf ("'!' -type p -exec %s -i -I -c '%%s' {} \\;", GREP_COMMAND);
- 		}
-		else {
-	 		GSearchOptionTemplates[SEARCH_CONSTRAINT_CONTAINS_THE_TEXT].option =
-			    g_strdup_printf ("'!' -type p -exec %s -i -c '%%s' {} \\;", GREP_COMMAND);		
-		}		
-	}
-	else {
- 		GSearchOptionTemplates[SEARCH_CONSTRAINT_CONTAINS_THE_TEXT].option =
-		    g_strdup_printf ("'!' -type p -exec %s -c '%%s' {} \\;", GREP_COMMAND);
+	switch (probe->step) {
+	case SEARCH_PROBE_FIND_IGNORE_CASE:
+		command = g_strdup ("find /dev/null -iname 'string'");
+		break;
+	case SEARCH_PROBE_FIND_PRINTF:
+		command = g_strdup ("find /dev/null -printf ''");
+		break;
+	case SEARCH_PROBE_GREP_IGNORE_CASE:
+		command = g_strdup_printf ("%s -i 'string' /dev/null", GREP_COMMAND);
+		break;
+	case SEARCH_PROBE_GREP_BINARY_FILES:
+		command = g_strdup_printf ("%s -i -I 'string' /dev/null", GREP_COMMAND);
+		break;
+	case SEARCH_PROBE_LOCATE_IGNORE_CASE:
+	case SEARCH_PROBE_LOCATE:
+		locate = g_find_program_in_path ("locate");
+		if (locate != NULL) {
+			command = g_strconcat (locate, (probe->step == SEARCH_PROBE_LOCATE_IGNORE_CASE) ? " -i /" : " /", NULL);
+		}
+		g_free (locate);
+		break;
+	default:
+		break;
 	}
-	g_free (cmd_stderr);
+	return command;
+}
 
-	locate = g_find_program_in_path ("locate");
+static void
+run_search_probe_step (GSearchProbe * probe)
+{
+	while (probe->step != SEARCH_PROBE_FINISHED) {
 
-	if (locate != NULL) {
 		GIOChannel * ioc_stdout;
-		gchar ** argv  = NULL;
-		gchar *command = NULL;
+		GIOChannel * ioc_stderr;
+		gchar ** argv = NULL;
+		gchar * command;
 		gint child_stdout;
+		gint child_stderr;
 
-		/* check locate command for -i argument compatibility */
-		command = g_strconcat (locate, " -i /", NULL);
-		g_shell_parse_argv (command, NULL, &argv, NULL);
-		g_free (command);
+		probe->is_spawned = FALSE;
+		probe->has_stderr_output = FALSE;
+		probe->has_stdout_path = FALSE;
 
-		gsearch->is_locate_database_check_finished = FALSE;
-		gsearch->is_locate_database_available = FALSE;
+		command = get_search_probe_command (probe);
+
+		if (command == NULL) {
+			/* locate is not installed */
+			locate_command_default_options = g_strdup ("");
+			probe->gsearch->is_locate_database_available = FALSE;
+			probe->step = SEARCH_PROBE_FINISHED;
+			break;
+		}
 
-		/* run locate command asynchronously because on some systems it can be slow */
-		if (g_spawn_async_with_pipes (g_get_home_dir (), argv, NULL,
-				       G_SPAWN_SEARCH_PATH, NULL, NULL,
-				       &locate_database_check_command_pid, NULL, &child_stdout,
-				       NULL, NULL)) {
+		/* run the commands asynchronously because on some systems locate can be slow */
+		if (g_shell_parse_argv (command, NULL, &argv, NULL) &&
+		    g_spawn_async_with_pipes (g_get_home_dir (), argv, NULL,
+		                              G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+		                              NULL, NULL, &probe->pid, NULL, &child_stdout,
+		                              &child_stderr, NULL)) {
+
+			probe->is_spawned = TRUE;
+			probe->open_pipes = 2;
+
+			g_child_watch_add (probe->pid, search_probe_child_exited_cb, NULL);
 
 			ioc_stdout = g_io_channel_unix_new (child_stdout);
+			ioc_stderr = g_io_channel_unix_new (child_stderr);
 			g_io_channel_set_encoding (ioc_stdout, NULL, NULL);
+			g_io_channel_set_encoding (ioc_stderr, NULL, NULL);
 			g_io_channel_set_flags (ioc_stdout, G_IO_FLAG_NONBLOCK, NULL);
+			g_io_channel_set_flags (ioc_stderr, G_IO_FLAG_NONBLOCK, NULL);
 			g_io_add_watch (ioc_stdout, G_IO_IN | G_IO_HUP,
-					handle_locate_command_stdout_io, gsearch);
+			                handle_search_probe_stdout_io, probe);
+			g_io_add_watch (ioc_stderr, G_IO_IN | G_IO_HUP,
+			                handle_search_probe_stderr_io, probe);
 			g_io_channel_unref (ioc_stdout);
-		}
-		else {
-			gsearch->is_locate_database_check_finished = TRUE;
-		}
-
-		g_strfreev (argv);
-
-		while (gsearch->is_locate_database_check_finished == FALSE) {
-			if (gtk_events_pending ()) {
-				while (gtk_events_pending ()) {
-					gtk_main_iteration ();
-				}
-			}
-		}
+			g_io_channel_unref (ioc_stderr);
 
-		if (gsearch->is_locate_database_available == TRUE) {
-			locate_command_default_options = g_strdup ("-i");
-		}
-		else {
-			/* run locate again to check if it can find anything */
-			command = g_strconcat (locate, " /", NULL);
-			g_shell_parse_argv (command, NULL, &argv, NULL);
+			g_strfreev (argv);
 			g_free (command);
+			return;
+		}
 
-			gsearch->is_locate_database_check_finished = FALSE;
-			locate_command_default_options = g_strdup ("");
-
-			/* run locate command asynchronously because on some systems it can be slow */
-			if (g_spawn_async_with_pipes (g_get_home_dir (), argv, NULL,
-					       G_SPAWN_SEARCH_PATH, NULL, NULL,
-					       &locate_database_check_command_pid, NULL, &child_stdout,
-					       NULL, NULL)) {
-
-				ioc_stdout = g_io_channel_unix_new (child_stdout);
-				g_io_channel_set_encoding (ioc_stdout, NULL, NULL);
-				g_io_channel_set_flags (ioc_stdout, G_IO_FLAG_NONBLOCK, NULL);
-				g_io_add_watch (ioc_stdout, G_IO_IN | G_IO_HUP,
-						handle_locate_command_stdout_io, gsearch);
-				g_io_channel_unref (ioc_stdout);
-			}
-			else {
-				gsearch->is_locate_database_check_finished = TRUE;
-			}
-
-			g_strfreev (argv);
+		g_strfreev (argv);
+		g_free (command);
+		finish_search_probe_step (probe);
+	}
 
-			while (gsearch->is_locate_database_check_finished == FALSE) {
-				if (gtk_events_pending ()) {
-					while (gtk_events_pending ()) {
-						gtk_main_iteration ();
-					}
-				}
-			}
+	/* All probes are finished, hand over to the waiting search. */
+	search_probe_finished = TRUE;
+	search_probe = NULL;
 
-			if (gsearch->is_locate_database_available == FALSE) {
-				g_warning (_("A locate database has probably not been created."));
-			}
-		}
-	}
-	else {
-		/* locate is not installed */
-		locate_command_default_options = g_strdup ("");
-		gsearch->is_locate_database_available = FALSE;
-	}
-	g_free (grep_cmd);
-	g_free (locate);
+	probe->gsearch->is_locate_database_check_finished = TRUE;
+	search_command_probe_finished (probe->gsearch);
+	g_slice_free (GSearchProbe, probe);
 }
 
-static gchar *
-setup_find_name_options (gchar * file)
+static void
+probe_search_commands (GSearchWindow * gsearch)
 {
-	/* This function builds the name options for the find command.  This in
-	   done to insure that the find command returns hidden files and folders. */
+	/* search_command_probe_finished() is called once the probe results
+	   are available, which may be right away. */
+	if (search_probe_finished == TRUE) {
+		search_command_probe_finished (gsearch);
+		return;
+	}
 
-	GString * command;
-	command = g_string_new ("");
+	if (search_probe == NULL) {
+		search_probe = g_slice_new0 (GSearchProbe);
+		search_probe->gsearch = gsearch;
+		search_probe->step = SEARCH_PROBE_FIND_IGNORE_CASE;
 
-	if (strstr (file, "*") == NULL) {
+		gsearch->is_locate_database_check_finished = FALSE;
+		gsearch->is_locate_database_available = FALSE;
 
-		if ((strlen (file) == 0) || (file[0] != '.')) {
-	 		g_string_append_printf (command, "\\( %s \"*%s*\" -o %s \".*%s*\" \\) ",
-					find_command_default_name_argument, file,
-					find_command_default_name_argument, file);
-		}
-		else {
-			g_string_append_printf (command, "\\( %s \"*%s*\" -o %s \".*%s*\" -o %s \"%s*\" \\) ",
-					find_command_default_name_argument, file,
-					find_command_default_name_argument, file,
-					find_command_default_name_argument, file);
-		}
+		run_search_probe_step (search_probe);
 	}
 	else {
-		if (file[0] == '.') {
-			g_string_append_printf (command, "\\( %s \"%s\" -o %s \".*%s\" \\) ",
-					find_command_default_name_argument, file,
-					find_command_default_name_argument, file);
-		}
-		else if (file[0] != '*') {
-			g_string_append_printf (command, "%s \"%s\" ",
-					find_command_default_name_argument, file);
-		}
-		else {
-			if ((strlen (file) >= 1) && (file[1] == '.')) {
-				g_string_append_printf (command, "\\( %s \"%s\" -o %s \"%s\" \\) ",
-					find_command_default_name_argument, file,
-					find_command_default_name_argument, &file[1]);
-			}
-			else {
-				g_string_append_printf (command, "\\( %s \"%s\" -o %s \".%s\" \\) ",
-					find_command_default_name_argument, file,
-					find_command_default_name_argument, file);
-			}
-		}
+		search_probe->gsearch = gsearch;
 	}
-	return g_string_free (command, FALSE);
 }
 
 static gboolean
@@ -496,6 +639,28 @@ display_dialog_character_set_conversion_error (GtkWidget * window,
 	gtk_widget_show (dialog);
 }
 
+static void
+display_dialog_could_not_store_results (GtkWidget * window)
+{
+	GtkWidget * dialog;
+
+	dialog = gtk_message_dialog_new (GTK_WINDOW (window),
+	                                 GTK_DIALOG_DESTROY_WITH_PARENT,
+	                                 GTK_MESSAGE_ERROR,
+	                                 GTK_BUTTONS_OK,
+	                                 _("The search was stopped, no more results could be kept."));
+
+	gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+	                                          _("There is not enough disk space or memory left. "
+	                                            "The files found so far are still shown."), NULL);
+
+	g_signal_connect (G_OBJECT (dialog),
+	                  "response",
+	                   G_CALLBACK (gtk_widget_destroy), NULL);
+
+	gtk_widget_show (dialog);
+}
+
 static void
 start_animation (GSearchWindow * gsearch, gboolean first_pass)
 {
@@ -551,70 +716,395 @@ stop_animation (GSearchWindow * gsearch)
 	}
 }
 
-gchar *
-build_search_command (GSearchWindow * gsearch,
-                      gboolean first_pass)
+static GSearchRoot *
+new_search_root (GSearchWindow * gsearch,
+                 const gchar * folder)
 {
-	GString * command;
-	GError * error = NULL;
-	gchar * file_is_named_utf8;
-	gchar * file_is_named_locale;
-	gchar * file_is_named_escaped;
-	gchar * file_is_named_backslashed;
-	gchar * look_in_folder_locale;
-	gchar * look_in_folder_escaped;
-	gchar * look_in_folder_backslashed;
-
-	start_animation (gsearch, first_pass);
-	setup_case_insensitive_arguments (gsearch);
-
-	file_is_named_utf8 = g_strdup ((gchar *) gtk_entry_get_text (GTK_ENTRY (gsearch_history_entry_get_entry
-	                                         (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry)))));
+	GSearchRoot * root;
 
-	if (!file_is_named_utf8 || !*file_is_named_utf8) {
-		g_free (file_is_named_utf8);
-		file_is_named_utf8 = g_strdup ("*");
+	root = g_slice_new0 (GSearchRoot);
+	root->gsearch = gsearch;
+	if (g_str_has_suffix (folder, G_DIR_SEPARATOR_S)) {
+		root->folder = g_strdup (folder);
 	}
 	else {
-		gchar * locale;
-
-		locale = g_locale_from_utf8 (file_is_named_utf8, -1, NULL, NULL, &error);
-		if (locale == NULL) {
-			stop_animation (gsearch);
-			display_dialog_character_set_conversion_error (gsearch->window, file_is_named_utf8, error);
-			g_free (file_is_named_utf8);
-			g_error_free (error);
-			return NULL;
-		}
-		gsearch_history_entry_prepend_text (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry), file_is_named_utf8);
-
-		if ((strstr (locale, "*") == NULL) && (strstr (locale, "?") == NULL)) {
-			gchar *tmp;
+		root->folder = g_strconcat (folder, G_DIR_SEPARATOR_S, NULL);
+	}
+	return root;
+}
 
-			tmp = file_is_named_utf8;
-			file_is_named_utf8 = g_strconcat ("*", file_is_named_utf8, "*", NULL);
-			g_free (tmp);
-		}
+static void
+free_search_root (gpointer data)
+{
+	GSearchRoot * root = data;
 
-		g_free (locale);
+	if (root->database_source != 0) {
+		g_source_remove (root->database_source);
+	}
+	if (root->locate_cursor != NULL) {
+		gsearchtool_locate_cursor_free (root->locate_cursor);
 	}
+	if (root->index_cursor != NULL) {
+		gsearchtool_index_cursor_free (root->index_cursor);
+	}
+	g_free (root->folder);
+	g_free (root->command);
+	g_slice_free (GSearchRoot, root);
+}
 
-	file_is_named_locale = g_locale_from_utf8 (file_is_named_utf8, -1, NULL, NULL, &error);
-	if (file_is_named_locale == NULL) {
-		stop_animation (gsearch);
-		display_dialog_character_set_conversion_error (gsearch->window, file_is_named_utf8, error);
-		g_free (file_is_named_utf8);
-		g_error_free (error);
-		return NULL;
+/* The folder of the search comes first, then the ones of the "Also look
+   in folders" option.  A folder that is, or is inside, one of the others
+   would only find the same files again and is left out, unless it is on
+   another filesystem and the search does not cross filesystems. */
+static void
+set_search_roots (GSearchWindow * gsearch,
+                  const gchar * look_in_folder,
+                  const gchar * also_look_in_folders,
+                  gboolean is_crossing_filesystems)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+	GPtrArray * folders;
+	GPtrArray * real_folders;
+	dev_t * devices;
+	guint i;
+	guint j;
+
+	if (command_details->roots != NULL) {
+		g_ptr_array_free (command_details->roots, TRUE);
 	}
+	command_details->roots = g_ptr_array_new_with_free_func (free_search_root);
+	command_details->command_running_roots = 0;
+	command_details->command_open_error_pipes = 0;
 
-	look_in_folder_locale = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (gsearch->look_in_folder_button));
+	folders = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (folders, g_strdup (look_in_folder));
 
-	if (look_in_folder_locale == NULL) {
-		/* If for some reason a path was not returned fallback to the user's home directory. */
-		look_in_folder_locale = g_strdup (g_get_home_dir ());
-		gtk_file_chooser_set_current_folder (GTK_FILE_CHOOSER (gsearch->look_in_folder_button), look_in_folder_locale);
-	}
+	if (also_look_in_folders != NULL) {
+		gchar ** strv;
+
+		strv = g_strsplit (also_look_in_folders, G_SEARCHPATH_SEPARATOR_S, -1);
+		for (i = 0; strv[i] != NULL; i++) {
+			gchar * folder = g_strstrip (strv[i]);
+
+			if (*folder == '\0') {
+				continue;
+			}
+			/* The commands run in the home folder. */
+			if ((folder[0] == '~') && ((folder[1] == '\0') || (folder[1] == G_DIR_SEPARATOR))) {
+				g_ptr_array_add (folders, g_build_filename (g_get_home_dir (), folder + 1, NULL));
+			}
+			else if (g_path_is_absolute (folder) == FALSE) {
+				g_ptr_array_add (folders, g_build_filename (g_get_home_dir (), folder, NULL));
+			}
+			else {
+				g_ptr_array_add (folders, g_strdup (folder));
+			}
+		}
+		g_strfreev (strv);
+	}
+
+	real_folders = g_ptr_array_new_with_free_func (g_free);
+	devices = g_new0 (dev_t, folders->len);
+	for (i = 0; i < folders->len; i++) {
+		GStatBuf file_stat;
+		gchar * real;
+
+		real = realpath (g_ptr_array_index (folders, i), NULL);
+		if (real == NULL) {
+			real = g_strdup (g_ptr_array_index (folders, i));
+		}
+		if (g_str_has_suffix (real, G_DIR_SEPARATOR_S)) {
+			g_ptr_array_add (real_folders, g_strdup (real));
+		}
+		else {
+			g_ptr_array_add (real_folders, g_strconcat (real, G_DIR_SEPARATOR_S, NULL));
+		}
+		if (g_stat (real, &file_stat) == 0) {
+			devices[i] = file_stat.st_dev;
+		}
+		free (real);
+	}
+
+	for (i = 0; i < folders->len; i++) {
+		const gchar * inner = g_ptr_array_index (real_folders, i);
+		gboolean is_covered = FALSE;
+
+		for (j = 0; (j < folders->len) && (is_covered == FALSE); j++) {
+			const gchar * outer = g_ptr_array_index (real_folders, j);
+
+			if ((j == i) || (g_str_has_prefix (inner, outer) == FALSE)) {
+				continue;
+			}
+			if (strcmp (inner, outer) == 0) {
+				is_covered = (j < i);
+			}
+			else {
+				is_covered = (is_crossing_filesystems || (devices[i] == devices[j]));
+			}
+		}
+		if (is_covered == FALSE) {
+			GSearchRoot * root;
+
+			root = new_search_root (gsearch, g_ptr_array_index (folders, i));
+			root->device = devices[i];
+			g_ptr_array_add (command_details->roots, root);
+		}
+	}
+
+	/* The search folder itself may have been left out for another one. */
+	g_free (command_details->look_in_folder_string);
+	command_details->look_in_folder_string = g_strdup (((GSearchRoot *) g_ptr_array_index (command_details->roots, 0))->folder);
+
+	g_ptr_array_free (real_folders, TRUE);
+	g_ptr_array_free (folders, TRUE);
+	g_free (devices);
+}
+
+/* The pattern of -path is a glob, its special characters are matched
+   literally when backslashed. */
+static void
+append_glob_escaped (GString * pattern,
+                     const gchar * string)
+{
+	for (; *string != '\0'; string++) {
+		if (strchr ("\\*?[", *string) != NULL) {
+			g_string_append_c (pattern, '\\');
+		}
+		g_string_append_c (pattern, *string);
+	}
+}
+
+/* Returns the find arguments that prune the mount points inside the
+   @folder of a root which @policy says to skip, an empty string if
+   there are none.  The mount table has the real paths, find prints
+   them under @folder as it was given. */
+static gchar *
+get_pruned_mounts_argument (const gchar * folder,
+                            GPtrArray * mounts,
+                            const gchar * policy)
+{
+	GString * argument;
+	gchar ** skipped;
+	gchar * real_folder;
+	gsize length;
+	gint i;
+
+	real_folder = realpath (folder, NULL);
+	if ((mounts == NULL) || (real_folder == NULL)) {
+		free (real_folder);
+		return g_strdup ("");
+	}
+	skipped = gsearchtool_device_get_skipped_mounts (mounts, real_folder, policy);
+	length = strlen (real_folder);
+	if (length == 1) {
+		length = 0;
+	}
+	free (real_folder);
+
+	argument = g_string_new ("");
+	for (i = 0; skipped[i] != NULL; i++) {
+		GString * pattern;
+		gchar * quoted;
+
+		pattern = g_string_new ("");
+		append_glob_escaped (pattern, folder);
+		append_glob_escaped (pattern, skipped[i] + length + 1);
+		quoted = g_shell_quote (pattern->str);
+		g_string_append_printf (argument, "%s-path %s ", (i == 0) ? "\\( " : "-o ", quoted);
+		g_string_free (pattern, TRUE);
+		g_free (quoted);
+	}
+	if (argument->len > 0) {
+		g_string_append (argument, "\\) -prune -o ");
+	}
+	g_strfreev (skipped);
+
+	return g_string_free (argument, FALSE);
+}
+
+/* The locate program when the quick search may look in @folder with
+   it, or NULL. */
+static gchar *
+get_quick_search_locate (GSearchWindow * gsearch,
+                         const gchar * folder)
+{
+	if ((gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_quick_search") == TRUE) ||
+	    (gsearch->is_locate_database_available == FALSE) ||
+	    (is_quick_search_excluded_path (folder) == TRUE)) {
+		return NULL;
+	}
+	return g_find_program_in_path ("locate");
+}
+
+/* The locate database when it is one that can be read here, opened
+   again once updatedb has replaced it.  When none could be opened the
+   locate command is run for the rest of the session and the planner
+   does not know how large the database is. */
+static GSearchLocateDatabase *
+get_locate_database (void)
+{
+	static GSearchLocateDatabase * database = NULL;
+	static gboolean is_open_failed = FALSE;
+
+	if ((database != NULL) && (gsearchtool_locate_database_is_current (database) == FALSE)) {
+		gsearchtool_locate_database_unref (database);
+		database = NULL;
+	}
+	if ((database == NULL) && (is_open_failed == FALSE)) {
+		database = gsearchtool_locate_database_open_default ();
+		is_open_failed = (database == NULL);
+	}
+	return database;
+}
+
+/* The index made with --update-index, when the quick search may look in
+   @folder with it, it has the files in @folder and it is not older than
+   the search_index_max_age key allows. */
+static GSearchIndex *
+get_search_index (const gchar * folder)
+{
+	static GSearchIndex * search_index = NULL;
+	gint max_age;
+
+	if ((search_index != NULL) && (gsearchtool_index_is_current (search_index) == FALSE)) {
+		gsearchtool_index_unref (search_index);
+		search_index = NULL;
+	}
+	if ((gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_quick_search") == TRUE) ||
+	    (is_quick_search_excluded_path (folder) == TRUE)) {
+		return NULL;
+	}
+	if (search_index == NULL) {
+		gchar * path = gsearchtool_index_get_default_path ();
+
+		search_index = gsearchtool_index_open (path);
+		g_free (path);
+	}
+	if ((search_index == NULL) || (gsearchtool_index_covers (search_index, folder) == FALSE)) {
+		return NULL;
+	}
+	max_age = gsearchtool_gconf_get_int ("/apps/gnome-search-tool/search_index_max_age");
+	if ((max_age > 0) && (time (NULL) - gsearchtool_index_get_time (search_index) > (gint64) max_age * 3600)) {
+		return NULL;
+	}
+	return search_index;
+}
+
+/* Lets gsearchtool-planner.c choose how the first pass finds the files,
+   from what the folder and the locate database hold.  The entries are
+   counted in the mlocate database, other databases cannot be counted
+   and leave the search to walk the folders. */
+static void
+plan_search_command (GSearchWindow * gsearch,
+                     const gchar * name_pattern,
+                     GSearchPredicate * predicate,
+                     const gchar * folder,
+                     gboolean has_locate,
+                     GSearchIndex * search_index,
+                     gboolean is_walk_required)
+{
+	GSearchLocateDatabase * database = NULL;
+	GSearchPlanQuery query;
+
+	if (has_locate == TRUE) {
+		database = get_locate_database ();
+	}
+
+	query.name_pattern = name_pattern;
+	query.predicate = predicate;
+	query.has_locate = (has_locate == TRUE) || (search_index != NULL);
+	query.has_metadata = (search_index != NULL);
+	query.is_walk_required = is_walk_required;
+	query.folder_entries = gsearchtool_planner_estimate_folder_entries (folder, database);
+	if (search_index != NULL) {
+		query.database_entries = gsearchtool_index_get_entries (search_index);
+	}
+	else {
+		query.database_entries = (database != NULL) ? gsearchtool_locate_database_get_entries (database) : -1;
+	}
+	gsearchtool_planner_choose (&query, &gsearch->command_details->plan);
+}
+
+gboolean
+build_search_command (GSearchWindow * gsearch,
+                      gboolean first_pass)
+{
+	GString * command;
+	GError * error = NULL;
+	gchar * file_is_named_utf8;
+	gchar * file_is_named_locale;
+	gchar * file_is_named_escaped;
+	gchar * file_is_named_backslashed;
+	gchar * look_in_folder_locale;
+	gchar * look_in_folder_escaped;
+	gchar * look_in_folder_backslashed;
+	gchar * also_look_in_folders = NULL;
+	gchar * skipped_filesystems;
+	GSearchPredicate * predicate;
+	GSearchIndex * search_index = NULL;
+	GString * find_options;
+	GPtrArray * mounts = NULL;
+	gboolean disable_mount_argument = TRUE;
+	gboolean is_printing_paths = FALSE;
+	gboolean is_locate = FALSE;
+	guint i;
+
+	file_is_named_utf8 = g_strdup ((gchar *) gtk_entry_get_text (GTK_ENTRY (gsearch_history_entry_get_entry
+	                                         (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry)))));
+
+	if (!file_is_named_utf8 || !*file_is_named_utf8) {
+		g_free (file_is_named_utf8);
+		file_is_named_utf8 = g_strdup ("*");
+	}
+	else {
+		gchar * locale;
+
+		locale = g_locale_from_utf8 (file_is_named_utf8, -1, NULL, NULL, &error);
+		if (locale == NULL) {
+			display_dialog_character_set_conversion_error (gsearch->window, file_is_named_utf8, error);
+			g_free (file_is_named_utf8);
+			g_error_free (error);
+			return FALSE;
+		}
+		/* What is typed in the search as you type mode is not kept,
+		   most of it is only a part of the name looked for. */
+		if (gsearch->command_details->is_command_live == FALSE) {
+			gsearch_history_entry_prepend_text (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry), file_is_named_utf8);
+		}
+
+		if ((strstr (locale, "*") == NULL) && (strstr (locale, "?") == NULL)) {
+			gchar *tmp;
+
+			tmp = file_is_named_utf8;
+			file_is_named_utf8 = g_strconcat ("*", file_is_named_utf8, "*", NULL);
+			g_free (tmp);
+		}
+
+		g_free (locale);
+	}
+
+	file_is_named_locale = g_locale_from_utf8 (file_is_named_utf8, -1, NULL, NULL, &error);
+	if (file_is_named_locale == NULL) {
+		display_dialog_character_set_conversion_error (gsearch->window, file_is_named_utf8, error);
+		g_free (file_is_named_utf8);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_AND);
+	find_options = g_string_new ("");
+	skipped_filesystems = gsearchtool_gconf_get_string ("/apps/gnome-search-tool/skipped_filesystems");
+	if (skipped_filesystems == NULL) {
+		skipped_filesystems = g_strdup (GNOME_SEARCH_TOOL_DEFAULT_SKIPPED_FILESYSTEMS);
+	}
+
+	look_in_folder_locale = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (gsearch->look_in_folder_button));
+
+	if (look_in_folder_locale == NULL) {
+		/* If for some reason a path was not returned fallback to the user's home directory. */
+		look_in_folder_locale = g_strdup (g_get_home_dir ());
+		gtk_file_chooser_set_current_folder (GTK_FILE_CHOOSER (gsearch->look_in_folder_button), look_in_folder_locale);
+	}
 
 	if (!g_str_has_suffix (look_in_folder_locale, G_DIR_SEPARATOR_S)) {
 		gchar *tmp;
@@ -631,13 +1121,28 @@ build_search_command (GSearchWindow * gsearch,
 
 	command = g_string_new ("");
 	gsearch->command_details->is_command_show_hidden_files_enabled = FALSE;
+	gsearch->command_details->is_command_regex_matching_enabled = FALSE;
+	gsearch->command_details->is_command_printing_file_details = FALSE;
+	gsearch->command_details->is_command_disk_usage_enabled = FALSE;
+	gsearch->command_details->is_command_count_only_enabled = FALSE;
+	gsearch->command_details->is_command_finding_duplicates = FALSE;
+	gsearch->command_details->is_command_decompress_enabled = FALSE;
+	gsearch->command_details->is_command_member_names_enabled = FALSE;
+	gsearch->command_details->top_count = 0;
+	g_free (gsearch->command_details->name_contains_regex_string);
 	gsearch->command_details->name_contains_regex_string = NULL;
-	gsearch->search_results_date_format_string = NULL;
+	g_free (gsearch->command_details->name_contains_pattern_string);
 	gsearch->command_details->name_contains_pattern_string = NULL;
+	g_free (gsearch->command_details->content_any_words_string);
+	gsearch->command_details->content_any_words_string = NULL;
+	g_free (gsearch->command_details->content_all_words_string);
+	gsearch->command_details->content_all_words_string = NULL;
 
+	gsearch->command_details->is_command_stating_candidates = FALSE;
 	gsearch->command_details->is_command_first_pass = first_pass;
 	if (gsearch->command_details->is_command_first_pass == TRUE) {
 		gsearch->command_details->is_command_using_quick_mode = FALSE;
+		gsearch->command_details->plan.kind = GSEARCH_PLAN_WALK;
 	}
 
 	if ((gtk_widget_get_visible (gsearch->available_options_vbox) == FALSE) ||
@@ -651,10 +1156,10 @@ build_search_command (GSearchWindow * gsearch,
 
 			gchar * locate;
 			gchar * show_thumbnails_string;
-			gboolean disable_quick_search;
 
-			locate = g_find_program_in_path ("locate");
-			disable_quick_search = gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_quick_search");
+			locate = get_quick_search_locate (gsearch, look_in_folder_locale);
+			search_index = get_search_index (look_in_folder_locale);
+			plan_search_command (gsearch, file_is_named_locale, NULL, look_in_folder_locale, (locate != NULL), search_index, FALSE);
 			gsearch->command_details->is_command_second_pass_enabled = !gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_quick_search_second_scan");
 
 			show_thumbnails_string = gsearchtool_gconf_get_string ("/apps/nautilus/preferences/show_image_thumbnails");
@@ -673,45 +1178,46 @@ build_search_command (GSearchWindow * gsearch,
 				gsearch->show_thumbnails_file_size_limit = 0;
 			}
 
-			if ((disable_quick_search == FALSE)
-			    && (gsearch->is_locate_database_available == TRUE)
-			    && (locate != NULL)
-			    && (is_quick_search_excluded_path (look_in_folder_locale) == FALSE)) {
+			if (gsearch->command_details->plan.kind == GSEARCH_PLAN_LOCATE) {
 
+				if (search_index == NULL) {
 					g_string_append_printf (command, "%s %s \"%s*%s\"",
 							locate,
 							locate_command_default_options,
 							look_in_folder_escaped,
 							file_is_named_escaped);
-					gsearch->command_details->is_command_using_quick_mode = TRUE;
+				}
+				gsearch->command_details->is_command_using_quick_mode = TRUE;
+				is_locate = TRUE;
 			}
 			else {
-				g_string_append_printf (command, "find \"%s\" %s \"%s\" -print",
-							look_in_folder_escaped,
+				g_string_append_printf (command, "%s \"%s\" ",
 							find_command_default_name_argument,
 							file_is_named_escaped);
+				is_printing_paths = TRUE;
 			}
 			g_free (locate);
 			g_free (show_thumbnails_string);
 		}
 		else {
-			g_string_append_printf (command, "find \"%s\" %s \"%s\" -print",
-						look_in_folder_escaped,
+			g_string_append_printf (command, "%s \"%s\" ",
 						find_command_default_name_argument,
 						file_is_named_escaped);
+			is_printing_paths = TRUE;
 		}
 	}
 	else {
 		GList * list;
-		gboolean disable_mount_argument = TRUE;
+		gchar * find_name_options;
+		gchar * predicate_arguments;
 
 		gsearch->command_details->is_command_regex_matching_enabled = FALSE;
 		file_is_named_backslashed = backslash_backslash_characters (file_is_named_locale);
 		file_is_named_escaped = escape_double_quotes (file_is_named_backslashed);
+		find_name_options = setup_find_name_options (find_command_default_name_argument, file_is_named_escaped);
 
-		g_string_append_printf (command, "find \"%s\" %s",
-					look_in_folder_escaped,
-					setup_find_name_options (file_is_named_escaped));
+		g_string_append (command, find_name_options);
+		g_free (find_name_options);
 
 		for (list = gsearch->available_options_selected_list; list != NULL; list = g_list_next (list)) {
 
@@ -725,9 +1231,32 @@ build_search_command (GSearchWindow * gsearch,
 				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "SHOW_HIDDEN_FILES") == 0) {
 					gsearch->command_details->is_command_show_hidden_files_enabled = TRUE;
 				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "DISK_USAGE_BY_FOLDER") == 0) {
+					gsearch->command_details->is_command_disk_usage_enabled = TRUE;
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "COUNT_ONLY") == 0) {
+					gsearch->command_details->is_command_count_only_enabled = TRUE;
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "FIND_DUPLICATES") == 0) {
+					gsearch->command_details->is_command_finding_duplicates = TRUE;
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "SEARCH_COMPRESSED_FILES") == 0) {
+					gsearch->command_details->is_command_decompress_enabled = TRUE;
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "MATCH_ARCHIVE_MEMBER_NAMES") == 0) {
+					gsearch->command_details->is_command_member_names_enabled = TRUE;
+				}
+				else if (constraint->constraint_id == SEARCH_CONSTRAINT_FILE_IS_EMPTY) {
+					gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_EMPTY));
+				}
+				else if (constraint->constraint_id == SEARCH_CONSTRAINT_OWNER_IS_UNRECOGNIZED) {
+					gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_NO_OWNER));
+				}
 				else {
 					g_string_append_printf (command, "%s ",
 						GSearchOptionTemplates[constraint->constraint_id].option);
+					g_string_append_printf (find_options, "%s ",
+						GSearchOptionTemplates[constraint->constraint_id].option);
 				}
 				break;
 			case SEARCH_CONSTRAINT_TYPE_TEXT:
@@ -747,6 +1276,59 @@ build_search_command (GSearchWindow * gsearch,
 					g_free (escaped);
 					g_free (regex);
 				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "CONTAINS_ANY_OF_THE_WORDS") == 0) {
+					g_free (gsearch->command_details->content_any_words_string);
+					gsearch->command_details->content_any_words_string = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "CONTAINS_ALL_OF_THE_WORDS") == 0) {
+					g_free (gsearch->command_details->content_all_words_string);
+					gsearch->command_details->content_all_words_string = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "ALSO_LOOK_IN_FOLDERS") == 0) {
+					g_free (also_look_in_folders);
+					also_look_in_folders = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "SKIP_FILESYSTEMS") == 0) {
+					g_free (skipped_filesystems);
+					skipped_filesystems = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				}
+				else if ((constraint->constraint_id == SEARCH_CONSTRAINT_OWNED_BY_USER) ||
+				         (constraint->constraint_id == SEARCH_CONSTRAINT_OWNED_BY_GROUP)) {
+					gchar * locale;
+
+					/* The name is looked up once here, find is given
+					   the id. */
+					locale = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+					if ((locale != NULL) && (strlen (locale) != 0)) {
+						gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_text (
+							(constraint->constraint_id == SEARCH_CONSTRAINT_OWNED_BY_USER) ?
+							GSEARCH_PREDICATE_USER : GSEARCH_PREDICATE_GROUP, locale));
+					}
+					g_free (locale);
+				}
+				else if (constraint->constraint_id == SEARCH_CONSTRAINT_FILE_IS_NOT_NAMED) {
+					gchar * backslashed;
+					gchar * locale;
+
+					backslashed = backslash_special_characters (constraint->data.text);
+					locale = g_locale_from_utf8 (backslashed, -1, NULL, NULL, NULL);
+					if ((locale != NULL) && (strlen (locale) != 0)) {
+						GSearchPredicateKind name_kind = GSEARCH_PREDICATE_NAME;
+						GSearchPredicate * not_named;
+						gchar * pattern;
+
+						if (strcmp (find_command_default_name_argument, "-iname") == 0) {
+							name_kind = GSEARCH_PREDICATE_INAME;
+						}
+						pattern = g_strconcat ("*", locale, "*", NULL);
+						not_named = gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT);
+						gsearchtool_predicate_add (not_named, gsearchtool_predicate_new_text (name_kind, pattern));
+						gsearchtool_predicate_add (predicate, not_named);
+						g_free (pattern);
+					}
+					g_free (backslashed);
+					g_free (locale);
+				}
 				else {
 					gchar * escaped;
 					gchar * backslashed;
@@ -757,12 +1339,14 @@ build_search_command (GSearchWindow * gsearch,
 
 					locale = g_locale_from_utf8 (escaped, -1, NULL, NULL, NULL);
 
-					if (strlen (locale) != 0) {
-						g_string_append_printf (command,
-							  	        GSearchOptionTemplates[constraint->constraint_id].option,
-						  		        locale);
+					if ((locale != NULL) && (strlen (locale) != 0)) {
+						gchar * test;
 
-						g_string_append_c (command, ' ');
+						/* The grep of the file contents is left to
+						   find, after all the other tests. */
+						test = g_strdup_printf (GSearchOptionTemplates[constraint->constraint_id].option, locale);
+						gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_text (GSEARCH_PREDICATE_FIND_TEST, test));
+						g_free (test);
 					}
 
 					g_free (escaped);
@@ -771,174 +1355,824 @@ build_search_command (GSearchWindow * gsearch,
 				}
 				break;
 			case SEARCH_CONSTRAINT_TYPE_NUMERIC:
-				g_string_append_printf (command,
-					  		GSearchOptionTemplates[constraint->constraint_id].option,
-							(constraint->data.number * 1024),
-					  		(constraint->data.number * 1024));
-				g_string_append_c (command, ' ');
+				if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "TOP_LARGEST_FILES") == 0) {
+					gsearch->command_details->top_kind = GSEARCH_TOPK_LARGEST;
+					gsearch->command_details->top_count = constraint->data.number;
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "TOP_NEWEST_FILES") == 0) {
+					gsearch->command_details->top_kind = GSEARCH_TOPK_NEWEST;
+					gsearch->command_details->top_count = constraint->data.number;
+				}
+				else if (strcmp (GSearchOptionTemplates[constraint->constraint_id].option, "TOP_OLDEST_FILES") == 0) {
+					gsearch->command_details->top_kind = GSEARCH_TOPK_OLDEST;
+					gsearch->command_details->top_count = constraint->data.number;
+				}
+				else {
+					gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (
+						(constraint->constraint_id == SEARCH_CONSTRAINT_SIZE_IS_MORE_THAN) ?
+						GSEARCH_PREDICATE_SIZE_AT_LEAST : GSEARCH_PREDICATE_SIZE_AT_MOST,
+						(gint64) constraint->data.number * 1024));
+				}
 				break;
 			case SEARCH_CONSTRAINT_TYPE_DATE_BEFORE:
-				g_string_append_printf (command,
-					 		GSearchOptionTemplates[constraint->constraint_id].option,
-					  		constraint->data.time);
-				g_string_append_c (command, ' ');
+				gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_WITHIN,
+				                                                                        constraint->data.time));
 				break;
 			case SEARCH_CONSTRAINT_TYPE_DATE_AFTER:
-				g_string_append_printf (command,
-					 		GSearchOptionTemplates[constraint->constraint_id].option,
-					  		constraint->data.time,
-					  		constraint->data.time);
-				g_string_append_c (command, ' ');
+				gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_BEFORE,
+				                                                                        constraint->data.time));
 				break;
 			default:
 		        	break;
 			}
 		}
-		gsearch->command_details->name_contains_pattern_string = g_strdup ("*");
 
-		if (disable_mount_argument != TRUE) {
-			g_string_append (command, "-xdev ");
+		/* The words are looked for in process, see add_matching_file(),
+		   only the duplicates and the largest, newest or oldest among
+		   the regular files, and the disk usage of all but the folders. */
+		if ((gsearch->command_details->content_any_words_string != NULL) ||
+		    (gsearch->command_details->content_all_words_string != NULL) ||
+		    ((gsearch->command_details->is_command_count_only_enabled == FALSE) &&
+		     ((gsearch->command_details->is_command_finding_duplicates == TRUE) ||
+		      (gsearch->command_details->top_count > 0)))) {
+			gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_REGULAR));
+		}
+		else if ((gsearch->command_details->is_command_count_only_enabled == FALSE) &&
+		         (gsearch->command_details->is_command_disk_usage_enabled == TRUE)) {
+			GSearchPredicate * not_directory;
+
+			not_directory = gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT);
+			gsearchtool_predicate_add (not_directory, gsearchtool_predicate_new (GSEARCH_PREDICATE_DIRECTORY));
+			gsearchtool_predicate_add (predicate, not_directory);
+		}
+
+		/* The tests run the cheapest and most decisive first, not in
+		   the order the constraints were added in. */
+		gsearchtool_predicate_optimize (predicate);
+
+		/* locate only has the names, the other tests are run on a stat
+		   of each file it finds, see flush_search_candidates().  The
+		   options find runs itself and the sizes and dates the disk
+		   usage and ranking take from find leave it to find. */
+		if (gsearch->command_details->is_command_first_pass == TRUE) {
+			gchar * locate;
+
+			locate = get_quick_search_locate (gsearch, look_in_folder_locale);
+			search_index = get_search_index (look_in_folder_locale);
+			plan_search_command (gsearch, file_is_named_locale, predicate, look_in_folder_locale, (locate != NULL), search_index,
+			                     (also_look_in_folders != NULL) ||
+			                     (disable_mount_argument == FALSE) ||
+			                     (find_options->len > 0) ||
+			                     (gsearch->command_details->is_command_disk_usage_enabled == TRUE) ||
+			                     (gsearch->command_details->top_count > 0));
+
+			if (gsearch->command_details->plan.kind == GSEARCH_PLAN_LOCATE_THEN_STAT) {
+				if (search_index == NULL) {
+					g_string_printf (command, "%s %s \"%s*%s\"",
+					                 locate,
+					                 locate_command_default_options,
+					                 look_in_folder_escaped,
+					                 file_is_named_escaped);
+				}
+				else {
+					g_string_truncate (command, 0);
+				}
+				gsearch->command_details->is_command_second_pass_enabled = !gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_quick_search_second_scan");
+				gsearch->command_details->is_command_using_quick_mode = TRUE;
+				gsearch->command_details->is_command_stating_candidates = TRUE;
+				is_locate = TRUE;
+			}
+			g_free (locate);
+		}
+
+		if (gsearch->command_details->is_command_stating_candidates == TRUE) {
+			gsearch->command_details->name_contains_pattern_string = g_strdup (file_is_named_utf8);
+		}
+		else {
+			gsearch->command_details->name_contains_pattern_string = g_strdup ("*");
+
+			predicate_arguments = gsearchtool_predicate_to_find_arguments (predicate);
+			g_string_append (command, predicate_arguments);
+			g_free (predicate_arguments);
+
+			if (disable_mount_argument != TRUE) {
+				g_string_append (command, "-xdev ");
+			}
+		}
+
+		if (is_locate == TRUE) {
+			/* The locate command prints the paths itself. */
+		}
+		else if (gsearch->command_details->is_command_count_only_enabled == TRUE) {
+			g_string_append (command, "-print ");
+		}
+		else if (gsearch->command_details->is_command_finding_duplicates == TRUE) {
+			/* The device and inode numbers are needed too, each
+			   file gets an lstat in add_matching_file(). */
+			g_string_append (command, "-print ");
+		}
+		else if ((gsearch->command_details->is_command_disk_usage_enabled == TRUE) ||
+		         (gsearch->command_details->top_count > 0)) {
+			/* The files are only summed up or ranked, find reports the
+			   size and date of each one so they never need a stat. */
+			if (find_command_has_printf_argument == TRUE) {
+				gsearch->command_details->is_command_printing_file_details = TRUE;
+				g_string_append (command, "-printf '%s %T@ %p\\n' ");
+			}
+			else {
+				g_string_append (command, "-print ");
+			}
+		}
+		else {
+			is_printing_paths = TRUE;
 		}
+	}
 
-		g_string_append (command, "-print ");
+	/* Everything but the name and the tests has to stay the same for a
+	   search to be a refinement of the one before. */
+	if (gsearch->command_details->is_command_first_pass == TRUE) {
+		GSearchCommandDetails * details = gsearch->command_details;
+
+		g_free (details->query_name_pattern);
+		g_free (details->query_key);
+		details->query_name_pattern = g_strdup (file_is_named_utf8);
+		details->query_key = g_strdup_printf ("%s\n%s\n%s\n%s\n%s\n%s\n%s\n%d %d %d %d %d %d %d %d %u",
+		                                      look_in_folder_locale,
+		                                      (also_look_in_folders != NULL) ? also_look_in_folders : "",
+		                                      skipped_filesystems,
+		                                      find_options->str,
+		                                      (details->name_contains_regex_string != NULL) ? details->name_contains_regex_string : "",
+		                                      (details->content_any_words_string != NULL) ? details->content_any_words_string : "",
+		                                      (details->content_all_words_string != NULL) ? details->content_all_words_string : "",
+		                                      disable_mount_argument,
+		                                      details->is_command_show_hidden_files_enabled,
+		                                      details->is_command_disk_usage_enabled,
+		                                      details->is_command_count_only_enabled,
+		                                      details->is_command_finding_duplicates,
+		                                      details->is_command_decompress_enabled,
+		                                      details->is_command_member_names_enabled,
+		                                      details->top_kind,
+		                                      details->top_count);
 	}
+	g_string_free (find_options, TRUE);
+
 	g_free (file_is_named_locale);
 	g_free (file_is_named_utf8);
 	g_free (file_is_named_backslashed);
 	g_free (file_is_named_escaped);
+
+	/* Hidden files are left out of the results, see
+	   add_search_command_output_line(), so find need not go in the
+	   hidden folders at all. */
+	if (gsearch->command_details->is_command_show_hidden_files_enabled == FALSE) {
+		gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT_HIDDEN));
+	}
+
+	if (gsearch->command_details->locate_database != NULL) {
+		gsearchtool_locate_database_unref (gsearch->command_details->locate_database);
+		gsearch->command_details->locate_database = NULL;
+	}
+	if (gsearch->command_details->search_index != NULL) {
+		gsearchtool_index_unref (gsearch->command_details->search_index);
+		gsearch->command_details->search_index = NULL;
+	}
+	if ((is_locate == TRUE) && (search_index != NULL)) {
+		gsearch->command_details->search_index = gsearchtool_index_ref (search_index);
+	}
+	else if ((is_locate == TRUE) &&
+	         (gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_locate_database_reader") == FALSE)) {
+		GSearchLocateDatabase * database = get_locate_database ();
+
+		if (database != NULL) {
+			gsearch->command_details->locate_database = gsearchtool_locate_database_ref (database);
+		}
+	}
+
+	/* Each folder gets its own command, a locate command already looks
+	   in the only one. */
+	set_search_roots (gsearch, look_in_folder_locale, also_look_in_folders, disable_mount_argument);
+	if (is_locate == FALSE) {
+		mounts = gsearchtool_device_read_mounts ("/proc/self/mountinfo");
+	}
+	for (i = 0; i < gsearch->command_details->roots->len; i++) {
+		GSearchRoot * root = g_ptr_array_index (gsearch->command_details->roots, i);
+
+		if (is_locate == TRUE) {
+			root->command = g_strdup (command->str);
+		}
+		else {
+			gchar * backslashed;
+			gchar * escaped;
+			gchar * pruned;
+			gchar * hidden_pruned;
+
+			/* On a spinning disk find also prints the inode numbers,
+			   which it has from the folders without a stat, and the
+			   files are read in their order. */
+			root->is_printing_inodes = (is_printing_paths == TRUE) &&
+			                           (find_command_has_printf_argument == TRUE) &&
+			                           gsearchtool_device_is_inode_ordered (gsearchtool_device_get_kind (root->device));
+
+			backslashed = backslash_backslash_characters (root->folder);
+			escaped = escape_double_quotes (backslashed);
+			pruned = get_pruned_mounts_argument (root->folder, mounts, skipped_filesystems);
+			hidden_pruned = gsearchtool_predicate_to_find_prune_arguments (predicate, root->folder);
+			root->command = g_strdup_printf ("find \"%s\" %s%s%s%s", escaped, pruned, hidden_pruned, command->str,
+			                                 (root->is_printing_inodes == TRUE) ? "-printf '%i %p\\n'" :
+			                                 (is_printing_paths == TRUE) ? "-print" : "");
+			g_free (backslashed);
+			g_free (escaped);
+			g_free (pruned);
+			g_free (hidden_pruned);
+		}
+	}
+	gsearchtool_predicate_free (gsearch->command_details->predicate);
+	gsearch->command_details->predicate = predicate;
+	if (mounts != NULL) {
+		g_ptr_array_free (mounts, TRUE);
+	}
+	g_free (skipped_filesystems);
+	g_free (also_look_in_folders);
 	g_free (look_in_folder_locale);
 	g_free (look_in_folder_backslashed);
 	g_free (look_in_folder_escaped);
+	g_string_free (command, TRUE);
 
-	return g_string_free (command, FALSE);
+	return TRUE;
 }
 
+/* Takes @folder, which it frees. */
 static void
-add_file_to_search_results (const gchar * file,
-			    GtkListStore * store,
-			    GtkTreeIter * iter,
-			    GSearchWindow * gsearch)
+watch_folder (GSearchWindow * gsearch,
+              gchar * folder)
 {
-	GdkPixbuf * pixbuf;
-	GSearchMonitor * monitor;
 	GFileMonitor * handle;
-	GFileInfo * file_info;
-	GFile * g_file;
-	GError * error = NULL;
-	GTimeVal time_val;
-	GtkTreePath * path;
-	GtkTreeRowReference * reference;
-	gchar * description;
-	gchar * readable_size;
-	gchar * readable_date;
-	gchar * utf8_base_name;
-	gchar * utf8_relative_dir_name;
-	gchar * base_name;
-	gchar * dir_name;
-	gchar * relative_dir_name;
-	gchar * look_in_folder;
-
-	if (g_hash_table_lookup_extended (gsearch->search_results_filename_hash_table, file, NULL, NULL) == TRUE) {
+	GFile * g_folder;
+
+	if (g_hash_table_lookup_extended (gsearch->search_results_monitor_hash_table, folder, NULL, NULL) == TRUE) {
+		g_free (folder);
 		return;
 	}
 
-	if ((g_file_test (file, G_FILE_TEST_EXISTS) != TRUE) &&
-	    (g_file_test (file, G_FILE_TEST_IS_SYMLINK) != TRUE)) {
+	g_folder = g_file_new_for_path (folder);
+	handle = g_file_monitor_directory (g_folder, G_FILE_MONITOR_NONE, NULL, NULL);
+	g_object_unref (g_folder);
+
+	if (handle != NULL) {
+		g_signal_connect (handle, "changed",
+				  G_CALLBACK (file_changed_cb), gsearch);
+	}
+	/* A folder that cannot be watched is not tried again. */
+	g_hash_table_insert (gsearch->search_results_monitor_hash_table, folder, handle);
+}
+
+static void
+add_folder_monitor (GSearchWindow * gsearch,
+                    const gchar * file)
+{
+	/* The results are watched through their folders, and only up to a
+	   point, so that a large search does not hold a monitor per file. */
+	if (g_hash_table_size (gsearch->search_results_monitor_hash_table) >= MAX_FOLDER_MONITORS) {
 		return;
 	}
+	watch_folder (gsearch, g_path_get_dirname (file));
+}
 
-	g_hash_table_insert (gsearch->search_results_filename_hash_table, g_strdup (file), NULL);
+static void
+free_folder_monitor (gpointer data)
+{
+	GFileMonitor * handle = data;
 
-	if (gtk_tree_view_get_headers_visible (GTK_TREE_VIEW (gsearch->search_results_tree_view)) == FALSE) {
-		gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (gsearch->search_results_tree_view), TRUE);
+	if (handle != NULL) {
+		g_file_monitor_cancel (handle);
+		g_object_unref (handle);
 	}
-	
-	g_file = g_file_new_for_path (file);
-	file_info = g_file_query_info (g_file, "standard::*,time::modified,thumbnail::path", 0, NULL, NULL);
-
-	pixbuf = get_file_pixbuf (gsearch, file_info);
-	description = get_file_type_description (file, file_info);
-	readable_size = g_format_size (g_file_info_get_size (file_info));
+}
 
-	g_file_info_get_modification_time (file_info, &time_val);
-	readable_date = get_readable_date (gsearch->search_results_date_format_string, time_val.tv_sec); 
+static GdkPixbuf *
+get_search_result_pixbuf (GFileInfo * file_info,
+                          gpointer data)
+{
+	return get_file_pixbuf (data, file_info);
+}
 
-	base_name = g_path_get_basename (file);
-	dir_name = g_path_get_dirname (file);
+/* Looks the content type of @file up from its name, and only reads the
+   start of the file when the name does not tell. */
+static gchar *
+get_content_type (GSearchWindow * gsearch,
+                  const gchar * file,
+                  GSearchIoStat * file_stat)
+{
+	gchar * content_type;
+	gboolean is_uncertain = FALSE;
 
-	look_in_folder = g_strdup (gsearch->command_details->look_in_folder_string);
-	if (strlen (look_in_folder) > 1) {
-		gchar * path_str;
+	if (S_ISDIR (file_stat->mode)) {
+		return g_strdup ("inode/directory");
+	}
 
-		if (g_str_has_suffix (look_in_folder, G_DIR_SEPARATOR_S) == TRUE) {
-			look_in_folder[strlen (look_in_folder) - 1] = '\0';
+	content_type = g_content_type_guess (file, NULL, 0, &is_uncertain);
+	if (is_uncertain == TRUE && file_stat->size > 0) {
+		GFileInfo * file_info;
+		GFile * g_file;
+
+		g_file = g_file_new_for_path (file);
+		file_info = g_file_query_info (g_file, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE, 0, NULL, NULL);
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_STAT_CALLS, 1);
+		if (file_info != NULL && g_file_info_get_content_type (file_info) != NULL) {
+			g_free (content_type);
+			content_type = g_strdup (g_file_info_get_content_type (file_info));
 		}
-		path_str = g_path_get_dirname (look_in_folder);
-		if (strcmp (path_str, G_DIR_SEPARATOR_S) == 0) {
-			relative_dir_name = g_strconcat (&dir_name[strlen (path_str)], NULL);
+		if (file_info != NULL) {
+			g_object_unref (file_info);
 		}
-		else {
-			relative_dir_name = g_strconcat (&dir_name[strlen (path_str) + 1], NULL);
-		}
-		g_free (path_str);
+		g_object_unref (g_file);
 	}
-	else {
-		relative_dir_name = g_strdup (dir_name);
-	}
-
-	utf8_base_name = g_filename_display_basename (file);
-	utf8_relative_dir_name = g_filename_display_name (relative_dir_name);
-
-	gtk_list_store_append (GTK_LIST_STORE (store), iter);
-	gtk_list_store_set (GTK_LIST_STORE (store), iter,
-			    COLUMN_ICON, pixbuf,
-			    COLUMN_NAME, utf8_base_name,
-			    COLUMN_RELATIVE_PATH, utf8_relative_dir_name,
-			    COLUMN_LOCALE_FILE, file,
-			    COLUMN_READABLE_SIZE, readable_size,
-			    COLUMN_SIZE, (-1) * (gdouble) g_file_info_get_size(file_info),
-			    COLUMN_TYPE, (description != NULL) ? description : g_strdup (g_file_info_get_content_type (file_info)),
-			    COLUMN_READABLE_DATE, readable_date,
-			    COLUMN_DATE, (-1) * (gdouble) time_val.tv_sec,
-			    COLUMN_NO_FILES_FOUND, FALSE,
-			    -1);
-
-	monitor = g_slice_new0 (GSearchMonitor);
-	if (monitor) {
-		path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), iter);
-		reference = gtk_tree_row_reference_new (GTK_TREE_MODEL (store), path);
-		gtk_tree_path_free (path);
+	return content_type;
+}
+
+static gint
+compare_pending_inodes (gconstpointer a,
+                        gconstpointer b,
+                        gpointer data)
+{
+	GSearchPendingFile * files = data;
+	guint64 inode_a = files[*(const guint *) a].inode;
+	guint64 inode_b = files[*(const guint *) b].inode;
+
+	return (inode_a < inode_b) ? -1 : (inode_a > inode_b);
+}
+
+static void
+clear_pending_file (GSearchPendingFile * pending_file)
+{
+	g_free (pending_file->path);
+}
+
+/* Adds the files waiting in search_results_pending, stating them all at
+   once through gsearchtool-io.c.  The stats go in the order of the inode
+   numbers that are known, the results stay in the order they were found. */
+static void
+flush_search_results (GSearchWindow * gsearch)
+{
+	GArray * pending = gsearch->search_results_pending;
+	GSearchPendingFile * files;
+	GSearchIoStat * sorted_stats;
+	GSearchIoStat * stats;
+	const gchar ** paths;
+	gboolean is_stored;
+	guint * order;
+	guint idx;
+
+	if (pending == NULL || pending->len == 0) {
+		return;
+	}
+	files = (GSearchPendingFile *) pending->data;
+
+	gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+	order = g_new (guint, pending->len);
+	for (idx = 0; idx < pending->len; idx++) {
+		order[idx] = idx;
+	}
+	g_qsort_with_data (order, pending->len, sizeof (guint), compare_pending_inodes, files);
 
-		handle = g_file_monitor_file (g_file, G_FILE_MONITOR_EVENT_DELETED, NULL, &error);
+	paths = g_new (const gchar *, pending->len);
+	for (idx = 0; idx < pending->len; idx++) {
+		paths[idx] = files[order[idx]].path;
+	}
+	sorted_stats = g_new (GSearchIoStat, pending->len);
+	gsearchtool_io_stat_files (paths, pending->len, sorted_stats);
+	gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_STAT_CALLS, pending->len);
+
+	stats = g_new (GSearchIoStat, pending->len);
+	for (idx = 0; idx < pending->len; idx++) {
+		stats[order[idx]] = sorted_stats[idx];
+	}
+	g_free (sorted_stats);
+	g_free (paths);
+	g_free (order);
+	gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+
+	for (idx = 0; idx < pending->len; idx++) {
+		const gchar * file = files[idx].path;
+		GFileInfo * file_info;
+		GTimeVal mtime;
+		gchar * content_type;
+
+		if (stats[idx].error != 0) {
+			continue;
+		}
+		/* The same file may have been queued twice. */
+		if (gsearch_results_model_contains (gsearch->search_results_model, file) == TRUE) {
+			gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_DEDUP_DROPPED, 1);
+			continue;
+		}
+
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_MATCHES, 1);
+		gsearchtool_stats_first_result (gsearch->search_stats);
+
+		if (GSearchGOptionArguments.batch) {
+			const gchar * hits = NULL;
+
+			if (gsearch->search_results_content_hits != NULL) {
+				hits = g_hash_table_lookup (gsearch->search_results_content_hits, file);
+			}
+			if (hits != NULL) {
+				g_print ("%s\t%s\n", file, hits);
+			}
+			else {
+				g_print ("%s\n", file);
+			}
+		}
 
-		if (error == NULL) {
-			monitor->gsearch = gsearch;
-			monitor->reference = reference;
-			monitor->handle = handle;
-			gtk_list_store_set (GTK_LIST_STORE (store), iter,
-			                    COLUMN_MONITOR, monitor, -1);
+		if (gtk_tree_view_get_headers_visible (GTK_TREE_VIEW (gsearch->search_results_tree_view)) == FALSE) {
+			gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (gsearch->search_results_tree_view), TRUE);
+		}
 
-			g_signal_connect (handle, "changed",
-					  G_CALLBACK (file_changed_cb), monitor);
+		/* Only what the store keeps is filled in here; the icon and the
+		   type description are looked up when the row is shown. */
+		gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+		content_type = get_content_type (gsearch, file, &stats[idx]);
+		gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+
+		file_info = g_file_info_new ();
+		g_file_info_set_content_type (file_info, content_type);
+		g_file_info_set_size (file_info, stats[idx].size);
+		mtime.tv_sec = stats[idx].mtime;
+		mtime.tv_usec = 0;
+		g_file_info_set_modification_time (file_info, &mtime);
+		g_free (content_type);
+
+		gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_UI_INSERTION);
+		is_stored = gsearch_results_model_append (gsearch->search_results_model, file, file_info);
+		if (is_stored == TRUE) {
+			add_folder_monitor (gsearch, file);
 		}
-		else {
-			gtk_tree_row_reference_free (reference);
-			g_slice_free (GSearchMonitor, monitor);
-			g_clear_error (&error);
+		gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_UI_INSERTION);
+
+		g_object_unref (file_info);
+
+		if (is_stored == FALSE) {
+			if (gsearch->command_details->command_status == RUNNING) {
+				stop_search_command (gsearch, MAKE_IT_STOP);
+				display_dialog_could_not_store_results (gsearch->window);
+			}
+			break;
+		}
+	}
+
+	g_free (stats);
+	g_array_set_size (pending, 0);
+}
+
+/* The files are queued and stated a batch at a time, see
+   flush_search_results(), which the callers run once they are done
+   adding.  @inode is 0 when it is not known. */
+static void
+add_file_to_search_results (const gchar * file,
+                            guint64 inode,
+			    GSearchWindow * gsearch)
+{
+	GSearchPendingFile pending_file;
+
+	if (gsearch_results_model_contains (gsearch->search_results_model, file) == TRUE) {
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_DEDUP_DROPPED, 1);
+		return;
+	}
+
+	pending_file.path = g_strdup (file);
+	pending_file.inode = inode;
+	g_array_append_val (gsearch->search_results_pending, pending_file);
+	if (gsearch->search_results_pending->len >= GNOME_SEARCH_TOOL_METADATA_BATCH_SIZE) {
+		flush_search_results (gsearch);
+	}
+}
+
+/* In the top-K modes a file only goes to the results once the search is
+   over and it is still among the best, see add_top_files_to_search_results(),
+   and when finding duplicates once it is known to have one, see
+   add_duplicates_to_search_results().  The count and disk usage modes do
+   not add any. */
+static void
+add_found_file (GSearchWindow * gsearch,
+                const gchar * file,
+                gint64 size,
+                gint64 mtime,
+                guint64 inode)
+{
+	if (gsearch->command_details->is_command_count_only_enabled == TRUE) {
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_MATCHES, 1);
+		gsearch->search_results_counted_files++;
+		return;
+	}
+	if (gsearch->search_results_duplicates != NULL) {
+		GStatBuf file_stat;
+
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_STAT_CALLS, 1);
+		if (g_lstat (file, &file_stat) == 0 && S_ISREG (file_stat.st_mode)) {
+			gsearchtool_dupes_add_file (gsearch->search_results_duplicates, file,
+			                            file_stat.st_size, file_stat.st_dev, file_stat.st_ino);
+		}
+		return;
+	}
+	if (gsearch->search_results_disk_usage == NULL && gsearch->search_results_topk == NULL) {
+		add_file_to_search_results (file, inode, gsearch);
+		return;
+	}
+
+	if (gsearch->command_details->is_command_printing_file_details == FALSE) {
+		GStatBuf file_stat;
+
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_STAT_CALLS, 1);
+		if (g_lstat (file, &file_stat) != 0) {
+			return;
+		}
+		size = file_stat.st_size;
+		mtime = file_stat.st_mtime;
+	}
+	if (gsearch->search_results_disk_usage != NULL) {
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_MATCHES, 1);
+		gsearchtool_du_add_file (gsearch->search_results_disk_usage, file, size);
+		return;
+	}
+	gsearchtool_topk_offer (gsearch->search_results_topk, file, size, mtime);
+}
+
+/* Adds the files locate found that pass the other tests, stating them
+   all at once through gsearchtool-io.c, see build_search_command(). */
+static void
+flush_search_candidates (GSearchWindow * gsearch)
+{
+	GArray * candidates = gsearch->search_candidates;
+	GSearchPendingFile * files;
+	GSearchIoStat * stats;
+	const gchar ** paths;
+	gint64 now;
+	guint idx;
+
+	if (candidates == NULL || candidates->len == 0) {
+		return;
+	}
+	files = (GSearchPendingFile *) candidates->data;
+
+	paths = g_new (const gchar *, candidates->len);
+	for (idx = 0; idx < candidates->len; idx++) {
+		paths[idx] = files[idx].path;
+	}
+	stats = g_new (GSearchIoStat, candidates->len);
+	gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+	gsearchtool_io_stat_files (paths, candidates->len, stats);
+	gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+	gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_STAT_CALLS, candidates->len);
+
+	now = time (NULL);
+	for (idx = 0; idx < candidates->len; idx++) {
+		if (gsearchtool_predicate_evaluate (gsearch->command_details->predicate,
+		                                    gsearch->command_details->look_in_folder_string,
+		                                    files[idx].path, &stats[idx], now) == TRUE) {
+			add_matching_file (gsearch, files[idx].path, stats[idx].size, stats[idx].mtime, stats[idx].inode);
+		}
+	}
+	g_free (stats);
+	g_free (paths);
+	g_array_set_size (candidates, 0);
+}
+
+/* With the "Contains any/all of the words" options, a file is only found
+   once its contents are read, on the threads of the content scanner. */
+static void
+add_matching_file (GSearchWindow * gsearch,
+                   const gchar * file,
+                   gint64 size,
+                   gint64 mtime,
+                   guint64 inode)
+{
+	if (gsearch->search_results_content_scanner != NULL) {
+		gsearchtool_content_scanner_push (gsearch->search_results_content_scanner, file, size, mtime, inode);
+		return;
+	}
+	add_found_file (gsearch, file, size, mtime, inode);
+}
+
+static void
+add_content_matches (GSearchWindow * gsearch)
+{
+	GSearchContentScanner * scanner = gsearch->search_results_content_scanner;
+	GSearchContentMatch * match;
+
+	while ((match = gsearchtool_content_scanner_pop (scanner)) != NULL) {
+		gchar * hits;
+		gchar * utf8;
+
+		hits = gsearchtool_content_patterns_get_hits_string (gsearchtool_content_scanner_get_patterns (scanner),
+		                                                     match->hits);
+		utf8 = g_locale_to_utf8 (hits, -1, NULL, NULL, NULL);
+		if (utf8 != NULL) {
+			g_hash_table_replace (gsearch->search_results_content_hits, g_strdup (match->path), utf8);
+		}
+		add_found_file (gsearch, match->path, match->size, match->mtime, match->inode);
+
+		g_free (hits);
+		gsearchtool_content_match_free (match);
+	}
+	flush_search_results (gsearch);
+}
+
+static GSearchContentPatterns *
+get_content_patterns (GSearchWindow * gsearch)
+{
+	GSearchContentPatterns * patterns;
+	GSearchContentFlags flags = 0;
+	const gchar * words_strings[2];
+	gint idx;
+
+	words_strings[0] = gsearch->command_details->content_all_words_string;
+	words_strings[1] = gsearch->command_details->content_any_words_string;
+	if (words_strings[0] == NULL && words_strings[1] == NULL) {
+		return NULL;
+	}
+
+	patterns = gsearchtool_content_patterns_new ();
+	for (idx = 0; idx < 2; idx++) {
+		gchar ** words = NULL;
+		gint word;
+
+		if (words_strings[idx] == NULL) {
+			continue;
+		}
+
+		/* The words are separated like shell arguments, quotes keep
+		   a phrase together. */
+		if (g_shell_parse_argv (words_strings[idx], NULL, &words, NULL) == FALSE) {
+			gsearchtool_content_patterns_add (patterns, words_strings[idx], (idx == 0));
+			continue;
+		}
+		for (word = 0; words[word] != NULL; word++) {
+			if (gsearchtool_content_patterns_add (patterns, words[word], (idx == 0)) == FALSE &&
+			    *words[word] != '\0') {
+				g_warning ("Only %d words can be looked for, \"%s\" is left out.",
+				           GSEARCH_CONTENT_MAX_PATTERNS, words[word]);
+			}
 		}
+		g_strfreev (words);
+	}
+
+	/* The archive members are read on the threads of the scanner, like
+	   the files themselves. */
+	if (gsearch->command_details->is_command_decompress_enabled == TRUE) {
+		flags |= GSEARCH_CONTENT_DECOMPRESS;
+	}
+	if (gsearch->command_details->is_command_member_names_enabled == TRUE) {
+		flags |= GSEARCH_CONTENT_DECOMPRESS | GSEARCH_CONTENT_MEMBER_NAMES;
+	}
+	gsearchtool_content_patterns_set_flags (patterns, flags);
+
+	return patterns;
+}
+
+static gint
+get_search_results_count (GSearchWindow * gsearch)
+{
+	if (gsearch->command_details->is_command_count_only_enabled == TRUE) {
+		return gsearch->search_results_counted_files;
+	}
+	if (gsearch->search_results_disk_usage != NULL) {
+		return gsearchtool_du_get_files (gsearch->search_results_disk_usage);
+	}
+	return gsearch_results_model_get_length (gsearch->search_results_model);
+}
+
+static void
+append_disk_usage_folder (GSearchWindow * gsearch,
+                          GtkTreeIter * parent,
+                          GSearchDiskUsageFolder * folder)
+{
+	GtkTreeIter iter;
+	GtkTreeIter placeholder;
+	gchar * name;
+	gchar * readable_size;
+	gchar * files;
+	gchar * count;
+
+	name = (parent == NULL) ? g_filename_display_name (folder->path) : g_filename_display_basename (folder->path);
+	readable_size = g_format_size (folder->total_size);
+	count = g_strdup_printf ("%'" G_GUINT64_FORMAT, folder->total_files);
+	files = g_strdup_printf (ngettext ("%s file", "%s files", folder->total_files), count);
+	g_free (count);
+
+	gtk_tree_store_append (gsearch->disk_usage_tree_store, &iter, parent);
+	gtk_tree_store_set (gsearch->disk_usage_tree_store, &iter,
+	                    DISK_USAGE_COLUMN_NAME, name,
+	                    DISK_USAGE_COLUMN_READABLE_SIZE, readable_size,
+	                    DISK_USAGE_COLUMN_FILES, files,
+	                    DISK_USAGE_COLUMN_FOLDER, folder,
+	                    -1);
+
+	/* The subfolders are only added when the row is expanded, an empty
+	   row stands in for them until then. */
+	if (folder->children->len > 0) {
+		gtk_tree_store_append (gsearch->disk_usage_tree_store, &placeholder, &iter);
 	}
 
-	g_object_unref (g_file);
-	g_object_unref (file_info);
-	g_free (base_name);
-	g_free (dir_name);
-	g_free (relative_dir_name);
-	g_free (utf8_base_name);
-	g_free (utf8_relative_dir_name);
-	g_free (look_in_folder);
-	g_free (description);
+	g_free (name);
 	g_free (readable_size);
-	g_free (readable_date);
+	g_free (files);
+}
+
+void
+add_disk_usage_folders (GSearchWindow * gsearch,
+                        GtkTreeIter * parent)
+{
+	GtkTreeModel * model = GTK_TREE_MODEL (gsearch->disk_usage_tree_store);
+	GSearchDiskUsageFolder * folder;
+	GSearchDiskUsageFolder * child_folder = NULL;
+	GtkTreeIter child;
+	guint idx;
+
+	if (gtk_tree_model_iter_children (model, &child, parent) == FALSE) {
+		return;
+	}
+	gtk_tree_model_get (model, &child, DISK_USAGE_COLUMN_FOLDER, &child_folder, -1);
+	if (child_folder != NULL) {
+		return;
+	}
+	gtk_tree_store_remove (gsearch->disk_usage_tree_store, &child);
+
+	gtk_tree_model_get (model, parent, DISK_USAGE_COLUMN_FOLDER, &folder, -1);
+	for (idx = 0; idx < folder->children->len; idx++) {
+		append_disk_usage_folder (gsearch, parent, g_ptr_array_index (folder->children, idx));
+	}
+}
+
+static void
+print_disk_usage_folder (GSearchDiskUsageFolder * folder)
+{
+	guint idx;
+
+	for (idx = 0; idx < folder->children->len; idx++) {
+		print_disk_usage_folder (g_ptr_array_index (folder->children, idx));
+	}
+	g_print ("%" G_GINT64_FORMAT "\t%s\n", folder->total_size, folder->path);
+}
+
+static void
+show_disk_usage_summary (GSearchWindow * gsearch)
+{
+	GSearchDiskUsageFolder * root;
+	GtkTreePath * path;
+
+	gsearchtool_du_finish (gsearch->search_results_disk_usage);
+	root = gsearchtool_du_get_root (gsearch->search_results_disk_usage);
+
+	if (GSearchGOptionArguments.batch) {
+		/* Like du, the folders are listed after their subfolders. */
+		print_disk_usage_folder (root);
+	}
+	if (gsearchtool_du_get_files (gsearch->search_results_disk_usage) == 0) {
+		return;
+	}
+
+	append_disk_usage_folder (gsearch, NULL, root);
+	path = gtk_tree_path_new_first ();
+	gtk_tree_view_expand_row (gsearch->disk_usage_tree_view, path, FALSE);
+	gtk_tree_path_free (path);
+
+	gtk_widget_hide (gsearch->search_results_window);
+	gtk_widget_show (gsearch->disk_usage_window);
+}
+
+static void
+add_top_files_to_search_results (GSearchWindow * gsearch)
+{
+	GPtrArray * sorted;
+	guint idx;
+
+	sorted = gsearchtool_topk_get_sorted (gsearch->search_results_topk);
+	for (idx = 0; idx < sorted->len; idx++) {
+		GSearchTopKEntry * entry = g_ptr_array_index (sorted, idx);
+
+		add_file_to_search_results (entry->path, 0, gsearch);
+	}
+	flush_search_results (gsearch);
+	g_ptr_array_free (sorted, TRUE);
+
+	gsearchtool_topk_free (gsearch->search_results_topk);
+	gsearch->search_results_topk = NULL;
+}
+
+static void
+add_duplicates_to_search_results (GSearchWindow * gsearch,
+                                  GSearchDupesGroup * group)
+{
+	guint idx;
+
+	for (idx = 0; idx < group->paths->len; idx++) {
+		add_file_to_search_results (g_ptr_array_index (group->paths, idx), 0, gsearch);
+	}
+	flush_search_results (gsearch);
+	if (GSearchGOptionArguments.batch) {
+		/* A blank line after each group, like fdupes. */
+		g_print ("\n");
+	}
 }
 
 static void
@@ -956,19 +2190,7 @@ add_no_files_found_message (GSearchWindow * gsearch)
 	              "underline", PANGO_UNDERLINE_NONE,
 	              "underline-set", FALSE,
 	              NULL);
-	gtk_list_store_append (GTK_LIST_STORE (gsearch->search_results_list_store), &gsearch->search_results_iter);
-	gtk_list_store_set (GTK_LIST_STORE (gsearch->search_results_list_store), &gsearch->search_results_iter,
-		    	    COLUMN_ICON, NULL,
-			    COLUMN_NAME, _("No files found"),
-			    COLUMN_RELATIVE_PATH, "",
-			    COLUMN_LOCALE_FILE, "",
-			    COLUMN_READABLE_SIZE, "",
-			    COLUMN_SIZE, (gdouble) 0,
-			    COLUMN_TYPE, "",
-		    	    COLUMN_READABLE_DATE, "",
-		    	    COLUMN_DATE, (gdouble) 0,
-			    COLUMN_NO_FILES_FOUND, TRUE,
-		    	    -1);
+	gsearch_results_model_add_no_files_found_row (gsearch->search_results_model);
 }
 
 void
@@ -984,7 +2206,7 @@ update_search_counts (GSearchWindow * gsearch)
 		stopped_string = g_strdup (_("(stopped)"));
 	}
 
-	total_files = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (gsearch->search_results_list_store), NULL);
+	total_files = get_search_results_count (gsearch);
 
 	if (total_files == 0) {
 		title_bar_string = g_strdup (_("No Files Found"));
@@ -1030,7 +2252,7 @@ intermediate_file_count_update (GSearchWindow * gsearch)
 	gchar * string;
 	gint count;
 
-	count = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (gsearch->search_results_list_store), NULL);
+	count = get_search_results_count (gsearch);
 
 	if (count > 0) {
 
@@ -1044,23 +2266,27 @@ intermediate_file_count_update (GSearchWindow * gsearch)
 	}
 }
 
-gboolean
-tree_model_iter_free_monitor (GtkTreeModel * model,
-                              GtkTreePath * path,
-                              GtkTreeIter * iter,
-                              gpointer data)
+static void
+update_search_statistics (GSearchWindow * gsearch)
 {
-	GSearchMonitor * monitor;
+	gchar * summary;
+	gchar * details;
 
-	g_return_val_if_fail (GTK_IS_TREE_MODEL (model), FALSE);
+	summary = gsearchtool_stats_get_summary (gsearch->search_stats);
+	details = gsearchtool_stats_get_details (gsearch->search_stats);
 
-	gtk_tree_model_get (model, iter, COLUMN_MONITOR, &monitor, -1);
-	if (monitor) {
-		g_file_monitor_cancel (monitor->handle);
-		gtk_tree_row_reference_free (monitor->reference);
-		g_slice_free (GSearchMonitor, monitor);
-	}
-	return FALSE;
+	gtk_label_set_text (GTK_LABEL (gsearch->search_stats_label), summary);
+	gtk_widget_set_tooltip_text (gsearch->search_stats_label, details);
+
+	g_free (summary);
+	g_free (details);
+}
+
+void
+set_search_statistics_visible (GSearchWindow * gsearch,
+                               gboolean visible)
+{
+	gtk_widget_set_visible (gsearch->search_stats_label, visible);
 }
 
 static GtkTreeModel *
@@ -1303,6 +2529,8 @@ gsearch_setup_goption_descriptions (void)
 			g_free (text);
 		}
 	}
+	GSearchGOptionEntries[i++].description = g_strdup (_("Search without showing the window, print the results and the search statistics"));
+	GSearchGOptionEntries[i++].description = g_strdup (_("Index the files in the folder for the quick search and quit"));
 }
 
 static gboolean
@@ -1326,6 +2554,24 @@ handle_goption_args (GSearchWindow * gsearch)
 		add_constraint (gsearch, SEARCH_CONSTRAINT_CONTAINS_THE_TEXT,
 				GSearchGOptionArguments.contains, TRUE);
 	}
+	if (GSearchGOptionArguments.contains_any != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_CONTAINS_ANY_OF_THE_WORDS,
+				GSearchGOptionArguments.contains_any, TRUE);
+	}
+	if (GSearchGOptionArguments.contains_all != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_CONTAINS_ALL_OF_THE_WORDS,
+				GSearchGOptionArguments.contains_all, TRUE);
+	}
+	if (GSearchGOptionArguments.compressed) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_SEARCH_COMPRESSED_FILES, NULL, TRUE);
+	}
+	if (GSearchGOptionArguments.member_names) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_MATCH_ARCHIVE_MEMBER_NAMES, NULL, TRUE);
+	}
 	if (GSearchGOptionArguments.mtimeless != NULL) {
 		goption_args_found = TRUE;
 		add_constraint (gsearch, SEARCH_CONSTRAINT_DATE_MODIFIED_BEFORE,
@@ -1386,6 +2632,43 @@ handle_goption_args (GSearchWindow * gsearch)
 		goption_args_found = TRUE;
 		add_constraint (gsearch, SEARCH_CONSTRAINT_SEARCH_OTHER_FILESYSTEMS, NULL, TRUE);
 	}
+	if (GSearchGOptionArguments.also_path != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_ALSO_LOOK_IN_FOLDERS,
+				GSearchGOptionArguments.also_path, TRUE);
+	}
+	if (GSearchGOptionArguments.skip_filesystems != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_SKIP_FILESYSTEMS,
+				GSearchGOptionArguments.skip_filesystems, TRUE);
+	}
+	if (GSearchGOptionArguments.top_largest != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_TOP_LARGEST_FILES,
+				GSearchGOptionArguments.top_largest, TRUE);
+	}
+	if (GSearchGOptionArguments.top_newest != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_TOP_NEWEST_FILES,
+				GSearchGOptionArguments.top_newest, TRUE);
+	}
+	if (GSearchGOptionArguments.top_oldest != NULL) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_TOP_OLDEST_FILES,
+				GSearchGOptionArguments.top_oldest, TRUE);
+	}
+	if (GSearchGOptionArguments.disk_usage) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_DISK_USAGE_BY_FOLDER, NULL, TRUE);
+	}
+	if (GSearchGOptionArguments.count_only) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_COUNT_ONLY, NULL, TRUE);
+	}
+	if (GSearchGOptionArguments.duplicates) {
+		goption_args_found = TRUE;
+		add_constraint (gsearch, SEARCH_CONSTRAINT_FIND_DUPLICATES, NULL, TRUE);
+	}
 	if (GSearchGOptionArguments.sortby != NULL) {
 
 		goption_args_found = TRUE;
@@ -1410,11 +2693,11 @@ handle_goption_args (GSearchWindow * gsearch)
 		}
 
 		if (GSearchGOptionArguments.descending) {
-			gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (gsearch->search_results_list_store), sort_by,
+			gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (gsearch->search_results_model), sort_by,
 							      GTK_SORT_DESCENDING);
 		}
 		else {
-			gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (gsearch->search_results_list_store), sort_by,
+			gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (gsearch->search_results_model), sort_by,
 							      GTK_SORT_ASCENDING);
 		}
 	}
@@ -1425,191 +2708,397 @@ handle_goption_args (GSearchWindow * gsearch)
 	return goption_args_found;
 }
 
-static gboolean
-handle_search_command_stdout_io (GIOChannel * ioc,
-				 GIOCondition condition,
-				 gpointer data)
+static void
+free_search_command_strings (GSearchWindow * gsearch)
 {
-	GSearchWindow * gsearch = data;
-	gboolean broken_pipe = FALSE;
+	g_free (gsearch->command_details->name_contains_pattern_string);
+	g_free (gsearch->command_details->name_contains_regex_string);
+	g_free (gsearch->command_details->content_any_words_string);
+	g_free (gsearch->command_details->content_all_words_string);
 
-	if (condition & G_IO_IN) {
-
-		GError * error = NULL;
-		GTimer * timer;
-		GString * string;
-		GdkRectangle prior_rect;
-		GdkRectangle after_rect;
-		gulong duration;
-		gint look_in_folder_string_length;
+	gsearch->command_details->name_contains_pattern_string = NULL;
+	gsearch->command_details->name_contains_regex_string = NULL;
+	gsearch->command_details->content_any_words_string = NULL;
+	gsearch->command_details->content_all_words_string = NULL;
+}
 
-		string = g_string_new (NULL);
-		look_in_folder_string_length = strlen (gsearch->command_details->look_in_folder_string);
+/* Tells how far the search got in each folder, when it looks in more
+   than one. */
+static void
+update_search_roots_tooltip (GSearchWindow * gsearch)
+{
+	GPtrArray * roots = gsearch->command_details->roots;
+	GString * tooltip;
+	guint i;
 
-		timer = g_timer_new ();
-		g_timer_start (timer);
+	if ((roots == NULL) || (roots->len < 2)) {
+		gtk_widget_set_tooltip_text (gsearch->files_found_label, NULL);
+		return;
+	}
 
-		while (ioc->is_readable != TRUE);
+	tooltip = g_string_new (NULL);
+	for (i = 0; i < roots->len; i++) {
+		GSearchRoot * root = g_ptr_array_index (roots, i);
+		gchar * folder;
 
-		do {
-			gchar * utf8 = NULL;
-			gchar * filename = NULL;
-			gint status;
+		folder = g_filename_display_name (root->folder);
+		if (tooltip->len > 0) {
+			g_string_append_c (tooltip, '\n');
+		}
+		if (root->is_started == FALSE) {
+			g_string_append_printf (tooltip, _("%s: waiting for the disk"), folder);
+		}
+		else if (root->is_finished == FALSE) {
+			g_string_append_printf (tooltip, ngettext ("%s: searching, %u entry so far",
+			                                           "%s: searching, %u entries so far",
+			                                           root->entries), folder, root->entries);
+		}
+		else if ((gsearch->command_details->command_status == MAKE_IT_STOP) ||
+		         (gsearch->command_details->command_status == ABORTED)) {
+			g_string_append_printf (tooltip, ngettext ("%s: stopped, %u entry",
+			                                           "%s: stopped, %u entries",
+			                                           root->entries), folder, root->entries);
+		}
+		else {
+			g_string_append_printf (tooltip, ngettext ("%s: finished, %u entry",
+			                                           "%s: finished, %u entries",
+			                                           root->entries), folder, root->entries);
+		}
+		g_free (folder);
+	}
+	gtk_widget_set_tooltip_text (gsearch->files_found_label, tooltip->str);
+	g_string_free (tooltip, TRUE);
+}
 
-			if (gsearch->command_details->command_status == MAKE_IT_STOP) {
-				broken_pipe = TRUE;
-				break;
-			}
-			else if (gsearch->command_details->command_status != RUNNING) {
-			 	break;
-			}
+static void
+search_command_pipe_closed (GSearchRoot * root)
+{
+	GSearchWindow * gsearch = root->gsearch;
 
-			do {
-				status = g_io_channel_read_line_string (ioc, string, NULL, &error);
+	/* A folder is done once both the stdout and stderr pipes of its
+	   command are closed, and a pass once all of its folders are. */
+	if (--root->open_pipes > 0) {
+		return;
+	}
+	root->is_finished = TRUE;
+	gsearch->command_details->command_running_roots--;
 
-				if (status == G_IO_STATUS_EOF) {
-					broken_pipe = TRUE;
-				}
-				else if (status == G_IO_STATUS_AGAIN) {
-					if (gtk_events_pending ()) {
-						intermediate_file_count_update (gsearch);
-						while (gtk_events_pending ()) {
-							if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
-								return FALSE;
-							}
-							gtk_main_iteration ();
-						}
+	start_search_roots (gsearch);
+	update_search_roots_tooltip (gsearch);
 
-					}
-				}
+	if (gsearch->command_details->command_running_roots > 0) {
+		return;
+	}
+	search_command_pass_finished (gsearch);
+}
 
-			} while (status == G_IO_STATUS_AGAIN && broken_pipe == FALSE);
+/* A file whose name matches, still to be tested when locate found it. */
+static void
+add_candidate_file (GSearchWindow * gsearch,
+                    const gchar * file,
+                    gint64 size,
+                    gint64 mtime,
+                    guint64 inode)
+{
+	GSearchPendingFile candidate;
 
-			if (broken_pipe == TRUE) {
-				break;
-			}
+	if (gsearch->command_details->is_command_stating_candidates == FALSE) {
+		add_matching_file (gsearch, file, size, mtime, inode);
+		return;
+	}
+	candidate.path = g_strdup (file);
+	candidate.inode = inode;
+	g_array_append_val (gsearch->search_candidates, candidate);
+	if (gsearch->search_candidates->len >= GNOME_SEARCH_TOOL_METADATA_BATCH_SIZE) {
+		flush_search_candidates (gsearch);
+	}
+}
 
-			if (status != G_IO_STATUS_NORMAL) {
-				if (error != NULL) {
-					g_warning ("handle_search_command_stdout_io(): %s", error->message);
-					g_error_free (error);
-				}
-				continue;
-			}
+static void
+add_search_command_output_line (GSearchRoot * root,
+                                GString * string,
+                                gint look_in_folder_string_length)
+{
+	GSearchWindow * gsearch = root->gsearch;
+	GdkRectangle prior_rect;
+	GdkRectangle after_rect;
+	gchar * utf8 = NULL;
+	gchar * filename = NULL;
+	gint64 size = 0;
+	gint64 mtime = 0;
+	guint64 inode = 0;
+
+	if ((string->len > 0) && (string->str[string->len - 1] == '\n')) {
+		g_string_truncate (string, string->len - 1);
+	}
+	if (gsearch->command_details->is_command_printing_file_details == TRUE) {
+		gchar * end;
 
-			string = g_string_truncate (string, string->len - 1);
-			if (string->len <= 1) {
-				continue;
-			}
+		/* The lines read "size seconds.fraction path". */
+		size = g_ascii_strtoll (string->str, &end, 10);
+		if (*end != ' ') {
+			return;
+		}
+		mtime = g_ascii_strtoll (end + 1, &end, 10);
+		end = strchr (end, ' ');
+		if (end == NULL) {
+			return;
+		}
+		g_string_erase (string, 0, end + 1 - string->str);
+	}
+	else if (root->is_printing_inodes == TRUE) {
+		gchar * end;
 
-			utf8 = g_filename_display_name (string->str);
-			if (utf8 == NULL) {
-				continue;
-			}
+		/* The lines read "inode path". */
+		inode = g_ascii_strtoull (string->str, &end, 10);
+		if (*end != ' ') {
+			return;
+		}
+		g_string_erase (string, 0, end + 1 - string->str);
+	}
+	if (string->len <= 1) {
+		return;
+	}
+	gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_ENTRIES_EXAMINED, 1);
+	root->entries++;
 
-			if (strncmp (string->str, gsearch->command_details->look_in_folder_string, look_in_folder_string_length) == 0) {
+	utf8 = g_filename_display_name (string->str);
+	if (utf8 == NULL) {
+		return;
+	}
 
-				if (strlen (string->str) != look_in_folder_string_length) {
+	if (strncmp (string->str, root->folder, look_in_folder_string_length) == 0) {
 
-					filename = g_path_get_basename (utf8);
+		if (strlen (string->str) != look_in_folder_string_length) {
 
-					if (fnmatch (gsearch->command_details->name_contains_pattern_string, filename, FNM_NOESCAPE | FNM_CASEFOLD ) != FNM_NOMATCH) {
-						if (gsearch->command_details->is_command_show_hidden_files_enabled) {
-							if (gsearch->command_details->is_command_regex_matching_enabled == FALSE) {
-								add_file_to_search_results (string->str, gsearch->search_results_list_store, &gsearch->search_results_iter, gsearch);
-							}
-							else if (compare_regex (gsearch->command_details->name_contains_regex_string, filename)) {
-								add_file_to_search_results (string->str, gsearch->search_results_list_store, &gsearch->search_results_iter, gsearch);
-							}
-						}
-						else if ((is_path_hidden (string->str) == FALSE ||
-						          is_path_hidden (gsearch->command_details->look_in_folder_string) == TRUE) &&
-						          (!g_str_has_suffix (string->str, "~"))) {
-							if (gsearch->command_details->is_command_regex_matching_enabled == FALSE) {
-								add_file_to_search_results (string->str, gsearch->search_results_list_store, &gsearch->search_results_iter, gsearch);
-							}
-							else if (compare_regex (gsearch->command_details->name_contains_regex_string, filename)) {
-								add_file_to_search_results (string->str, gsearch->search_results_list_store, &gsearch->search_results_iter, gsearch);
-							}
-						}
+			filename = g_path_get_basename (utf8);
+
+			if (compare_name_pattern (gsearch->command_details->name_contains_pattern_string, filename)) {
+				if (gsearch->command_details->is_command_show_hidden_files_enabled) {
+					if (gsearch->command_details->is_command_regex_matching_enabled == FALSE) {
+						add_candidate_file (gsearch, string->str, size, mtime, inode);
+					}
+					else if (compare_regex (gsearch->command_details->name_contains_regex_string, filename)) {
+						add_candidate_file (gsearch, string->str, size, mtime, inode);
+					}
+				}
+				else if ((is_path_hidden (string->str) == FALSE ||
+				          is_path_hidden (root->folder) == TRUE) &&
+				          (!g_str_has_suffix (string->str, "~"))) {
+					if (gsearch->command_details->is_command_regex_matching_enabled == FALSE) {
+						add_candidate_file (gsearch, string->str, size, mtime, inode);
+					}
+					else if (compare_regex (gsearch->command_details->name_contains_regex_string, filename)) {
+						add_candidate_file (gsearch, string->str, size, mtime, inode);
 					}
 				}
 			}
-			g_free (utf8);
-			g_free (filename);
+		}
+	}
+	g_free (utf8);
+	g_free (filename);
 
-			gtk_tree_view_get_visible_rect (GTK_TREE_VIEW (gsearch->search_results_tree_view), &prior_rect);
+	gtk_tree_view_get_visible_rect (GTK_TREE_VIEW (gsearch->search_results_tree_view), &prior_rect);
 
-			if (prior_rect.y == 0) {
-				gtk_tree_view_get_visible_rect (GTK_TREE_VIEW (gsearch->search_results_tree_view), &after_rect);
-				if (after_rect.y <= 40) {  /* limit this hack to the first few pixels */
-					gtk_tree_view_scroll_to_point (GTK_TREE_VIEW (gsearch->search_results_tree_view), -1, 0);
-				}
+	if (prior_rect.y == 0) {
+		gtk_tree_view_get_visible_rect (GTK_TREE_VIEW (gsearch->search_results_tree_view), &after_rect);
+		if (after_rect.y <= 40) {  /* limit this hack to the first few pixels */
+			gtk_tree_view_scroll_to_point (GTK_TREE_VIEW (gsearch->search_results_tree_view), -1, 0);
+		}
+	}
+}
+
+static gboolean
+handle_search_command_stdout_io (GIOChannel * ioc,
+				 GIOCondition condition,
+				 gpointer data)
+{
+	GSearchRoot * root = data;
+	GSearchWindow * gsearch = root->gsearch;
+	gboolean broken_pipe = FALSE;
+
+	if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
+		return FALSE;
+	}
+
+	if (condition & G_IO_IN) {
+
+		GError * error = NULL;
+		GTimer * timer;
+		GString * string;
+		gint look_in_folder_string_length;
+
+		string = g_string_new (NULL);
+		look_in_folder_string_length = strlen (root->folder);
+
+		timer = g_timer_new ();
+		g_timer_start (timer);
+
+		/* Only consume what can be read without blocking, and give the
+		   main loop back after GNOME_SEARCH_TOOL_REFRESH_DURATION so the
+		   window keeps redrawing while the command is producing output. */
+		while (TRUE) {
+			GIOStatus status;
+
+			if (gsearch->command_details->command_status == MAKE_IT_STOP) {
+				broken_pipe = TRUE;
+				break;
 			}
 
-			g_timer_elapsed (timer, &duration);
+			status = g_io_channel_read_line_string (ioc, string, NULL, &error);
 
-			if (duration > GNOME_SEARCH_TOOL_REFRESH_DURATION) {
-				if (gtk_events_pending ()) {
-					intermediate_file_count_update (gsearch);
-					while (gtk_events_pending ()) {
-						if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
-							return FALSE;
-						}
-						gtk_main_iteration ();
-					}
+			if (status == G_IO_STATUS_AGAIN) {
+				break;
+			}
+			else if (status == G_IO_STATUS_EOF) {
+				broken_pipe = TRUE;
+				break;
+			}
+			else if (status != G_IO_STATUS_NORMAL) {
+				if (error != NULL) {
+					g_warning ("handle_search_command_stdout_io(): %s", error->message);
+					g_clear_error (&error);
 				}
-				g_timer_reset (timer);
+				broken_pipe = TRUE;
+				break;
 			}
 
-		} while (g_io_channel_get_buffer_condition (ioc) & G_IO_IN);
+			add_search_command_output_line (root, string, look_in_folder_string_length);
+
+			if (g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC > GNOME_SEARCH_TOOL_REFRESH_DURATION) {
+				break;
+			}
+		}
+
+		flush_search_candidates (gsearch);
+		flush_search_results (gsearch);
+		intermediate_file_count_update (gsearch);
+		update_search_roots_tooltip (gsearch);
 
 		g_string_free (string, TRUE);
 		g_timer_destroy (timer);
 	}
 
 	if (!(condition & G_IO_IN) || broken_pipe == TRUE) {
-
 		g_io_channel_shutdown (ioc, TRUE, NULL);
+		search_command_pipe_closed (root);
+		return FALSE;
+	}
+	return TRUE;
+}
 
-		if ((gsearch->command_details->command_status != MAKE_IT_STOP)
-		     && (gsearch->command_details->is_command_using_quick_mode == TRUE)
-		     && (gsearch->command_details->is_command_first_pass == TRUE)
-		     && (gsearch->command_details->is_command_second_pass_enabled == TRUE)
-		     && (is_second_scan_excluded_path (gsearch->command_details->look_in_folder_string) == FALSE)) {
+static gboolean
+get_next_database_path (GSearchRoot * root,
+                        GString * string,
+                        guint * budget)
+{
+	if (root->index_cursor != NULL) {
+		return gsearchtool_index_cursor_next (root->index_cursor, string, budget);
+	}
+	return gsearchtool_locate_cursor_next (root->locate_cursor, string, budget);
+}
 
-			gchar * command;
+/* Reads the part of the index or of the locate database in the folder
+   of @root, a chunk at a time like the output of a command.  The cursor
+   reads GNOME_SEARCH_TOOL_DATABASE_BUDGET entries at most between looks at
+   the time and at the Stop button, found or not. */
+static gboolean
+read_search_database_cb (gpointer data)
+{
+	GSearchRoot * root = data;
+	GSearchWindow * gsearch = root->gsearch;
+	gboolean is_finished = FALSE;
+	GTimer * timer;
+	GString * string;
+	gint look_in_folder_string_length;
+	guint budget = GNOME_SEARCH_TOOL_DATABASE_BUDGET;
+
+	if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
+		root->database_source = 0;
+		return FALSE;
+	}
 
-			/* Free these strings now because they are reassign values during the second pass. */
-			g_free (gsearch->command_details->name_contains_pattern_string);
-			g_free (gsearch->command_details->name_contains_regex_string);
-			g_free (gsearch->search_results_date_format_string);
+	string = g_string_new (NULL);
+	look_in_folder_string_length = strlen (root->folder);
 
-			command = build_search_command (gsearch, FALSE);
-			if (command != NULL) {
-				spawn_search_command (gsearch, command);
-				g_free (command);
-			}
+	timer = g_timer_new ();
+	g_timer_start (timer);
+
+	while (TRUE) {
+		if (gsearch->command_details->command_status == MAKE_IT_STOP) {
+			is_finished = TRUE;
+			break;
+		}
+		if (get_next_database_path (root, string, &budget) == TRUE) {
+			add_search_command_output_line (root, string, look_in_folder_string_length);
+		}
+		else if (budget == 0) {
+			budget = GNOME_SEARCH_TOOL_DATABASE_BUDGET;
 		}
 		else {
-			gsearch->command_details->command_status = (gsearch->command_details->command_status == MAKE_IT_STOP) ? ABORTED : STOPPED;
-			gsearch->command_details->is_command_timeout_enabled = TRUE;
-			g_hash_table_destroy (gsearch->search_results_pixbuf_hash_table);
-			g_hash_table_destroy (gsearch->search_results_filename_hash_table);
-			g_timeout_add (500, not_running_timeout_cb, (gpointer) gsearch);
+			is_finished = TRUE;
+			break;
+		}
+
+		if (g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC > GNOME_SEARCH_TOOL_REFRESH_DURATION) {
+			break;
+		}
+	}
 
-			update_search_counts (gsearch);
-			stop_animation (gsearch);
+	flush_search_candidates (gsearch);
+	flush_search_results (gsearch);
+	intermediate_file_count_update (gsearch);
+	update_search_roots_tooltip (gsearch);
 
-			/* Free the gchar fields of search_command structure. */
-			g_free (gsearch->command_details->name_contains_pattern_string);
-			g_free (gsearch->command_details->name_contains_regex_string);
-			g_free (gsearch->search_results_date_format_string);
+	g_string_free (string, TRUE);
+	g_timer_destroy (timer);
 
+	if (is_finished == FALSE) {
+		return TRUE;
+	}
+	if (root->index_cursor != NULL) {
+		if (gsearchtool_index_cursor_is_damaged (root->index_cursor) == TRUE) {
+			g_warning ("read_search_database_cb(): the search index is damaged, build it again with --update-index");
 		}
-		return FALSE;
+		gsearchtool_index_cursor_free (root->index_cursor);
+		root->index_cursor = NULL;
 	}
-	return TRUE;
+	else {
+		gsearchtool_locate_cursor_free (root->locate_cursor);
+		root->locate_cursor = NULL;
+	}
+	root->database_source = 0;
+	search_command_pipe_closed (root);
+	return FALSE;
+}
+
+/* Looks for the files of @root in the index or in the mlocate database
+   itself, which seeks to the folder instead of going through the whole
+   database and needs no command, pipe or copy of each path.  The index
+   also runs the tests on the sizes, times and owners it holds, so only
+   the files that pass them are stat'ed in flush_search_candidates(). */
+static void
+read_search_database (GSearchWindow * gsearch,
+                      GSearchRoot * root)
+{
+	if (gsearch->command_details->search_index != NULL) {
+		root->index_cursor = gsearchtool_index_cursor_new (gsearch->command_details->search_index,
+		                                                   root->folder,
+		                                                   gsearch->command_details->name_contains_pattern_string);
+		if (gsearch->command_details->is_command_stating_candidates == TRUE) {
+			gsearchtool_index_cursor_set_predicate (root->index_cursor,
+			                                        gsearch->command_details->predicate,
+			                                        time (NULL));
+		}
+	}
+	else {
+		root->locate_cursor = gsearchtool_locate_cursor_new (gsearch->command_details->locate_database,
+		                                                     root->folder,
+		                                                     gsearch->command_details->name_contains_pattern_string);
+	}
+	root->open_pipes = 1;
+	gsearch->command_details->command_running_roots++;
+	root->database_source = g_idle_add (read_search_database_cb, root);
 }
 
 static gboolean
@@ -1617,16 +3106,20 @@ handle_search_command_stderr_io (GIOChannel * ioc,
 				 GIOCondition condition,
 				 gpointer data)
 {
-	GSearchWindow * gsearch = data;
+	GSearchRoot * root = data;
+	GSearchWindow * gsearch = root->gsearch;
 	static GString * error_msgs = NULL;
 	static gboolean truncate_error_msgs = FALSE;
 	gboolean broken_pipe = FALSE;
 
+	if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
+		return FALSE;
+	}
+
 	if (condition & G_IO_IN) {
 
 		GString * string;
 		GError * error = NULL;
-		gchar * utf8 = NULL;
 
 		string = g_string_new (NULL);
 
@@ -1634,42 +3127,25 @@ handle_search_command_stderr_io (GIOChannel * ioc,
 			error_msgs = g_string_new (NULL);
 		}
 
-		while (ioc->is_readable != TRUE);
-
-		do {
-			gint status;
-
-			do {
-				status = g_io_channel_read_line_string (ioc, string, NULL, &error);
-
-				if (status == G_IO_STATUS_EOF) {
-					broken_pipe = TRUE;
-				}
-				else if (status == G_IO_STATUS_AGAIN) {
-					if (gtk_events_pending ()) {
-						intermediate_file_count_update (gsearch);
-						while (gtk_events_pending ()) {
-							if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
-								break;
-							}
-							gtk_main_iteration ();
-
-						}
-					}
-				}
+		while (TRUE) {
+			GIOStatus status;
 
-			} while (status == G_IO_STATUS_AGAIN && broken_pipe == FALSE);
+			status = g_io_channel_read_line_string (ioc, string, NULL, &error);
 
-			if (broken_pipe == TRUE) {
+			if (status == G_IO_STATUS_AGAIN) {
 				break;
 			}
-
-			if (status != G_IO_STATUS_NORMAL) {
+			else if (status == G_IO_STATUS_EOF) {
+				broken_pipe = TRUE;
+				break;
+			}
+			else if (status != G_IO_STATUS_NORMAL) {
 				if (error != NULL) {
 					g_warning ("handle_search_command_stderr_io(): %s", error->message);
-					g_error_free (error);
+					g_clear_error (&error);
 				}
-				continue;
+				broken_pipe = TRUE;
+				break;
 			}
 
 			if (truncate_error_msgs == FALSE) {
@@ -1677,21 +3153,26 @@ handle_search_command_stderr_io (GIOChannel * ioc,
 			   	    (strstr (string->str, "No such file or directory") == NULL) &&
 			   	    (strncmp (string->str, "grep: ", 6) != 0) &&
 			 	    (strcmp (string->str, "find: ") != 0)) {
+					gchar * utf8;
+
 					utf8 = g_locale_to_utf8 (string->str, -1, NULL, NULL, NULL);
-					error_msgs = g_string_append (error_msgs, utf8);
-					truncate_error_msgs = limit_string_to_x_lines (error_msgs, 20);
+					if (utf8 != NULL) {
+						error_msgs = g_string_append (error_msgs, utf8);
+						truncate_error_msgs = limit_string_to_x_lines (error_msgs, 20);
+					}
+					g_free (utf8);
 				}
 			}
-
-		} while (g_io_channel_get_buffer_condition (ioc) & G_IO_IN);
+		}
 
 		g_string_free (string, TRUE);
-		g_free (utf8);
 	}
 
 	if (!(condition & G_IO_IN) || broken_pipe == TRUE) {
 
-		if (error_msgs != NULL) {
+		/* The errors of all the folders are shown together, once the
+		   last of their commands is done. */
+		if ((--gsearch->command_details->command_open_error_pipes == 0) && (error_msgs != NULL)) {
 
 			if (error_msgs->len > 0) {
 
@@ -1702,7 +3183,10 @@ handle_search_command_stderr_io (GIOChannel * ioc,
 				     		_("\n... Too many errors to display ..."));
 				}
 
-				if (gsearch->command_details->is_command_using_quick_mode != TRUE) {
+				if (GSearchGOptionArguments.batch) {
+					g_printerr ("%s", error_msgs->str);
+				}
+				else if (gsearch->command_details->is_command_using_quick_mode != TRUE) {
 
 					GtkWidget * hbox;
 					GtkWidget * spacer;
@@ -1758,157 +3242,1213 @@ handle_search_command_stderr_io (GIOChannel * ioc,
 					                                          "Please reference the help documentation for instructions "
 										  "on how to configure and enable quick searches.");
 
-					hbox = gtk_hbox_new (0, FALSE);
+					hbox = gtk_hbox_new (0, FALSE);
+
+					spacer = gtk_label_new ("     ");
+					gtk_box_pack_start (GTK_BOX (hbox), spacer, FALSE, FALSE, 0);
+
+					expander = gtk_expander_new_with_mnemonic (_("Show more _details"));
+					gtk_container_set_border_width (GTK_CONTAINER (expander), 6);
+					gtk_expander_set_spacing (GTK_EXPANDER (expander), 6);
+					gtk_box_pack_start (GTK_BOX (hbox), expander, TRUE, TRUE, 0);
+
+					label = gtk_label_new (error_msgs->str);
+					gtk_container_add (GTK_CONTAINER (expander), label);
+
+					gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (dialog))), hbox, FALSE, FALSE, 0);
+					gtk_widget_show_all (hbox);
+
+					button = gsearchtool_button_new_with_stock_icon (_("Disable _Quick Search"), GTK_STOCK_OK);
+					gtk_widget_set_can_default (button, TRUE);
+					gtk_widget_show (button);
+
+					gtk_dialog_add_action_widget (GTK_DIALOG (dialog), button, GTK_RESPONSE_OK);
+					gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_OK);
+
+					g_signal_connect (G_OBJECT (dialog),
+					                  "response",
+					                  G_CALLBACK (disable_quick_search_cb), (gpointer) gsearch);
+
+					gtk_widget_show (dialog);
+				}
+			}
+			truncate_error_msgs = FALSE;
+			g_string_truncate (error_msgs, 0);
+		}
+		g_io_channel_shutdown (ioc, TRUE, NULL);
+		search_command_pipe_closed (root);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+child_command_set_pgid_cb (gpointer data)
+{
+	if (setpgid (0, 0) < 0) {
+		g_print (_("Failed to set process group id of child %d: %s.\n"),
+		         getpid (), g_strerror (errno));
+	}
+}
+
+static void
+child_command_exited_cb (GPid pid,
+                         gint status,
+                         gpointer data)
+{
+	GSearchWindow * gsearch = data;
+	GPtrArray * roots = gsearch->command_details->roots;
+	guint i;
+
+	for (i = 0; (roots != NULL) && (i < roots->len); i++) {
+		GSearchRoot * root = g_ptr_array_index (roots, i);
+
+		if (root->pid == pid) {
+			root->pid = 0;
+		}
+	}
+	g_spawn_close_pid (pid);
+}
+
+/* The disk usage of several folders is summed up from the deepest folder
+   holding them all. */
+static gchar *
+get_search_roots_ancestor (GSearchWindow * gsearch)
+{
+	GPtrArray * roots = gsearch->command_details->roots;
+	gchar * ancestor;
+	guint i;
+
+	ancestor = g_strdup (((GSearchRoot *) g_ptr_array_index (roots, 0))->folder);
+
+	for (i = 1; i < roots->len; i++) {
+		GSearchRoot * root = g_ptr_array_index (roots, i);
+
+		while ((strlen (ancestor) > 1) && (g_str_has_prefix (root->folder, ancestor) == FALSE)) {
+			gchar * parent;
+
+			ancestor[strlen (ancestor) - 1] = '\0';
+			parent = g_path_get_dirname (ancestor);
+			g_free (ancestor);
+			if (g_str_has_suffix (parent, G_DIR_SEPARATOR_S)) {
+				ancestor = parent;
+			}
+			else {
+				ancestor = g_strconcat (parent, G_DIR_SEPARATOR_S, NULL);
+				g_free (parent);
+			}
+		}
+	}
+	return ancestor;
+}
+
+/* Called once the commands of the first pass are running. */
+static void
+clear_search_results_model (GSearchWindow * gsearch)
+{
+	GPtrArray * roots = gsearch->command_details->roots;
+	gchar ** look_in_folders;
+	gint memory_budget;
+	guint i;
+
+	memory_budget = gsearchtool_gconf_get_int ("/apps/gnome-search-tool/search_results_memory_budget");
+	if (memory_budget <= 0) {
+		memory_budget = GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET / (1024 * 1024);
+	}
+
+	look_in_folders = g_new0 (gchar *, roots->len + 1);
+	for (i = 0; i < roots->len; i++) {
+		look_in_folders[i] = ((GSearchRoot *) g_ptr_array_index (roots, i))->folder;
+	}
+
+	/* The view is detached while the old results go, it would
+	   otherwise be told about each of them being removed. */
+	gtk_tree_view_scroll_to_point (GTK_TREE_VIEW (gsearch->search_results_tree_view), 0, 0);
+	gtk_tree_view_set_model (GTK_TREE_VIEW (gsearch->search_results_tree_view), NULL);
+	gsearch_results_model_clear (gsearch->search_results_model,
+	                             (const gchar * const *) look_in_folders,
+	                             (gsize) memory_budget * 1024 * 1024);
+	gtk_tree_view_set_model (GTK_TREE_VIEW (gsearch->search_results_tree_view),
+	                         GTK_TREE_MODEL (gsearch->search_results_model));
+	g_free (look_in_folders);
+}
+
+static void
+setup_search_results (GSearchWindow * gsearch)
+{
+	GSearchContentPatterns * patterns;
+	gchar * date_format;
+
+	gsearch->search_results_monitor_hash_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, free_folder_monitor);
+
+	gsearchtool_topk_free (gsearch->search_results_topk);
+	gsearch->search_results_topk = NULL;
+	if (gsearch->command_details->top_count > 0) {
+		gsearch->search_results_topk = gsearchtool_topk_new (gsearch->command_details->top_kind,
+		                                                     gsearch->command_details->top_count);
+	}
+
+	/* The summary rows point into the disk usage totals. */
+	gtk_tree_store_clear (gsearch->disk_usage_tree_store);
+	gsearchtool_du_free (gsearch->search_results_disk_usage);
+	gsearch->search_results_disk_usage = NULL;
+	if (gsearch->command_details->is_command_disk_usage_enabled == TRUE) {
+		gchar * ancestor;
+
+		ancestor = get_search_roots_ancestor (gsearch);
+		gsearch->search_results_disk_usage = gsearchtool_du_new (ancestor);
+		g_free (ancestor);
+	}
+	gsearch->search_results_counted_files = 0;
+
+	gsearchtool_dupes_free (gsearch->search_results_duplicates);
+	gsearch->search_results_duplicates = NULL;
+	if (gsearch->command_details->is_command_finding_duplicates == TRUE) {
+		gsearch->search_results_duplicates = gsearchtool_dupes_new (0);
+
+		/* Equal rows keep the order they came in, so sorting on
+		   the size keeps each group of duplicates together. */
+		gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (gsearch->search_results_model),
+		                                      COLUMN_SIZE, GTK_SORT_DESCENDING);
+	}
+	gtk_widget_hide (gsearch->disk_usage_window);
+	gtk_widget_show (gsearch->search_results_window);
+
+	if (gsearch->search_results_pending == NULL) {
+		gsearch->search_results_pending = g_array_new (FALSE, FALSE, sizeof (GSearchPendingFile));
+		g_array_set_clear_func (gsearch->search_results_pending, (GDestroyNotify) clear_pending_file);
+	}
+	g_array_set_size (gsearch->search_results_pending, 0);
+	if (gsearch->search_candidates == NULL) {
+		gsearch->search_candidates = g_array_new (FALSE, FALSE, sizeof (GSearchPendingFile));
+		g_array_set_clear_func (gsearch->search_candidates, (GDestroyNotify) clear_pending_file);
+	}
+	g_array_set_size (gsearch->search_candidates, 0);
+
+	if (gsearch->search_results_content_hits != NULL) {
+		g_hash_table_destroy (gsearch->search_results_content_hits);
+		gsearch->search_results_content_hits = NULL;
+	}
+	patterns = get_content_patterns (gsearch);
+	if (patterns != NULL) {
+		gsearch->search_results_content_hits = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		gsearch->search_results_content_scanner = gsearchtool_content_scanner_new (patterns, 0);
+		gsearch->search_results_content_timeout = g_timeout_add (GNOME_SEARCH_TOOL_REFRESH_DURATION / 1000,
+		                                                         content_scan_timeout_cb, gsearch);
+	}
+
+	/* Get value of nautilus date_format key */
+	date_format = gsearchtool_gconf_get_string ("/apps/nautilus/preferences/date_format");
+	gsearch_results_model_set_date_format (gsearch->search_results_model, date_format);
+	g_free (date_format);
+
+	clear_search_results_model (gsearch);
+
+	gtk_tree_view_column_set_visible (gsearch->search_results_folder_column, TRUE);
+	gtk_tree_view_column_set_visible (gsearch->search_results_size_column, TRUE);
+	gtk_tree_view_column_set_visible (gsearch->search_results_type_column, TRUE);
+	gtk_tree_view_column_set_visible (gsearch->search_results_date_column, TRUE);
+}
+
+gboolean
+spawn_search_command (GSearchWindow * gsearch,
+                      GSearchRoot * root)
+{
+	GIOChannel * ioc_stdout;
+	GIOChannel * ioc_stderr;
+	GError * error = NULL;
+	gchar ** argv  = NULL;
+	gint child_stdout;
+	gint child_stderr;
+
+	if (!g_shell_parse_argv (root->command, NULL, &argv, &error)) {
+		GtkWidget * dialog;
+
+		dialog = gtk_message_dialog_new (GTK_WINDOW (gsearch->window),
+		                                 GTK_DIALOG_DESTROY_WITH_PARENT,
+		                                 GTK_MESSAGE_ERROR,
+		                                 GTK_BUTTONS_OK,
+		                                 _("Error parsing the search command."));
+		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+		                                          (error == NULL) ? " " : error->message, NULL);
+
+		g_signal_connect (G_OBJECT (dialog),
+		                  "response",
+		                   G_CALLBACK (gtk_widget_destroy), NULL);
+
+		gtk_widget_show (dialog);
+		g_error_free (error);
+		g_strfreev (argv);
+		return FALSE;
+	}
+
+	if (!g_spawn_async_with_pipes (g_get_home_dir (), argv, NULL,
+				       G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+				       child_command_set_pgid_cb, NULL, &root->pid, NULL, &child_stdout,
+				       &child_stderr, &error)) {
+		GtkWidget * dialog;
+
+		dialog = gtk_message_dialog_new (GTK_WINDOW (gsearch->window),
+		                                 GTK_DIALOG_DESTROY_WITH_PARENT,
+		                                 GTK_MESSAGE_ERROR,
+		                                 GTK_BUTTONS_OK,
+		                                 _("Error running the search command."));
+		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
+		                                          (error == NULL) ? " " : error->message, NULL);
+
+		g_signal_connect (G_OBJECT (dialog),
+		                  "response",
+		                   G_CALLBACK (gtk_widget_destroy), NULL);
+
+		gtk_widget_show (dialog);
+		g_error_free (error);
+		g_strfreev (argv);
+		root->pid = 0;
+		return FALSE;
+	}
+
+	g_child_watch_add (root->pid, child_command_exited_cb, gsearch);
+
+	ioc_stdout = g_io_channel_unix_new (child_stdout);
+	ioc_stderr = g_io_channel_unix_new (child_stderr);
+
+	g_io_channel_set_encoding (ioc_stdout, NULL, NULL);
+	g_io_channel_set_encoding (ioc_stderr, NULL, NULL);
+
+	g_io_channel_set_flags (ioc_stdout, G_IO_FLAG_NONBLOCK, NULL);
+	g_io_channel_set_flags (ioc_stderr, G_IO_FLAG_NONBLOCK, NULL);
+
+	/* The output is handled below the priority of redraws and user input. */
+	root->open_pipes = 2;
+	gsearch->command_details->command_running_roots++;
+	gsearch->command_details->command_open_error_pipes++;
+	g_io_add_watch_full (ioc_stdout, G_PRIORITY_DEFAULT_IDLE, G_IO_IN | G_IO_HUP,
+	                     handle_search_command_stdout_io, root, NULL);
+	g_io_add_watch_full (ioc_stderr, G_PRIORITY_DEFAULT_IDLE, G_IO_IN | G_IO_HUP,
+	                     handle_search_command_stderr_io, root, NULL);
+
+	g_io_channel_unref (ioc_stdout);
+	g_io_channel_unref (ioc_stderr);
+	g_strfreev (argv);
+
+	return TRUE;
+}
+
+/* The search lifecycle is a small state machine driven from main loop
+   callbacks only:
+
+     SEARCH_STATE_PROBE        the one time find/grep/locate capability check
+     SEARCH_STATE_FIRST_PASS   locate (quick mode) or find
+     SEARCH_STATE_SECOND_PASS  find, after a quick mode first pass
+     SEARCH_STATE_CONTENT_SCAN read the files find has left to be read
+     SEARCH_STATE_DUPLICATES   hash the files found, in the duplicates mode
+     SEARCH_STATE_FINALIZE     update the window, back to SEARCH_STATE_IDLE
+
+   A pass runs one command per folder searched, all at once.  It is over
+   when the stdout and stderr pipes of all of them are closed, see
+   search_command_pipe_closed(). */
+
+/* Starts the commands of the folders still waiting, up to the
+   concurrency of the device of each.  A folder whose command could not be
+   started is left out, the search goes on in the others.  Returns the
+   number of commands running. */
+static gint
+start_search_roots (GSearchWindow * gsearch)
+{
+	GPtrArray * roots = gsearch->command_details->roots;
+	guint i;
+	guint j;
+
+	for (i = 0; i < roots->len; i++) {
+		GSearchRoot * root = g_ptr_array_index (roots, i);
+		GSearchDeviceKind kind;
+		guint running = 0;
+
+		if (root->is_started == TRUE) {
+			continue;
+		}
+		if (gsearch->command_details->command_status != RUNNING) {
+			root->is_started = TRUE;
+			root->is_finished = TRUE;
+			continue;
+		}
+		for (j = 0; j < roots->len; j++) {
+			GSearchRoot * other = g_ptr_array_index (roots, j);
+
+			if ((other->device == root->device) && (other->is_started == TRUE) && (other->is_finished == FALSE)) {
+				running++;
+			}
+		}
+		kind = gsearchtool_device_get_kind (root->device);
+		if (running >= gsearchtool_device_get_concurrency (kind)) {
+			continue;
+		}
+		root->is_started = TRUE;
+		if ((gsearch->command_details->search_index != NULL) ||
+		    (gsearch->command_details->locate_database != NULL)) {
+			read_search_database (gsearch, root);
+		}
+		else if (spawn_search_command (gsearch, root) == FALSE) {
+			root->is_finished = TRUE;
+		}
+	}
+	return gsearch->command_details->command_running_roots;
+}
+
+static void
+load_device_concurrency (void)
+{
+	gsearchtool_device_set_concurrency (GSEARCH_DEVICE_SOLID,
+		MAX (gsearchtool_gconf_get_int ("/apps/gnome-search-tool/device_concurrency_solid"), 0));
+	gsearchtool_device_set_concurrency (GSEARCH_DEVICE_ROTATIONAL,
+		MAX (gsearchtool_gconf_get_int ("/apps/gnome-search-tool/device_concurrency_rotational"), 0));
+	gsearchtool_device_set_concurrency (GSEARCH_DEVICE_NETWORK,
+		MAX (gsearchtool_gconf_get_int ("/apps/gnome-search-tool/device_concurrency_network"), 0));
+	gsearchtool_device_set_concurrency (GSEARCH_DEVICE_OTHER,
+		MAX (gsearchtool_gconf_get_int ("/apps/gnome-search-tool/device_concurrency_other"), 0));
+}
+
+/* Whether the search about to run only narrows down the one whose
+   results are shown, so they can be filtered instead, see
+   refine_search_results(). */
+static gboolean
+is_search_refinement (GSearchWindow * gsearch)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+
+	if ((command_details->refinable_predicate == NULL) ||
+	    (gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_refine_in_place") == TRUE)) {
+		return FALSE;
+	}
+	return (g_strcmp0 (command_details->query_key, command_details->refinable_key) == 0) &&
+	       (is_name_pattern_narrower (command_details->query_name_pattern,
+	                                  command_details->refinable_name_pattern) == TRUE) &&
+	       (gsearchtool_predicate_refines (command_details->predicate,
+	                                       command_details->refinable_predicate) == TRUE);
+}
+
+/* Keeps the results that pass the new tests, with a batched stat of each
+   so that files changed since are tested as they are now and files gone
+   are left out.  The type of each is kept from before. */
+static void
+refine_search_results (GSearchWindow * gsearch)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+	GSearchResults * results = gsearch->search_results_model->results;
+	GSearchIoStat * stats;
+	gchar ** paths;
+	gchar ** content_types;
+	gboolean is_stored;
+	gint64 now;
+	guint length;
+	guint idx;
+
+	length = gsearchtool_results_get_length (results);
+	paths = g_new0 (gchar *, length + 1);
+	content_types = g_new0 (gchar *, length + 1);
+	for (idx = 0; idx < length; idx++) {
+		GSearchResultsRecord record;
+
+		if (gsearchtool_results_get (results, idx, &record) == TRUE) {
+			paths[idx] = g_strdup (record.path);
+			content_types[idx] = g_strdup (record.content_type);
+		}
+		else {
+			paths[idx] = g_strdup ("");
+		}
+	}
+	gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_ENTRIES_EXAMINED, length);
+
+	stats = g_new (GSearchIoStat, length);
+	gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+	gsearchtool_io_stat_files ((const gchar * const *) paths, length, stats);
+	gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_METADATA);
+	gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_STAT_CALLS, length);
+
+	gsearch->search_results_monitor_hash_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, free_folder_monitor);
+	clear_search_results_model (gsearch);
+
+	now = time (NULL);
+	for (idx = 0; idx < length; idx++) {
+		GFileInfo * file_info;
+		GTimeVal mtime;
+		gchar * utf8;
+		gchar * filename;
+		gboolean is_matching;
+
+		if (stats[idx].error != 0) {
+			continue;
+		}
+		utf8 = g_filename_display_name (paths[idx]);
+		filename = g_path_get_basename (utf8);
+		is_matching = (compare_name_pattern (command_details->query_name_pattern, filename) == TRUE) &&
+		              (gsearchtool_predicate_evaluate (command_details->predicate,
+		                                               command_details->look_in_folder_string,
+		                                               paths[idx], &stats[idx], now) == TRUE);
+		g_free (utf8);
+		g_free (filename);
+		if (is_matching == FALSE) {
+			continue;
+		}
+
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_MATCHES, 1);
+		gsearchtool_stats_first_result (gsearch->search_stats);
+
+		file_info = g_file_info_new ();
+		g_file_info_set_content_type (file_info, content_types[idx]);
+		g_file_info_set_size (file_info, stats[idx].size);
+		mtime.tv_sec = stats[idx].mtime;
+		mtime.tv_usec = 0;
+		g_file_info_set_modification_time (file_info, &mtime);
+
+		is_stored = gsearch_results_model_append (gsearch->search_results_model, paths[idx], file_info);
+		g_object_unref (file_info);
+		if (is_stored == FALSE) {
+			display_dialog_could_not_store_results (gsearch->window);
+			break;
+		}
+		add_folder_monitor (gsearch, paths[idx]);
+	}
+	g_free (stats);
+	g_strfreev (paths);
+	g_strfreev (content_types);
+}
+
+static void
+run_search_command_pass (GSearchWindow * gsearch,
+                         GSearchCommandState state)
+{
+	GSearchStatsPhase phase;
+	GPtrArray * roots;
+	guint i;
+
+	gsearch->command_details->command_state = state;
+	phase = (state == SEARCH_STATE_FIRST_PASS) ? GSEARCH_STATS_PHASE_FIRST_PASS : GSEARCH_STATS_PHASE_SECOND_PASS;
+	gsearchtool_stats_phase_begin (gsearch->search_stats, phase);
+
+	if (build_search_command (gsearch, (state == SEARCH_STATE_FIRST_PASS)) == FALSE) {
+		gsearch->command_details->command_status = MAKE_IT_STOP;
+		finalize_search_command (gsearch);
+		return;
+	}
+	roots = gsearch->command_details->roots;
+
+	if (state == SEARCH_STATE_FIRST_PASS) {
+		GString * folders;
+		gchar * explanation;
+		gboolean is_refining;
+
+		load_device_concurrency ();
+		gsearchtool_io_set_uring_enabled (!gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/disable_io_uring"));
+
+		folders = g_string_new (NULL);
+		for (i = 0; i < roots->len; i++) {
+			if (i > 0) {
+				g_string_append (folders, G_SEARCHPATH_SEPARATOR_S);
+			}
+			g_string_append (folders, ((GSearchRoot *) g_ptr_array_index (roots, i))->folder);
+		}
+		is_refining = is_search_refinement (gsearch);
+		gsearchtool_stats_set_query (gsearch->search_stats,
+		                             gsearch->command_details->name_contains_pattern_string,
+		                             folders->str,
+		                             (is_refining == TRUE) ? "refine" :
+		                             gsearchtool_planner_get_kind_name (gsearch->command_details->plan.kind));
+		g_string_free (folders, TRUE);
+
+		/* A narrower search is run on the results already found. */
+		if (is_refining == TRUE) {
+			refine_search_results (gsearch);
+			gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_FIRST_PASS);
+			finalize_search_command (gsearch);
+			return;
+		}
+		explanation = gsearchtool_planner_explain (&gsearch->command_details->plan);
+		gsearchtool_stats_set_plan (gsearch->search_stats, explanation,
+		                            gsearch->command_details->plan.costs[gsearch->command_details->plan.kind]);
+		g_free (explanation);
+	}
+
+	if (start_search_roots (gsearch) == 0) {
+		gsearch->command_details->command_status = MAKE_IT_STOP;
+		finalize_search_command (gsearch);
+		return;
+	}
+	if (state == SEARCH_STATE_FIRST_PASS) {
+		setup_search_results (gsearch);
+	}
+	update_search_roots_tooltip (gsearch);
+}
+
+/* Whether a file found by the watch mode is one the search would have
+   found, see add_search_command_output_line(). */
+static gboolean
+is_watched_file_matching (GSearchWindow * gsearch,
+                          const gchar * file,
+                          GSearchIoStat * file_stat,
+                          gint64 now)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+	gchar * utf8;
+	gchar * filename;
+	gboolean is_matching;
+
+	if ((command_details->is_command_show_hidden_files_enabled == FALSE) &&
+	    (g_str_has_suffix (file, "~") == TRUE)) {
+		return FALSE;
+	}
+	utf8 = g_filename_display_name (file);
+	filename = g_path_get_basename (utf8);
+	is_matching = (compare_name_pattern (command_details->refinable_name_pattern, filename) == TRUE) &&
+	              (gsearchtool_predicate_evaluate (command_details->refinable_predicate,
+	                                               command_details->look_in_folder_string,
+	                                               file, file_stat, now) == TRUE);
+	g_free (utf8);
+	g_free (filename);
+
+	return is_matching;
+}
+
+/* Tests the files that changed since the last time again, all at once:
+   the ones that match are added or have their size and date updated,
+   the others are taken out. */
+static gboolean
+watch_timeout_cb (gpointer data)
+{
+	GSearchWindow * gsearch = data;
+	GSearchIoStat * stats;
+	GHashTableIter iter;
+	gpointer key;
+	gchar ** paths;
+	gboolean is_changed = FALSE;
+	gint64 now;
+	guint length;
+	guint idx;
+
+	gsearch->search_results_watch_timeout = 0;
+
+	length = g_hash_table_size (gsearch->search_results_watch_pending);
+	paths = g_new0 (gchar *, length + 1);
+	idx = 0;
+	g_hash_table_iter_init (&iter, gsearch->search_results_watch_pending);
+	while (g_hash_table_iter_next (&iter, &key, NULL) == TRUE) {
+		paths[idx++] = g_strdup (key);
+	}
+	g_hash_table_remove_all (gsearch->search_results_watch_pending);
+
+	stats = g_new (GSearchIoStat, length);
+	gsearchtool_io_stat_files ((const gchar * const *) paths, length, stats);
+
+	now = time (NULL);
+	for (idx = 0; idx < length; idx++) {
+		const gchar * file = paths[idx];
+		GFileInfo * file_info;
+		GTimeVal mtime;
+		gchar * content_type;
+
+		if (stats[idx].error != 0) {
+			is_changed |= gsearch_results_model_remove_file (gsearch->search_results_model, file);
+			continue;
+		}
+		/* A folder made in the tree is watched too. */
+		if (S_ISDIR (stats[idx].mode) &&
+		    (g_hash_table_size (gsearch->search_results_monitor_hash_table) < MAX_WATCHED_FOLDERS)) {
+			watch_folder (gsearch, g_strdup (file));
+		}
+
+		if (is_watched_file_matching (gsearch, file, &stats[idx], now) == FALSE) {
+			is_changed |= gsearch_results_model_remove_file (gsearch->search_results_model, file);
+			continue;
+		}
+
+		content_type = get_content_type (gsearch, file, &stats[idx]);
+		file_info = g_file_info_new ();
+		g_file_info_set_content_type (file_info, content_type);
+		g_file_info_set_size (file_info, stats[idx].size);
+		mtime.tv_sec = stats[idx].mtime;
+		mtime.tv_usec = 0;
+		g_file_info_set_modification_time (file_info, &mtime);
+
+		/* A result that changed keeps its row. */
+		if (gsearch_results_model_update_file (gsearch->search_results_model, file, file_info) == FALSE) {
+			gsearch_results_model_append (gsearch->search_results_model, file, file_info);
+		}
+		g_object_unref (file_info);
+		g_free (content_type);
+		is_changed = TRUE;
+	}
+	g_free (stats);
+	g_strfreev (paths);
+
+	if (is_changed == TRUE) {
+		gsearch_results_model_sort (gsearch->search_results_model);
+		update_search_counts (gsearch);
+	}
+	return FALSE;
+}
+
+/* Queues @file, reported changed by a folder monitor in the watch mode,
+   to be tested again once the changes have settled. */
+void
+queue_watched_file (GSearchWindow * gsearch,
+                    const gchar * file)
+{
+	gchar * key;
+
+	if (gsearch->is_search_results_watched == FALSE) {
+		return;
+	}
+	key = g_strdup (file);
+	g_hash_table_replace (gsearch->search_results_watch_pending, key, key);
+	if (gsearch->search_results_watch_timeout == 0) {
+		gsearch->search_results_watch_timeout = g_timeout_add (GNOME_SEARCH_TOOL_WATCH_DELAY,
+		                                                       watch_timeout_cb, gsearch);
+	}
+}
+
+/* Watches the folders of the searched tree a few at a time, staying on
+   the device of each root and out of the hidden folders the search
+   left out. */
+static gboolean
+watch_folders_idle_cb (gpointer data)
+{
+	GSearchWindow * gsearch = data;
+	GQueue * folders = gsearch->search_results_watch_folders;
+	gint count;
+
+	for (count = 0; count < GNOME_SEARCH_TOOL_WATCH_WALK_BATCH; count++) {
+		GStatBuf folder_stat;
+		const gchar * name;
+		gchar * folder;
+		GDir * dir;
+
+		if ((g_queue_is_empty (folders) == TRUE) ||
+		    (g_hash_table_size (gsearch->search_results_monitor_hash_table) >= MAX_WATCHED_FOLDERS)) {
+			gsearch->search_results_watch_walk = 0;
+			return FALSE;
+		}
+		folder = g_queue_pop_head (folders);
+		if ((g_lstat (folder, &folder_stat) != 0) ||
+		    ((dir = g_dir_open (folder, 0, NULL)) == NULL)) {
+			g_free (folder);
+			continue;
+		}
+		while ((name = g_dir_read_name (dir)) != NULL) {
+			GStatBuf file_stat;
+			gchar * file;
+
+			if ((name[0] == '.') &&
+			    (gsearch->command_details->is_command_show_hidden_files_enabled == FALSE)) {
+				continue;
+			}
+			file = g_build_filename (folder, name, NULL);
+			if ((g_lstat (file, &file_stat) == 0) &&
+			    S_ISDIR (file_stat.st_mode) &&
+			    (file_stat.st_dev == folder_stat.st_dev)) {
+				g_queue_push_tail (folders, file);
+			}
+			else {
+				g_free (file);
+			}
+		}
+		g_dir_close (dir);
+		watch_folder (gsearch, folder);
+	}
+	return TRUE;
+}
+
+static void
+stop_watching_search_results (GSearchWindow * gsearch)
+{
+	if (gsearch->search_results_watch_timeout != 0) {
+		g_source_remove (gsearch->search_results_watch_timeout);
+		gsearch->search_results_watch_timeout = 0;
+	}
+	if (gsearch->search_results_watch_walk != 0) {
+		g_source_remove (gsearch->search_results_watch_walk);
+		gsearch->search_results_watch_walk = 0;
+	}
+	if (gsearch->search_results_watch_pending != NULL) {
+		g_hash_table_destroy (gsearch->search_results_watch_pending);
+		gsearch->search_results_watch_pending = NULL;
+	}
+	if (gsearch->search_results_watch_folders != NULL) {
+		g_queue_foreach (gsearch->search_results_watch_folders, (GFunc) g_free, NULL);
+		g_queue_free (gsearch->search_results_watch_folders);
+		gsearch->search_results_watch_folders = NULL;
+	}
+	gsearch->is_search_results_watched = FALSE;
+}
+
+/* In the watch mode the results of a search that ran to the end are
+   kept current: every folder of the searched tree is watched and the
+   files created or changed in them are tested with the predicate of the
+   search, see watch_timeout_cb().  The tests find runs itself, and the
+   words and regular expression looked for, cannot be run again here. */
+static void
+start_watching_search_results (GSearchWindow * gsearch)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+	guint i;
+
+	if ((gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/watch_search_results") == FALSE) ||
+	    (command_details->refinable_predicate == NULL) ||
+	    (command_details->is_command_regex_matching_enabled == TRUE) ||
+	    (command_details->content_any_words_string != NULL) ||
+	    (command_details->content_all_words_string != NULL) ||
+	    (gsearchtool_predicate_has_kind (command_details->refinable_predicate, GSEARCH_PREDICATE_FIND_TEST) == TRUE)) {
+		return;
+	}
+
+	gsearch->search_results_watch_pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	gsearch->search_results_watch_folders = g_queue_new ();
+	for (i = 0; i < command_details->roots->len; i++) {
+		GSearchRoot * root = g_ptr_array_index (command_details->roots, i);
+
+		g_queue_push_tail (gsearch->search_results_watch_folders, g_strdup (root->folder));
+	}
+	gsearch->search_results_watch_walk = g_idle_add (watch_folders_idle_cb, gsearch);
+	gsearch->is_search_results_watched = TRUE;
+}
+
+static void
+finalize_search_command (GSearchWindow * gsearch)
+{
+	gboolean has_results_table = (gsearch->search_results_monitor_hash_table != NULL);
+
+	gsearch->command_details->command_state = SEARCH_STATE_FINALIZE;
+	gsearch->command_details->command_status = (gsearch->command_details->command_status == MAKE_IT_STOP) ? ABORTED : STOPPED;
+	gsearch->command_details->is_command_timeout_enabled = TRUE;
+	g_timeout_add (500, not_running_timeout_cb, (gpointer) gsearch);
+
+	if (gsearch->search_results_content_scanner != NULL) {
+		if (gsearch->search_results_content_timeout != 0) {
+			g_source_remove (gsearch->search_results_content_timeout);
+			gsearch->search_results_content_timeout = 0;
+		}
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_BYTES_READ,
+		                       gsearchtool_content_scanner_get_bytes_read (gsearch->search_results_content_scanner));
+		gsearchtool_content_scanner_free (gsearch->search_results_content_scanner);
+		gsearch->search_results_content_scanner = NULL;
+	}
+	if (gsearch->search_results_duplicates != NULL) {
+		gsearchtool_stats_add (gsearch->search_stats, GSEARCH_STATS_BYTES_READ,
+		                       gsearchtool_dupes_get_bytes_read (gsearch->search_results_duplicates));
+		gsearchtool_dupes_free (gsearch->search_results_duplicates);
+		gsearch->search_results_duplicates = NULL;
+	}
+
+	if (has_results_table == TRUE) {
+		if (gsearch->search_results_topk != NULL) {
+			add_top_files_to_search_results (gsearch);
+		}
+		if (gsearch->search_results_disk_usage != NULL) {
+			show_disk_usage_summary (gsearch);
+		}
+
+		flush_search_results (gsearch);
+
+		/* Results that came in after the store stopped keeping them in
+		   order are sorted once the search is over. */
+		gsearch_results_model_sort (gsearch->search_results_model);
+		update_search_counts (gsearch);
+		update_search_roots_tooltip (gsearch);
+	}
+	else {
+		/* The search never got to run a command, leave the results alone. */
+		gtk_window_set_title (GTK_WINDOW (gsearch->window), _("Search for Files"));
+	}
+	stop_animation (gsearch);
+
+	/* Only a search that ran to the end and shows every file it found
+	   can be refined. */
+	g_free (gsearch->command_details->refinable_name_pattern);
+	g_free (gsearch->command_details->refinable_key);
+	gsearchtool_predicate_free (gsearch->command_details->refinable_predicate);
+	gsearch->command_details->refinable_name_pattern = NULL;
+	gsearch->command_details->refinable_key = NULL;
+	gsearch->command_details->refinable_predicate = NULL;
+	if ((has_results_table == TRUE) &&
+	    (gsearch->command_details->command_status == STOPPED) &&
+	    (gsearch->command_details->is_command_count_only_enabled == FALSE) &&
+	    (gsearch->command_details->is_command_disk_usage_enabled == FALSE) &&
+	    (gsearch->command_details->is_command_finding_duplicates == FALSE) &&
+	    (gsearch->command_details->top_count == 0)) {
+		gsearch->command_details->refinable_name_pattern = g_strdup (gsearch->command_details->query_name_pattern);
+		gsearch->command_details->refinable_key = g_strdup (gsearch->command_details->query_key);
+		gsearch->command_details->refinable_predicate = gsearch->command_details->predicate;
+		gsearch->command_details->predicate = NULL;
+
+		start_watching_search_results (gsearch);
+	}
+
+	gsearchtool_stats_finish (gsearch->search_stats, (gsearch->command_details->command_status == ABORTED));
+	update_search_statistics (gsearch);
+	gsearchtool_stats_log (gsearch->search_stats,
+	                       gsearchtool_gconf_get_int ("/apps/gnome-search-tool/search_statistics_log_length"));
+
+	/* Free the gchar fields of search_command structure. */
+	free_search_command_strings (gsearch);
+
+	gsearch->command_details->command_state = SEARCH_STATE_IDLE;
+	gsearch->command_details->is_command_live = FALSE;
+
+	/* A search as you type stopped for a broader one, see
+	   update_live_search(). */
+	if (gsearch->command_details->is_live_search_restarting == TRUE) {
+		gsearch->command_details->is_live_search_restarting = FALSE;
+		gsearch->live_search_timeout = g_idle_add (live_search_timeout_cb, gsearch);
+	}
 
-					spacer = gtk_label_new ("     ");
-					gtk_box_pack_start (GTK_BOX (hbox), spacer, FALSE, FALSE, 0);
+	if (GSearchGOptionArguments.batch) {
+		gchar * json;
 
-					expander = gtk_expander_new_with_mnemonic (_("Show more _details"));
-					gtk_container_set_border_width (GTK_CONTAINER (expander), 6);
-					gtk_expander_set_spacing (GTK_EXPANDER (expander), 6);
-					gtk_box_pack_start (GTK_BOX (hbox), expander, TRUE, TRUE, 0);
+		json = gsearchtool_stats_to_json (gsearch->search_stats);
+		g_print ("%s\n", json);
+		g_free (json);
+		gtk_main_quit ();
+	}
+}
 
-					label = gtk_label_new (error_msgs->str);
-					gtk_container_add (GTK_CONTAINER (expander), label);
+static void
+search_command_probe_finished (GSearchWindow * gsearch)
+{
+	if (gsearch->command_details->command_state != SEARCH_STATE_PROBE) {
+		return;
+	}
+	gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_PROBE);
 
-					gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (dialog))), hbox, FALSE, FALSE, 0);
-					gtk_widget_show_all (hbox);
+	if (gsearch->command_details->command_status == RUNNING) {
+		run_search_command_pass (gsearch, SEARCH_STATE_FIRST_PASS);
+	}
+	else {
+		finalize_search_command (gsearch);
+	}
+}
 
-					button = gsearchtool_button_new_with_stock_icon (_("Disable _Quick Search"), GTK_STOCK_OK);
-					gtk_widget_set_can_default (button, TRUE);
-					gtk_widget_show (button);
+static gboolean
+find_duplicates_timeout_cb (gpointer data)
+{
+	GSearchWindow * gsearch = data;
+	GSearchDupesGroup * group;
+	gboolean is_finished;
 
-					gtk_dialog_add_action_widget (GTK_DIALOG (dialog), button, GTK_RESPONSE_OK);
-					gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_OK);
+	if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
+		return FALSE;
+	}
 
-					g_signal_connect (G_OBJECT (dialog),
-					                  "response",
-					                  G_CALLBACK (disable_quick_search_cb), (gpointer) gsearch);
+	/* Checked first, the groups still queued once it is over are the
+	   last ones. */
+	is_finished = gsearchtool_dupes_is_finished (gsearch->search_results_duplicates);
+	while ((group = gsearchtool_dupes_pop_group (gsearch->search_results_duplicates, FALSE)) != NULL) {
+		add_duplicates_to_search_results (gsearch, group);
+		gsearchtool_dupes_group_free (group);
+	}
+	intermediate_file_count_update (gsearch);
 
-					gtk_widget_show (dialog);
-				}
-			}
-			truncate_error_msgs = FALSE;
-			g_string_truncate (error_msgs, 0);
-		}
-		g_io_channel_shutdown (ioc, TRUE, NULL);
+	if ((is_finished == TRUE) || (gsearch->command_details->command_status != RUNNING)) {
+		gsearchtool_stats_phase_end (gsearch->search_stats, GSEARCH_STATS_PHASE_DUPLICATES);
+		finalize_search_command (gsearch);
 		return FALSE;
 	}
 	return TRUE;
 }
 
+/* The files the content scanner found are added from here, while the
+   passes run and after, until the scanner has read them all. */
+static gboolean
+content_scan_timeout_cb (gpointer data)
+{
+	GSearchWindow * gsearch = data;
+	gboolean is_idle;
+
+	if (gsearch->command_details->command_status == MAKE_IT_QUIT) {
+		gsearch->search_results_content_timeout = 0;
+		return FALSE;
+	}
+
+	is_idle = gsearchtool_content_scanner_is_idle (gsearch->search_results_content_scanner);
+	add_content_matches (gsearch);
+
+	if (gsearch->command_details->command_state != SEARCH_STATE_CONTENT_SCAN) {
+		return TRUE;
+	}
+	intermediate_file_count_update (gsearch);
+
+	if ((is_idle == FALSE) && (gsearch->command_details->command_status == RUNNING)) {
+		return TRUE;
+	}
+	gsearch->search_results_content_timeout = 0;
+	search_command_content_scan_finished (gsearch);
+	return FALSE;
+}
+
+/* The files the search found are hashed on other threads, the groups of
+   duplicates are added to the results as they are found. */
 static void
-child_command_set_pgid_cb (gpointer data)
+find_duplicates (GSearchWindow * gsearch)
 {
-	if (setpgid (0, 0) < 0) {
-		g_print (_("Failed to set process group id of child %d: %s.\n"),
-		         getpid (), g_strerror (errno));
+	gsearch->command_details->command_state = SEARCH_STATE_DUPLICATES;
+	gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_DUPLICATES);
+
+	gsearchtool_dupes_start (gsearch->search_results_duplicates);
+	g_timeout_add (GNOME_SEARCH_TOOL_REFRESH_DURATION / 1000, find_duplicates_timeout_cb, gsearch);
+}
+
+/* Called once the passes, and the content scan if any, are over. */
+static void
+search_command_content_scan_finished (GSearchWindow * gsearch)
+{
+	if ((gsearch->command_details->command_status == RUNNING)
+	     && (gsearch->search_results_duplicates != NULL)) {
+		find_duplicates (gsearch);
+	}
+	else {
+		finalize_search_command (gsearch);
+	}
+}
+
+static void
+search_command_pass_finished (GSearchWindow * gsearch)
+{
+	gsearchtool_stats_phase_end (gsearch->search_stats,
+	                             (gsearch->command_details->command_state == SEARCH_STATE_FIRST_PASS) ?
+	                             GSEARCH_STATS_PHASE_FIRST_PASS : GSEARCH_STATS_PHASE_SECOND_PASS);
+
+	if ((gsearch->command_details->command_status == RUNNING)
+	     && (gsearch->command_details->command_state == SEARCH_STATE_FIRST_PASS)
+	     && (gsearch->command_details->is_command_using_quick_mode == TRUE)
+	     && (gsearch->command_details->is_command_second_pass_enabled == TRUE)
+	     && (is_second_scan_excluded_path (gsearch->command_details->look_in_folder_string) == FALSE)) {
+
+		run_search_command_pass (gsearch, SEARCH_STATE_SECOND_PASS);
+	}
+	else if ((gsearch->command_details->command_status == RUNNING)
+	          && (gsearch->search_results_content_scanner != NULL)) {
+		gsearch->command_details->command_state = SEARCH_STATE_CONTENT_SCAN;
+	}
+	else {
+		search_command_content_scan_finished (gsearch);
 	}
 }
 
 void
-spawn_search_command (GSearchWindow * gsearch,
-                      gchar * command)
+start_search_command (GSearchWindow * gsearch)
 {
-	GIOChannel * ioc_stdout;
-	GIOChannel * ioc_stderr;
-	GError * error = NULL;
-	gchar ** argv  = NULL;
-	gint child_stdout;
-	gint child_stderr;
+	if (gsearch->command_details->command_state != SEARCH_STATE_IDLE) {
+		return;
+	}
 
-	if (!g_shell_parse_argv (command, NULL, &argv, &error)) {
-		GtkWidget * dialog;
+	if (gsearch->live_search_timeout != 0) {
+		g_source_remove (gsearch->live_search_timeout);
+		gsearch->live_search_timeout = 0;
+	}
 
-		stop_animation (gsearch);
+	gsearch->command_details->command_status = RUNNING;
+	gsearch->command_details->command_state = SEARCH_STATE_PROBE;
+	start_animation (gsearch, TRUE);
 
-		dialog = gtk_message_dialog_new (GTK_WINDOW (gsearch->window),
-		                                 GTK_DIALOG_DESTROY_WITH_PARENT,
-		                                 GTK_MESSAGE_ERROR,
-		                                 GTK_BUTTONS_OK,
-		                                 _("Error parsing the search command."));
-		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
-		                                          (error == NULL) ? " " : error->message, NULL);
+	/* The folders of the previous results are no longer watched. */
+	stop_watching_search_results (gsearch);
+	if (gsearch->search_results_monitor_hash_table != NULL) {
+		g_hash_table_destroy (gsearch->search_results_monitor_hash_table);
+		gsearch->search_results_monitor_hash_table = NULL;
+	}
 
-		gtk_dialog_run (GTK_DIALOG (dialog));
-		gtk_widget_destroy (dialog);
-		g_error_free (error);
-		g_strfreev (argv);
+	/* The find and grep commands do not report the folders they visit
+	   or the bytes they read, the entries examined are the lines they
+	   print. */
+	gsearchtool_stats_reset (gsearch->search_stats);
+	gsearchtool_stats_set_unknown (gsearch->search_stats, GSEARCH_STATS_DIRECTORIES_VISITED);
+	gsearchtool_stats_set_unknown (gsearch->search_stats, GSEARCH_STATS_BYTES_READ);
+	gtk_label_set_text (GTK_LABEL (gsearch->search_stats_label), "");
+	gtk_widget_set_tooltip_text (gsearch->search_stats_label, NULL);
+	gsearchtool_stats_phase_begin (gsearch->search_stats, GSEARCH_STATS_PHASE_PROBE);
+
+	probe_search_commands (gsearch);
+}
 
-		/* Free the gchar fields of search_command structure. */
-		g_free (gsearch->command_details->look_in_folder_string);
-		g_free (gsearch->command_details->name_contains_pattern_string);
-		g_free (gsearch->command_details->name_contains_regex_string);
-		g_free (gsearch->search_results_date_format_string);
+void
+stop_search_command (GSearchWindow * gsearch,
+                     GSearchCommandStatus status)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+	gboolean is_killed = FALSE;
+	guint i;
+
+	if (command_details->command_status != RUNNING) {
 		return;
 	}
+	command_details->command_status = status;
 
-	if (!g_spawn_async_with_pipes (g_get_home_dir (), argv, NULL,
-				       G_SPAWN_SEARCH_PATH,
-				       child_command_set_pgid_cb, NULL, &gsearch->command_details->command_pid, NULL, &child_stdout,
-				       &child_stderr, &error)) {
-		GtkWidget * dialog;
+	for (i = 0; (command_details->roots != NULL) && (i < command_details->roots->len); i++) {
+		GSearchRoot * root = g_ptr_array_index (command_details->roots, i);
 
-		stop_animation (gsearch);
+		if (root->pid > 0) {
+#ifdef HAVE_GETPGID
+			pid_t pgid;
 
-		dialog = gtk_message_dialog_new (GTK_WINDOW (gsearch->window),
-		                                 GTK_DIALOG_DESTROY_WITH_PARENT,
-		                                 GTK_MESSAGE_ERROR,
-		                                 GTK_BUTTONS_OK,
-		                                 _("Error running the search command."));
-		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog),
-		                                          (error == NULL) ? " " : error->message, NULL);
+			pgid = getpgid (root->pid);
 
-		gtk_dialog_run (GTK_DIALOG (dialog));
-		gtk_widget_destroy (dialog);
-		g_error_free (error);
-		g_strfreev (argv);
+			if ((pgid > 1) && (pgid != getpid ())) {
+				kill (-pgid, SIGKILL);
+			}
+			else {
+				kill (root->pid, SIGKILL);
+			}
+#else
+			kill (root->pid, SIGKILL);
+#endif
+			is_killed = TRUE;
+		}
+	}
+	if ((is_killed == FALSE) && (command_details->command_state == SEARCH_STATE_PROBE) && (status == MAKE_IT_STOP)) {
+		/* Nothing is running for this search yet, the probe finishes on its own. */
+		finalize_search_command (gsearch);
+	}
+}
 
-		/* Free the gchar fields of search_command structure. */
-		g_free (gsearch->command_details->look_in_folder_string);
-		g_free (gsearch->command_details->name_contains_pattern_string);
-		g_free (gsearch->command_details->name_contains_regex_string);
-		g_free (gsearch->search_results_date_format_string);
-		return;
+/* The name pattern a search for @text looks for, as in
+   build_search_command(). */
+static gchar *
+get_name_pattern (const gchar * text)
+{
+	if ((text == NULL) || (*text == '\0')) {
+		return g_strdup ("*");
 	}
+	if ((strchr (text, '*') == NULL) && (strchr (text, '?') == NULL)) {
+		return g_strconcat ("*", text, "*", NULL);
+	}
+	return g_strdup (text);
+}
 
-	if (gsearch->command_details->is_command_first_pass == TRUE) {
+/* Whether the running search can go on with @name_pattern, a narrower
+   one, see narrow_running_search(). */
+static gboolean
+is_running_search_narrowed (GSearchWindow * gsearch,
+                            const gchar * name_pattern)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+
+	return ((command_details->command_state == SEARCH_STATE_FIRST_PASS) ||
+	        (command_details->command_state == SEARCH_STATE_SECOND_PASS)) &&
+	       (command_details->query_name_pattern != NULL) &&
+	       (gsearch->search_results_content_scanner == NULL) &&
+	       (gsearch->search_results_topk == NULL) &&
+	       (gsearch->search_results_disk_usage == NULL) &&
+	       (gsearch->search_results_duplicates == NULL) &&
+	       (command_details->is_command_count_only_enabled == FALSE) &&
+	       (is_name_pattern_narrower (name_pattern, command_details->query_name_pattern) == TRUE);
+}
+
+static gboolean
+is_result_name_matching (const GSearchResultsRecord * record,
+                         gpointer data)
+{
+	const gchar * name_pattern = data;
+	gchar * utf8;
+	gchar * filename;
+	gboolean is_matching;
+
+	utf8 = g_filename_display_name (record->path);
+	filename = g_path_get_basename (utf8);
+	is_matching = compare_name_pattern (name_pattern, filename);
+	g_free (utf8);
+	g_free (filename);
+
+	return is_matching;
+}
 
-		gsearch->command_details->command_status = RUNNING;
-		gsearch->search_results_pixbuf_hash_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
-		gsearch->search_results_filename_hash_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+/* Takes the files found so far that do not match @name_pattern out of
+   the results, the files still to come are filtered on it in
+   add_search_command_output_line(). */
+static void
+narrow_running_search (GSearchWindow * gsearch,
+                       const gchar * name_pattern)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+
+	flush_search_candidates (gsearch);
+	flush_search_results (gsearch);
+
+	g_free (command_details->name_contains_pattern_string);
+	g_free (command_details->query_name_pattern);
+	command_details->name_contains_pattern_string = g_strdup (name_pattern);
+	command_details->query_name_pattern = g_strdup (name_pattern);
 
-		/* Get value of nautilus date_format key */
-		gsearch->search_results_date_format_string = gsearchtool_gconf_get_string ("/apps/nautilus/preferences/date_format");
+	gsearch_results_model_filter (gsearch->search_results_model, is_result_name_matching,
+	                              command_details->query_name_pattern);
 
-		gtk_tree_view_scroll_to_point (GTK_TREE_VIEW (gsearch->search_results_tree_view), 0, 0);
-		gtk_tree_model_foreach (GTK_TREE_MODEL (gsearch->search_results_list_store),
-					(GtkTreeModelForeachFunc) tree_model_iter_free_monitor, gsearch);
-		gtk_list_store_clear (GTK_LIST_STORE (gsearch->search_results_list_store));
-		
-		gtk_tree_view_column_set_visible (gsearch->search_results_folder_column, TRUE);
-		gtk_tree_view_column_set_visible (gsearch->search_results_size_column, TRUE);
-		gtk_tree_view_column_set_visible (gsearch->search_results_type_column, TRUE);
-		gtk_tree_view_column_set_visible (gsearch->search_results_date_column, TRUE);
+	intermediate_file_count_update (gsearch);
+}
+
+static void
+start_live_search (GSearchWindow * gsearch)
+{
+	if (gsearch->command_details->command_state != SEARCH_STATE_IDLE) {
+		return;
 	}
+	gsearch->command_details->is_command_live = TRUE;
+	start_search_command (gsearch);
+}
 
-	ioc_stdout = g_io_channel_unix_new (child_stdout);
-	ioc_stderr = g_io_channel_unix_new (child_stderr);
+static gboolean
+live_search_timeout_cb (gpointer data)
+{
+	GSearchWindow * gsearch = data;
 
-	g_io_channel_set_encoding (ioc_stdout, NULL, NULL);
-	g_io_channel_set_encoding (ioc_stderr, NULL, NULL);
+	gsearch->live_search_timeout = 0;
+	if (gsearch->command_details->command_status == RUNNING) {
+		gsearch->command_details->is_live_search_restarting = TRUE;
+		stop_search_command (gsearch, MAKE_IT_STOP);
+	}
+	else {
+		start_live_search (gsearch);
+	}
+	return FALSE;
+}
 
-	g_io_channel_set_flags (ioc_stdout, G_IO_FLAG_NONBLOCK, NULL);
-	g_io_channel_set_flags (ioc_stderr, G_IO_FLAG_NONBLOCK, NULL);
+/* In the search as you type mode each change of the name is searched
+   for.  A longer name only narrows the search down, the running one goes
+   on or the results shown are filtered, at once.  Any other change waits
+   for the typing to pause, then starts the search over. */
+void
+update_live_search (GSearchWindow * gsearch)
+{
+	GSearchCommandDetails * command_details = gsearch->command_details;
+	const gchar * text;
+	gchar * name_pattern;
 
-	g_io_add_watch (ioc_stdout, G_IO_IN | G_IO_HUP,
-			handle_search_command_stdout_io, gsearch);
-	g_io_add_watch (ioc_stderr, G_IO_IN | G_IO_HUP,
-			handle_search_command_stderr_io, gsearch);
+	if (gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/search_as_you_type") == FALSE) {
+		return;
+	}
+	if (gsearch->live_search_timeout != 0) {
+		g_source_remove (gsearch->live_search_timeout);
+		gsearch->live_search_timeout = 0;
+	}
 
-	g_io_channel_unref (ioc_stdout);
-	g_io_channel_unref (ioc_stderr);
-	g_strfreev (argv);
+	text = gtk_entry_get_text (GTK_ENTRY (gsearch_history_entry_get_entry
+	                                      (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry))));
+	if (*text == '\0') {
+		stop_search_command (gsearch, MAKE_IT_STOP);
+		return;
+	}
+	name_pattern = get_name_pattern (text);
+
+	if ((command_details->command_status == RUNNING) &&
+	    (is_running_search_narrowed (gsearch, name_pattern) == TRUE)) {
+		narrow_running_search (gsearch, name_pattern);
+	}
+	else if ((command_details->command_state == SEARCH_STATE_IDLE) &&
+	         (command_details->refinable_name_pattern != NULL) &&
+	         (is_name_pattern_narrower (name_pattern, command_details->refinable_name_pattern) == TRUE)) {
+		start_live_search (gsearch);
+	}
+	else {
+		gsearch->live_search_timeout = g_timeout_add (GNOME_SEARCH_TOOL_LIVE_SEARCH_DELAY,
+		                                              live_search_timeout_cb, gsearch);
+	}
+	g_free (name_pattern);
 }
 
 static GtkWidget *
@@ -2276,6 +4816,11 @@ create_search_results_section (GSearchWindow * gsearch)
 	g_object_set (G_OBJECT (gsearch->files_found_label), "xalign", 1.0, NULL);
 	gtk_box_pack_start (GTK_BOX (hbox), gsearch->files_found_label, TRUE, TRUE, 0);
 
+	gsearch->search_stats_label = gtk_label_new (NULL);
+	gtk_label_set_selectable (GTK_LABEL (gsearch->search_stats_label), TRUE);
+	gtk_widget_set_no_show_all (gsearch->search_stats_label, TRUE);
+	gtk_box_pack_start (GTK_BOX (hbox), gsearch->search_stats_label, FALSE, FALSE, 0);
+
 	window = gtk_scrolled_window_new (NULL, NULL);
 	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (window), GTK_SHADOW_IN);
 	gtk_container_set_border_width (GTK_CONTAINER (window), 0);
@@ -2284,26 +4829,20 @@ create_search_results_section (GSearchWindow * gsearch)
                                         GTK_POLICY_AUTOMATIC,
                                         GTK_POLICY_AUTOMATIC);
 
-	gsearch->search_results_list_store = gtk_list_store_new (NUM_COLUMNS,
-					      GDK_TYPE_PIXBUF,
-					      G_TYPE_STRING,
-					      G_TYPE_STRING,
-					      G_TYPE_STRING,
-					      G_TYPE_STRING,
-					      G_TYPE_DOUBLE,
-					      G_TYPE_STRING,
-					      G_TYPE_STRING,
-					      G_TYPE_DOUBLE,
-					      G_TYPE_POINTER,
-					      G_TYPE_BOOLEAN);
-
-	gsearch->search_results_tree_view = GTK_TREE_VIEW (gtk_tree_view_new_with_model (GTK_TREE_MODEL (gsearch->search_results_list_store)));
+	gsearch->search_results_pixbuf_hash_table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+	gsearch->search_results_model = gsearch_results_model_new (get_search_result_pixbuf, gsearch);
+
+	gsearch->search_results_tree_view = GTK_TREE_VIEW (gtk_tree_view_new_with_model (GTK_TREE_MODEL (gsearch->search_results_model)));
+
+	/* Every row has the same height, the view does not need to measure
+	   each of them when there are millions. */
+	gtk_tree_view_set_fixed_height_mode (gsearch->search_results_tree_view, TRUE);
 
 	gtk_tree_view_set_headers_visible (gsearch->search_results_tree_view, FALSE);
 	gtk_tree_view_set_search_equal_func (gsearch->search_results_tree_view,
 	                                     gsearch_equal_func, NULL, NULL);
 	gtk_tree_view_set_rules_hint (gsearch->search_results_tree_view, TRUE);
-  	g_object_unref (G_OBJECT (gsearch->search_results_list_store));
+  	g_object_unref (G_OBJECT (gsearch->search_results_model));
 
 	if (gsearch->is_window_accessible) {
 		add_atk_namedesc (GTK_WIDGET (gsearch->search_results_tree_view), _("List View"), NULL);
@@ -2359,10 +4898,71 @@ create_search_results_section (GSearchWindow * gsearch)
 	                  G_CALLBACK (file_leave_notify_cb),
 	                  (gpointer) gsearch);
 
+	/* the words a file was found with, for the multi-word content search */
+	gtk_widget_set_has_tooltip (GTK_WIDGET (gsearch->search_results_tree_view), TRUE);
+	g_signal_connect (G_OBJECT (gsearch->search_results_tree_view),
+	                  "query_tooltip",
+	                  G_CALLBACK (file_query_tooltip_cb),
+	                  (gpointer) gsearch);
+
 	gtk_label_set_mnemonic_widget (GTK_LABEL (label), GTK_WIDGET (gsearch->search_results_tree_view));
 
 	gtk_container_add (GTK_CONTAINER (window), GTK_WIDGET (gsearch->search_results_tree_view));
 	gtk_box_pack_end (GTK_BOX (vbox), window, TRUE, TRUE, 0);
+	gsearch->search_results_window = window;
+
+	/* create the disk usage summary, shown in place of the results */
+	window = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (window), GTK_SHADOW_IN);
+	gtk_container_set_border_width (GTK_CONTAINER (window), 0);
+	gtk_widget_set_size_request (window, 530, 160);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (window),
+                                        GTK_POLICY_AUTOMATIC,
+                                        GTK_POLICY_AUTOMATIC);
+	gtk_widget_set_no_show_all (window, TRUE);
+
+	gsearch->disk_usage_tree_store = gtk_tree_store_new (DISK_USAGE_NUM_COLUMNS,
+							     G_TYPE_STRING,
+							     G_TYPE_STRING,
+							     G_TYPE_STRING,
+							     G_TYPE_POINTER);
+	gsearch->disk_usage_tree_view = GTK_TREE_VIEW (gtk_tree_view_new_with_model (GTK_TREE_MODEL (gsearch->disk_usage_tree_store)));
+	gtk_tree_view_set_rules_hint (gsearch->disk_usage_tree_view, TRUE);
+	g_object_unref (G_OBJECT (gsearch->disk_usage_tree_store));
+
+	g_signal_connect (G_OBJECT (gsearch->disk_usage_tree_view),
+	                  "test_expand_row",
+	                  G_CALLBACK (disk_usage_test_expand_row_cb),
+	                  (gpointer) gsearch);
+
+	renderer = gtk_cell_renderer_text_new ();
+	column = gtk_tree_view_column_new_with_attributes (_("Folder"), renderer,
+							   "text", DISK_USAGE_COLUMN_NAME,
+							   NULL);
+	gtk_tree_view_column_set_resizable (column, TRUE);
+	gtk_tree_view_column_set_expand (column, TRUE);
+	gtk_tree_view_append_column (gsearch->disk_usage_tree_view, column);
+
+	renderer = gtk_cell_renderer_text_new ();
+	g_object_set (renderer, "xalign", 1.0, NULL);
+	column = gtk_tree_view_column_new_with_attributes (_("Size"), renderer,
+							   "text", DISK_USAGE_COLUMN_READABLE_SIZE,
+							   NULL);
+	gtk_tree_view_column_set_resizable (column, TRUE);
+	gtk_tree_view_append_column (gsearch->disk_usage_tree_view, column);
+
+	renderer = gtk_cell_renderer_text_new ();
+	g_object_set (renderer, "xalign", 1.0, NULL);
+	column = gtk_tree_view_column_new_with_attributes (_("Files"), renderer,
+							   "text", DISK_USAGE_COLUMN_FILES,
+							   NULL);
+	gtk_tree_view_column_set_resizable (column, TRUE);
+	gtk_tree_view_append_column (gsearch->disk_usage_tree_view, column);
+
+	gtk_widget_show (GTK_WIDGET (gsearch->disk_usage_tree_view));
+	gtk_container_add (GTK_CONTAINER (window), GTK_WIDGET (gsearch->disk_usage_tree_view));
+	gtk_box_pack_end (GTK_BOX (vbox), window, TRUE, TRUE, 0);
+	gsearch->disk_usage_window = window;
 
 	/* create the name column */
 	column = gtk_tree_view_column_new ();
@@ -2379,7 +4979,8 @@ create_search_results_section (GSearchWindow * gsearch)
         gtk_tree_view_column_set_attributes (column, gsearch->search_results_name_cell_renderer,
                                              "text", COLUMN_NAME,
 					     NULL);
-	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 200);
 	gtk_tree_view_column_set_resizable (column, TRUE);
 	gtk_tree_view_column_set_sort_column_id (column, COLUMN_NAME);
 	gtk_tree_view_column_set_reorderable (column, TRUE);
@@ -2393,7 +4994,8 @@ create_search_results_section (GSearchWindow * gsearch)
 	column = gtk_tree_view_column_new_with_attributes (_("Folder"), renderer,
 							   "text", COLUMN_RELATIVE_PATH,
 							   NULL);
-	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 200);
 	gtk_tree_view_column_set_resizable (column, TRUE);
 	gtk_tree_view_column_set_sort_column_id (column, COLUMN_RELATIVE_PATH);
 	gtk_tree_view_column_set_reorderable (column, TRUE);
@@ -2406,7 +5008,8 @@ create_search_results_section (GSearchWindow * gsearch)
 	column = gtk_tree_view_column_new_with_attributes (_("Size"), renderer,
 							   "text", COLUMN_READABLE_SIZE,
 							   NULL);
-	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 75);
 	gtk_tree_view_column_set_resizable (column, TRUE);
 	gtk_tree_view_column_set_sort_column_id (column, COLUMN_SIZE);
 	gtk_tree_view_column_set_reorderable (column, TRUE);
@@ -2418,7 +5021,8 @@ create_search_results_section (GSearchWindow * gsearch)
 	column = gtk_tree_view_column_new_with_attributes (_("Type"), renderer,
 							   "text", COLUMN_TYPE,
 							   NULL);
-	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 120);
 	gtk_tree_view_column_set_resizable (column, TRUE);
 	gtk_tree_view_column_set_sort_column_id (column, COLUMN_TYPE);
 	gtk_tree_view_column_set_reorderable (column, TRUE);
@@ -2430,7 +5034,8 @@ create_search_results_section (GSearchWindow * gsearch)
 	column = gtk_tree_view_column_new_with_attributes (_("Date Modified"), renderer,
 							   "text", COLUMN_READABLE_DATE,
 							   NULL);
-	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_AUTOSIZE);
+	gtk_tree_view_column_set_sizing (column, GTK_TREE_VIEW_COLUMN_FIXED);
+	gtk_tree_view_column_set_fixed_width (column, 150);
 	gtk_tree_view_column_set_resizable (column, TRUE);
 	gtk_tree_view_column_set_sort_column_id (column, COLUMN_DATE);
 	gtk_tree_view_column_set_reorderable (column, TRUE);
@@ -2543,6 +5148,30 @@ set_clone_command (GSearchWindow * gsearch,
 				argv[i++] = g_strdup_printf ("--contains=%s", tmp);
 				g_free (tmp);
 				break;
+			case SEARCH_CONSTRAINT_CONTAINS_ANY_OF_THE_WORDS:
+				locale = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				if (escape_values)
+					tmp = g_shell_quote (locale);
+				else
+					tmp = g_strdup (locale);
+				argv[i++] = g_strdup_printf ("--contains-any=%s", tmp);
+				g_free (tmp);
+				break;
+			case SEARCH_CONSTRAINT_CONTAINS_ALL_OF_THE_WORDS:
+				locale = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				if (escape_values)
+					tmp = g_shell_quote (locale);
+				else
+					tmp = g_strdup (locale);
+				argv[i++] = g_strdup_printf ("--contains-all=%s", tmp);
+				g_free (tmp);
+				break;
+			case SEARCH_CONSTRAINT_SEARCH_COMPRESSED_FILES:
+				argv[i++] = g_strdup ("--compressed");
+				break;
+			case SEARCH_CONSTRAINT_MATCH_ARCHIVE_MEMBER_NAMES:
+				argv[i++] = g_strdup ("--member-names");
+				break;
 			case SEARCH_CONSTRAINT_DATE_MODIFIED_BEFORE:
 				argv[i++] = g_strdup_printf ("--mtimeless=%d", constraint->data.time);
 				break;
@@ -2606,6 +5235,42 @@ set_clone_command (GSearchWindow * gsearch,
 			case SEARCH_CONSTRAINT_SEARCH_OTHER_FILESYSTEMS:
 				argv[i++] = g_strdup ("--mounts");
 				break;
+			case SEARCH_CONSTRAINT_ALSO_LOOK_IN_FOLDERS:
+				locale = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				if (escape_values)
+					tmp = g_shell_quote (locale);
+				else
+					tmp = g_strdup (locale);
+				argv[i++] = g_strdup_printf ("--also-path=%s", tmp);
+				g_free (tmp);
+				break;
+			case SEARCH_CONSTRAINT_SKIP_FILESYSTEMS:
+				locale = g_locale_from_utf8 (constraint->data.text, -1, NULL, NULL, NULL);
+				if (escape_values)
+					tmp = g_shell_quote (locale);
+				else
+					tmp = g_strdup (locale);
+				argv[i++] = g_strdup_printf ("--skip-fs=%s", tmp);
+				g_free (tmp);
+				break;
+			case SEARCH_CONSTRAINT_TOP_LARGEST_FILES:
+				argv[i++] = g_strdup_printf ("--top-largest=%u", constraint->data.number);
+				break;
+			case SEARCH_CONSTRAINT_TOP_NEWEST_FILES:
+				argv[i++] = g_strdup_printf ("--top-newest=%u", constraint->data.number);
+				break;
+			case SEARCH_CONSTRAINT_TOP_OLDEST_FILES:
+				argv[i++] = g_strdup_printf ("--top-oldest=%u", constraint->data.number);
+				break;
+			case SEARCH_CONSTRAINT_DISK_USAGE_BY_FOLDER:
+				argv[i++] = g_strdup ("--du");
+				break;
+			case SEARCH_CONSTRAINT_COUNT_ONLY:
+				argv[i++] = g_strdup ("--count");
+				break;
+			case SEARCH_CONSTRAINT_FIND_DUPLICATES:
+				argv[i++] = g_strdup ("--duplicates");
+				break;
 			default:
 				break;
 			}
@@ -2714,6 +5379,7 @@ gsearch_app_create (GSearchWindow * gsearch)
 			  G_CALLBACK (gsearch_window_size_allocate),
 			  gsearch);
 	gsearch->command_details = g_slice_new0 (GSearchCommandDetails);
+	gsearch->search_stats = gsearchtool_stats_new ();
 	gsearch->window_geometry.min_height = MINIMUM_WINDOW_HEIGHT;
 	gsearch->window_geometry.min_width  = MINIMUM_WINDOW_WIDTH;
 
@@ -2763,6 +5429,9 @@ gsearch_app_create (GSearchWindow * gsearch)
 	g_signal_connect (G_OBJECT (gsearch_history_entry_get_entry (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry))), "activate",
 			  G_CALLBACK (name_contains_activate_cb),
 			  (gpointer) gsearch);
+	g_signal_connect (G_OBJECT (gsearch_history_entry_get_entry (GSEARCH_HISTORY_ENTRY (gsearch->name_contains_entry))), "changed",
+			  G_CALLBACK (name_contains_changed_cb),
+			  (gpointer) gsearch);
 
 	label = gtk_label_new_with_mnemonic (_("_Look in folder:"));
 	gtk_label_set_justify (GTK_LABEL (label), GTK_JUSTIFY_LEFT);
@@ -2924,6 +5593,14 @@ gsearchtool_setup_gconf_notifications (GSearchWindow * gsearch)
 {
 	gchar * click_to_activate_pref;
 
+	set_search_statistics_visible (gsearch,
+	                               gsearchtool_gconf_get_boolean ("/apps/gnome-search-tool/show_search_statistics"));
+
+	gsearchtool_gconf_watch_key ("/apps/gnome-search-tool",
+	                             "/apps/gnome-search-tool/show_search_statistics",
+	                             (GConfClientNotifyFunc) show_search_statistics_key_changed_cb,
+	                             gsearch);
+
 	/* Get value of nautilus click behavior (single or double click to activate items) */
 	click_to_activate_pref = gsearchtool_gconf_get_string ("/apps/nautilus/preferences/click_policy");
 
@@ -2973,6 +5650,22 @@ main (int argc,
 
 	g_option_context_free (context);
 
+	/* The index is built without a window, for a cron job to keep it
+	   current. */
+	if (GSearchGOptionArguments.update_index != NULL) {
+		gchar * path = gsearchtool_index_get_default_path ();
+
+		if (gsearchtool_index_build (GSearchGOptionArguments.update_index, path, &error) == FALSE) {
+			g_printerr (_("Failed to index %s: %s\n"), GSearchGOptionArguments.update_index,
+			            (error != NULL) ? error->message : g_strerror (errno));
+			g_clear_error (&error);
+			g_free (path);
+			return (-1);
+		}
+		g_free (path);
+		return 0;
+	}
+
 	g_set_application_name (_("Search for Files"));
 	gtk_window_set_default_icon_name (GNOME_SEARCH_TOOL_ICON);
 
@@ -3003,7 +5696,14 @@ main (int argc,
 		                  (gpointer) gsearch);
 	}
 
-	gtk_widget_show (gsearch->window);
+	/* Batch mode runs the search from the command line arguments without
+	   showing the window, see finalize_search_command(). */
+	if (GSearchGOptionArguments.batch) {
+		GSearchGOptionArguments.start = TRUE;
+	}
+	else {
+		gtk_widget_show (gsearch->window);
+	}
 
 	gsearchtool_setup_gconf_notifications (gsearch);
 
@@ -37,6 +37,19 @@ extern "C" {
 #include <gconf/gconf.h>
 #include <gconf/gconf-client.h>
 
+#include "gsearchtool-stats.h"
+#include "gsearchtool-results-model.h"
+#include "gsearchtool-topk.h"
+#include "gsearchtool-content.h"
+#include "gsearchtool-du.h"
+#include "gsearchtool-dupes.h"
+#include "gsearchtool-device.h"
+#include "gsearchtool-io.h"
+#include "gsearchtool-predicate.h"
+#include "gsearchtool-planner.h"
+#include "gsearchtool-locate.h"
+#include "gsearchtool-index.h"
+
 #define GSEARCH_TYPE_WINDOW gsearch_window_get_type()
 #define GSEARCH_WINDOW(obj) \
   (G_TYPE_CHECK_INSTANCE_CAST ((obj), GSEARCH_TYPE_WINDOW, GSearchWindow))
@@ -65,6 +78,16 @@ typedef enum {
 	MAKE_IT_QUIT
 } GSearchCommandStatus;
 
+typedef enum {
+	SEARCH_STATE_IDLE,
+	SEARCH_STATE_PROBE,
+	SEARCH_STATE_FIRST_PASS,
+	SEARCH_STATE_SECOND_PASS,
+	SEARCH_STATE_CONTENT_SCAN,
+	SEARCH_STATE_DUPLICATES,
+	SEARCH_STATE_FINALIZE
+} GSearchCommandState;
+
 typedef enum {
 	COLUMN_ICON,
 	COLUMN_NAME,
@@ -75,16 +98,23 @@ typedef enum {
 	COLUMN_TYPE,
 	COLUMN_READABLE_DATE,
 	COLUMN_DATE,
-	COLUMN_MONITOR,
 	COLUMN_NO_FILES_FOUND,
 	NUM_COLUMNS
 } GSearchResultColumns;
 
+typedef enum {
+	DISK_USAGE_COLUMN_NAME,
+	DISK_USAGE_COLUMN_READABLE_SIZE,
+	DISK_USAGE_COLUMN_FILES,
+	DISK_USAGE_COLUMN_FOLDER,
+	DISK_USAGE_NUM_COLUMNS
+} GSearchDiskUsageColumns;
+
 typedef struct _GSearchWindow GSearchWindow;
 typedef struct _GSearchWindowClass GSearchWindowClass;
 typedef struct _GSearchCommandDetails GSearchCommandDetails;
 typedef struct _GSearchConstraint GSearchConstraint;
-typedef struct _GSearchMonitor GSearchMonitor;
+typedef struct _GSearchRoot GSearchRoot;
 
 struct _GSearchWindow {
 	GtkWindow               parent_instance;
@@ -114,23 +144,42 @@ struct _GSearchWindow {
 	GList                 * available_options_selected_list;
 
 	GtkWidget             * files_found_label;
+	GtkWidget             * search_stats_label;
 	GtkWidget             * search_results_vbox;
 	GtkWidget             * search_results_popup_menu;
 	GtkWidget             * search_results_popup_submenu;
 	GtkWidget             * search_results_save_results_as_item;
+	GtkWidget             * search_results_window;
 	GtkTreeView           * search_results_tree_view;
 	GtkTreeViewColumn     * search_results_folder_column;
 	GtkTreeViewColumn     * search_results_size_column;
 	GtkTreeViewColumn     * search_results_type_column;
 	GtkTreeViewColumn     * search_results_date_column;
-	GtkListStore          * search_results_list_store;
+	GSearchResultsModel   * search_results_model;
 	GtkCellRenderer       * search_results_name_cell_renderer;
 	GtkTreeSelection      * search_results_selection;
-	GtkTreeIter             search_results_iter;
 	GtkTreePath           * search_results_hover_path;
-	GHashTable            * search_results_filename_hash_table;
 	GHashTable            * search_results_pixbuf_hash_table;
-	gchar                 * search_results_date_format_string;
+	GHashTable            * search_results_monitor_hash_table;
+	GSearchTopK           * search_results_topk;
+	GSearchDiskUsage      * search_results_disk_usage;
+	GSearchDupes          * search_results_duplicates;
+	GSearchContentScanner * search_results_content_scanner;
+	guint                   search_results_content_timeout;
+	guint                   live_search_timeout;
+	GHashTable            * search_results_watch_pending;
+	GQueue                * search_results_watch_folders;
+	guint                   search_results_watch_timeout;
+	guint                   search_results_watch_walk;
+	gboolean                is_search_results_watched;
+	GHashTable            * search_results_content_hits;
+	GArray                * search_results_pending;
+	GArray                * search_candidates;
+	guint                   search_results_counted_files;
+	GtkWidget             * disk_usage_window;
+	GtkTreeView           * disk_usage_tree_view;
+	GtkTreeStore          * disk_usage_tree_store;
+	GSearchStats          * search_stats;
 	gint		        show_thumbnails_file_size_limit;
 	gboolean		show_thumbnails;
 	gboolean                is_search_results_single_click_to_activate;
@@ -142,20 +191,71 @@ struct _GSearchWindow {
 	GSearchCommandDetails * command_details;
 };
 
+/* A folder the search looks in.  Each one has its own command, the
+   commands of a pass run at once, as many on each device as it takes. */
+struct _GSearchRoot {
+	GSearchWindow         * gsearch;
+	gchar                 * folder;
+	gchar                 * command;
+	guint64                 device;
+	pid_t                   pid;
+	gint                    open_pipes;
+	GSearchLocateCursor   * locate_cursor;
+	GSearchIndexCursor    * index_cursor;
+	guint                   database_source;
+	guint                   entries;
+	gboolean                is_printing_inodes;
+	gboolean                is_started;
+	gboolean                is_finished;
+};
+
 struct _GSearchCommandDetails {
-	pid_t                   command_pid;
+	GPtrArray             * roots;
 	GSearchCommandStatus    command_status;
+	GSearchCommandState     command_state;
+	gint                    command_running_roots;
+	gint                    command_open_error_pipes;
 
 	gchar                 * name_contains_pattern_string;
 	gchar                 * name_contains_regex_string;
+	gchar                 * content_any_words_string;
+	gchar                 * content_all_words_string;
 	gchar                 * look_in_folder_string;
 
+	GSearchTopKKind         top_kind;
+	guint                   top_count;
+
+	GSearchPredicate      * predicate;
+	GSearchPlan             plan;
+
+	/* Read in place of running the locate command, see
+	   read_search_database(). */
+	GSearchLocateDatabase * locate_database;
+	GSearchIndex          * search_index;
+
+	/* What the first pass looked for, and what the results still shown
+	   were found with, see is_search_refinement(). */
+	gchar                 * query_name_pattern;
+	gchar                 * query_key;
+	gchar                 * refinable_name_pattern;
+	gchar                 * refinable_key;
+	GSearchPredicate      * refinable_predicate;
+
 	gboolean		is_command_first_pass;
 	gboolean		is_command_using_quick_mode;
+	gboolean		is_command_stating_candidates;
 	gboolean		is_command_second_pass_enabled;
 	gboolean		is_command_show_hidden_files_enabled;
 	gboolean		is_command_regex_matching_enabled;
+	gboolean		is_command_printing_file_details;
+	gboolean		is_command_disk_usage_enabled;
+	gboolean		is_command_count_only_enabled;
+	gboolean		is_command_finding_duplicates;
+	gboolean		is_command_decompress_enabled;
+	gboolean		is_command_member_names_enabled;
 	gboolean		is_command_timeout_enabled;
+	gboolean		is_command_live;
+	gboolean		is_live_search_restarting;
 };
 
 struct _GSearchConstraint {
@@ -171,21 +271,23 @@ struct _GSearchWindowClass {
 	GtkWindowClass parent_class;
 };
 
-struct _GSearchMonitor {
-	GSearchWindow         * gsearch;
-	GtkTreeRowReference   * reference;
-	GFileMonitor          * handle;
-};
-
 GType
 gsearch_window_get_type (void);
 
-gchar *
+void
+start_search_command (GSearchWindow * gsearch);
+
+void
+stop_search_command (GSearchWindow * gsearch,
+                     GSearchCommandStatus status);
+void
+update_live_search (GSearchWindow * gsearch);
+gboolean
 build_search_command (GSearchWindow * gsearch,
                       gboolean first_pass);
-void
+gboolean
 spawn_search_command (GSearchWindow * gsearch,
-                      gchar * command);
+                      GSearchRoot * root);
 void
 add_constraint (GSearchWindow * gsearch,
                 gint constraint_id,
@@ -213,11 +315,16 @@ set_clone_command (GSearchWindow * gsearch,
 void
 update_search_counts (GSearchWindow * gsearch);
 
-gboolean
-tree_model_iter_free_monitor (GtkTreeModel * model,
-                              GtkTreePath * path,
-                              GtkTreeIter * iter,
-                              gpointer data);
+void
+queue_watched_file (GSearchWindow * gsearch,
+                    const gchar * file);
+
+void
+set_search_statistics_visible (GSearchWindow * gsearch,
+                               gboolean visible);
+void
+add_disk_usage_folders (GSearchWindow * gsearch,
+                        GtkTreeIter * parent);
 
 #ifdef __cplusplus
 }
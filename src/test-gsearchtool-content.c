@@ -0,0 +1,327 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-content.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the multi-pattern content matching.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-content.h"
+
+static GSearchContentPatterns *
+new_patterns (const gchar * first,
+              ...)
+{
+	GSearchContentPatterns * patterns;
+	const gchar * pattern;
+	va_list args;
+
+	patterns = gsearchtool_content_patterns_new ();
+	va_start (args, first);
+	for (pattern = first; pattern != NULL; pattern = va_arg (args, const gchar *)) {
+		g_assert (gsearchtool_content_patterns_add (patterns, pattern, FALSE));
+	}
+	va_end (args);
+
+	return patterns;
+}
+
+static gchar *
+scan (GSearchContentPatterns * patterns,
+      const gchar * text)
+{
+	guint64 hits;
+
+	hits = gsearchtool_content_patterns_scan (patterns, text, strlen (text));
+	return gsearchtool_content_patterns_get_hits_string (patterns, hits);
+}
+
+static void
+test_content_overlapping (void)
+{
+	GSearchContentPatterns * patterns;
+	gchar * hits;
+
+	patterns = new_patterns ("he", "she", "his", "hers", NULL);
+
+	hits = scan (patterns, "ushers");
+	g_assert_cmpstr (hits, ==, "he, she, hers");
+	g_free (hits);
+
+	hits = scan (patterns, "ahishers");
+	g_assert_cmpstr (hits, ==, "he, she, his, hers");
+	g_free (hits);
+
+	hits = scan (patterns, "hxs");
+	g_assert_cmpstr (hits, ==, "");
+	g_free (hits);
+
+	gsearchtool_content_patterns_free (patterns);
+}
+
+static void
+test_content_ignore_case (void)
+{
+	GSearchContentPatterns * patterns;
+	gchar * hits;
+
+	patterns = new_patterns ("Hello World", "FOO", NULL);
+
+	hits = scan (patterns, "...HELLO world... fOo");
+	g_assert_cmpstr (hits, ==, "hello world, foo");
+	g_free (hits);
+
+	gsearchtool_content_patterns_free (patterns);
+}
+
+static void
+test_content_required (void)
+{
+	GSearchContentPatterns * patterns;
+	guint64 hits;
+
+	/* Needs "alpha", and "beta" or "gamma". */
+	patterns = gsearchtool_content_patterns_new ();
+	g_assert (gsearchtool_content_patterns_add (patterns, "alpha", TRUE));
+	g_assert (gsearchtool_content_patterns_add (patterns, "beta", FALSE));
+	g_assert (gsearchtool_content_patterns_add (patterns, "gamma", FALSE));
+	g_assert (gsearchtool_content_patterns_add (patterns, "", FALSE) == FALSE);
+	g_assert_cmpuint (gsearchtool_content_patterns_get_length (patterns), ==, 3);
+
+	hits = gsearchtool_content_patterns_scan (patterns, "alpha gamma", 11);
+	g_assert (gsearchtool_content_patterns_is_match (patterns, hits));
+	hits = gsearchtool_content_patterns_scan (patterns, "alpha", 5);
+	g_assert (gsearchtool_content_patterns_is_match (patterns, hits) == FALSE);
+	hits = gsearchtool_content_patterns_scan (patterns, "beta gamma", 10);
+	g_assert (gsearchtool_content_patterns_is_match (patterns, hits) == FALSE);
+
+	gsearchtool_content_patterns_free (patterns);
+}
+
+static void
+test_content_too_many (void)
+{
+	GSearchContentPatterns * patterns;
+	gint idx;
+
+	patterns = gsearchtool_content_patterns_new ();
+	for (idx = 0; idx < GSEARCH_CONTENT_MAX_PATTERNS; idx++) {
+		gchar * pattern = g_strdup_printf ("p%d", idx);
+
+		g_assert (gsearchtool_content_patterns_add (patterns, pattern, TRUE));
+		g_free (pattern);
+	}
+	g_assert (gsearchtool_content_patterns_add (patterns, "more", TRUE) == FALSE);
+	gsearchtool_content_patterns_free (patterns);
+}
+
+static gchar *
+write_file (const gchar * folder,
+            const gchar * name,
+            const gchar * contents,
+            gsize length)
+{
+	gchar * path;
+
+	path = g_build_filename (folder, name, NULL);
+	g_assert (g_file_set_contents (path, contents, length, NULL));
+
+	return path;
+}
+
+static void
+test_content_files (void)
+{
+	GSearchContentPatterns * patterns;
+	GSearchContentScanner * scanner;
+	GSearchContentMatch * match;
+	gchar * folder;
+	gchar * paths[4];
+	gchar * large;
+	gsize large_length = 3 * 65536;
+	guint64 bytes_read = 0;
+	guint64 hits;
+	gchar * string;
+	gint idx;
+
+	folder = g_dir_make_tmp ("test-gsearchtool-content-XXXXXX", NULL);
+	g_assert (folder != NULL);
+
+	/* The pattern straddles two reads. */
+	large = g_malloc (large_length);
+	memset (large, '.', large_length);
+	memcpy (large + 65536 - 3, "needle", 6);
+	paths[0] = write_file (folder, "large", large, large_length);
+	paths[1] = write_file (folder, "binary", "needle\0haystack", 15);
+	paths[2] = write_file (folder, "text", "haystack and needle", 19);
+	paths[3] = write_file (folder, "none", "nothing here", 12);
+	g_free (large);
+
+	patterns = new_patterns ("needle", "haystack", NULL);
+	hits = gsearchtool_content_patterns_scan_file (patterns, paths[0], &bytes_read);
+	string = gsearchtool_content_patterns_get_hits_string (patterns, hits);
+	g_assert_cmpstr (string, ==, "needle");
+	g_free (string);
+	g_assert_cmpuint (bytes_read, ==, large_length);
+
+	hits = gsearchtool_content_patterns_scan_file (patterns, paths[1], NULL);
+	g_assert_cmpuint (hits, ==, 0);
+	gsearchtool_content_patterns_free (patterns);
+
+	patterns = new_patterns ("needle", "haystack", NULL);
+	scanner = gsearchtool_content_scanner_new (patterns, 2);
+	for (idx = 0; idx < 4; idx++) {
+		gsearchtool_content_scanner_push (scanner, paths[idx], idx, 0, 0);
+	}
+	while (gsearchtool_content_scanner_is_idle (scanner) == FALSE) {
+		g_usleep (1000);
+	}
+
+	hits = 0;
+	while ((match = gsearchtool_content_scanner_pop (scanner)) != NULL) {
+		if (match->size == 0) {
+			g_assert_cmpstr (match->path, ==, paths[0]);
+			g_assert_cmpuint (match->hits, ==, 1);
+		}
+		else {
+			g_assert_cmpint (match->size, ==, 2);
+			g_assert_cmpstr (match->path, ==, paths[2]);
+			g_assert_cmpuint (match->hits, ==, 3);
+		}
+		hits |= G_GUINT64_CONSTANT (1) << match->size;
+		gsearchtool_content_match_free (match);
+	}
+	g_assert_cmpuint (hits, ==, 5);
+	g_assert_cmpuint (gsearchtool_content_scanner_get_bytes_read (scanner), ==, large_length + 15 + 19 + 12);
+	gsearchtool_content_scanner_free (scanner);
+
+	for (idx = 0; idx < 4; idx++) {
+		g_unlink (paths[idx]);
+		g_free (paths[idx]);
+	}
+	g_rmdir (folder);
+	g_free (folder);
+}
+
+static void
+append_tar_member (GString * tar,
+                   const gchar * name,
+                   const gchar * contents,
+                   gsize length)
+{
+	gchar header[512];
+	guint checksum = 0;
+	gint idx;
+
+	memset (header, 0, sizeof (header));
+	strcpy (header, name);
+	g_snprintf (header + 124, 12, "%011o", (guint) length);
+	header[156] = '0';
+	memcpy (header + 257, "ustar", 6);
+	memset (header + 148, ' ', 8);
+	for (idx = 0; idx < 512; idx++) {
+		checksum += (guchar) header[idx];
+	}
+	g_snprintf (header + 148, 8, "%06o", checksum);
+
+	g_string_append_len (tar, header, sizeof (header));
+	g_string_append_len (tar, contents, length);
+	memset (header, 0, sizeof (header));
+	g_string_append_len (tar, header, (512 - length % 512) % 512);
+}
+
+static void
+test_content_archive (void)
+{
+	GSearchContentPatterns * patterns;
+	GString * tar;
+	gchar * folder;
+	gchar * path;
+	guint64 hits;
+	gchar * string;
+
+	folder = g_dir_make_tmp ("test-gsearchtool-content-XXXXXX", NULL);
+	g_assert (folder != NULL);
+
+	/* A binary member is left out, not the members after it. */
+	tar = g_string_new (NULL);
+	append_tar_member (tar, "first.txt", "alpha", 5);
+	append_tar_member (tar, "binary", "beta\0gamma", 10);
+	append_tar_member (tar, "last.txt", "gamma", 5);
+	g_string_set_size (tar, tar->len + 1024);
+	memset (tar->str + tar->len - 1024, 0, 1024);
+	path = write_file (folder, "archive.tar", tar->str, tar->len);
+	g_string_free (tar, TRUE);
+
+	patterns = new_patterns ("alpha", "beta", "gamma", "last", NULL);
+	gsearchtool_content_patterns_set_flags (patterns, GSEARCH_CONTENT_DECOMPRESS);
+	hits = gsearchtool_content_patterns_scan_file (patterns, path, NULL);
+	string = gsearchtool_content_patterns_get_hits_string (patterns, hits);
+	g_assert_cmpstr (string, ==, "alpha, gamma");
+	g_free (string);
+	gsearchtool_content_patterns_free (patterns);
+
+	patterns = new_patterns ("alpha", "beta", "gamma", "last", NULL);
+	gsearchtool_content_patterns_set_flags (patterns, GSEARCH_CONTENT_DECOMPRESS | GSEARCH_CONTENT_MEMBER_NAMES);
+	hits = gsearchtool_content_patterns_scan_file (patterns, path, NULL);
+	string = gsearchtool_content_patterns_get_hits_string (patterns, hits);
+	g_assert_cmpstr (string, ==, "alpha, gamma, last");
+	g_free (string);
+	gsearchtool_content_patterns_free (patterns);
+
+	/* Read as it is, the archive is binary. */
+	patterns = new_patterns ("alpha", NULL);
+	hits = gsearchtool_content_patterns_scan_file (patterns, path, NULL);
+	g_assert_cmpuint (hits, ==, 0);
+	gsearchtool_content_patterns_free (patterns);
+
+	g_unlink (path);
+	g_free (path);
+	g_rmdir (folder);
+	g_free (folder);
+}
+
+int
+main (int argc,
+      char ** argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/content/overlapping", test_content_overlapping);
+	g_test_add_func ("/content/ignore_case", test_content_ignore_case);
+	g_test_add_func ("/content/required", test_content_required);
+	g_test_add_func ("/content/too_many", test_content_too_many);
+	g_test_add_func ("/content/files", test_content_files);
+	g_test_add_func ("/content/archive", test_content_archive);
+
+	return g_test_run ();
+}
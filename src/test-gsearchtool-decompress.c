@@ -0,0 +1,417 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-decompress.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for reading compressed files and archives.  The formats
+ * the build has no library for are left out.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+#ifdef HAVE_LZMA
+#  include <lzma.h>
+#endif
+
+#include "gsearchtool-decompress.h"
+
+/* What the callback was given, as "[member]data". */
+typedef struct {
+	GString               * log;
+	gsize                   stop_after;
+} Collector;
+
+static gboolean
+collect (const gchar * member,
+         const guchar * buffer,
+         gsize length,
+         gpointer data)
+{
+	Collector * collector = data;
+
+	if (member != NULL) {
+		g_string_append_printf (collector->log, "[%s]", member);
+	}
+	else {
+		g_string_append_len (collector->log, (const gchar *) buffer, length);
+	}
+	return collector->stop_after == 0 || collector->log->len < collector->stop_after;
+}
+
+/* Writes @contents to a temporary file and reads it back. */
+static gchar *
+decompress (GByteArray * contents,
+            gsize stop_after,
+            gboolean * is_ok,
+            GSearchDecompressFormat * format)
+{
+	Collector collector;
+	guchar head[GSEARCH_DECOMPRESS_HEADER_SIZE];
+	gchar * path;
+	gssize count;
+	gint fd;
+
+	fd = g_file_open_tmp ("test-gsearchtool-decompress-XXXXXX", &path, NULL);
+	g_assert (fd >= 0);
+	g_assert (write (fd, contents->data, contents->len) == (gssize) contents->len);
+	g_assert (lseek (fd, 0, SEEK_SET) == 0);
+
+	count = read (fd, head, sizeof (head));
+	g_assert (count >= 0);
+	*format = gsearchtool_decompress_get_format (head, count);
+
+	collector.log = g_string_new (NULL);
+	collector.stop_after = stop_after;
+	*is_ok = gsearchtool_decompress_fd (fd, *format, head, count, collect, &collector, NULL);
+
+	close (fd);
+	g_unlink (path);
+	g_free (path);
+
+	return g_string_free (collector.log, FALSE);
+}
+
+static void
+append_tar_member (GByteArray * tar,
+                   const gchar * name,
+                   gchar type,
+                   const gchar * contents)
+{
+	guchar header[512];
+	guint checksum = 0;
+	gsize length = strlen (contents);
+	gint idx;
+
+	memset (header, 0, sizeof (header));
+	strncpy ((gchar *) header, name, 100);
+	g_snprintf ((gchar *) header + 100, 8, "%07o", 0644);
+	g_snprintf ((gchar *) header + 124, 12, "%011o", (guint) length);
+	header[156] = type;
+	memcpy (header + 257, "ustar", 6);
+	memcpy (header + 263, "00", 2);
+	memset (header + 148, ' ', 8);
+	for (idx = 0; idx < 512; idx++) {
+		checksum += header[idx];
+	}
+	g_snprintf ((gchar *) header + 148, 8, "%06o", checksum);
+
+	g_byte_array_append (tar, header, sizeof (header));
+	g_byte_array_append (tar, (const guint8 *) contents, length);
+	memset (header, 0, sizeof (header));
+	g_byte_array_append (tar, header, (512 - length % 512) % 512);
+}
+
+static GByteArray *
+new_tar (void)
+{
+	GByteArray * tar;
+	guchar zeros[1024];
+	gchar * long_name;
+
+	tar = g_byte_array_new ();
+	append_tar_member (tar, "logs/a.log", '0', "alpha");
+	append_tar_member (tar, "logs", '5', "");
+	long_name = g_strnfill (120, 'n');
+	append_tar_member (tar, "././@LongLink", 'L', long_name);
+	append_tar_member (tar, "nnnn", '0', "beta");
+	append_tar_member (tar, "empty", '0', "");
+	g_free (long_name);
+
+	memset (zeros, 0, sizeof (zeros));
+	g_byte_array_append (tar, zeros, sizeof (zeros));
+
+	return tar;
+}
+
+static void
+test_decompress_tar (void)
+{
+	GSearchDecompressFormat format;
+	GByteArray * tar;
+	gchar * long_name;
+	gchar * expected;
+	gchar * log;
+	gboolean is_ok;
+
+	tar = new_tar ();
+	log = decompress (tar, 0, &is_ok, &format);
+	g_assert_cmpint (format, ==, GSEARCH_DECOMPRESS_TAR);
+	g_assert (is_ok);
+
+	long_name = g_strnfill (120, 'n');
+	expected = g_strdup_printf ("[logs/a.log]alpha[%s]beta[empty]", long_name);
+	g_free (long_name);
+	g_assert_cmpstr (log, ==, expected);
+	g_free (expected);
+	g_free (log);
+	g_byte_array_free (tar, TRUE);
+}
+
+static void
+test_decompress_plain (void)
+{
+	GSearchDecompressFormat format;
+	GByteArray * contents;
+	gchar * log;
+	gboolean is_ok;
+
+	contents = g_byte_array_new ();
+	g_byte_array_append (contents, (const guint8 *) "just text", 9);
+	log = decompress (contents, 0, &is_ok, &format);
+	g_assert_cmpint (format, ==, GSEARCH_DECOMPRESS_NONE);
+	g_assert_cmpstr (log, ==, "just text");
+	g_free (log);
+	g_byte_array_free (contents, TRUE);
+}
+
+#ifdef HAVE_ZLIB
+/* @window_bits is 15 + 16 for gzip, -15 for raw deflate. */
+static void
+append_deflated (GByteArray * array,
+                 const guchar * data,
+                 gsize length,
+                 gint window_bits)
+{
+	z_stream stream;
+	guchar output[4096];
+	gint status;
+
+	memset (&stream, 0, sizeof (stream));
+	g_assert_cmpint (deflateInit2 (&stream, 9, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY), ==, Z_OK);
+	stream.next_in = (Bytef *) data;
+	stream.avail_in = length;
+	do {
+		stream.next_out = output;
+		stream.avail_out = sizeof (output);
+		status = deflate (&stream, Z_FINISH);
+		g_byte_array_append (array, output, sizeof (output) - stream.avail_out);
+	} while (status == Z_OK);
+	g_assert_cmpint (status, ==, Z_STREAM_END);
+	deflateEnd (&stream);
+}
+
+static void
+test_decompress_gzip (void)
+{
+	GSearchDecompressFormat format;
+	GByteArray * gzip;
+	GByteArray * tar;
+	GString * large;
+	gchar * log;
+	gboolean is_ok;
+	gint idx;
+
+	/* Two members, as with cat a.gz b.gz, the first one larger than a
+	   read. */
+	large = g_string_new (NULL);
+	for (idx = 0; large->len < 300000; idx++) {
+		g_string_append_printf (large, "line %d\n", idx);
+	}
+	gzip = g_byte_array_new ();
+	append_deflated (gzip, (const guchar *) large->str, large->len, 15 + 16);
+	append_deflated (gzip, (const guchar *) "needle", 6, 15 + 16);
+	log = decompress (gzip, 0, &is_ok, &format);
+	g_assert_cmpint (format, ==, GSEARCH_DECOMPRESS_GZIP);
+	g_assert (is_ok);
+	g_string_append (large, "needle");
+	g_assert_cmpstr (log, ==, large->str);
+	g_free (log);
+
+	/* Stopped early. */
+	log = decompress (gzip, 100, &is_ok, &format);
+	g_assert_cmpuint (strlen (log), <, large->len);
+	g_free (log);
+
+	/* Cut short, what could be read is still passed on. */
+	g_byte_array_set_size (gzip, gzip->len / 2);
+	log = decompress (gzip, 0, &is_ok, &format);
+	g_assert (strncmp (log, large->str, 1000) == 0);
+	g_free (log);
+	g_byte_array_free (gzip, TRUE);
+	g_string_free (large, TRUE);
+
+	/* A compressed tar archive is walked too. */
+	tar = new_tar ();
+	gzip = g_byte_array_new ();
+	append_deflated (gzip, tar->data, tar->len, 15 + 16);
+	log = decompress (gzip, 0, &is_ok, &format);
+	g_assert (g_str_has_prefix (log, "[logs/a.log]alpha["));
+	g_assert (g_str_has_suffix (log, "]beta[empty]"));
+	g_free (log);
+	g_byte_array_free (gzip, TRUE);
+	g_byte_array_free (tar, TRUE);
+}
+
+static void
+append_le (GByteArray * array,
+           guint32 value,
+           gint length)
+{
+	gint idx;
+
+	for (idx = 0; idx < length; idx++) {
+		guint8 byte = (value >> (8 * idx)) & 0xff;
+
+		g_byte_array_append (array, &byte, 1);
+	}
+}
+
+static void
+append_zip_header (GByteArray * array,
+                   gboolean is_central,
+                   const gchar * name,
+                   guint16 method,
+                   guint16 flags,
+                   guint32 compressed_size,
+                   guint32 size,
+                   guint32 local_offset)
+{
+	append_le (array, is_central ? 0x02014b50 : 0x04034b50, 4);
+	if (is_central) {
+		append_le (array, 20, 2);
+	}
+	append_le (array, 20, 2);
+	append_le (array, flags, 2);
+	append_le (array, method, 2);
+	append_le (array, 0, 4);
+	append_le (array, 0, 4);
+	append_le (array, compressed_size, 4);
+	append_le (array, size, 4);
+	append_le (array, strlen (name), 2);
+	append_le (array, 0, 2);
+	if (is_central) {
+		append_le (array, 0, 2);
+		append_le (array, 0, 2);
+		append_le (array, 0, 2);
+		append_le (array, 0, 4);
+		append_le (array, local_offset, 4);
+	}
+	g_byte_array_append (array, (const guint8 *) name, strlen (name));
+}
+
+static void
+test_decompress_zip (void)
+{
+	const gchar * names[] = { "a.txt", "dir/", "dir/b.txt", "secret.txt" };
+	const guint16 methods[] = { 0, 0, Z_DEFLATED, 0 };
+	const guint16 flags[] = { 0, 0, 0, 1 };
+	const gchar * contents[] = { "stored text", "", "deflated text deflated text", "hidden" };
+	GSearchDecompressFormat format;
+	GByteArray * zip;
+	GByteArray * central;
+	gchar * log;
+	gboolean is_ok;
+	gint idx;
+
+	zip = g_byte_array_new ();
+	central = g_byte_array_new ();
+	for (idx = 0; idx < G_N_ELEMENTS (names); idx++) {
+		GByteArray * data = g_byte_array_new ();
+		guint32 offset = zip->len;
+
+		if (methods[idx] == Z_DEFLATED) {
+			append_deflated (data, (const guchar *) contents[idx], strlen (contents[idx]), -15);
+		}
+		else {
+			g_byte_array_append (data, (const guint8 *) contents[idx], strlen (contents[idx]));
+		}
+		append_zip_header (zip, FALSE, names[idx], methods[idx], flags[idx], data->len, strlen (contents[idx]), 0);
+		g_byte_array_append (zip, data->data, data->len);
+		append_zip_header (central, TRUE, names[idx], methods[idx], flags[idx], data->len, strlen (contents[idx]), offset);
+		g_byte_array_free (data, TRUE);
+	}
+	append_le (central, 0x06054b50, 4);
+	append_le (central, 0, 4);
+	append_le (central, G_N_ELEMENTS (names), 2);
+	append_le (central, G_N_ELEMENTS (names), 2);
+	append_le (central, central->len - 12, 4);
+	append_le (central, zip->len, 4);
+	append_le (central, 0, 2);
+	g_byte_array_append (zip, central->data, central->len);
+	g_byte_array_free (central, TRUE);
+
+	log = decompress (zip, 0, &is_ok, &format);
+	g_assert_cmpint (format, ==, GSEARCH_DECOMPRESS_ZIP);
+	g_assert (is_ok);
+	g_assert_cmpstr (log, ==, "[a.txt]stored text[dir/b.txt]deflated text deflated text[secret.txt]");
+	g_free (log);
+	g_byte_array_free (zip, TRUE);
+}
+#endif
+
+#ifdef HAVE_LZMA
+static void
+test_decompress_xz (void)
+{
+	GSearchDecompressFormat format;
+	GByteArray * xz;
+	const gchar * text = "compressed with xz";
+	gsize length = 0;
+	gchar * log;
+	gboolean is_ok;
+
+	xz = g_byte_array_new ();
+	g_byte_array_set_size (xz, 1024);
+	g_assert_cmpint (lzma_easy_buffer_encode (6, LZMA_CHECK_CRC64, NULL, (const guint8 *) text, strlen (text),
+	                                          xz->data, &length, xz->len), ==, LZMA_OK);
+	g_byte_array_set_size (xz, length);
+
+	log = decompress (xz, 0, &is_ok, &format);
+	g_assert_cmpint (format, ==, GSEARCH_DECOMPRESS_XZ);
+	g_assert (is_ok);
+	g_assert_cmpstr (log, ==, text);
+	g_free (log);
+	g_byte_array_free (xz, TRUE);
+}
+#endif
+
+int
+main (int argc,
+      char ** argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/decompress/plain", test_decompress_plain);
+	g_test_add_func ("/decompress/tar", test_decompress_tar);
+#ifdef HAVE_ZLIB
+	g_test_add_func ("/decompress/gzip", test_decompress_gzip);
+	g_test_add_func ("/decompress/zip", test_decompress_zip);
+#endif
+#ifdef HAVE_LZMA
+	g_test_add_func ("/decompress/xz", test_decompress_xz);
+#endif
+
+	return g_test_run ();
+}
@@ -0,0 +1,252 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-device.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the device lookups, run on a sysfs tree and a mount
+ * table written to a temporary folder.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_SYSMACROS_H
+#  include <sys/sysmacros.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-device.h"
+#include "test-gsearchtool-util.h"
+
+typedef struct {
+	gchar                 * folder;
+	gchar                 * sys_folder;
+	gchar                 * mountinfo;
+} Fixture;
+
+static void
+write_file (Fixture * fixture,
+            const gchar * name,
+            const gchar * contents)
+{
+	gchar * path;
+	gchar * folder;
+
+	path = g_build_filename (fixture->folder, name, NULL);
+	folder = g_path_get_dirname (path);
+	g_assert (g_mkdir_with_parents (folder, 0700) == 0);
+	g_assert (g_file_set_contents (path, contents, -1, NULL));
+	g_free (folder);
+	g_free (path);
+}
+
+static void
+fixture_setup (Fixture * fixture,
+               gconstpointer data)
+{
+	gchar * link;
+
+	fixture->folder = g_dir_make_tmp ("test-gsearchtool-device-XXXXXX", NULL);
+	g_assert (fixture->folder != NULL);
+	fixture->sys_folder = g_build_filename (fixture->folder, "sys", NULL);
+	fixture->mountinfo = g_build_filename (fixture->folder, "mountinfo", NULL);
+
+	/* A spinning disk with a partition, and a solid state one. */
+	write_file (fixture, "sys/block/sda/queue/rotational", "1\n");
+	write_file (fixture, "sys/block/sda/sda1/partition", "1\n");
+	write_file (fixture, "sys/block/nvme0n1/queue/rotational", "0\n");
+	write_file (fixture, "sys/dev/block/.keep", "");
+
+	link = g_build_filename (fixture->sys_folder, "dev", "block", "8:0", NULL);
+	g_assert (symlink ("../../block/sda", link) == 0);
+	g_free (link);
+	link = g_build_filename (fixture->sys_folder, "dev", "block", "8:1", NULL);
+	g_assert (symlink ("../../block/sda/sda1", link) == 0);
+	g_free (link);
+	link = g_build_filename (fixture->sys_folder, "dev", "block", "259:0", NULL);
+	g_assert (symlink ("../../block/nvme0n1", link) == 0);
+	g_free (link);
+
+	write_file (fixture, "mountinfo",
+	            "22 1 259:0 / / rw,relatime shared:1 - ext4 /dev/nvme0n1 rw\n"
+	            "40 22 8:1 / /media/disk rw,nosuid shared:20 - ext4 /dev/sda1 rw\n"
+	            "41 22 0:50 / /net/home rw,relatime shared:21 master:3 - nfs4 server:/home rw,vers=4.2\n"
+	            "42 22 0:51 / /tmp rw,nosuid shared:22 - tmpfs tmpfs rw\n"
+	            "43 22 0:52 / /proc rw,nosuid shared:23 - proc proc rw\n"
+	            "44 43 0:53 / /proc/sys/fs/binfmt_misc rw shared:24 - autofs systemd-1 rw\n"
+	            "45 22 0:54 / /sys rw,nosuid shared:25 - sysfs sysfs rw\n"
+	            "46 40 8:2 / /media/disk/my\\040stick rw shared:26 - vfat /dev/sdb1 rw\n");
+}
+
+static void
+fixture_teardown (Fixture * fixture,
+                  gconstpointer data)
+{
+	test_remove_tree (fixture->folder);
+	g_free (fixture->folder);
+	g_free (fixture->sys_folder);
+	g_free (fixture->mountinfo);
+}
+
+static void
+test_device_kinds (Fixture * fixture,
+                   gconstpointer data)
+{
+	g_assert_cmpint (gsearchtool_device_lookup_kind (fixture->sys_folder, fixture->mountinfo, makedev (259, 0)),
+	                 ==, GSEARCH_DEVICE_SOLID);
+	g_assert_cmpint (gsearchtool_device_lookup_kind (fixture->sys_folder, fixture->mountinfo, makedev (8, 0)),
+	                 ==, GSEARCH_DEVICE_ROTATIONAL);
+
+	/* A partition has the queue of its disk. */
+	g_assert_cmpint (gsearchtool_device_lookup_kind (fixture->sys_folder, fixture->mountinfo, makedev (8, 1)),
+	                 ==, GSEARCH_DEVICE_ROTATIONAL);
+
+	g_assert_cmpint (gsearchtool_device_lookup_kind (fixture->sys_folder, fixture->mountinfo, makedev (0, 50)),
+	                 ==, GSEARCH_DEVICE_NETWORK);
+	g_assert_cmpint (gsearchtool_device_lookup_kind (fixture->sys_folder, fixture->mountinfo, makedev (0, 51)),
+	                 ==, GSEARCH_DEVICE_OTHER);
+
+	/* Neither mounted nor in sysfs. */
+	g_assert_cmpint (gsearchtool_device_lookup_kind (fixture->sys_folder, fixture->mountinfo, makedev (7, 3)),
+	                 ==, GSEARCH_DEVICE_OTHER);
+}
+
+static void
+test_device_concurrency (void)
+{
+	g_assert_cmpuint (gsearchtool_device_get_concurrency (GSEARCH_DEVICE_ROTATIONAL), ==, 1);
+	g_assert_cmpuint (gsearchtool_device_get_concurrency (GSEARCH_DEVICE_SOLID), >=, 2);
+
+	gsearchtool_device_set_concurrency (GSEARCH_DEVICE_ROTATIONAL, 3);
+	g_assert_cmpuint (gsearchtool_device_get_concurrency (GSEARCH_DEVICE_ROTATIONAL), ==, 3);
+	gsearchtool_device_set_concurrency (GSEARCH_DEVICE_ROTATIONAL, 0);
+	g_assert_cmpuint (gsearchtool_device_get_concurrency (GSEARCH_DEVICE_ROTATIONAL), ==, 1);
+}
+
+static void
+test_device_skipped_mounts (Fixture * fixture,
+                            gconstpointer data)
+{
+	GPtrArray * mounts;
+	gchar ** skipped;
+
+	mounts = gsearchtool_device_read_mounts (fixture->mountinfo);
+	g_assert_cmpuint (mounts->len, ==, 8);
+	g_assert_cmpstr (((GSearchMount *) g_ptr_array_index (mounts, 7))->mount_point, ==, "/media/disk/my stick");
+
+	/* The mounts inside /proc go with it. */
+	skipped = gsearchtool_device_get_skipped_mounts (mounts, "/", "pseudo,network");
+	g_assert_cmpuint (g_strv_length (skipped), ==, 4);
+	g_assert_cmpstr (skipped[0], ==, "/net/home");
+	g_assert_cmpstr (skipped[1], ==, "/proc");
+	g_assert_cmpstr (skipped[2], ==, "/sys");
+	g_assert_cmpstr (skipped[3], ==, "/tmp");
+	g_strfreev (skipped);
+
+	/* By type, and only inside the folder. */
+	skipped = gsearchtool_device_get_skipped_mounts (mounts, "/media", "vfat");
+	g_assert_cmpuint (g_strv_length (skipped), ==, 1);
+	g_assert_cmpstr (skipped[0], ==, "/media/disk/my stick");
+	g_strfreev (skipped);
+
+	/* The folder itself is searched whatever it is on. */
+	skipped = gsearchtool_device_get_skipped_mounts (mounts, "/proc/", "pseudo");
+	g_assert_cmpuint (g_strv_length (skipped), ==, 1);
+	g_assert_cmpstr (skipped[0], ==, "/proc/sys/fs/binfmt_misc");
+	g_strfreev (skipped);
+
+	skipped = gsearchtool_device_get_skipped_mounts (mounts, "/", "local");
+	g_assert_cmpuint (g_strv_length (skipped), ==, 1);
+	g_assert_cmpstr (skipped[0], ==, "/media/disk");
+	g_strfreev (skipped);
+
+	skipped = gsearchtool_device_get_skipped_mounts (mounts, "/", "");
+	g_assert_cmpuint (g_strv_length (skipped), ==, 0);
+	g_strfreev (skipped);
+
+	g_ptr_array_free (mounts, TRUE);
+}
+
+static void
+test_device_queue (void)
+{
+	GSearchDeviceQueue * queue;
+	static const guint64 inodes[] = { 40, 10, 30, 10, 20 };
+	gchar * names[] = { "a", "b", "c", "d", "e" };
+	guint i;
+
+	/* First in, first out. */
+	queue = gsearchtool_device_queue_new (FALSE);
+	for (i = 0; i < G_N_ELEMENTS (inodes); i++) {
+		gsearchtool_device_queue_push (queue, names[i], inodes[i]);
+	}
+	g_assert_cmpuint (gsearchtool_device_queue_get_length (queue), ==, 5);
+	for (i = 0; i < G_N_ELEMENTS (inodes); i++) {
+		g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, names[i]);
+	}
+	g_assert (gsearchtool_device_queue_pop (queue) == NULL);
+	gsearchtool_device_queue_free (queue, NULL);
+
+	/* By inode, the equal ones in the order they came in. */
+	queue = gsearchtool_device_queue_new (TRUE);
+	for (i = 0; i < G_N_ELEMENTS (inodes); i++) {
+		gsearchtool_device_queue_push (queue, names[i], inodes[i]);
+	}
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "b");
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "d");
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "e");
+
+	/* Lower ones pushed on the way up wait for the next sweep. */
+	gsearchtool_device_queue_push (queue, "f", 5);
+	gsearchtool_device_queue_push (queue, "g", 35);
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "c");
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "g");
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "a");
+	g_assert_cmpstr (gsearchtool_device_queue_pop (queue), ==, "f");
+	g_assert (gsearchtool_device_queue_pop (queue) == NULL);
+
+	gsearchtool_device_queue_push (queue, g_strdup ("h"), 1);
+	gsearchtool_device_queue_free (queue, g_free);
+}
+
+int
+main (int argc,
+      char ** argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add ("/device/kinds", Fixture, NULL,
+	            fixture_setup, test_device_kinds, fixture_teardown);
+	g_test_add ("/device/skipped-mounts", Fixture, NULL,
+	            fixture_setup, test_device_skipped_mounts, fixture_teardown);
+	g_test_add_func ("/device/concurrency", test_device_concurrency);
+	g_test_add_func ("/device/queue", test_device_queue);
+
+	return g_test_run ();
+}
@@ -0,0 +1,124 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-du.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the per-folder disk usage totals.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "gsearchtool-du.h"
+
+static GSearchDiskUsageFolder *
+get_child (GSearchDiskUsageFolder * folder,
+           guint idx)
+{
+	g_assert_cmpuint (idx, <, folder->children->len);
+	return g_ptr_array_index (folder->children, idx);
+}
+
+static void
+test_du_totals (void)
+{
+	GSearchDiskUsage * du;
+	GSearchDiskUsageFolder * root;
+	GSearchDiskUsageFolder * folder;
+
+	du = gsearchtool_du_new ("/home/user/");
+	gsearchtool_du_add_file (du, "/home/user/a.txt", 10);
+	gsearchtool_du_add_file (du, "/home/user/small/b.txt", 5);
+	gsearchtool_du_add_file (du, "/home/user/big/deep/er/c.bin", 1000);
+	gsearchtool_du_add_file (du, "/home/user/big/d.bin", 100);
+	gsearchtool_du_add_file (du, "/home/user/small/e.txt", 7);
+	gsearchtool_du_add_file (du, "/home/user/big/deep/f.bin", 1);
+	gsearchtool_du_finish (du);
+
+	g_assert_cmpuint (gsearchtool_du_get_files (du), ==, 6);
+
+	root = gsearchtool_du_get_root (du);
+	g_assert_cmpstr (root->path, ==, "/home/user");
+	g_assert_cmpint (root->size, ==, 10);
+	g_assert_cmpint (root->total_size, ==, 1123);
+	g_assert_cmpuint (root->total_files, ==, 6);
+	g_assert_cmpuint (root->children->len, ==, 2);
+
+	/* Largest first. */
+	folder = get_child (root, 0);
+	g_assert_cmpstr (folder->path, ==, "/home/user/big");
+	g_assert_cmpint (folder->total_size, ==, 1101);
+	g_assert_cmpuint (folder->total_files, ==, 3);
+	g_assert (folder->parent == root);
+
+	folder = get_child (folder, 0);
+	g_assert_cmpstr (folder->path, ==, "/home/user/big/deep");
+	g_assert_cmpint (folder->size, ==, 1);
+	g_assert_cmpint (folder->total_size, ==, 1001);
+
+	folder = get_child (folder, 0);
+	g_assert_cmpstr (folder->path, ==, "/home/user/big/deep/er");
+	g_assert_cmpuint (folder->children->len, ==, 0);
+
+	folder = get_child (root, 1);
+	g_assert_cmpstr (folder->path, ==, "/home/user/small");
+	g_assert_cmpint (folder->total_size, ==, 12);
+	g_assert_cmpuint (folder->total_files, ==, 2);
+
+	gsearchtool_du_free (du);
+}
+
+static void
+test_du_filesystem_root (void)
+{
+	GSearchDiskUsage * du;
+	GSearchDiskUsageFolder * root;
+
+	du = gsearchtool_du_new ("/");
+	gsearchtool_du_add_file (du, "/vmlinuz", 3);
+	gsearchtool_du_add_file (du, "/etc/passwd", 2);
+	gsearchtool_du_finish (du);
+
+	root = gsearchtool_du_get_root (du);
+	g_assert_cmpstr (root->path, ==, "/");
+	g_assert_cmpint (root->size, ==, 3);
+	g_assert_cmpint (root->total_size, ==, 5);
+	g_assert_cmpstr (get_child (root, 0)->path, ==, "/etc");
+
+	gsearchtool_du_free (du);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/du/totals", test_du_totals);
+	g_test_add_func ("/du/filesystem_root", test_du_filesystem_root);
+
+	return g_test_run ();
+}
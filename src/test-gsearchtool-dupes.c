@@ -0,0 +1,286 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-dupes.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the duplicate file finder, run on files written to a
+ * temporary folder.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-dupes.h"
+
+typedef struct {
+	gchar                 * folder;
+	GSearchDupes          * dupes;
+} Fixture;
+
+static void
+write_file (Fixture * fixture,
+            const gchar * name,
+            gsize size,
+            gchar fill,
+            gchar middle)
+{
+	gchar * path;
+	gchar * contents;
+
+	contents = g_malloc (size + 1);
+	memset (contents, fill, size);
+	contents[size / 2] = middle;
+
+	path = g_build_filename (fixture->folder, name, NULL);
+	g_assert (g_file_set_contents (path, contents, size, NULL));
+	g_free (path);
+	g_free (contents);
+}
+
+static void
+link_file (Fixture * fixture,
+           const gchar * name,
+           const gchar * link_name)
+{
+	gchar * path;
+	gchar * link_path;
+
+	path = g_build_filename (fixture->folder, name, NULL);
+	link_path = g_build_filename (fixture->folder, link_name, NULL);
+	g_assert_cmpint (link (path, link_path), ==, 0);
+	g_free (path);
+	g_free (link_path);
+}
+
+static void
+add_files (Fixture * fixture)
+{
+	GDir * dir;
+	const gchar * name;
+
+	dir = g_dir_open (fixture->folder, 0, NULL);
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		GStatBuf file_stat;
+		gchar * path;
+
+		path = g_build_filename (fixture->folder, name, NULL);
+		g_assert_cmpint (g_lstat (path, &file_stat), ==, 0);
+		gsearchtool_dupes_add_file (fixture->dupes, path, file_stat.st_size,
+		                            file_stat.st_dev, file_stat.st_ino);
+		g_free (path);
+	}
+	g_dir_close (dir);
+}
+
+static gint
+compare_groups (gconstpointer a,
+                gconstpointer b)
+{
+	const GSearchDupesGroup * group_a = *(const GSearchDupesGroup **) a;
+	const GSearchDupesGroup * group_b = *(const GSearchDupesGroup **) b;
+
+	return strcmp (g_ptr_array_index (group_a->paths, 0), g_ptr_array_index (group_b->paths, 0));
+}
+
+/* Returns the groups found, as "name name ..." strings in order. */
+static gchar *
+get_groups (Fixture * fixture)
+{
+	GSearchDupesGroup * group;
+	GPtrArray * groups;
+	GString * string;
+	gsize prefix_length;
+	guint idx;
+
+	groups = g_ptr_array_new_with_free_func ((GDestroyNotify) gsearchtool_dupes_group_free);
+	while ((group = gsearchtool_dupes_pop_group (fixture->dupes, TRUE)) != NULL) {
+		g_ptr_array_add (groups, group);
+	}
+	g_assert (gsearchtool_dupes_is_finished (fixture->dupes));
+	g_ptr_array_sort (groups, compare_groups);
+
+	prefix_length = strlen (fixture->folder) + 1;
+	string = g_string_new (NULL);
+	for (idx = 0; idx < groups->len; idx++) {
+		guint path;
+
+		group = g_ptr_array_index (groups, idx);
+		if (idx > 0) {
+			g_string_append (string, "; ");
+		}
+		for (path = 0; path < group->paths->len; path++) {
+			if (path > 0) {
+				g_string_append_c (string, ' ');
+			}
+			g_string_append (string, (gchar *) g_ptr_array_index (group->paths, path) + prefix_length);
+		}
+	}
+	g_ptr_array_free (groups, TRUE);
+
+	return g_string_free (string, FALSE);
+}
+
+static void
+fixture_setup (Fixture * fixture,
+               gconstpointer data)
+{
+	fixture->folder = g_dir_make_tmp ("test-gsearchtool-dupes-XXXXXX", NULL);
+	g_assert (fixture->folder != NULL);
+	fixture->dupes = gsearchtool_dupes_new (GPOINTER_TO_UINT (data));
+}
+
+static void
+fixture_teardown (Fixture * fixture,
+                  gconstpointer data)
+{
+	GDir * dir;
+	const gchar * name;
+
+	gsearchtool_dupes_free (fixture->dupes);
+
+	dir = g_dir_open (fixture->folder, 0, NULL);
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		gchar * path;
+
+		path = g_build_filename (fixture->folder, name, NULL);
+		g_unlink (path);
+		g_free (path);
+	}
+	g_dir_close (dir);
+	g_rmdir (fixture->folder);
+	g_free (fixture->folder);
+}
+
+static void
+test_dupes_groups (Fixture * fixture,
+                   gconstpointer data)
+{
+	gsize large = 4 * GSEARCH_DUPES_BLOCK_SIZE;
+	gchar * groups;
+
+	/* Same size, same first and last blocks, only the middle differs. */
+	write_file (fixture, "large-a", large, 'x', 'a');
+	write_file (fixture, "large-b", large, 'x', 'a');
+	write_file (fixture, "large-c", large, 'x', 'c');
+	write_file (fixture, "small-a", 100, 's', 's');
+	write_file (fixture, "small-b", 100, 's', 's');
+	write_file (fixture, "small-c", 100, 't', 't');
+	write_file (fixture, "unique", 200, 'u', 'u');
+	write_file (fixture, "empty-a", 0, 'e', 'e');
+	write_file (fixture, "empty-b", 0, 'e', 'e');
+
+	add_files (fixture);
+	gsearchtool_dupes_start (fixture->dupes);
+	groups = get_groups (fixture);
+	g_assert_cmpstr (groups, ==, "large-a large-b; small-a small-b");
+	g_free (groups);
+
+	/* The large files all collide on their first and last blocks. */
+	g_assert_cmpuint (gsearchtool_dupes_get_bytes_read (fixture->dupes), ==,
+	                  3 * 2 * GSEARCH_DUPES_BLOCK_SIZE + 3 * large + 3 * 100);
+}
+
+static void
+test_dupes_hard_links (Fixture * fixture,
+                       gconstpointer data)
+{
+	gchar * groups;
+
+	write_file (fixture, "a", 3000, 'a', 'a');
+	link_file (fixture, "a", "a-link");
+	write_file (fixture, "b", 3000, 'a', 'a');
+	write_file (fixture, "c", 3000, 'c', 'c');
+	link_file (fixture, "c", "c-link");
+
+	add_files (fixture);
+	gsearchtool_dupes_start (fixture->dupes);
+	groups = get_groups (fixture);
+
+	/* c and its link are the same file, not a duplicate. */
+	g_assert_cmpstr (groups, ==, "a a-link b");
+	g_free (groups);
+
+	g_assert_cmpuint (gsearchtool_dupes_get_bytes_read (fixture->dupes), ==, 3 * 3000);
+}
+
+static void
+test_dupes_nothing_to_hash (Fixture * fixture,
+                            gconstpointer data)
+{
+	gchar * groups;
+
+	write_file (fixture, "a", 10, 'a', 'a');
+	write_file (fixture, "b", 20, 'a', 'a');
+
+	add_files (fixture);
+	gsearchtool_dupes_start (fixture->dupes);
+	groups = get_groups (fixture);
+	g_assert_cmpstr (groups, ==, "");
+	g_free (groups);
+	g_assert_cmpuint (gsearchtool_dupes_get_bytes_read (fixture->dupes), ==, 0);
+}
+
+static void
+test_dupes_cancel (Fixture * fixture,
+                   gconstpointer data)
+{
+	gchar * name;
+	gint idx;
+
+	for (idx = 0; idx < 64; idx++) {
+		name = g_strdup_printf ("file-%02d", idx);
+		write_file (fixture, name, 3 * GSEARCH_DUPES_BLOCK_SIZE, 'f', 'f');
+		g_free (name);
+	}
+	add_files (fixture);
+	gsearchtool_dupes_start (fixture->dupes);
+
+	/* Freed by the teardown while the files are being hashed. */
+}
+
+int
+main (int argc,
+      char ** argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add ("/dupes/groups", Fixture, GUINT_TO_POINTER (0),
+	            fixture_setup, test_dupes_groups, fixture_teardown);
+	g_test_add ("/dupes/groups_one_thread", Fixture, GUINT_TO_POINTER (1),
+	            fixture_setup, test_dupes_groups, fixture_teardown);
+	g_test_add ("/dupes/hard_links", Fixture, GUINT_TO_POINTER (0),
+	            fixture_setup, test_dupes_hard_links, fixture_teardown);
+	g_test_add ("/dupes/nothing_to_hash", Fixture, GUINT_TO_POINTER (0),
+	            fixture_setup, test_dupes_nothing_to_hash, fixture_teardown);
+	g_test_add ("/dupes/cancel", Fixture, GUINT_TO_POINTER (4),
+	            fixture_setup, test_dupes_cancel, fixture_teardown);
+
+	return g_test_run ();
+}
@@ -0,0 +1,528 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-index.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for writing and reading the index of the files in a
+ * folder.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-index.h"
+#include "gsearchtool-match.h"
+
+/* The paths found in @folder, one per line in the order found, read a
+   few records at a time. */
+static gchar *
+collect (GSearchIndex * index,
+         const gchar * folder,
+         const gchar * pattern,
+         gboolean * is_damaged)
+{
+	GSearchIndexCursor * cursor;
+	GString * paths;
+	GString * path;
+	guint budget = 7;
+
+	paths = g_string_new (NULL);
+	path = g_string_new (NULL);
+	cursor = gsearchtool_index_cursor_new (index, folder, pattern);
+	while (TRUE) {
+		if (gsearchtool_index_cursor_next (cursor, path, &budget) == TRUE) {
+			g_string_append_printf (paths, "%s %d\n", path->str, gsearchtool_index_cursor_get_entry (cursor)->type);
+		}
+		else if (budget == 0) {
+			budget = 7;
+		}
+		else {
+			break;
+		}
+	}
+	if (is_damaged != NULL) {
+		*is_damaged = gsearchtool_index_cursor_is_damaged (cursor);
+	}
+	gsearchtool_index_cursor_free (cursor);
+	g_string_free (path, TRUE);
+	return g_string_free (paths, FALSE);
+}
+
+/* Two thousand folders, enough for many blocks, where
+   "/data/d0500/sub" comes before "/data/d0500-x". */
+static gchar *
+write_index (void)
+{
+	GSearchIndexWriter * writer;
+	GSearchIndexEntry regular = { GSEARCH_INDEX_REGULAR, S_IFREG | 0644, 0, -86400, 1000, 100 };
+	GSearchIndexEntry folder = { GSEARCH_INDEX_FOLDER, S_IFDIR | 0755, 4096, 1700000000, 0, 0 };
+	gchar * path;
+	gint fd;
+	gint i;
+
+	writer = gsearchtool_index_writer_new ("/data/");
+	gsearchtool_index_writer_add_folder (writer, "/data", NULL);
+	gsearchtool_index_writer_add_entry (writer, "d0000", &folder);
+	for (i = 0; i < 2000; i++) {
+		gchar * name;
+
+		name = g_strdup_printf ("/data/d%04d", i);
+		gsearchtool_index_writer_add_folder (writer, name, NULL);
+		g_free (name);
+
+		name = g_strdup_printf ("file%d.txt", i);
+		regular.size = i;
+		gsearchtool_index_writer_add_entry (writer, name, &regular);
+		regular.size = 0;
+		g_free (name);
+		gsearchtool_index_writer_add_entry (writer, "notes", &regular);
+		gsearchtool_index_writer_add_entry (writer, "notes.old", &regular);
+		gsearchtool_index_writer_add_entry (writer, "sub", &folder);
+
+		name = g_strdup_printf ("/data/d%04d/sub", i);
+		gsearchtool_index_writer_add_folder (writer, name, NULL);
+		g_free (name);
+
+		name = g_strdup_printf ("deep%d.TXT", i);
+		gsearchtool_index_writer_add_entry (writer, name, &regular);
+		g_free (name);
+
+		if (i == 500) {
+			gsearchtool_index_writer_add_folder (writer, "/data/d0500-x", NULL);
+			gsearchtool_index_writer_add_entry (writer, "other.txt", &regular);
+		}
+	}
+
+	fd = g_file_open_tmp ("test-gsearchtool-index-XXXXXX", &path, NULL);
+	g_assert (fd >= 0);
+	close (fd);
+	g_assert (gsearchtool_index_writer_write (writer, path, NULL));
+	gsearchtool_index_writer_free (writer);
+	return path;
+}
+
+static void
+test_index_seek (void)
+{
+	GSearchIndex * index;
+	gchar * path;
+	gchar * paths;
+	gboolean is_damaged;
+
+	path = write_index ();
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+	g_assert_cmpstr (gsearchtool_index_get_root (index), ==, "/data");
+	g_assert_cmpint (gsearchtool_index_get_entries (index), ==, 10002);
+	g_assert (gsearchtool_index_covers (index, "/data/"));
+	g_assert (gsearchtool_index_covers (index, "/data/d0001"));
+	g_assert (gsearchtool_index_covers (index, "/database") == FALSE);
+	g_assert (gsearchtool_index_covers (index, "/") == FALSE);
+
+	paths = collect (index, "/data/d0500/", "*", &is_damaged);
+	g_assert_cmpstr (paths, ==,
+	                 "/data/d0500/file500.txt 0\n"
+	                 "/data/d0500/notes 0\n"
+	                 "/data/d0500/notes.old 0\n"
+	                 "/data/d0500/sub 1\n"
+	                 "/data/d0500/sub/deep500.TXT 0\n");
+	g_assert (is_damaged == FALSE);
+	g_free (paths);
+
+	paths = collect (index, "/data/d1999", "*.txt", NULL);
+	g_assert_cmpstr (paths, ==, "/data/d1999/file1999.txt 0\n/data/d1999/sub/deep1999.TXT 0\n");
+	g_free (paths);
+
+	paths = collect (index, "/data/d0000/sub", "deep*", NULL);
+	g_assert_cmpstr (paths, ==, "/data/d0000/sub/deep0.TXT 0\n");
+	g_free (paths);
+
+	paths = collect (index, "/data", "other*", NULL);
+	g_assert_cmpstr (paths, ==, "/data/d0500-x/other.txt 0\n");
+	g_free (paths);
+
+	paths = collect (index, "/data", "deep1234.txt", NULL);
+	g_assert_cmpstr (paths, ==, "/data/d1234/sub/deep1234.TXT 0\n");
+	g_free (paths);
+
+	paths = collect (index, "/data/d050", "*", NULL);
+	g_assert_cmpstr (paths, ==, "");
+	g_free (paths);
+
+	gsearchtool_index_unref (index);
+	g_unlink (path);
+	g_free (path);
+}
+
+static void
+test_index_metadata (void)
+{
+	GSearchIndex * index;
+	GSearchIndexCursor * cursor;
+	GSearchPredicate * predicate;
+	const GSearchIndexEntry * entry;
+	GString * found;
+	GString * all;
+	gchar * path;
+	gchar * paths;
+
+	path = write_index ();
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+
+	found = g_string_new (NULL);
+	cursor = gsearchtool_index_cursor_new (index, "/data/d0042", "file*");
+	g_assert (gsearchtool_index_cursor_next (cursor, found, NULL));
+	entry = gsearchtool_index_cursor_get_entry (cursor);
+	g_assert_cmpint (entry->size, ==, 42);
+	g_assert_cmpint (entry->mtime, ==, -86400);
+	g_assert_cmpint (entry->mode, ==, S_IFREG | 0644);
+	g_assert_cmpint (entry->uid, ==, 1000);
+	g_assert_cmpint (entry->gid, ==, 100);
+	g_assert (gsearchtool_index_cursor_next (cursor, found, NULL) == FALSE);
+	gsearchtool_index_cursor_free (cursor);
+	g_string_free (found, TRUE);
+
+	/* The tests are run on the index, without a stat. */
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_AND);
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 1997));
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_REGULAR));
+	cursor = gsearchtool_index_cursor_new (index, "/data", "*.txt");
+	gsearchtool_index_cursor_set_predicate (cursor, predicate, 0);
+	found = g_string_new (NULL);
+	all = g_string_new (NULL);
+	while (gsearchtool_index_cursor_next (cursor, found, NULL)) {
+		g_string_append_printf (all, "%s\n", found->str);
+	}
+	paths = g_string_free (all, FALSE);
+	g_assert_cmpstr (paths, ==, "/data/d1997/file1997.txt\n/data/d1998/file1998.txt\n/data/d1999/file1999.txt\n");
+	g_free (paths);
+	gsearchtool_index_cursor_free (cursor);
+	gsearchtool_predicate_free (predicate);
+	g_string_free (found, TRUE);
+
+	gsearchtool_index_unref (index);
+	g_unlink (path);
+	g_free (path);
+}
+
+static void
+test_index_damaged (void)
+{
+	GSearchIndex * index;
+	gchar * contents;
+	gchar * path;
+	gchar * paths;
+	gsize length;
+	gboolean is_damaged;
+
+	g_assert (gsearchtool_index_open ("/no/such/index") == NULL);
+
+	path = write_index ();
+	g_assert (g_file_get_contents (path, &contents, &length, NULL));
+
+	/* A header that does not match its checksum. */
+	contents[30] ^= 1;
+	g_assert (g_file_set_contents (path, contents, length, NULL));
+	g_assert (gsearchtool_index_open (path) == NULL);
+	contents[30] ^= 1;
+
+	/* A block that does not match its checksum is only found out when
+	   a search reads it. */
+	contents[length / 2] ^= 1;
+	g_assert (g_file_set_contents (path, contents, length, NULL));
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+	paths = collect (index, "/data", "*", &is_damaged);
+	g_assert (is_damaged == TRUE);
+	g_free (paths);
+	paths = collect (index, "/data/d0000", "notes", &is_damaged);
+	g_assert_cmpstr (paths, ==, "/data/d0000/notes 0\n");
+	g_assert (is_damaged == FALSE);
+	g_free (paths);
+
+	g_assert (gsearchtool_index_is_current (index));
+	g_assert (g_file_set_contents (path, contents, length - 1, NULL));
+	g_assert (gsearchtool_index_is_current (index) == FALSE);
+	gsearchtool_index_unref (index);
+
+	g_unlink (path);
+	g_free (path);
+	g_free (contents);
+}
+
+static void
+test_index_filter (void)
+{
+	static const gchar * patterns[] = {
+		"deep1999*", "*1999*", "*.TXT", "notes.old", "*ot*", "file12[0-9]*", "nothing*"
+	};
+	GSearchIndex * index;
+	gchar * contents;
+	gchar * path;
+	gchar * paths;
+	gchar ** all;
+	gsize length;
+	gboolean is_damaged;
+	gint i;
+	gint j;
+
+	path = write_index ();
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+
+	/* The blocks passed over hold none of the files found. */
+	paths = collect (index, "/data", "*", NULL);
+	all = g_strsplit (paths, "\n", -1);
+	g_free (paths);
+	for (i = 0; i < G_N_ELEMENTS (patterns); i++) {
+		GString * expected = g_string_new (NULL);
+
+		for (j = 0; all[j] != NULL; j++) {
+			gchar * name = strrchr (all[j], '/');
+
+			if (name != NULL) {
+				gchar * file = g_strndup (name + 1, strcspn (name + 1, " "));
+
+				if (compare_name_pattern (patterns[i], file)) {
+					g_string_append_printf (expected, "%s\n", all[j]);
+				}
+				g_free (file);
+			}
+		}
+		paths = collect (index, "/data", patterns[i], NULL);
+		g_assert_cmpstr (paths, ==, expected->str);
+		g_free (paths);
+		g_string_free (expected, TRUE);
+	}
+	g_strfreev (all);
+	gsearchtool_index_unref (index);
+
+	/* A damaged block is not read for a name its filter rules out. */
+	g_assert (g_file_get_contents (path, &contents, &length, NULL));
+	contents[length / 2] ^= 1;
+	g_assert (g_file_set_contents (path, contents, length, NULL));
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+	paths = collect (index, "/data", "deep1999*", &is_damaged);
+	g_assert_cmpstr (paths, ==, "/data/d1999/sub/deep1999.TXT 0\n");
+	g_assert (is_damaged == FALSE);
+	g_free (paths);
+	paths = collect (index, "/data", "*.txt", &is_damaged);
+	g_assert (is_damaged == TRUE);
+	g_free (paths);
+	gsearchtool_index_unref (index);
+
+	g_unlink (path);
+	g_free (path);
+	g_free (contents);
+}
+
+static void
+test_index_build (void)
+{
+	GSearchIndex * index;
+	gchar * folder;
+	gchar * path;
+	gchar * paths;
+	gchar * expected;
+	gchar * file;
+
+	folder = g_dir_make_tmp ("test-gsearchtool-index-XXXXXX", NULL);
+	g_assert (folder != NULL);
+	file = g_build_filename (folder, "b", "c", NULL);
+	g_assert (g_mkdir_with_parents (file, 0700) == 0);
+	g_free (file);
+	file = g_build_filename (folder, "b", "c", "one.txt", NULL);
+	g_assert (g_file_set_contents (file, "1", 1, NULL));
+	g_free (file);
+	file = g_build_filename (folder, "b-two.txt", NULL);
+	g_assert (g_file_set_contents (file, "2", 1, NULL));
+	g_free (file);
+
+	path = g_build_filename (folder, "cache", "index", NULL);
+	g_assert (gsearchtool_index_build (folder, path, NULL));
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+	g_assert_cmpstr (gsearchtool_index_get_root (index), ==, folder);
+
+	paths = collect (index, folder, "*.txt", NULL);
+	expected = g_strdup_printf ("%s/b-two.txt 0\n%s/b/c/one.txt 0\n", folder, folder);
+	g_assert_cmpstr (paths, ==, expected);
+	g_free (expected);
+	g_free (paths);
+	gsearchtool_index_unref (index);
+
+	g_assert (gsearchtool_index_build ("/no/such/folder", path, NULL) == FALSE);
+
+	g_unlink (path);
+	g_free (path);
+	path = g_build_filename (folder, "cache", NULL);
+	g_rmdir (path);
+	g_free (path);
+	file = g_build_filename (folder, "b", "c", "one.txt", NULL);
+	g_unlink (file);
+	g_free (file);
+	file = g_build_filename (folder, "b", "c", NULL);
+	g_rmdir (file);
+	g_free (file);
+	file = g_build_filename (folder, "b", NULL);
+	g_rmdir (file);
+	g_free (file);
+	file = g_build_filename (folder, "b-two.txt", NULL);
+	g_unlink (file);
+	g_free (file);
+	g_rmdir (folder);
+	g_free (folder);
+}
+
+/* The size of the first file the index at @path has in @folder. */
+static gint64
+get_indexed_size (const gchar * path,
+                  const gchar * folder)
+{
+	GSearchIndex * index;
+	GSearchIndexCursor * cursor;
+	GString * file;
+	gint64 size = -1;
+
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+	file = g_string_new (NULL);
+	cursor = gsearchtool_index_cursor_new (index, folder, "*.txt");
+	if (gsearchtool_index_cursor_next (cursor, file, NULL)) {
+		size = gsearchtool_index_cursor_get_entry (cursor)->size;
+	}
+	gsearchtool_index_cursor_free (cursor);
+	gsearchtool_index_unref (index);
+	g_string_free (file, TRUE);
+	return size;
+}
+
+static void
+test_index_rebuild (void)
+{
+	GSearchIndex * index;
+	GSearchIndexCursor * cursor;
+	GSearchPredicate * predicate;
+	GString * found;
+	gchar * folder;
+	gchar * same;
+	gchar * grown;
+	gchar * file;
+	gchar * path;
+	gchar * paths;
+	gchar * expected;
+	gint fd;
+
+	folder = g_dir_make_tmp ("test-gsearchtool-index-XXXXXX", NULL);
+	g_assert (folder != NULL);
+	same = g_build_filename (folder, "same", NULL);
+	grown = g_build_filename (folder, "grown", NULL);
+	g_assert (g_mkdir (same, 0700) == 0);
+	g_assert (g_mkdir (grown, 0700) == 0);
+	file = g_build_filename (same, "a.txt", NULL);
+	g_assert (g_file_set_contents (file, "1", 1, NULL));
+	path = g_strconcat (folder, ".index", NULL);
+
+	/* The folders are only taken from an index built after the second
+	   they last changed in. */
+	g_usleep (1100000);
+	g_assert (gsearchtool_index_build (folder, path, NULL));
+	g_assert_cmpint (get_indexed_size (path, same), ==, 1);
+
+	/* A file written in place leaves its folder as it was, its names
+	   are taken from the index but its size is new, a file added to a
+	   folder is found. */
+	fd = g_open (file, O_WRONLY | O_APPEND, 0);
+	g_assert (fd >= 0);
+	g_assert (write (fd, "23", 2) == 2);
+	close (fd);
+	g_free (file);
+	file = g_build_filename (grown, "b.txt", NULL);
+	g_assert (g_file_set_contents (file, "4", 1, NULL));
+
+	g_assert (gsearchtool_index_build (folder, path, NULL));
+	g_assert_cmpint (get_indexed_size (path, same), ==, 3);
+	index = gsearchtool_index_open (path);
+	g_assert (index != NULL);
+	paths = collect (index, folder, "*.txt", NULL);
+	expected = g_strdup_printf ("%s/grown/b.txt 0\n%s/same/a.txt 0\n", folder, folder);
+	g_assert_cmpstr (paths, ==, expected);
+	g_free (expected);
+	g_free (paths);
+
+	/* A search by size finds the file written in place. */
+	predicate = gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 2);
+	cursor = gsearchtool_index_cursor_new (index, folder, "*.txt");
+	gsearchtool_index_cursor_set_predicate (cursor, predicate, 0);
+	found = g_string_new (NULL);
+	g_assert (gsearchtool_index_cursor_next (cursor, found, NULL));
+	expected = g_build_filename (same, "a.txt", NULL);
+	g_assert_cmpstr (found->str, ==, expected);
+	g_free (expected);
+	g_assert (gsearchtool_index_cursor_next (cursor, found, NULL) == FALSE);
+	gsearchtool_index_cursor_free (cursor);
+	gsearchtool_predicate_free (predicate);
+	g_string_free (found, TRUE);
+	gsearchtool_index_unref (index);
+
+	g_unlink (path);
+	g_free (path);
+	g_unlink (file);
+	g_free (file);
+	file = g_build_filename (same, "a.txt", NULL);
+	g_unlink (file);
+	g_free (file);
+	g_rmdir (same);
+	g_free (same);
+	g_rmdir (grown);
+	g_free (grown);
+	g_rmdir (folder);
+	g_free (folder);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/index/seek", test_index_seek);
+	g_test_add_func ("/index/metadata", test_index_metadata);
+	g_test_add_func ("/index/damaged", test_index_damaged);
+	g_test_add_func ("/index/filter", test_index_filter);
+	g_test_add_func ("/index/build", test_index_build);
+	g_test_add_func ("/index/rebuild", test_index_rebuild);
+
+	return g_test_run ();
+}
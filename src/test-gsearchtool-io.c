@@ -0,0 +1,214 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-io.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the batched file reads, run through io_uring when the
+ * kernel has it and through the fallback either way.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-io.h"
+
+#define HEAD_SIZE 16
+
+typedef struct {
+	gchar                 * folder;
+	gchar                 * paths[6];
+	gchar                 * contents;
+} Fixture;
+
+static void
+fixture_setup (Fixture * fixture,
+               gconstpointer data)
+{
+	guint i;
+
+	gsearchtool_io_set_uring_enabled (GPOINTER_TO_INT (data));
+
+	fixture->folder = g_dir_make_tmp ("test-gsearchtool-io-XXXXXX", NULL);
+	g_assert (fixture->folder != NULL);
+	fixture->paths[0] = g_build_filename (fixture->folder, "small", NULL);
+	fixture->paths[1] = g_build_filename (fixture->folder, "folder", NULL);
+	fixture->paths[2] = g_build_filename (fixture->folder, "dangling", NULL);
+	fixture->paths[3] = g_build_filename (fixture->folder, "missing", NULL);
+	fixture->paths[4] = g_build_filename (fixture->folder, "large", NULL);
+	fixture->paths[5] = NULL;
+
+	fixture->contents = g_malloc (HEAD_SIZE * 3 + 5);
+	for (i = 0; i < HEAD_SIZE * 3 + 5; i++) {
+		fixture->contents[i] = 'a' + i % 26;
+	}
+
+	g_assert (g_file_set_contents (fixture->paths[0], "hello", -1, NULL));
+	g_assert (g_mkdir (fixture->paths[1], 0700) == 0);
+	g_assert (symlink ("nowhere", fixture->paths[2]) == 0);
+	g_assert (g_file_set_contents (fixture->paths[4], fixture->contents, HEAD_SIZE * 3 + 5, NULL));
+}
+
+static void
+fixture_teardown (Fixture * fixture,
+                  gconstpointer data)
+{
+	g_unlink (fixture->paths[0]);
+	g_rmdir (fixture->paths[1]);
+	g_unlink (fixture->paths[2]);
+	g_unlink (fixture->paths[4]);
+	g_rmdir (fixture->folder);
+	g_free (fixture->paths[0]);
+	g_free (fixture->paths[1]);
+	g_free (fixture->paths[2]);
+	g_free (fixture->paths[3]);
+	g_free (fixture->paths[4]);
+	g_free (fixture->folder);
+	g_free (fixture->contents);
+	gsearchtool_io_set_uring_enabled (TRUE);
+}
+
+static void
+test_io_stat_files (Fixture * fixture,
+                    gconstpointer data)
+{
+	GSearchIoStat stats[5];
+
+	gsearchtool_io_stat_files ((const gchar * const *) fixture->paths, 5, stats);
+
+	g_assert_cmpint (stats[0].error, ==, 0);
+	g_assert (S_ISREG (stats[0].mode));
+	g_assert_cmpint (stats[0].size, ==, 5);
+	g_assert_cmpint (stats[0].mtime, >, 0);
+	g_assert_cmpuint (stats[0].inode, !=, 0);
+
+	g_assert_cmpint (stats[1].error, ==, 0);
+	g_assert (S_ISDIR (stats[1].mode));
+	g_assert_cmpuint (stats[1].device, ==, stats[0].device);
+
+	/* The link itself, as it leads nowhere. */
+	g_assert_cmpint (stats[2].error, ==, 0);
+	g_assert (S_ISLNK (stats[2].mode));
+
+	g_assert_cmpint (stats[3].error, ==, ENOENT);
+
+	g_assert_cmpint (stats[4].error, ==, 0);
+	g_assert_cmpint (stats[4].size, ==, HEAD_SIZE * 3 + 5);
+}
+
+/* More files than fit in a ring or a slice of the thread pool. */
+static void
+test_io_stat_many_files (Fixture * fixture,
+                         gconstpointer data)
+{
+	GSearchIoStat * stats;
+	gchar ** paths;
+	guint n_paths = 1000;
+	guint i;
+
+	paths = g_new0 (gchar *, n_paths + 1);
+	for (i = 0; i < n_paths; i++) {
+		paths[i] = g_strdup (fixture->paths[i % 5]);
+	}
+	stats = g_new (GSearchIoStat, n_paths);
+
+	gsearchtool_io_stat_files ((const gchar * const *) paths, n_paths, stats);
+	for (i = 0; i < n_paths; i++) {
+		g_assert_cmpint (stats[i].error, ==, (i % 5 == 3) ? ENOENT : 0);
+		if (i % 5 == 0) {
+			g_assert_cmpint (stats[i].size, ==, 5);
+		}
+	}
+
+	g_free (stats);
+	g_strfreev (paths);
+}
+
+static void
+test_io_open_files (Fixture * fixture,
+                    gconstpointer data)
+{
+	const gchar * paths[3];
+	GSearchIoHead heads[3];
+	guchar buffers[3][HEAD_SIZE];
+	gchar rest[HEAD_SIZE * 3];
+	guint i;
+
+	paths[0] = fixture->paths[0];
+	paths[1] = fixture->paths[3];
+	paths[2] = fixture->paths[4];
+	for (i = 0; i < 3; i++) {
+		heads[i].head = buffers[i];
+	}
+
+	gsearchtool_io_open_files (paths, 3, heads, HEAD_SIZE);
+
+	g_assert_cmpint (heads[0].fd, >=, 0);
+	g_assert_cmpint (heads[0].length, ==, 5);
+	g_assert (memcmp (heads[0].head, "hello", 5) == 0);
+
+	g_assert_cmpint (heads[1].fd, ==, -1);
+	g_assert_cmpint (heads[1].length, ==, 0);
+
+	/* The rest of the file follows the head. */
+	g_assert_cmpint (heads[2].fd, >=, 0);
+	g_assert_cmpint (heads[2].length, ==, HEAD_SIZE);
+	g_assert (memcmp (heads[2].head, fixture->contents, HEAD_SIZE) == 0);
+	g_assert_cmpint (read (heads[2].fd, rest, sizeof (rest)), ==, HEAD_SIZE * 2 + 5);
+	g_assert (memcmp (rest, fixture->contents + HEAD_SIZE, HEAD_SIZE * 2 + 5) == 0);
+
+	gsearchtool_io_close_files (heads, 3);
+	for (i = 0; i < 3; i++) {
+		g_assert_cmpint (heads[i].fd, ==, -1);
+	}
+}
+
+int
+main (int argc,
+      char ** argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add ("/io/uring/stat-files", Fixture, GINT_TO_POINTER (TRUE),
+	            fixture_setup, test_io_stat_files, fixture_teardown);
+	g_test_add ("/io/uring/stat-many-files", Fixture, GINT_TO_POINTER (TRUE),
+	            fixture_setup, test_io_stat_many_files, fixture_teardown);
+	g_test_add ("/io/uring/open-files", Fixture, GINT_TO_POINTER (TRUE),
+	            fixture_setup, test_io_open_files, fixture_teardown);
+	g_test_add ("/io/fallback/stat-files", Fixture, GINT_TO_POINTER (FALSE),
+	            fixture_setup, test_io_stat_files, fixture_teardown);
+	g_test_add ("/io/fallback/stat-many-files", Fixture, GINT_TO_POINTER (FALSE),
+	            fixture_setup, test_io_stat_many_files, fixture_teardown);
+	g_test_add ("/io/fallback/open-files", Fixture, GINT_TO_POINTER (FALSE),
+	            fixture_setup, test_io_open_files, fixture_teardown);
+
+	return g_test_run ();
+}
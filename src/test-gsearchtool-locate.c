@@ -0,0 +1,378 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-locate.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for reading the mlocate database, made up here the way
+ * updatedb writes it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-locate.h"
+
+/* Each folder is given as its path and names separated by tabs, a name
+   ending in '/' is a subfolder. */
+static gchar *
+write_database (GPtrArray * folders,
+                gboolean is_visibility_checked)
+{
+	static const guchar header[] = { '\0', 'm', 'l', 'o', 'c', 'a', 't', 'e', 0, 0, 0, 4, 0, 0, 0, 0 };
+	static const guchar folder_header[16] = { 0 };
+	GByteArray * contents;
+	gchar * path;
+	guint i;
+	gint fd;
+
+	contents = g_byte_array_new ();
+	g_byte_array_append (contents, header, sizeof (header));
+	contents->data[13] = is_visibility_checked;
+	g_byte_array_append (contents, (const guchar *) "/", 2);
+	g_byte_array_append (contents, (const guchar *) "abc", 4);
+
+	for (i = 0; i < folders->len; i++) {
+		gchar ** fields = g_strsplit (g_ptr_array_index (folders, i), "\t", -1);
+		gint j;
+
+		g_byte_array_append (contents, folder_header, sizeof (folder_header));
+		g_byte_array_append (contents, (const guchar *) fields[0], strlen (fields[0]) + 1);
+		for (j = 1; fields[j] != NULL; j++) {
+			gsize length = strlen (fields[j]);
+			guint8 type = 0;
+
+			if (g_str_has_suffix (fields[j], "/")) {
+				type = 1;
+				length--;
+			}
+			g_byte_array_append (contents, &type, 1);
+			g_byte_array_append (contents, (const guchar *) fields[j], length);
+			g_byte_array_append (contents, (const guchar *) "", 1);
+		}
+		g_byte_array_append (contents, (const guchar *) "\2", 1);
+		g_strfreev (fields);
+	}
+
+	fd = g_file_open_tmp ("test-gsearchtool-locate-XXXXXX", &path, NULL);
+	g_assert (fd >= 0);
+	g_assert (write (fd, contents->data, contents->len) == (gssize) contents->len);
+	close (fd);
+	g_byte_array_free (contents, TRUE);
+	return path;
+}
+
+/* The paths found in @folder, one per line in the order found, read a
+   few names at a time. */
+static gchar *
+collect (GSearchLocateDatabase * database,
+         const gchar * folder,
+         const gchar * pattern)
+{
+	GSearchLocateCursor * cursor;
+	GString * paths;
+	GString * path;
+	guint budget = 3;
+
+	paths = g_string_new (NULL);
+	path = g_string_new (NULL);
+	cursor = gsearchtool_locate_cursor_new (database, folder, pattern);
+	while (TRUE) {
+		if (gsearchtool_locate_cursor_next (cursor, path, &budget) == TRUE) {
+			g_string_append_printf (paths, "%s\n", path->str);
+		}
+		else if (budget == 0) {
+			budget = 3;
+		}
+		else {
+			break;
+		}
+	}
+	gsearchtool_locate_cursor_free (cursor);
+	g_string_free (path, TRUE);
+	return g_string_free (paths, FALSE);
+}
+
+/* A tree of two hundred folders, in the order of the database, where
+   "/data/d050/sub" comes before "/data/d050-x". */
+static GPtrArray *
+make_folders (void)
+{
+	GPtrArray * folders;
+	gint i;
+
+	folders = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (folders, g_strdup ("/\tdata/"));
+	g_ptr_array_add (folders, g_strdup ("/data\td000/"));
+	for (i = 0; i < 200; i++) {
+		g_ptr_array_add (folders, g_strdup_printf ("/data/d%03d\tfile%d.txt\tnotes\tsub/", i, i));
+		g_ptr_array_add (folders, g_strdup_printf ("/data/d%03d/sub\tdeep%d.TXT", i, i));
+		if (i == 50) {
+			g_ptr_array_add (folders, g_strdup ("/data/d050-x\tother.txt"));
+		}
+	}
+	return folders;
+}
+
+static void
+test_locate_seek (void)
+{
+	GSearchLocateDatabase * database;
+	GPtrArray * folders;
+	gchar * path;
+	gchar * paths;
+
+	folders = make_folders ();
+	path = write_database (folders, FALSE);
+	database = gsearchtool_locate_database_open (path);
+	g_assert (database != NULL);
+
+	paths = collect (database, "/data/d050/", "*");
+	g_assert_cmpstr (paths, ==, "/data/d050/file50.txt\n/data/d050/notes\n/data/d050/sub\n/data/d050/sub/deep50.TXT\n");
+	g_free (paths);
+
+	paths = collect (database, "/data/d050", "*.txt");
+	g_assert_cmpstr (paths, ==, "/data/d050/file50.txt\n/data/d050/sub/deep50.TXT\n");
+	g_free (paths);
+
+	paths = collect (database, "/data/d199/sub", "deep*");
+	g_assert_cmpstr (paths, ==, "/data/d199/sub/deep199.TXT\n");
+	g_free (paths);
+
+	paths = collect (database, "/data/d000", "notes");
+	g_assert_cmpstr (paths, ==, "/data/d000/notes\n");
+	g_free (paths);
+
+	paths = collect (database, "/", "other*");
+	g_assert_cmpstr (paths, ==, "/data/d050-x/other.txt\n");
+	g_free (paths);
+
+	paths = collect (database, "/data/d05", "*");
+	g_assert_cmpstr (paths, ==, "");
+	g_free (paths);
+
+	paths = collect (database, "/zzz", "*");
+	g_assert_cmpstr (paths, ==, "");
+	g_free (paths);
+
+	g_assert_cmpint (gsearchtool_locate_database_count_entries (database, "/data/d050/", 100), ==, 4);
+	g_assert_cmpint (gsearchtool_locate_database_count_entries (database, "/data/d199/sub", 100), ==, 1);
+	g_assert_cmpint (gsearchtool_locate_database_count_entries (database, "/data/d05", 100), ==, 0);
+	g_assert_cmpint (gsearchtool_locate_database_count_entries (database, "/data", 10), ==, 10);
+
+	gsearchtool_locate_database_unref (database);
+	g_unlink (path);
+	g_free (path);
+	g_ptr_array_free (folders, TRUE);
+}
+
+static void
+test_locate_unsorted (void)
+{
+	GSearchLocateDatabase * database;
+	GPtrArray * folders;
+	gchar * path;
+	gchar * paths;
+	guint i;
+
+	/* The folders the other way round are read through. */
+	folders = make_folders ();
+	for (i = 0; i < folders->len / 2; i++) {
+		gpointer folder = folders->pdata[i];
+
+		folders->pdata[i] = folders->pdata[folders->len - 1 - i];
+		folders->pdata[folders->len - 1 - i] = folder;
+	}
+	path = write_database (folders, FALSE);
+	database = gsearchtool_locate_database_open (path);
+	g_assert (database != NULL);
+
+	paths = collect (database, "/data/d050/", "*.txt");
+	g_assert_cmpstr (paths, ==, "/data/d050/sub/deep50.TXT\n/data/d050/file50.txt\n");
+	g_free (paths);
+
+	gsearchtool_locate_database_unref (database);
+	g_unlink (path);
+	g_free (path);
+	g_ptr_array_free (folders, TRUE);
+}
+
+static void
+test_locate_visibility (void)
+{
+	GSearchLocateDatabase * database;
+	GPtrArray * folders;
+	gchar * folder;
+	gchar * path;
+	gchar * paths;
+	gchar * expected;
+
+	/* Only the folders the user may read are shown. */
+	folder = g_dir_make_tmp ("test-gsearchtool-locate-XXXXXX", NULL);
+	g_assert (folder != NULL);
+	folders = g_ptr_array_new_with_free_func (g_free);
+	g_ptr_array_add (folders, g_strdup_printf ("%s\tseen", folder));
+	g_ptr_array_add (folders, g_strdup_printf ("%s/missing\tunseen", folder));
+	path = write_database (folders, TRUE);
+	database = gsearchtool_locate_database_open (path);
+	g_assert (database != NULL);
+
+	paths = collect (database, folder, "*seen");
+	expected = g_strdup_printf ("%s/seen\n", folder);
+	g_assert_cmpstr (paths, ==, expected);
+	g_free (expected);
+	g_free (paths);
+
+	gsearchtool_locate_database_unref (database);
+	g_unlink (path);
+	g_free (path);
+	g_rmdir (folder);
+	g_free (folder);
+	g_ptr_array_free (folders, TRUE);
+}
+
+/* A database as updatedb writes it for /tmp/t holding a.txt and
+   sub/b.txt, byte by byte, with the times of the folders set so that
+   reading a record from the wrong place shows. */
+static const guchar updatedb_database[] = {
+	/* Header: magic, configuration size 54 (big endian), version 0,
+	   no visibility check, padding. */
+	0x00, 'm', 'l', 'o', 'c', 'a', 't', 'e',
+	0x00, 0x00, 0x00, 0x36,
+	0x00, 0x00, 0x00, 0x00,
+	/* The folder the database was made from. */
+	'/', 't', 'm', 'p', '/', 't', 0x00,
+	/* Configuration: each variable, its values, then an empty
+	   string. */
+	'p', 'r', 'u', 'n', 'e', '_', 'b', 'i', 'n', 'd', '_', 'm', 'o', 'u', 'n', 't', 's', 0x00,
+	'0', 0x00, 0x00,
+	'p', 'r', 'u', 'n', 'e', 'f', 's', 0x00, 0x00,
+	'p', 'r', 'u', 'n', 'e', 'n', 'a', 'm', 'e', 's', 0x00, 0x00,
+	'p', 'r', 'u', 'n', 'e', 'p', 'a', 't', 'h', 's', 0x00, 0x00,
+	/* Folder: seconds (64 bit), nanoseconds (32 bit), padding (32
+	   bit), then its path and entries, a file, a folder, the end. */
+	0x00, 0x00, 0x00, 0x00, 0x65, 0xa0, 0xb3, 0xc1,
+	0x1d, 0xcd, 0x65, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+	'/', 't', 'm', 'p', '/', 't', 0x00,
+	0x00, 'a', '.', 't', 'x', 't', 0x00,
+	0x01, 's', 'u', 'b', 0x00,
+	0x02,
+	0x00, 0x00, 0x00, 0x00, 0x65, 0xa0, 0xb3, 0xc2,
+	0x00, 0x00, 0x00, 0x2a,
+	0x00, 0x00, 0x00, 0x00,
+	'/', 't', 'm', 'p', '/', 't', '/', 's', 'u', 'b', 0x00,
+	0x00, 'b', '.', 't', 'x', 't', 0x00,
+	0x02
+};
+
+static void
+test_locate_updatedb (void)
+{
+	GSearchLocateDatabase * database;
+	gchar * path;
+	gchar * paths;
+	gint fd;
+
+	fd = g_file_open_tmp ("test-gsearchtool-locate-XXXXXX", &path, NULL);
+	g_assert (fd >= 0);
+	g_assert (write (fd, updatedb_database, sizeof (updatedb_database)) == sizeof (updatedb_database));
+	close (fd);
+	database = gsearchtool_locate_database_open (path);
+	g_assert (database != NULL);
+
+	paths = collect (database, "/tmp/t", "*");
+	g_assert_cmpstr (paths, ==, "/tmp/t/a.txt\n/tmp/t/sub\n/tmp/t/sub/b.txt\n");
+	g_free (paths);
+	paths = collect (database, "/tmp/t/sub", "*.TXT");
+	g_assert_cmpstr (paths, ==, "/tmp/t/sub/b.txt\n");
+	g_free (paths);
+
+	g_assert_cmpint (gsearchtool_locate_database_get_entries (database), ==, 3);
+	g_assert_cmpint (gsearchtool_locate_database_count_entries (database, "/tmp/t", 100), ==, 3);
+	g_assert_cmpint (gsearchtool_locate_database_count_entries (database, "/tmp/t/sub", 100), ==, 1);
+
+	gsearchtool_locate_database_unref (database);
+	g_unlink (path);
+	g_free (path);
+}
+
+static void
+test_locate_invalid (void)
+{
+	GSearchLocateDatabase * database;
+	GPtrArray * folders;
+	gchar * contents;
+	gchar * path;
+	gsize length;
+
+	g_assert (gsearchtool_locate_database_open ("/no/such/database") == NULL);
+
+	/* A plocate database, and a folder record cut short. */
+	folders = make_folders ();
+	path = write_database (folders, FALSE);
+	g_assert (g_file_get_contents (path, &contents, &length, NULL));
+
+	contents[1] = 'p';
+	g_assert (g_file_set_contents (path, contents, length, NULL));
+	g_assert (gsearchtool_locate_database_open (path) == NULL);
+
+	contents[1] = 'm';
+	g_assert (g_file_set_contents (path, contents, length - 3, NULL));
+	g_assert (gsearchtool_locate_database_open (path) == NULL);
+
+	/* A new database in place of the one opened. */
+	g_assert (g_file_set_contents (path, contents, length, NULL));
+	database = gsearchtool_locate_database_open (path);
+	g_assert (database != NULL);
+	g_assert (gsearchtool_locate_database_is_current (database));
+	g_assert (g_file_set_contents (path, contents, length - 1, NULL));
+	g_assert (gsearchtool_locate_database_is_current (database) == FALSE);
+	gsearchtool_locate_database_unref (database);
+
+	g_unlink (path);
+	g_free (path);
+	g_free (contents);
+	g_ptr_array_free (folders, TRUE);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/locate/seek", test_locate_seek);
+	g_test_add_func ("/locate/unsorted", test_locate_unsorted);
+	g_test_add_func ("/locate/visibility", test_locate_visibility);
+	g_test_add_func ("/locate/invalid", test_locate_invalid);
+	g_test_add_func ("/locate/updatedb", test_locate_updatedb);
+
+	return g_test_run ();
+}
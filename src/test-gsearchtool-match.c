@@ -0,0 +1,571 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-match.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the matching layer.  Every predicate is checked against
+ * a table of known answers and, where one exists, against an independent
+ * reference implementation over a generated corpus.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <fnmatch.h>
+#include <string.h>
+#include <glib.h>
+
+#include "gsearchtool-match.h"
+
+#define CORPUS_SIZE 20000
+
+/* Reference glob matcher: '*', '?' and '[...]' with ranges and '!',
+   ASCII case insensitive, no escapes, a leading '.' is not special. */
+static gboolean
+reference_glob (const gchar * pattern,
+                const gchar * name)
+{
+	while (*pattern != '\0') {
+		switch (*pattern) {
+		case '*':
+			while (*pattern == '*') {
+				pattern++;
+			}
+			if (*pattern == '\0') {
+				return TRUE;
+			}
+			for (; *name != '\0'; name++) {
+				if (reference_glob (pattern, name)) {
+					return TRUE;
+				}
+			}
+			return FALSE;
+		case '?':
+			if (*name == '\0') {
+				return FALSE;
+			}
+			break;
+		case '[': {
+			const gchar * p = pattern + 1;
+			gboolean negate = FALSE;
+			gboolean found = FALSE;
+			gchar c = g_ascii_tolower (*name);
+
+			if (*name == '\0') {
+				return FALSE;
+			}
+			if (*p == '!') {
+				negate = TRUE;
+				p++;
+			}
+			do {
+				if ((p[1] == '-') && (p[2] != ']') && (p[2] != '\0')) {
+					if ((c >= g_ascii_tolower (p[0])) && (c <= g_ascii_tolower (p[2]))) {
+						found = TRUE;
+					}
+					p += 3;
+				}
+				else {
+					if (c == g_ascii_tolower (*p)) {
+						found = TRUE;
+					}
+					p++;
+				}
+			} while ((*p != ']') && (*p != '\0'));
+
+			if (found == negate) {
+				return FALSE;
+			}
+			pattern = p;
+			break;
+		}
+		default:
+			if (g_ascii_tolower (*pattern) != g_ascii_tolower (*name)) {
+				return FALSE;
+			}
+			break;
+		}
+		pattern++;
+		name++;
+	}
+	return (*name == '\0');
+}
+
+static gchar *
+random_string (GRand * rand,
+               const gchar * alphabet,
+               gint max_length)
+{
+	gint length = g_rand_int_range (rand, 0, max_length + 1);
+	gint alphabet_length = strlen (alphabet);
+	gchar * string = g_malloc (length + 1);
+	gint idx;
+
+	for (idx = 0; idx < length; idx++) {
+		string[idx] = alphabet[g_rand_int_range (rand, 0, alphabet_length)];
+	}
+	string[length] = '\0';
+
+	return string;
+}
+
+static void
+test_compare_name_pattern_table (void)
+{
+	static const struct {
+		const gchar * pattern;
+		const gchar * name;
+		gboolean result;
+	} table[] = {
+		{ "*", "", TRUE },
+		{ "*", ".hidden", TRUE },
+		{ "*report*", "Annual-REPORT.odt", TRUE },
+		{ "*report*", "reprt.odt", FALSE },
+		{ "*.c", "main.c", TRUE },
+		{ "*.c", "main.cc", FALSE },
+		{ "*.[ch]", "main.h", TRUE },
+		{ "*.[!ch]", "main.h", FALSE },
+		{ "file?.txt", "file1.txt", TRUE },
+		{ "file?.txt", "file.txt", FALSE },
+		{ "a\\b", "a\\b", TRUE },
+		{ "*/*", "a/b", TRUE },
+		{ "[a-c]*", "Beta", TRUE },
+	};
+	gint idx;
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		g_assert_cmpint (compare_name_pattern (table[idx].pattern, table[idx].name), ==, table[idx].result);
+	}
+}
+
+static void
+test_compare_name_pattern_reference (void)
+{
+	GRand * rand = g_rand_new_with_seed (29);
+	gint idx;
+
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		gchar * pattern = random_string (rand, "ab.*?", 6);
+		gchar * name = random_string (rand, "aAbB.", 8);
+
+		if (compare_name_pattern (pattern, name) != reference_glob (pattern, name)) {
+			g_error ("compare_name_pattern (\"%s\", \"%s\") disagrees with the reference", pattern, name);
+		}
+		g_free (pattern);
+		g_free (name);
+	}
+	g_rand_free (rand);
+}
+
+/* Reference: a path is hidden when one of its components starts with a
+   '.', except for the first such component if it is a .gnome-desktop
+   folder. */
+static gboolean
+reference_path_hidden (const gchar * path)
+{
+	gchar ** components = g_strsplit (path, G_DIR_SEPARATOR_S, -1);
+	gboolean is_first = TRUE;
+	gboolean results = FALSE;
+	gint idx;
+
+	/* Components after a separator only, like the "/." search. */
+	for (idx = 1; components[idx] != NULL; idx++) {
+		if (components[idx][0] != '.') {
+			continue;
+		}
+		if (is_first && (strcmp (components[idx], ".gnome-desktop") == 0) && (components[idx + 1] != NULL)) {
+			is_first = FALSE;
+			continue;
+		}
+		results = TRUE;
+		break;
+	}
+	g_strfreev (components);
+
+	return results;
+}
+
+static void
+test_is_path_hidden_table (void)
+{
+	static const struct {
+		const gchar * path;
+		gboolean result;
+	} table[] = {
+		{ "/home/user/report.odt", FALSE },
+		{ "/home/user/.bashrc", TRUE },
+		{ "/home/user/.cache/thumbnails/x.png", TRUE },
+		{ "/home/user/file.with.dots", FALSE },
+		{ "/home/user/.gnome-desktop/launcher", FALSE },
+		{ "/home/user/.gnome-desktop", TRUE },
+		{ "/home/user/.gnome-desktop/.hidden", TRUE },
+		{ "/home/user/.gnome-desktop/x/.gnome-desktop/y", TRUE },
+		{ "/home/user/./report.odt", TRUE },
+		{ "relative/.hidden", TRUE },
+		{ ".hidden", FALSE },
+		{ "/", FALSE },
+	};
+	gint idx;
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		g_assert_cmpint (is_path_hidden (table[idx].path), ==, table[idx].result);
+	}
+}
+
+static void
+test_is_path_hidden_reference (void)
+{
+	static const gchar * components[] = {
+		"home", "user", ".cache", ".gnome-desktop", "gnome-desktop", "a.b", ".", "..", "x"
+	};
+	GRand * rand = g_rand_new_with_seed (29);
+	gint idx;
+
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		GString * path = g_string_new (NULL);
+		gint depth = g_rand_int_range (rand, 1, 6);
+		gint level;
+
+		for (level = 0; level < depth; level++) {
+			g_string_append_c (path, G_DIR_SEPARATOR);
+			g_string_append (path, components[g_rand_int_range (rand, 0, G_N_ELEMENTS (components))]);
+		}
+		if (g_rand_int_range (rand, 0, 4) == 0) {
+			g_string_append_c (path, G_DIR_SEPARATOR);
+		}
+
+		if (is_path_hidden (path->str) != reference_path_hidden (path->str)) {
+			g_error ("is_path_hidden (\"%s\") disagrees with the reference", path->str);
+		}
+		g_string_free (path, TRUE);
+	}
+	g_rand_free (rand);
+}
+
+static void
+test_compare_folder_paths (void)
+{
+	static const struct {
+		const gchar * a;
+		const gchar * b;
+		gint sign;
+	} table[] = {
+		{ "/a", "/a", 0 },
+		{ "/a", "/a/b", -1 },
+		{ "/a/b", "/a-b", -1 },
+		{ "/a/z", "/a.b", -1 },
+		{ "/a-b", "/a.b", -1 },
+		{ "/a/b", "/a", 1 },
+		{ "/", "/a", -1 },
+		{ "/b", "/a/z", 1 },
+	};
+	gint idx;
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		gint result = compare_folder_paths (table[idx].a, table[idx].b);
+
+		g_assert_cmpint ((result > 0) - (result < 0), ==, table[idx].sign);
+	}
+}
+
+static void
+test_is_path_excluded (void)
+{
+	static const struct {
+		const gchar * path;
+		gboolean result;
+	} table[] = {
+		{ "/mnt/", TRUE },
+		{ "/mnt", FALSE },
+		{ "/mnt/disk/", TRUE },
+		{ "/media/cdrom/", TRUE },
+		{ "/tmp/", TRUE },
+		{ "/tmp", FALSE },
+		{ "/tmpfiles/", FALSE },
+		{ "/home/user/", TRUE },
+		{ "/home/user/Documents/", FALSE },
+		{ "/home/", FALSE },
+	};
+	GSList * list = NULL;
+	gint idx;
+
+	list = g_slist_append (list, "/mnt/*");
+	list = g_slist_append (list, "/media/*");
+	list = g_slist_append (list, "");
+	list = g_slist_append (list, NULL);
+	list = g_slist_append (list, "/tmp");
+	list = g_slist_append (list, "/home/user/");
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		g_assert_cmpint (is_path_excluded (table[idx].path, list), ==, table[idx].result);
+	}
+	g_assert (is_path_excluded ("/tmp/", NULL) == FALSE);
+
+	g_slist_free (list);
+}
+
+static void
+test_compare_regex (void)
+{
+	static const gchar * patterns[] = {
+		"^report", "\\.c$", "^[a-z]+-[0-9]+\\.txt$", "a|b", "(ab)+c", "^$", "x{2,}"
+	};
+	GRand * rand = g_rand_new_with_seed (29);
+	gint idx;
+
+	/* A NULL regular expression matches everything, an invalid one nothing. */
+	g_assert (compare_regex (NULL, "anything") == TRUE);
+	g_assert (compare_regex ("(", "(") == FALSE);
+	g_assert (compare_regex ("^report", "report-1.txt") == TRUE);
+	g_assert (compare_regex ("^report", "my-report") == FALSE);
+	g_assert (compare_regex ("REPORT", "report") == FALSE);
+
+	/* These patterns mean the same as POSIX extended and Perl regular
+	   expressions, so GRegex can be used as the reference. */
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		const gchar * pattern = patterns[idx % G_N_ELEMENTS (patterns)];
+		gchar * name = random_string (rand, "abcx-0123.txtreport", 12);
+
+		if (compare_regex (pattern, name) != g_regex_match_simple (pattern, name, 0, 0)) {
+			g_error ("compare_regex (\"%s\", \"%s\") disagrees with the reference", pattern, name);
+		}
+		g_free (name);
+	}
+	g_rand_free (rand);
+}
+
+static void
+test_setup_find_name_options_table (void)
+{
+	static const struct {
+		const gchar * file;
+		const gchar * options;
+	} table[] = {
+		{ "", "\\( -iname \"**\" -o -iname \".**\" \\) " },
+		{ "report", "\\( -iname \"*report*\" -o -iname \".*report*\" \\) " },
+		{ ".bash", "\\( -iname \"*.bash*\" -o -iname \".*.bash*\" -o -iname \".bash*\" \\) " },
+		{ "*.c", "\\( -iname \"*.c\" -o -iname \".c\" \\) " },
+		{ "*rc", "\\( -iname \"*rc\" -o -iname \".*rc\" \\) " },
+		{ ".*rc", "\\( -iname \".*rc\" -o -iname \".*.*rc\" \\) " },
+		{ "report*", "-iname \"report*\" " },
+	};
+	gint idx;
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		gchar * options = setup_find_name_options ("-iname", table[idx].file);
+
+		g_assert_cmpstr (options, ==, table[idx].options);
+		g_free (options);
+	}
+}
+
+/* Evaluates the translated find options like find -iname does, @flags
+   selects the leading period behaviour. */
+static gboolean
+find_name_options_match (const gchar * options,
+                         const gchar * name,
+                         gint flags)
+{
+	const gchar * p = options;
+
+	while ((p = strchr (p, '"')) != NULL) {
+		const gchar * end = strchr (p + 1, '"');
+		gchar * pattern;
+		gboolean match;
+
+		g_assert (end != NULL);
+		pattern = g_strndup (p + 1, end - p - 1);
+		match = (fnmatch (pattern, name, flags | FNM_NOESCAPE | FNM_CASEFOLD) == 0);
+		g_free (pattern);
+
+		if (match) {
+			return TRUE;
+		}
+		p = end + 1;
+	}
+	return FALSE;
+}
+
+/* The name options must find exactly what the results filter accepts,
+   and they must also find hidden files with a find(1) whose wildcards do
+   not match a leading period. */
+static void
+test_setup_find_name_options_reference (void)
+{
+	static const gchar * files[] = {
+		"a", "ab", ".a", "*a", "*.a", "a*", ".*a", "*", "a?b"
+	};
+	GRand * rand = g_rand_new_with_seed (29);
+	gint idx;
+
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		const gchar * file = files[idx % G_N_ELEMENTS (files)];
+		gchar * name = random_string (rand, "aAb.", 6);
+		gchar * options = setup_find_name_options ("-iname", file);
+		gchar * pattern;
+
+		if (strchr (file, '*') == NULL) {
+			pattern = g_strconcat ("*", file, "*", NULL);
+		}
+		else {
+			pattern = g_strdup (file);
+		}
+
+		if (find_name_options_match (options, name, 0) != compare_name_pattern (pattern, name)) {
+			g_error ("setup_find_name_options (\"%s\") disagrees with \"%s\" for \"%s\"", file, pattern, name);
+		}
+		g_free (pattern);
+		g_free (options);
+		g_free (name);
+	}
+	g_rand_free (rand);
+
+	/* Hidden files the translation exists for. */
+	g_assert (find_name_options_match ("\\( -iname \"*report*\" -o -iname \".*report*\" \\) ", ".report", FNM_PERIOD));
+	g_assert (find_name_options_match ("\\( -iname \"*.c\" -o -iname \".c\" \\) ", ".c", FNM_PERIOD));
+	g_assert (find_name_options_match ("\\( -iname \"*rc\" -o -iname \".*rc\" \\) ", ".bashrc", FNM_PERIOD));
+}
+
+static void
+test_is_name_pattern_narrower (void)
+{
+	static const struct {
+		const gchar * pattern;
+		const gchar * other;
+		gboolean is_narrower;
+	} table[] = {
+		{ "*report*", "*", TRUE },
+		{ "*report*", "*report*", TRUE },
+		{ "*report.txt*", "*report*", TRUE },
+		{ "*REPORT.txt*", "*report*", TRUE },
+		{ "*report*", "*report.txt*", FALSE },
+		{ "logfile*", "log*", TRUE },
+		{ "*logfile*", "log*", FALSE },
+		{ "*main.c", "*.c", TRUE },
+		{ "*main.c*", "*.c", FALSE },
+		{ "main.c", "*.c", TRUE },
+		{ "*a?c*", "*a*", FALSE },
+		{ "*", "*report*", FALSE },
+	};
+	static const gchar * patterns[] = {
+		"*", "*a*", "*ab*", "a*", "ab*", "*a", "*ba", "ab", "*.a*", "*a.*"
+	};
+	GRand * rand = g_rand_new_with_seed (43);
+	gint idx;
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		g_assert_cmpint (is_name_pattern_narrower (table[idx].pattern, table[idx].other), ==, table[idx].is_narrower);
+	}
+
+	/* A narrower pattern never matches a name the other does not. */
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		const gchar * pattern = patterns[g_rand_int_range (rand, 0, G_N_ELEMENTS (patterns))];
+		const gchar * other = patterns[g_rand_int_range (rand, 0, G_N_ELEMENTS (patterns))];
+		gchar * name = random_string (rand, "aAb.", 4);
+
+		if ((is_name_pattern_narrower (pattern, other) == TRUE) &&
+		    (compare_name_pattern (pattern, name) == TRUE) &&
+		    (compare_name_pattern (other, name) == FALSE)) {
+			g_error ("\"%s\" is not narrower than \"%s\" for \"%s\"", pattern, other, name);
+		}
+		g_free (name);
+	}
+	g_rand_free (rand);
+}
+
+static void
+test_get_name_pattern_literals (void)
+{
+	static const struct {
+		const gchar * pattern;
+		const gchar * literals;
+	} table[] = {
+		{ "*", "" },
+		{ "*Report*", "report" },
+		{ "*.TXT", ".txt" },
+		{ "ab*cd", "" },
+		{ "abc?defg*hi", "abc defg" },
+		{ "log[0-9]file.txt", "log file.txt" },
+		{ "x[]abc]yyy", "yyy" },
+		{ "x[!]abc]yyy", "yyy" },
+		{ "abc[def", "abc" },
+		{ "caf\xc3\xa9.txt", "caf .txt" },
+	};
+	static const gchar * patterns[] = {
+		"*abc*", "a?c*", "*b.a", "[ab]cab*", "*ABC", "ab[!c]c*"
+	};
+	GRand * rand = g_rand_new_with_seed (47);
+	gint idx;
+
+	for (idx = 0; idx < G_N_ELEMENTS (table); idx++) {
+		gchar ** literals = get_name_pattern_literals (table[idx].pattern, 3);
+		gchar * joined = g_strjoinv (" ", literals);
+
+		g_assert_cmpstr (joined, ==, table[idx].literals);
+		g_free (joined);
+		g_strfreev (literals);
+	}
+
+	/* A name the pattern matches holds each literal. */
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		const gchar * pattern = patterns[g_rand_int_range (rand, 0, G_N_ELEMENTS (patterns))];
+		gchar * name = random_string (rand, "aAbBc.", 6);
+		gchar * folded = g_ascii_strdown (name, -1);
+		gchar ** literals = get_name_pattern_literals (pattern, 1);
+		gint i;
+
+		if (compare_name_pattern (pattern, name) == TRUE) {
+			for (i = 0; literals[i] != NULL; i++) {
+				if (strstr (folded, literals[i]) == NULL) {
+					g_error ("\"%s\" matches \"%s\" without \"%s\"", pattern, name, literals[i]);
+				}
+			}
+		}
+		g_strfreev (literals);
+		g_free (folded);
+		g_free (name);
+	}
+	g_rand_free (rand);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/match/compare_name_pattern/table", test_compare_name_pattern_table);
+	g_test_add_func ("/match/compare_name_pattern/reference", test_compare_name_pattern_reference);
+	g_test_add_func ("/match/is_name_pattern_narrower", test_is_name_pattern_narrower);
+	g_test_add_func ("/match/is_path_hidden/table", test_is_path_hidden_table);
+	g_test_add_func ("/match/is_path_hidden/reference", test_is_path_hidden_reference);
+	g_test_add_func ("/match/compare_folder_paths", test_compare_folder_paths);
+	g_test_add_func ("/match/get_name_pattern_literals", test_get_name_pattern_literals);
+	g_test_add_func ("/match/is_path_excluded", test_is_path_excluded);
+	g_test_add_func ("/match/compare_regex", test_compare_regex);
+	g_test_add_func ("/match/setup_find_name_options/table", test_setup_find_name_options_table);
+	g_test_add_func ("/match/setup_find_name_options/reference", test_setup_find_name_options_reference);
+
+	return g_test_run ();
+}
@@ -0,0 +1,190 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-planner.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+
+/*
+ * Unit tests for the query planner, on made up folders and databases
+ * so the plans do not depend on the machine the tests run on.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-planner.h"
+
+static void
+test_planner_selectivity (void)
+{
+	g_assert_cmpfloat (gsearchtool_planner_get_name_selectivity (NULL), ==, 1.0);
+	g_assert_cmpfloat (gsearchtool_planner_get_name_selectivity ("*"), ==, 1.0);
+	g_assert_cmpfloat (gsearchtool_planner_get_name_selectivity ("*a?"), ==, 0.5);
+	g_assert_cmpfloat (gsearchtool_planner_get_name_selectivity ("*.c"), ==, 0.25);
+	g_assert_cmpfloat (gsearchtool_planner_get_name_selectivity ("*a_very_long_name*"), ==, 0.001);
+}
+
+static void
+test_planner_choose (void)
+{
+	GSearchPlanQuery query;
+	GSearchPredicate * predicate;
+	GSearchPlan plan;
+	gchar * explanation;
+	gint64 cost;
+
+	/* Only the names, locate reads the database quicker than find
+	   walks the same files. */
+	memset (&query, 0, sizeof (query));
+	query.name_pattern = "*report*";
+	query.has_locate = TRUE;
+	query.folder_entries = 1000000;
+	query.database_entries = 1000000;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_LOCATE);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE_THEN_STAT], ==, GSEARCH_PLAN_IMPOSSIBLE);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE], <, plan.costs[GSEARCH_PLAN_WALK]);
+
+	/* A small folder is walked rather than a large database read. */
+	query.folder_entries = 1000;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+
+	/* Nor when the size of the folder or of the database is not known. */
+	query.folder_entries = -1;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE], ==, GSEARCH_PLAN_IMPOSSIBLE);
+	query.folder_entries = 1000000;
+	query.database_entries = -1;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+	query.database_entries = 1000000;
+
+	/* Without locate there is only the walk. */
+	query.folder_entries = 1000000;
+	query.has_locate = FALSE;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE], ==, GSEARCH_PLAN_IMPOSSIBLE);
+
+	/* The other tests take a stat of each name locate finds, worth it
+	   when the name lets few through. */
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_AND);
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 4096));
+	query.has_locate = TRUE;
+	query.predicate = predicate;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_LOCATE_THEN_STAT);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE], ==, GSEARCH_PLAN_IMPOSSIBLE);
+
+	query.name_pattern = "*";
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+
+	/* An index with the sizes runs the tests itself, only the files
+	   that pass them get a stat. */
+	cost = plan.costs[GSEARCH_PLAN_LOCATE_THEN_STAT];
+	query.has_metadata = TRUE;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE_THEN_STAT], <, cost);
+	query.has_metadata = FALSE;
+
+	/* Nor when find has to run one of the tests itself. */
+	query.name_pattern = "*report*";
+	query.is_walk_required = TRUE;
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+
+	query.is_walk_required = FALSE;
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_text (GSEARCH_PREDICATE_FIND_TEST, "-perm -u+x"));
+	gsearchtool_planner_choose (&query, &plan);
+	g_assert_cmpint (plan.kind, ==, GSEARCH_PLAN_WALK);
+	g_assert_cmpint (plan.costs[GSEARCH_PLAN_LOCATE_THEN_STAT], ==, GSEARCH_PLAN_IMPOSSIBLE);
+
+	explanation = gsearchtool_planner_explain (&plan);
+	g_assert (strchr (explanation, '\n') == NULL);
+	g_free (explanation);
+	gsearchtool_predicate_free (predicate);
+
+	g_assert_cmpstr (gsearchtool_planner_get_kind_name (GSEARCH_PLAN_LOCATE_THEN_STAT), ==, "locate+stat");
+}
+
+/* A small folder is read whole, so its entries are counted exactly. */
+static void
+test_planner_estimates (void)
+{
+	gchar * folder;
+	gchar * path;
+	gint i;
+
+	folder = g_dir_make_tmp ("test-gsearchtool-planner-XXXXXX", NULL);
+	g_assert (folder != NULL);
+	path = g_build_filename (folder, "sub", NULL);
+	g_assert (g_mkdir (path, 0700) == 0);
+	g_free (path);
+	for (i = 0; i < 10; i++) {
+		gchar * name = g_strdup_printf ("%s/file%d", (i < 5) ? "" : "sub", i);
+
+		path = g_build_filename (folder, name, NULL);
+		g_assert (g_file_set_contents (path, "", 0, NULL) == TRUE);
+		g_free (path);
+		g_free (name);
+	}
+
+	g_assert_cmpint (gsearchtool_planner_estimate_folder_entries (folder, NULL), ==, 11);
+	g_assert_cmpint (gsearchtool_planner_estimate_folder_entries ("/", NULL), >, 0);
+	g_assert_cmpint (gsearchtool_planner_estimate_folder_entries ("/no/such/folder", NULL), ==, -1);
+
+	for (i = 0; i < 10; i++) {
+		gchar * name = g_strdup_printf ("%s/file%d", (i < 5) ? "" : "sub", i);
+
+		path = g_build_filename (folder, name, NULL);
+		g_unlink (path);
+		g_free (path);
+		g_free (name);
+	}
+	path = g_build_filename (folder, "sub", NULL);
+	g_rmdir (path);
+	g_free (path);
+	g_rmdir (folder);
+	g_free (folder);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/planner/selectivity", test_planner_selectivity);
+	g_test_add_func ("/planner/choose", test_planner_choose);
+	g_test_add_func ("/planner/estimates", test_planner_estimates);
+
+	return g_test_run ();
+}
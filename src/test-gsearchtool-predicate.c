@@ -0,0 +1,429 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-predicate.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+
+/*
+ * Unit tests for the constraint predicates.  The trees are run both by
+ * find, on the arguments they give, and in process on a tree of files
+ * written to a temporary folder, and must pick the same files.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-predicate.h"
+#include "test-gsearchtool-util.h"
+
+typedef struct {
+	gchar                 * folder;
+} Fixture;
+
+static void
+write_file (Fixture * fixture,
+            const gchar * name,
+            gsize size,
+            gint days_old)
+{
+	gchar * path;
+	gchar * folder;
+	gchar * contents;
+
+	path = g_build_filename (fixture->folder, name, NULL);
+	folder = g_path_get_dirname (path);
+	g_assert (g_mkdir_with_parents (folder, 0700) == 0);
+	contents = g_strnfill (size, 'x');
+	g_assert (g_file_set_contents (path, contents, size, NULL));
+	if (days_old > 0) {
+		struct utimbuf times;
+
+		times.actime = times.modtime = time (NULL) - days_old * 24 * 60 * 60 - 60;
+		g_assert (utime (path, &times) == 0);
+	}
+	g_free (contents);
+	g_free (folder);
+	g_free (path);
+}
+
+static void
+fixture_setup (Fixture * fixture,
+               gconstpointer data)
+{
+	fixture->folder = g_dir_make_tmp ("test-gsearchtool-predicate-XXXXXX", NULL);
+	g_assert (fixture->folder != NULL);
+
+	write_file (fixture, "small.txt", 10, 0);
+	write_file (fixture, "big.bin", 5000, 0);
+	write_file (fixture, "empty", 0, 0);
+	write_file (fixture, "old.txt", 10, 30);
+	write_file (fixture, "sub/new.log", 100, 0);
+	write_file (fixture, "sub/older.log", 6000, 10);
+	write_file (fixture, ".hidden/inner.txt", 10, 0);
+	write_file (fixture, "sub/.dot.txt", 10, 0);
+}
+
+static void
+fixture_teardown (Fixture * fixture,
+                  gconstpointer data)
+{
+	test_remove_tree (fixture->folder);
+	g_free (fixture->folder);
+}
+
+static void
+walk (GSearchPredicate * predicate,
+      const gchar * folder,
+      const gchar * path,
+      gint64 now,
+      GPtrArray * found)
+{
+	GSearchIoStat io_stat;
+	GDir * dir;
+	const gchar * name;
+
+	gsearchtool_io_stat_files (&path, 1, &io_stat);
+	if (gsearchtool_predicate_evaluate (predicate, folder, path, &io_stat, now) == TRUE) {
+		g_ptr_array_add (found, g_strdup (path));
+	}
+
+	dir = g_dir_open (path, 0, NULL);
+	if (dir == NULL) {
+		return;
+	}
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		gchar * child;
+
+		child = g_build_filename (path, name, NULL);
+		walk (predicate, folder, child, now, found);
+		g_free (child);
+	}
+	g_dir_close (dir);
+}
+
+static gint
+compare_paths (gconstpointer a,
+               gconstpointer b)
+{
+	return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+static gchar *
+join_sorted (GPtrArray * paths)
+{
+	GString * joined;
+	guint i;
+
+	g_ptr_array_sort (paths, compare_paths);
+	joined = g_string_new ("");
+	for (i = 0; i < paths->len; i++) {
+		g_string_append_printf (joined, "%s\n", (gchar *) g_ptr_array_index (paths, i));
+	}
+	return g_string_free (joined, FALSE);
+}
+
+/* Runs @predicate on the fixture both ways, and returns the names of
+   the files it picks relative to the folder. */
+static gchar *
+run_both_ways (Fixture * fixture,
+               GSearchPredicate * predicate)
+{
+	GPtrArray * found;
+	gchar * prune;
+	gchar * arguments;
+	gchar * quoted;
+	gchar * command;
+	gchar * argv[] = { "/bin/sh", "-c", NULL, NULL };
+	gchar * output;
+	gchar ** lines;
+	gchar * by_find;
+	gchar * in_process;
+	gchar ** parts;
+	gchar * relative;
+	gint status;
+	gint i;
+
+	gsearchtool_predicate_optimize (predicate);
+	prune = gsearchtool_predicate_to_find_prune_arguments (predicate, fixture->folder);
+	arguments = gsearchtool_predicate_to_find_arguments (predicate);
+	quoted = g_shell_quote (fixture->folder);
+	command = g_strdup_printf ("find %s %s%s-print", quoted, prune, arguments);
+	argv[2] = command;
+	g_assert (g_spawn_sync (NULL, argv, NULL, 0, NULL, NULL, &output, NULL, &status, NULL));
+	g_assert_cmpint (status, ==, 0);
+
+	found = g_ptr_array_new_with_free_func (g_free);
+	lines = g_strsplit (output, "\n", -1);
+	for (i = 0; lines[i] != NULL; i++) {
+		if (*lines[i] != '\0') {
+			g_ptr_array_add (found, g_strdup (lines[i]));
+		}
+	}
+	by_find = join_sorted (found);
+	g_ptr_array_set_size (found, 0);
+
+	walk (predicate, fixture->folder, fixture->folder, time (NULL), found);
+	in_process = join_sorted (found);
+	g_assert_cmpstr (in_process, ==, by_find);
+
+	parts = g_strsplit (in_process, fixture->folder, -1);
+	relative = g_strjoinv ("", parts);
+
+	g_ptr_array_free (found, TRUE);
+	g_strfreev (parts);
+	g_strfreev (lines);
+	g_free (in_process);
+	g_free (by_find);
+	g_free (output);
+	g_free (command);
+	g_free (quoted);
+	g_free (arguments);
+	g_free (prune);
+	gsearchtool_predicate_free (predicate);
+
+	return relative;
+}
+
+static GSearchPredicate *
+new_and (GSearchPredicate * first,
+         GSearchPredicate * second)
+{
+	GSearchPredicate * predicate;
+
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_AND);
+	gsearchtool_predicate_add (predicate, first);
+	if (second != NULL) {
+		gsearchtool_predicate_add (predicate, second);
+	}
+	return predicate;
+}
+
+static GSearchPredicate *
+new_not_named (const gchar * pattern)
+{
+	GSearchPredicate * predicate;
+
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT);
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_text (GSEARCH_PREDICATE_NAME, pattern));
+	return predicate;
+}
+
+static void
+test_predicate_order (void)
+{
+	GSearchPredicate * predicate;
+	gchar * arguments;
+
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_AND);
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_text (GSEARCH_PREDICATE_FIND_TEST, "-exec grep -q text {} \\;"));
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_NO_OWNER));
+	gsearchtool_predicate_add (predicate, new_not_named ("*x*"));
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 1024));
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT_HIDDEN));
+
+	arguments = gsearchtool_predicate_to_find_arguments (predicate);
+	g_assert_cmpstr (arguments, ==, "-exec grep -q text {} \\; \\( -nouser -o -nogroup \\) '!' -name '*x*' \\( -size 1024c -o -size +1024c \\) ");
+	g_free (arguments);
+
+	/* The size rules out the most files for the work, the grep of
+	   the contents is the most work. */
+	gsearchtool_predicate_optimize (predicate);
+	arguments = gsearchtool_predicate_to_find_arguments (predicate);
+	g_assert_cmpstr (arguments, ==, "\\( -size 1024c -o -size +1024c \\) '!' -name '*x*' \\( -nouser -o -nogroup \\) -exec grep -q text {} \\; ");
+	g_free (arguments);
+
+	arguments = gsearchtool_predicate_to_find_prune_arguments (predicate, "/home/user/");
+	g_assert_cmpstr (arguments, ==, "\\( -name '.*' '!' -name .gnome-desktop \\) -prune -o ");
+	g_free (arguments);
+	arguments = gsearchtool_predicate_to_find_prune_arguments (predicate, "/home/user/.cache/");
+	g_assert_cmpstr (arguments, ==, "");
+	g_free (arguments);
+
+	gsearchtool_predicate_free (predicate);
+}
+
+static void
+test_predicate_owners (void)
+{
+	GSearchPredicate * predicate;
+	gchar * arguments;
+
+	predicate = gsearchtool_predicate_new_text (GSEARCH_PREDICATE_USER, "root");
+	g_assert_cmpint (gsearchtool_predicate_get_kind (predicate), ==, GSEARCH_PREDICATE_UID);
+	arguments = gsearchtool_predicate_to_find_arguments (predicate);
+	g_assert_cmpstr (arguments, ==, "-uid 0 ");
+	g_free (arguments);
+	gsearchtool_predicate_free (predicate);
+
+	predicate = gsearchtool_predicate_new_text (GSEARCH_PREDICATE_GROUP, "4321");
+	g_assert_cmpint (gsearchtool_predicate_get_kind (predicate), ==, GSEARCH_PREDICATE_GID);
+	gsearchtool_predicate_free (predicate);
+
+	predicate = gsearchtool_predicate_new_text (GSEARCH_PREDICATE_USER, "no such user");
+	g_assert_cmpint (gsearchtool_predicate_get_kind (predicate), ==, GSEARCH_PREDICATE_USER);
+	arguments = gsearchtool_predicate_to_find_arguments (predicate);
+	g_assert_cmpstr (arguments, ==, "-user 'no such user' ");
+	g_free (arguments);
+	gsearchtool_predicate_free (predicate);
+}
+
+static void
+test_predicate_evaluate (Fixture * fixture,
+                         gconstpointer data)
+{
+	GSearchPredicate * predicate;
+	GSearchPredicate * either;
+	gchar * found;
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 4500), NULL));
+	g_assert_cmpstr (found, ==, "/big.bin\n/sub/older.log\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_BEFORE, 10), NULL));
+	g_assert_cmpstr (found, ==, "/old.txt\n/sub/older.log\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_WITHIN, 7),
+	                                         new_not_named ("*.txt")));
+	g_assert_cmpstr (found, ==, "\n/.hidden\n/big.bin\n/empty\n/sub\n/sub/new.log\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_EMPTY), NULL));
+	g_assert_cmpstr (found, ==, "/empty\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT_HIDDEN),
+	                                         gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_MOST, 10)));
+	g_assert_cmpstr (found, ==, "/empty\n/old.txt\n/small.txt\n");
+	g_free (found);
+
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_AND);
+	either = gsearchtool_predicate_new (GSEARCH_PREDICATE_OR);
+	gsearchtool_predicate_add (either, gsearchtool_predicate_new_text (GSEARCH_PREDICATE_NAME, "*.log"));
+	gsearchtool_predicate_add (either, gsearchtool_predicate_new (GSEARCH_PREDICATE_EMPTY));
+	gsearchtool_predicate_add (predicate, either);
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_number (GSEARCH_PREDICATE_UID, getuid ()));
+	found = run_both_ways (fixture, predicate);
+	g_assert_cmpstr (found, ==, "/empty\n/sub/new.log\n/sub/older.log\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_DIRECTORY), NULL));
+	g_assert_cmpstr (found, ==, "\n/.hidden\n/sub\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_REGULAR),
+	                                         gsearchtool_predicate_new_text (GSEARCH_PREDICATE_NAME, "*.log")));
+	g_assert_cmpstr (found, ==, "/sub/new.log\n/sub/older.log\n");
+	g_free (found);
+
+	/* Only -iname leaves the case out. */
+	write_file (fixture, "Mixed.TXT", 10, 0);
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_REGULAR),
+	                                         gsearchtool_predicate_new_text (GSEARCH_PREDICATE_INAME, "*mixed*")));
+	g_assert_cmpstr (found, ==, "/Mixed.TXT\n");
+	g_free (found);
+
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_REGULAR),
+	                                         gsearchtool_predicate_new_text (GSEARCH_PREDICATE_NAME, "*mixed*")));
+	g_assert_cmpstr (found, ==, "");
+	g_free (found);
+
+	predicate = gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT);
+	gsearchtool_predicate_add (predicate, gsearchtool_predicate_new_text (GSEARCH_PREDICATE_INAME, "*.txt*"));
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_REGULAR), predicate));
+	g_assert_cmpstr (found, ==, "/big.bin\n/empty\n/sub/new.log\n/sub/older.log\n");
+	g_free (found);
+	found = run_both_ways (fixture, new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_NO_OWNER), NULL));
+	g_assert_cmpstr (found, ==, "");
+	g_free (found);
+}
+
+static gboolean
+refines (GSearchPredicate * predicate,
+         GSearchPredicate * previous)
+{
+	gboolean is_refining;
+
+	is_refining = gsearchtool_predicate_refines (predicate, previous);
+	gsearchtool_predicate_free (predicate);
+	gsearchtool_predicate_free (previous);
+	return is_refining;
+}
+
+static void
+test_predicate_refines (void)
+{
+	/* A tighter bound or one more test narrows the search down. */
+	g_assert (refines (new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 2048), NULL),
+	                   new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 1024), NULL)));
+	g_assert (refines (new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_WITHIN, 3), NULL),
+	                   new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_WITHIN, 7), NULL)));
+	g_assert (refines (new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT_HIDDEN),
+	                            gsearchtool_predicate_new (GSEARCH_PREDICATE_EMPTY)),
+	                   new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT_HIDDEN), NULL)));
+	g_assert (refines (new_and (new_not_named ("*~*"),
+	                            new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_UID, 0), NULL)),
+	                   new_and (new_not_named ("*~*"), NULL)));
+	g_assert (refines (new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_EMPTY), NULL),
+	                   new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_MOST, 10), NULL)));
+
+	/* A looser one or a test taken away does not. */
+	g_assert (!refines (new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 512), NULL),
+	                    new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_SIZE_AT_LEAST, 1024), NULL)));
+	g_assert (!refines (new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_BEFORE, 3), NULL),
+	                    new_and (gsearchtool_predicate_new_number (GSEARCH_PREDICATE_MODIFIED_BEFORE, 7), NULL)));
+	g_assert (!refines (gsearchtool_predicate_new (GSEARCH_PREDICATE_AND),
+	                    new_and (gsearchtool_predicate_new (GSEARCH_PREDICATE_NOT_HIDDEN), NULL)));
+	g_assert (!refines (new_and (new_not_named ("*~*"), NULL),
+	                    new_and (new_not_named ("*.bak*"), NULL)));
+
+	/* The tests find runs must have been run on the files before. */
+	g_assert (refines (new_and (gsearchtool_predicate_new_text (GSEARCH_PREDICATE_FIND_TEST, "-perm -u+x"),
+	                            gsearchtool_predicate_new (GSEARCH_PREDICATE_EMPTY)),
+	                   new_and (gsearchtool_predicate_new_text (GSEARCH_PREDICATE_FIND_TEST, "-perm -u+x"), NULL)));
+	g_assert (!refines (new_and (gsearchtool_predicate_new_text (GSEARCH_PREDICATE_FIND_TEST, "-perm -u+x"), NULL),
+	                    gsearchtool_predicate_new (GSEARCH_PREDICATE_AND)));
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/predicate/order", test_predicate_order);
+	g_test_add_func ("/predicate/owners", test_predicate_owners);
+	g_test_add_func ("/predicate/refines", test_predicate_refines);
+	g_test_add ("/predicate/evaluate", Fixture, NULL,
+	            fixture_setup, test_predicate_evaluate, fixture_teardown);
+
+	return g_test_run ();
+}
@@ -0,0 +1,457 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-results.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the result store, in memory and spilled to disk with a
+ * budget small enough to force it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gsearchtool-results.h"
+
+#define SPILL_RESULTS 60000
+#define SPILL_BUDGET (256 * 1024)
+
+static gchar * spill_folder = NULL;
+
+static const gchar * ContentTypes[] = {
+	"text/plain", "image/jpeg", "application/pdf", "inode/directory", NULL
+};
+
+static gchar *
+create_path (gint idx)
+{
+	return g_strdup_printf ("/home/user/folder-%d/file-%07d.txt", idx % 97, (idx * 7919) % 1000003);
+}
+
+static GSearchResults *
+create_results (gsize budget,
+                gint count)
+{
+	GSearchResults * results;
+	gint idx;
+
+	results = gsearchtool_results_new (budget, spill_folder);
+	for (idx = 0; idx < count; idx++) {
+		gchar * path = create_path (idx);
+
+		g_assert (gsearchtool_results_contains (results, path) == FALSE);
+		gsearchtool_results_append (results, path, ContentTypes[idx % G_N_ELEMENTS (ContentTypes)],
+		                            (idx * 31) % 5000, 1000000 + (idx * 17) % 777);
+		g_free (path);
+	}
+	return results;
+}
+
+static void
+check_records (GSearchResults * results,
+               gint count)
+{
+	GSearchResultsRecord record;
+	gint idx;
+
+	g_assert_cmpuint (gsearchtool_results_get_length (results), ==, count);
+
+	for (idx = 0; idx < count; idx++) {
+		gchar * path = create_path (idx);
+
+		g_assert (gsearchtool_results_contains (results, path) == TRUE);
+		g_assert (gsearchtool_results_get (results, idx, &record) == TRUE);
+		g_assert_cmpstr (record.path, ==, path);
+		g_assert_cmpstr (record.content_type, ==, ContentTypes[idx % G_N_ELEMENTS (ContentTypes)]);
+		g_assert_cmpint (record.size, ==, (idx * 31) % 5000);
+		g_assert_cmpint (record.mtime, ==, 1000000 + (idx * 17) % 777);
+		g_free (path);
+	}
+	g_assert (gsearchtool_results_get (results, count, &record) == FALSE);
+	g_assert (gsearchtool_results_contains (results, "/home/user/missing") == FALSE);
+}
+
+/* Checks that each row is found again from its path. */
+static void
+check_find (GSearchResults * results)
+{
+	GSearchResultsRecord record;
+	guint length;
+	guint row;
+
+	length = gsearchtool_results_get_length (results);
+	for (row = 0; row < length; row++) {
+		gchar * path;
+
+		g_assert (gsearchtool_results_get (results, row, &record) == TRUE);
+		path = g_strdup (record.path);
+		g_assert_cmpint (gsearchtool_results_find (results, path), ==, row);
+		g_free (path);
+	}
+}
+
+/* Sorts by @column and checks the order and the reorder array against a
+   copy of the rows taken before. */
+static void
+check_sort (GSearchResults * results,
+            GSearchResultsSortColumn column,
+            gboolean descending)
+{
+	GPtrArray * paths;
+	GSearchResultsRecord record;
+	gint64 previous = G_MININT64;
+	gchar * previous_name = NULL;
+	gint * new_order;
+	guint length;
+	guint row;
+
+	length = gsearchtool_results_get_length (results);
+	paths = g_ptr_array_new_with_free_func (g_free);
+	for (row = 0; row < length; row++) {
+		gsearchtool_results_get (results, row, &record);
+		g_ptr_array_add (paths, g_strdup (record.path));
+	}
+
+	gsearchtool_results_set_sort (results, column, descending);
+	new_order = gsearchtool_results_sort (results);
+	g_assert (new_order != NULL);
+	g_assert (gsearchtool_results_is_sorted (results) == TRUE);
+
+	for (row = 0; row < length; row++) {
+		gint64 value;
+
+		gsearchtool_results_get (results, row, &record);
+		g_assert_cmpstr (record.path, ==, g_ptr_array_index (paths, new_order[row]));
+
+		if (column == GSEARCH_RESULTS_SORT_NAME) {
+			gchar * name = g_path_get_basename (record.path);
+
+			if (previous_name != NULL) {
+				g_assert_cmpint (g_ascii_strcasecmp (previous_name, name) * (descending ? -1 : 1), <=, 0);
+			}
+			g_free (previous_name);
+			previous_name = name;
+			continue;
+		}
+
+		value = (column == GSEARCH_RESULTS_SORT_SIZE) ? record.size : record.mtime;
+		if (descending) {
+			value = -value;
+		}
+		g_assert_cmpint (value, >=, previous);
+		previous = value;
+	}
+
+	g_free (previous_name);
+	g_free (new_order);
+	g_ptr_array_free (paths, TRUE);
+
+	check_find (results);
+}
+
+static void
+test_results_memory (void)
+{
+	GSearchResults * results;
+
+	results = create_results (GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET, 5000);
+	g_assert (gsearchtool_results_is_spilled (results) == FALSE);
+	check_records (results, 5000);
+
+	gsearchtool_results_clear (results);
+	g_assert_cmpuint (gsearchtool_results_get_length (results), ==, 0);
+	g_assert (gsearchtool_results_contains (results, "/home/user/folder-0/file-0000000.txt") == FALSE);
+
+	gsearchtool_results_free (results);
+}
+
+static void
+test_results_spill (void)
+{
+	GSearchResults * results;
+
+	results = create_results (SPILL_BUDGET, SPILL_RESULTS);
+	g_assert (gsearchtool_results_is_spilled (results) == TRUE);
+
+	/* At most two chunks of each of the five segments stay mapped. */
+	g_assert_cmpuint (gsearchtool_results_get_memory_size (results), <=, 5 * 2 * 256 * 1024);
+	check_records (results, SPILL_RESULTS);
+
+	gsearchtool_results_free (results);
+}
+
+static void
+test_results_sort (void)
+{
+	GSearchResults * results;
+
+	results = create_results (GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET, 5000);
+	check_sort (results, GSEARCH_RESULTS_SORT_SIZE, TRUE);
+	check_sort (results, GSEARCH_RESULTS_SORT_DATE, FALSE);
+	check_sort (results, GSEARCH_RESULTS_SORT_NAME, TRUE);
+	gsearchtool_results_free (results);
+
+	results = create_results (SPILL_BUDGET, SPILL_RESULTS);
+	check_sort (results, GSEARCH_RESULTS_SORT_SIZE, FALSE);
+	check_sort (results, GSEARCH_RESULTS_SORT_DATE, TRUE);
+	check_sort (results, GSEARCH_RESULTS_SORT_NAME, FALSE);
+
+	/* Back to the order the results were found in. */
+	gsearchtool_results_set_sort (results, GSEARCH_RESULTS_SORT_NONE, FALSE);
+	g_free (gsearchtool_results_sort (results));
+	check_records (results, SPILL_RESULTS);
+
+	gsearchtool_results_free (results);
+}
+
+static void
+test_results_sorted_insert (void)
+{
+	GSearchResults * results;
+	GSearchResultsRecord record;
+	const gchar * previous = NULL;
+	guint row;
+	gint idx;
+
+	results = gsearchtool_results_new (GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET, spill_folder);
+	gsearchtool_results_set_sort (results, GSEARCH_RESULTS_SORT_NAME, FALSE);
+
+	for (idx = 0; idx < 2000; idx++) {
+		gchar * path = create_path (idx);
+
+		gsearchtool_results_append (results, path, NULL, 0, 0);
+		g_free (path);
+	}
+	g_assert (gsearchtool_results_is_sorted (results) == TRUE);
+	g_assert (gsearchtool_results_sort (results) == NULL);
+
+	for (row = 0; row < gsearchtool_results_get_length (results); row++) {
+		gchar * name;
+
+		gsearchtool_results_get (results, row, &record);
+		g_assert (record.content_type == NULL);
+		name = g_path_get_basename (record.path);
+		if (previous != NULL) {
+			g_assert_cmpstr (previous, <=, name);
+		}
+		g_free ((gchar *) previous);
+		previous = name;
+	}
+	g_free ((gchar *) previous);
+	check_find (results);
+
+	gsearchtool_results_free (results);
+}
+
+static void
+test_results_remove (void)
+{
+	GSearchResults * results;
+	GSearchResultsRecord record;
+	gchar * path;
+	gint row;
+
+	results = create_results (SPILL_BUDGET, SPILL_RESULTS);
+
+	path = create_path (SPILL_RESULTS / 2);
+	row = gsearchtool_results_find (results, path);
+	g_assert_cmpint (row, ==, SPILL_RESULTS / 2);
+
+	gsearchtool_results_remove (results, row);
+	g_assert_cmpuint (gsearchtool_results_get_length (results), ==, SPILL_RESULTS - 1);
+	g_assert_cmpint (gsearchtool_results_find (results, path), ==, -1);
+
+	/* Removed results are still known, so they are not added again. */
+	g_assert (gsearchtool_results_contains (results, path) == TRUE);
+
+	gsearchtool_results_get (results, row, &record);
+	g_free (path);
+	path = create_path (SPILL_RESULTS / 2 + 1);
+	g_assert_cmpstr (record.path, ==, path);
+	g_free (path);
+
+	gsearchtool_results_get (results, SPILL_RESULTS - 2, &record);
+	path = create_path (SPILL_RESULTS - 1);
+	g_assert_cmpstr (record.path, ==, path);
+	g_free (path);
+
+	/* The rows after the removed one are found where they moved to. */
+	gsearchtool_results_remove (results, 0);
+	check_find (results);
+
+	gsearchtool_results_free (results);
+}
+
+static gboolean
+is_size_even (const GSearchResultsRecord * record,
+              gpointer data)
+{
+	return (record->size % 2) == 0;
+}
+
+/* Narrows the store down to the even sizes in one go. */
+static void
+check_filter (GSearchResults * results,
+              gint count)
+{
+	GSearchResultsRecord record;
+	GArray * removed;
+	guint row = 0;
+	gint idx;
+
+	removed = gsearchtool_results_filter (results, is_size_even, NULL);
+
+	/* The removed rows come in increasing order, as they were before. */
+	for (idx = 0; idx < count; idx++) {
+		if (((idx * 31) % 5000) % 2 != 0) {
+			g_assert_cmpuint (row, <, removed->len);
+			g_assert_cmpuint (g_array_index (removed, guint, row), ==, idx);
+			row++;
+		}
+	}
+	g_assert_cmpuint (row, ==, removed->len);
+	g_assert_cmpuint (gsearchtool_results_get_length (results), ==, count - removed->len);
+
+	/* The rows kept stay in order, the removed ones are still known. */
+	row = 0;
+	for (idx = 0; idx < count; idx++) {
+		gchar * path = create_path (idx);
+
+		g_assert (gsearchtool_results_contains (results, path) == TRUE);
+		if (((idx * 31) % 5000) % 2 == 0) {
+			g_assert (gsearchtool_results_get (results, row, &record) == TRUE);
+			g_assert_cmpstr (record.path, ==, path);
+			g_assert_cmpint (gsearchtool_results_find (results, path), ==, row);
+			row++;
+		}
+		else {
+			g_assert_cmpint (gsearchtool_results_find (results, path), ==, -1);
+		}
+		g_free (path);
+	}
+	g_array_free (removed, TRUE);
+}
+
+static void
+test_results_filter (void)
+{
+	GSearchResults * results;
+
+	results = create_results (GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET, 5000);
+	check_filter (results, 5000);
+	gsearchtool_results_free (results);
+
+	results = create_results (SPILL_BUDGET, SPILL_RESULTS);
+	check_filter (results, SPILL_RESULTS);
+	gsearchtool_results_free (results);
+}
+
+/* What the watch mode does with a result that changes twice and is
+   then deleted, and with one deleted and created again. */
+static void
+test_results_watch (void)
+{
+	GSearchResults * results;
+	GSearchResultsRecord record;
+	const gchar * path = "/home/user/folder-1/watched.txt";
+	gint row;
+
+	results = create_results (GSEARCH_RESULTS_DEFAULT_MEMORY_BUDGET, 100);
+	gsearchtool_results_append (results, path, "text/plain", 10, 1000);
+
+	row = gsearchtool_results_find (results, path);
+	g_assert_cmpint (row, ==, 100);
+	gsearchtool_results_update (results, row, "text/plain", 20, 2000);
+
+	row = gsearchtool_results_find (results, path);
+	g_assert_cmpint (row, ==, 100);
+	gsearchtool_results_update (results, row, "text/x-csrc", 30, 3000);
+
+	g_assert_cmpuint (gsearchtool_results_get_length (results), ==, 101);
+	g_assert (gsearchtool_results_get (results, 100, &record) == TRUE);
+	g_assert_cmpstr (record.path, ==, path);
+	g_assert_cmpstr (record.content_type, ==, "text/x-csrc");
+	g_assert_cmpint (record.size, ==, 30);
+	g_assert_cmpint (record.mtime, ==, 3000);
+
+	row = gsearchtool_results_find (results, path);
+	g_assert_cmpint (row, ==, 100);
+	gsearchtool_results_remove (results, row);
+	g_assert_cmpuint (gsearchtool_results_get_length (results), ==, 100);
+	g_assert_cmpint (gsearchtool_results_find (results, path), ==, -1);
+	check_records (results, 100);
+
+	/* Created again, the new row is the one found. */
+	row = gsearchtool_results_append (results, path, "text/plain", 40, 4000);
+	g_assert_cmpint (gsearchtool_results_find (results, path), ==, row);
+	gsearchtool_results_update (results, row, "text/plain", 50, 5000);
+	g_assert (gsearchtool_results_get (results, row, &record) == TRUE);
+	g_assert_cmpint (record.size, ==, 50);
+
+	gsearchtool_results_remove (results, gsearchtool_results_find (results, path));
+	g_assert_cmpint (gsearchtool_results_find (results, path), ==, -1);
+	check_records (results, 100);
+
+	/* A changed result goes out of order when sorted by what changed. */
+	gsearchtool_results_set_sort (results, GSEARCH_RESULTS_SORT_SIZE, FALSE);
+	g_free (gsearchtool_results_sort (results));
+	gsearchtool_results_update (results, 0, NULL, 1000000, 0);
+	g_assert (gsearchtool_results_is_sorted (results) == FALSE);
+	g_free (gsearchtool_results_sort (results));
+	g_assert (gsearchtool_results_get (results, 99, &record) == TRUE);
+	g_assert_cmpint (record.size, ==, 1000000);
+	check_find (results);
+
+	gsearchtool_results_free (results);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	gint result;
+
+	g_test_init (&argc, &argv, NULL);
+
+	spill_folder = g_build_filename (g_get_tmp_dir (), "test-gsearchtool-results", NULL);
+
+	g_test_add_func ("/results/memory", test_results_memory);
+	g_test_add_func ("/results/spill", test_results_spill);
+	g_test_add_func ("/results/sort", test_results_sort);
+	g_test_add_func ("/results/sorted_insert", test_results_sorted_insert);
+	g_test_add_func ("/results/remove", test_results_remove);
+	g_test_add_func ("/results/filter", test_results_filter);
+	g_test_add_func ("/results/watch", test_results_watch);
+
+	result = g_test_run ();
+
+	/* The spill files are unlinked as soon as they are created. */
+	g_rmdir (spill_folder);
+	g_free (spill_folder);
+
+	return result;
+}
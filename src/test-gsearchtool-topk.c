@@ -0,0 +1,151 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*
+ * GNOME Search Tool
+ *
+ *  File:  test-gsearchtool-topk.c
+ *
+ *  (C) 2002 the Free Software Foundation
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Street #330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+/*
+ * Unit tests for the top-K selection, checked against a full sort of a
+ * generated corpus that holds ties and files reported twice.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+
+#include "gsearchtool-topk.h"
+
+#define CORPUS_SIZE 20000
+
+static GSearchTopKKind sort_kind;
+
+static gint
+compare_reference (gconstpointer a,
+                   gconstpointer b)
+{
+	const GSearchTopKEntry * entry_a = *(const GSearchTopKEntry **) a;
+	const GSearchTopKEntry * entry_b = *(const GSearchTopKEntry **) b;
+	gint64 value_a = (sort_kind == GSEARCH_TOPK_LARGEST) ? entry_a->size : entry_a->mtime;
+	gint64 value_b = (sort_kind == GSEARCH_TOPK_LARGEST) ? entry_b->size : entry_b->mtime;
+
+	if (value_a != value_b) {
+		if (sort_kind == GSEARCH_TOPK_OLDEST) {
+			return (value_a < value_b) ? -1 : 1;
+		}
+		return (value_a > value_b) ? -1 : 1;
+	}
+	return strcmp (entry_a->path, entry_b->path);
+}
+
+static void
+check_topk (GSearchTopKKind kind,
+            guint count)
+{
+	GSearchTopK * topk;
+	GPtrArray * corpus;
+	GPtrArray * sorted;
+	GRand * rand;
+	guint idx;
+
+	rand = g_rand_new_with_seed (count);
+	corpus = g_ptr_array_new ();
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		GSearchTopKEntry * entry = g_new0 (GSearchTopKEntry, 1);
+
+		entry->path = g_strdup_printf ("/home/user/file-%05u", idx);
+		entry->size = g_rand_int_range (rand, 0, 1000);
+		entry->mtime = g_rand_int_range (rand, 0, 1000);
+		g_ptr_array_add (corpus, entry);
+	}
+
+	topk = gsearchtool_topk_new (kind, count);
+	for (idx = 0; idx < CORPUS_SIZE; idx++) {
+		GSearchTopKEntry * entry = g_ptr_array_index (corpus, g_rand_int_range (rand, 0, CORPUS_SIZE));
+
+		/* Every file is offered once, some a second time. */
+		gsearchtool_topk_offer (topk, entry->path, entry->size, entry->mtime);
+		entry = g_ptr_array_index (corpus, idx);
+		gsearchtool_topk_offer (topk, entry->path, entry->size, entry->mtime);
+	}
+	g_assert_cmpuint (gsearchtool_topk_get_length (topk), ==, MIN (count, CORPUS_SIZE));
+
+	sort_kind = kind;
+	g_ptr_array_sort (corpus, compare_reference);
+
+	sorted = gsearchtool_topk_get_sorted (topk);
+	g_assert_cmpuint (sorted->len, ==, MIN (count, CORPUS_SIZE));
+	for (idx = 0; idx < sorted->len; idx++) {
+		GSearchTopKEntry * entry = g_ptr_array_index (sorted, idx);
+		GSearchTopKEntry * expected = g_ptr_array_index (corpus, idx);
+
+		g_assert_cmpstr (entry->path, ==, expected->path);
+		g_assert_cmpint (entry->size, ==, expected->size);
+		g_assert_cmpint (entry->mtime, ==, expected->mtime);
+	}
+	g_ptr_array_free (sorted, TRUE);
+	gsearchtool_topk_free (topk);
+
+	for (idx = 0; idx < corpus->len; idx++) {
+		GSearchTopKEntry * entry = g_ptr_array_index (corpus, idx);
+
+		g_free (entry->path);
+		g_free (entry);
+	}
+	g_ptr_array_free (corpus, TRUE);
+	g_rand_free (rand);
+}
+
+static void
+test_topk_largest (void)
+{
+	check_topk (GSEARCH_TOPK_LARGEST, 1);
+	check_topk (GSEARCH_TOPK_LARGEST, 100);
+}
+
+static void
+test_topk_newest (void)
+{
+	check_topk (GSEARCH_TOPK_NEWEST, 100);
+	check_topk (GSEARCH_TOPK_NEWEST, CORPUS_SIZE * 2);
+}
+
+static void
+test_topk_oldest (void)
+{
+	check_topk (GSEARCH_TOPK_OLDEST, 7);
+	check_topk (GSEARCH_TOPK_OLDEST, 5000);
+}
+
+int
+main (int argc,
+      char * argv[])
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/topk/largest", test_topk_largest);
+	g_test_add_func ("/topk/newest", test_topk_newest);
+	g_test_add_func ("/topk/oldest", test_topk_oldest);
+
+	return g_test_run ();
+}